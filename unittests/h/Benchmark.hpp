@@ -0,0 +1,44 @@
+#ifndef XRUT_BENCHMARK_HPP
+#define XRUT_BENCHMARK_HPP
+//==============================================================================
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include <chrono>
+#include <cstdlib>
+
+namespace xr
+{
+
+// Benchmarks are opt-in, to keep them out of regular test runs; they only run
+// if the XRUT_BENCHMARKS environment variable is set, e.g.:
+//   XRUT_BENCHMARKS=1 unittests Benchmark
+// Their results are traced, so they need an XR_DEBUG build to be seen.
+inline bool IsBenchmarkEnabled()
+{
+  static const bool enabled = std::getenv("XRUT_BENCHMARKS") != nullptr;
+  return enabled;
+}
+
+// Calls @a fn @a passes times, and returns the mean duration of a call, in
+// milliseconds.
+template <typename Fn>
+double TimeMs(int passes, Fn&& fn)
+{
+  const auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < passes; ++i)
+  {
+    fn();
+  }
+  const auto elapsed = std::chrono::high_resolution_clock::now() - start;
+  return std::chrono::duration<double, std::milli>(elapsed).count() / passes;
+}
+
+}
+
+#endif //XRUT_BENCHMARK_HPP
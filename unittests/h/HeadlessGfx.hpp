@@ -0,0 +1,51 @@
+#ifndef XRUT_HEADLESSGFX_HPP
+#define XRUT_HEADLESSGFX_HPP
+//==============================================================================
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xr/Gfx.hpp"
+#include <cstdlib>
+
+namespace xr
+{
+
+// Initialises Gfx in headless mode, without a context, for the lifetime of the
+// object, and restores the environment that configures it, on destruction.
+class HeadlessGfx
+{
+public:
+  enum class Mode
+  {
+    Single,
+    Multi,
+    MultiSorted,  // multithreaded, sorting draws.
+  };
+
+  explicit HeadlessGfx(Mode mode = Mode::Single)
+  {
+    putenv(const_cast<char*>("XR_GFX_HEADLESS=1"));
+    putenv(const_cast<char*>(mode == Mode::Single ? "XR_GFX_MULTITHREADED=0" :
+      "XR_GFX_MULTITHREADED=1"));
+    putenv(const_cast<char*>(mode == Mode::MultiSorted ? "XR_GFX_SORT_DRAWS=1" :
+      "XR_GFX_SORT_DRAWS=0"));
+    Gfx::Init(nullptr);
+  }
+
+  ~HeadlessGfx()
+  {
+    Gfx::Shutdown();
+    putenv(const_cast<char*>("XR_GFX_HEADLESS=0"));
+    putenv(const_cast<char*>("XR_GFX_MULTITHREADED=0"));
+    putenv(const_cast<char*>("XR_GFX_SORT_DRAWS=0"));
+  }
+};
+
+}
+
+#endif //XRUT_HEADLESSGFX_HPP
@@ -0,0 +1,66 @@
+#ifndef XRUT_TESTFONT_HPP
+#define XRUT_TESTFONT_HPP
+//==============================================================================
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xm.hpp"
+#include "xr/Font.hpp"
+#include "xr/io/streamutils.hpp"
+#include <sstream>
+#include <vector>
+
+namespace xr
+{
+
+// Creates a font with the given code points, in the format that the Font
+// builder writes. Glyphs' bitmaps are glyphWidth by glyphHeight pixels, filled
+// with the lowest byte of the code point; whitespace has none. The advance of
+// the glyphs varies with their code point.
+inline
+Font::Ptr CreateTestFont(std::vector<uint32_t> const& codePoints, Px cacheSize,
+  Px glyphWidth, Px glyphHeight)
+{
+  std::ostringstream data;
+  WriteBinaryStream(16.f, data); // line height
+  WriteBinaryStream(12.f, data); // ascent
+  WriteBinaryStream(cacheSize, data);
+  WriteBinaryStream(static_cast<uint32_t>(codePoints.size()), data);
+
+  std::ostringstream glyphBitmaps;
+  uint32_t glyphBytesWritten = 0;
+  for (auto cp : codePoints)
+  {
+    const float advance = 10.f + cp % 5;
+    Font::Glyph glyph{ cp, 10.f, 14.f, advance, 1.f, -2.f, 0, 0, uint32_t(-1) };
+    if (cp != ' ')
+    {
+      glyph.fieldWidth = glyphWidth;
+      glyph.fieldHeight = glyphHeight;
+      glyph.dataOffset = glyphBytesWritten;
+
+      std::vector<uint8_t> bitmap(glyphWidth * glyphHeight, uint8_t(cp));
+      WriteRangeBinaryStream<uint32_t>(bitmap.begin(), bitmap.end(), glyphBitmaps);
+      glyphBytesWritten += uint32_t(bitmap.size());
+    }
+    WriteBinaryStream(glyph, data);
+  }
+
+  WriteBinaryStream(glyphBytesWritten, data);
+  auto blob = glyphBitmaps.str();
+  WriteRangeBinaryStream<uint32_t>(blob.begin(), blob.end(), data);
+
+  auto str = data.str();
+  Font::Ptr font(Font::Create(0, Asset::UnmanagedFlag));
+  XM_ASSERT_TRUE(font->ProcessData(Buffer::FromArray(str.size(), str.data())));
+  return font;
+}
+
+}
+
+#endif //XRUT_TESTFONT_HPP
@@ -27,6 +27,7 @@ project "unittests"
 		"../xr3core/h",
 		"../xr3json/h",
 		"../xr3/h",
+		"../xr3/src", -- for internals under test, e.g. AssetLoadJob
 		"../xr3scene/h",
 	}
 
@@ -0,0 +1,62 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xm.hpp"
+#include "xr/memory/Arena.hpp"
+#include <cstring>
+
+using namespace xr;
+
+namespace
+{
+
+struct Pair
+{
+  int a;
+  double b;
+
+  Pair(int a_, double b_)
+  : a(a_),
+    b(b_)
+  {}
+};
+
+XM_TEST(Arena, Basics)
+{
+  Arena arena(64);
+  XM_ASSERT_EQ(arena.GetNumBlocks(), 0u);
+  XM_ASSERT_EQ(arena.CalculateUsed(), 0u);
+
+  auto p0 = static_cast<char*>(arena.Allocate(10, 1));
+  std::memset(p0, 0xff, 10);
+  XM_ASSERT_EQ(arena.GetNumBlocks(), 1u);
+  XM_ASSERT_EQ(arena.CalculateUsed(), 10u);
+
+  auto pair = arena.New<Pair>(42, 1.5);
+  XM_ASSERT_EQ(reinterpret_cast<uintptr_t>(pair) % alignof(Pair), 0u);
+  XM_ASSERT_EQ(pair->a, 42);
+  XM_ASSERT_EQ(pair->b, 1.5);
+
+  // Doesn't fit the first block; blocks grow.
+  auto p1 = arena.Allocate(100, 16);
+  XM_ASSERT_EQ(reinterpret_cast<uintptr_t>(p1) % 16, 0u);
+  XM_ASSERT_EQ(arena.GetNumBlocks(), 2u);
+  XM_ASSERT_TRUE(arena.CalculateUsed() >= 10u + sizeof(Pair) + 100u);
+
+  // Previous allocations are intact.
+  XM_ASSERT_EQ(static_cast<uint8_t>(p0[9]), 0xff);
+  XM_ASSERT_EQ(pair->a, 42);
+
+  // Reset keeps the last, largest block.
+  arena.Reset();
+  XM_ASSERT_EQ(arena.GetNumBlocks(), 1u);
+  XM_ASSERT_EQ(arena.CalculateUsed(), 0u);
+  XM_ASSERT_EQ(arena.Allocate(100, 16), p1);
+}
+
+}
@@ -0,0 +1,104 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xm.hpp"
+#include "xr/threading/BoundedQueue.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace xr;
+
+namespace
+{
+
+XM_TEST(BoundedQueue, Capacity)
+{
+  BoundedQueue<int> q(5);
+  XM_ASSERT_EQ(q.capacity(), 8u);
+
+  BoundedQueue<int> q2(16);
+  XM_ASSERT_EQ(q2.capacity(), 16u);
+}
+
+XM_TEST(BoundedQueue, PushPop)
+{
+  BoundedQueue<int> q(4);
+  int value;
+  XM_ASSERT_FALSE(q.try_pop(value));
+
+  for (int i = 0; i < 4; ++i)
+  {
+    XM_ASSERT_TRUE(q.try_push(i));
+  }
+  XM_ASSERT_FALSE(q.try_push(4)); // full
+
+  // Wrap around a few times.
+  for (int i = 0; i < 20; ++i)
+  {
+    XM_ASSERT_TRUE(q.try_pop(value));
+    XM_ASSERT_EQ(value, i);
+    XM_ASSERT_TRUE(q.try_push(i + 4));
+  }
+
+  for (int i = 20; i < 24; ++i)
+  {
+    XM_ASSERT_TRUE(q.try_pop(value));
+    XM_ASSERT_EQ(value, i);
+  }
+  XM_ASSERT_FALSE(q.try_pop(value));
+}
+
+XM_TEST(BoundedQueue, MultipleProducersConsumers)
+{
+  const int kNumThreads = 4;
+  const int kNumValues = 100000;
+  BoundedQueue<int> q(64);
+
+  std::atomic<int64_t> sum(0);
+  std::atomic<int> numPopped(0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i)
+  {
+    threads.emplace_back([&q, i] {
+      for (int j = i; j < kNumValues; j += kNumThreads)
+      {
+        while (!q.try_push(j + 1))
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+
+    threads.emplace_back([&] {
+      int value;
+      while (numPopped.load() < kNumValues)
+      {
+        if (q.try_pop(value))
+        {
+          sum += value;
+          ++numPopped;
+        }
+        else
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  for (auto& t : threads)
+  {
+    t.join();
+  }
+
+  XM_ASSERT_EQ(numPopped.load(), kNumValues);
+  XM_ASSERT_EQ(sum.load(), int64_t(kNumValues) * (kNumValues + 1) / 2);
+}
+
+}
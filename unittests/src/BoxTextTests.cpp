@@ -0,0 +1,394 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xm.hpp"
+#include "Benchmark.hpp"
+#include "TestFont.hpp"
+#include "xr/BoxText.hpp"
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace xr;
+
+namespace
+{
+
+// Printable ASCII, and some of Latin-1 Supplement; the advance of glyphs is
+// 10 + (code point % 5), their x bearing is 1.
+Font::Ptr CreateFont()
+{
+  std::vector<uint32_t> codePoints;
+  for (uint32_t cp = ' '; cp <= '~'; ++cp)
+  {
+    codePoints.push_back(cp);
+  }
+
+  for (uint32_t cp = 0xc0; cp < 0x100; ++cp)
+  {
+    codePoints.push_back(cp);
+  }
+  return CreateTestFont(codePoints, 256, 8, 8);
+}
+
+BoxText CreateBoxText(Font::Ptr const& font, float width, float height)
+{
+  BoxText boxText;
+  boxText.SetFont(font);
+  boxText.SetBoxSize(width, height);
+  return boxText;
+}
+
+std::string GetLine(BoxText::Measurement const& m, size_t i)
+{
+  return std::string(m.lines[i].start, m.lines[i].end);
+}
+
+XM_TEST(BoxText, Measure)
+{
+  auto font = CreateFont();
+  auto boxText = CreateBoxText(font, 100.f, 100.f);
+
+  const char* text = "ab cd";
+  BoxText::Measurement m;
+  boxText.Measure(text, m);
+  XM_ASSERT_EQ(m.numGlyphs, 4u);
+  XM_ASSERT_EQ(m.lines.size(), 1u);
+  XM_ASSERT_EQ(m.lines[0].start, text);
+  XM_ASSERT_EQ(m.lines[0].end, text + strlen(text));
+  // The x bearing of the first glyph isn't included.
+  XM_ASSERT_EQ(m.lines[0].width, 11.f + 13.f + 12.f + 14.f + 10.f);
+  XM_ASSERT_EQ(m.size.x, m.lines[0].width);
+  XM_ASSERT_EQ(m.size.y, font->GetLineHeight());
+
+  // Break at word boundary.
+  boxText.SetBoxSize(40.f, 100.f);
+  boxText.Measure(text, m);
+  XM_ASSERT_EQ(m.lines.size(), 2u);
+  XM_ASSERT_EQ(GetLine(m, 0), "ab");
+  XM_ASSERT_EQ(m.lines[0].width, 24.f);
+  XM_ASSERT_EQ(GetLine(m, 1), "cd");
+  XM_ASSERT_EQ(m.size.y, font->GetLineHeight() * 2.f);
+
+  // Break words that don't fit.
+  boxText.SetBoxSize(30.f, 100.f);
+  boxText.Measure("abcde", m);
+  XM_ASSERT_EQ(m.lines.size(), 3u);
+  XM_ASSERT_EQ(GetLine(m, 0), "ab");
+  XM_ASSERT_EQ(GetLine(m, 1), "cd");
+  XM_ASSERT_EQ(GetLine(m, 2), "e");
+
+  // Only the lines that fit.
+  boxText.SetBoxSize(30.f, font->GetLineHeight() * 2.5f);
+  boxText.Measure("abcde", m);
+  XM_ASSERT_EQ(m.lines.size(), 2u);
+  XM_ASSERT_EQ(m.numGlyphs, 4u);
+  XM_ASSERT_EQ(m.size.y, font->GetLineHeight() * 2.f);
+
+  boxText.SetBoxSize(30.f, font->GetLineHeight() * .5f);
+  boxText.Measure("abcde", m);
+  XM_ASSERT_EQ(m.lines.size(), 0u);
+  XM_ASSERT_EQ(m.numGlyphs, 0u);
+}
+
+XM_TEST(BoxText, MeasureLineBreaks)
+{
+  auto font = CreateFont();
+  auto boxText = CreateBoxText(font, 100.f, 100.f);
+
+  BoxText::Measurement m;
+  boxText.Measure("\xc3\xa0" "b\r\ncd\n\n\xc3\xa9", m);
+  XM_ASSERT_EQ(m.numGlyphs, 5u);
+  XM_ASSERT_EQ(m.lines.size(), 4u);
+  XM_ASSERT_EQ(GetLine(m, 0), "\xc3\xa0" "b");
+  XM_ASSERT_EQ(GetLine(m, 1), "cd");
+  XM_ASSERT_EQ(GetLine(m, 2), "");
+  XM_ASSERT_EQ(GetLine(m, 3), "\xc3\xa9");
+
+  // Leading whitespace only, then an empty line.
+  boxText.Measure("  \n\nab", m);
+  XM_ASSERT_EQ(m.lines.size(), 3u);
+  XM_ASSERT_EQ(GetLine(m, 0), "");
+  XM_ASSERT_EQ(m.lines[0].width, 0.f);
+  XM_ASSERT_EQ(GetLine(m, 1), "");
+  XM_ASSERT_EQ(m.lines[1].width, 0.f);
+  XM_ASSERT_EQ(GetLine(m, 2), "ab");
+
+  // Invalid UTF-8 terminates the text.
+  boxText.Measure("ab\xff" "cd", m);
+  XM_ASSERT_EQ(m.lines.size(), 1u);
+  XM_ASSERT_EQ(GetLine(m, 0), "ab");
+}
+
+// The results of the original, unbatched implementation of Measure(), for
+// cases that are sensitive to how the widths of lines and the spacing between
+// them are accounted for.
+XM_TEST(BoxText, MeasureGolden)
+{
+  struct Line
+  {
+    const char* text;
+    float width;
+  };
+
+  struct Case
+  {
+    const char* text;
+    Vector2 boxSize;
+    float hSpacing;
+    float vSpacing;
+    float scale;
+    Vector2 size;
+    uint32_t numGlyphs;
+    std::vector<Line> lines;
+  };
+
+  const Case cases[] = {
+    { " ab\ncd", Vector2(100.f, 100.f), 0.f, 0.f, 1.f, Vector2(24.f, 32.f), 4,
+      { { "ab", 24.f }, { "cd", 12.f } } },
+    { "  ab\ncd", Vector2(100.f, 100.f), 0.f, 0.f, 1.f, Vector2(24.f, 32.f), 4,
+      { { "ab", 24.f }, { "cd", 0.f } } },
+    { "   ab cd", Vector2(40.f, 100.f), 0.f, 0.f, 1.f, Vector2(24.f, 48.f), 4,
+      { { "", 0.f }, { "ab", 23.f }, { "cd", 24.f } } },
+    { " Z", Vector2(15.f, 100.f), 0.f, 0.f, 1.f, Vector2(8.f, 32.f), 1,
+      { { "", 0.f }, { "Z", 8.f } } },
+    { "\x7f 1qc", Vector2(42.f, 100.f), 1.f, 0.f, 1.f, Vector2(43.f, 32.f), 3,
+      { { "\x7f", 0.f }, { "1qc", 43.f } } },
+    { "ab\ncd\nef", Vector2(100.f, 40.f), 0.f, 4.f, 1.f, Vector2(24.f, 40.f), 4,
+      { { "ab", 24.f }, { "cd", 24.f } } },
+    { "ab\ncd\nef", Vector2(100.f, 100.f), 0.f, 4.f, 1.f, Vector2(24.f, 56.f), 6,
+      { { "ab", 24.f }, { "cd", 24.f }, { "ef", 23.f } } },
+    // The original counted 6 glyphs, including one past the last line.
+    { "lorem ipsum dolor sit amet", Vector2(80.f, 100.f), 2.f, 3.f, 2.f,
+      Vector2(78.f, 70.f), 5, { { "lor", 78.f }, { "em", 50.f } } },
+    { "lorem ipsum dolor sit amet", Vector2(200.f, 100.f), 1.f, 2.f, .5f,
+      Vector2(178.f, 8.f), 22, { { "lorem ipsum dolor sit amet", 178.f } } },
+  };
+
+  auto font = CreateFont();
+  BoxText::Measurement m;
+  for (auto& c : cases)
+  {
+    auto boxText = CreateBoxText(font, c.boxSize.x, c.boxSize.y);
+    boxText.SetHorizontalSpacing(c.hSpacing);
+    boxText.SetVerticalSpacing(c.vSpacing);
+    boxText.SetScale(c.scale);
+    boxText.Measure(c.text, m);
+
+    XM_ASSERT_EQ(m.size.x, c.size.x);
+    XM_ASSERT_EQ(m.size.y, c.size.y);
+    XM_ASSERT_EQ(m.numGlyphs, c.numGlyphs);
+    XM_ASSERT_EQ(m.lines.size(), c.lines.size());
+    for (size_t i = 0; i < c.lines.size(); ++i)
+    {
+      XM_ASSERT_EQ(GetLine(m, i), c.lines[i].text);
+      XM_ASSERT_EQ(m.lines[i].width, c.lines[i].width);
+    }
+  }
+}
+
+XM_TEST(BoxText, Generate)
+{
+  auto font = CreateFont();
+  auto boxText = CreateBoxText(font, 100.f, 100.f);
+  boxText.SetHorizontalAlignment(BoxText::Alignment::Negative);
+  boxText.SetVerticalAlignment(BoxText::Alignment::Negative);
+  boxText.SetHorizontalSpacing(2.f);
+
+  BoxText::Measurement m;
+  boxText.Measure("a\x7f" "b\ncd", m); // \x7f is missing.
+  XM_ASSERT_EQ(m.numGlyphs, 4u);
+
+  std::vector<BoxText::Vertex> vertices(m.numGlyphs * 4);
+  BoxText::Stats stats;
+  boxText.Generate(m, vertices.data(), false, &stats);
+  XM_ASSERT_EQ(stats.numLines, 2u);
+  XM_ASSERT_EQ(stats.maxLineWidth, m.size.x);
+  XM_ASSERT_EQ(stats.height, m.size.y);
+
+  // The baseline is at the top of the box, less the ascent.
+  const float left = -50.f;
+  const float baseline = 50.f - font->GetAscent();
+  auto a = font->GetGlyph('a');
+  XM_ASSERT_EQ(vertices[0].pos.x, left + a->xBearing);
+  XM_ASSERT_EQ(vertices[0].pos.y, baseline + a->yBearing + a->height);
+  XM_ASSERT_EQ(vertices[3].pos.x, left + a->xBearing + a->width);
+  XM_ASSERT_EQ(vertices[3].pos.y, baseline + a->yBearing);
+
+  // The missing glyph is spacing only.
+  const float bLeft = left + a->advance + 2.f * 2.f;
+  XM_ASSERT_EQ(vertices[4].pos.x, bLeft + font->GetGlyph('b')->xBearing);
+
+  const float nextBaseline = baseline - font->GetLineHeight();
+  XM_ASSERT_EQ(vertices[9].pos.y, nextBaseline + font->GetGlyph('c')->yBearing);
+
+  auto cg = font->CacheGlyph('d');
+  XM_ASSERT_EQ(vertices[12].uv0.x, cg->uvs.left);
+  XM_ASSERT_EQ(vertices[12].uv0.y, cg->uvs.top);
+  XM_ASSERT_EQ(vertices[15].uv0.x, cg->uvs.right);
+  XM_ASSERT_EQ(vertices[15].uv0.y, cg->uvs.bottom);
+}
+
+// Lays out random texts with random parameters, and checks the consistency of
+// the results.
+XM_TEST(BoxText, LayoutRandom)
+{
+  auto font = CreateFont();
+  const char* const pieces[] = { "a", "b", "q", "Z", "~", "1", "\xc3\xa9", "\x7f",
+    " ", " ", "\n", "\r\n" };
+  const size_t kNumPieces = sizeof(pieces) / sizeof(pieces[0]);
+  std::mt19937 rng(7);
+  auto getText = [&rng, &pieces]() {
+    std::string text;
+    const int length = rng() % 60;
+    for (int i = 0; i < length; ++i)
+    {
+      text += pieces[rng() % kNumPieces];
+    }
+
+    if (rng() % 8 == 0)
+    {
+      text += "\xff" "abc";
+    }
+    return text;
+  };
+
+  BoxText::Measurement m;
+  BoxText::Measurement mOther;
+  std::vector<BoxText::Vertex> vertices;
+  std::vector<BoxText::Vertex> verticesPartial;
+  std::vector<uint32_t> lineGlyphCounts;
+  for (int i = 0; i < 20000; ++i)
+  {
+    const std::string text = getText();
+    auto boxText = CreateBoxText(font, float(rng() % 300 + 30),
+      float(rng() % 200 + 20));
+    boxText.SetScale((rng() % 3 + 1) * .5f);
+    boxText.SetHorizontalSpacing(float(rng() % 3));
+    boxText.SetVerticalSpacing(float(rng() % 3));
+    boxText.SetHorizontalAlignment(BoxText::Alignment(rng() % 3));
+    boxText.SetVerticalAlignment(BoxText::Alignment(rng() % 3));
+
+    // The result doesn't depend on what was laid out before.
+    boxText.Measure(text.c_str(), text.size(), m);
+    const std::string other = getText();
+    boxText.Measure(other.c_str(), other.size(), mOther);
+    boxText.Measure(text.c_str(), text.size(), mOther);
+    XM_ASSERT_EQ(mOther.numGlyphs, m.numGlyphs);
+    XM_ASSERT_EQ(mOther.size.x, m.size.x);
+    XM_ASSERT_EQ(mOther.size.y, m.size.y);
+    XM_ASSERT_EQ(mOther.lines.size(), m.lines.size());
+
+    // The lines are in order, and within the text.
+    float maxWidth = 0.f;
+    char const* lastEnd = text.c_str();
+    for (size_t j = 0; j < m.lines.size(); ++j)
+    {
+      auto& line = m.lines[j];
+      XM_ASSERT_EQ(mOther.lines[j].start, line.start);
+      XM_ASSERT_EQ(mOther.lines[j].end, line.end);
+      XM_ASSERT_EQ(mOther.lines[j].width, line.width);
+
+      XM_ASSERT_LE(lastEnd, line.start);
+      XM_ASSERT_LE(line.start, line.end);
+      XM_ASSERT_LE(line.end, text.c_str() + text.size());
+      lastEnd = line.end;
+      maxWidth = std::max(maxWidth, line.width);
+    }
+    XM_ASSERT_EQ(m.size.x, maxWidth);
+
+    // Generating from any line onwards writes the same vertices as generating
+    // the whole.
+    vertices.resize(m.numGlyphs * Quad::Vertex::kCount);
+    BoxText::Stats stats;
+    boxText.Generate(m, vertices.data(), false, &stats);
+    if (m.numGlyphs > 0)
+    {
+      XM_ASSERT_EQ(stats.numLines, m.lines.size());
+      XM_ASSERT_EQ(stats.maxLineWidth, m.size.x);
+      XM_ASSERT_EQ(stats.height, m.size.y);
+    }
+
+    verticesPartial.assign(vertices.size(), BoxText::Vertex());
+    lineGlyphCounts.resize(m.lines.size());
+    boxText.Generate(m, 0, BoxText::Vertex::kSize, &verticesPartial.data()->pos,
+      &verticesPartial.data()->uv0, lineGlyphCounts.data(), false, nullptr);
+    XM_ASSERT_EQ(memcmp(verticesPartial.data(), vertices.data(),
+      vertices.size() * sizeof(BoxText::Vertex)), 0);
+
+    const size_t firstLine = m.lines.empty() ? 0 : rng() % m.lines.size();
+    uint32_t firstGlyph = 0;
+    for (size_t j = 0; j < firstLine; ++j)
+    {
+      firstGlyph += lineGlyphCounts[j];
+    }
+    std::fill(verticesPartial.begin() + firstGlyph * Quad::Vertex::kCount,
+      verticesPartial.end(), BoxText::Vertex());
+
+    auto verts = verticesPartial.data() + firstGlyph * Quad::Vertex::kCount;
+    boxText.Generate(m, firstLine, BoxText::Vertex::kSize, &verts->pos,
+      &verts->uv0, lineGlyphCounts.data(), false, nullptr);
+    uint32_t numGlyphs = firstGlyph;
+    for (size_t j = 0; j < m.lines.size() - firstLine; ++j)
+    {
+      numGlyphs += lineGlyphCounts[j];
+    }
+    XM_ASSERT_EQ(numGlyphs, m.numGlyphs);
+    XM_ASSERT_EQ(memcmp(verticesPartial.data(), vertices.data(),
+      vertices.size() * sizeof(BoxText::Vertex)), 0);
+  }
+}
+
+XM_TEST(BoxText, LayoutBenchmark)
+{
+  if (!IsBenchmarkEnabled())
+  {
+    return;
+  }
+
+  auto font = CreateFont();
+  auto boxText = CreateBoxText(font, 240.f, 80.f);
+
+  // UI-like labels, re-laid out every frame.
+  std::vector<std::string> labels;
+  uint32_t seed = 1;
+  for (int i = 0; i < 1000; ++i)
+  {
+    std::string label;
+    for (int j = 0; j < 24; ++j)
+    {
+      seed = seed * 1664525 + 1013904223;
+      const auto r = (seed >> 8) % 64;
+      label += r < 10 ? ' ' : char('a' + r % 26);
+    }
+    labels.push_back(label);
+  }
+
+  BoxText::Measurement m;
+  std::vector<BoxText::Vertex> vertices;
+  size_t numGlyphs = 0;
+  const int kFrames = 20;
+  const double ms = TimeMs(kFrames, [&] {
+    for (auto& label : labels)
+    {
+      boxText.Measure(label.c_str(), label.size(), m);
+      vertices.resize(m.numGlyphs * 4);
+      boxText.Generate(m, vertices.data(), false, nullptr);
+      numGlyphs += m.numGlyphs;
+    }
+  });
+  XM_ASSERT_GT(numGlyphs, 0u);
+
+  XR_TRACE(BoxText, ("%zu labels of %zu glyphs: %.3fms per frame, %.2fns per glyph",
+    labels.size(), numGlyphs / (labels.size() * kFrames), ms, ms * 1e6 * kFrames / numGlyphs));
+  (void)ms;
+}
+
+}
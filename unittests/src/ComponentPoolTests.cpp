@@ -0,0 +1,145 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xm.hpp"
+#include "Benchmark.hpp"
+#include "xr/Entity.hpp"
+#include "xr/ComponentPool.hpp"
+#include <memory>
+#include <vector>
+
+using namespace xr;
+
+namespace
+{
+
+class XR_COMPONENT_DECL(Mover)
+{
+public:
+  Vector3 position;
+  Vector3 velocity;
+
+  Mover* Clone() const override
+  {
+    auto clone = new Mover();
+    clone->position = position;
+    clone->velocity = velocity;
+    return clone;
+  }
+};
+
+XM_TEST(ComponentPool, Basics)
+{
+  // Nothing may derive from a pooled type, or ForEach() would miss it.
+  static_assert(std::is_final<Mover>::value, "XR_COMPONENT_DECL() types are final.");
+
+  auto& pool = ComponentPool<Mover>::Get();
+  XM_ASSERT_EQ(ComponentPoolBase::Find(Component::GetTypeIdImpl<Mover>()), &pool.GetBase());
+  XM_ASSERT_EQ(pool.GetBase().GetTypeId(), Component::GetTypeIdImpl<Mover>());
+
+  const size_t kCount = ComponentPoolBase::kBlockSize + 10;
+  std::vector<std::unique_ptr<Entity>> entities;
+  for (size_t i = 0; i < kCount; ++i)
+  {
+    entities.emplace_back(new Entity(nullptr));
+    auto m = entities.back()->AddComponent<Mover>();
+    m->position = Vector3(float(i), 0.f, 0.f);
+  }
+  XM_ASSERT_EQ(pool.GetSize(), kCount);
+
+  // Visits each component once, in the order of their creation.
+  size_t count = 0;
+  pool.ForEach([&count, &entities](Mover& m) {
+    XM_ASSERT_EQ(m.GetOwner(), entities[count].get());
+    XM_ASSERT_EQ(m.position.x, float(count));
+    ++count;
+  });
+  XM_ASSERT_EQ(count, kCount);
+
+  // Freed slots get reused.
+  auto m = entities[5]->FindComponent<Mover>();
+  entities[5]->RemoveComponent<Mover>();
+  XM_ASSERT_EQ(pool.GetSize(), kCount - 1);
+  XM_ASSERT_EQ(entities[5]->AddComponent<Mover>(), m);
+
+  // Clones are pooled.
+  auto clone = entities[0]->Clone(nullptr);
+  XM_ASSERT_EQ(pool.GetSize(), kCount + 1);
+  delete clone;
+
+  entities.clear();
+  XM_ASSERT_EQ(pool.GetSize(), 0u);
+}
+
+double BenchmarkLookup(std::vector<std::unique_ptr<Entity>> const& entities, int passes)
+{
+  return TimeMs(passes, [&entities] {
+    for (auto& e : entities)
+    {
+      if (auto m = e->FindComponent<Mover>())
+      {
+        m->position += m->velocity;
+      }
+    }
+  });
+}
+
+double BenchmarkPool(int passes)
+{
+  auto& pool = ComponentPool<Mover>::Get();
+  return TimeMs(passes, [&pool] {
+    pool.ForEach([](Mover& m) {
+      m.position += m.velocity;
+    });
+  });
+}
+
+class XR_COMPONENT_DECL(Tag)
+{
+public:
+  Tag* Clone() const override
+  {
+    return new Tag();
+  }
+};
+
+XM_TEST(ComponentPool, IterationBenchmark)
+{
+  if (!IsBenchmarkEnabled())
+  {
+    return;
+  }
+
+  const int kPasses = 20;
+  for (size_t count : { 10000, 100000 })
+  {
+    std::vector<std::unique_ptr<Entity>> entities;
+    entities.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+      entities.emplace_back(new Entity(nullptr));
+      entities.back()->AddComponent<Tag>();  // give the lookup some work.
+      entities.back()->AddComponent<Mover>()->velocity = Vector3::UnitX();
+    }
+
+    const double lookupMs = BenchmarkLookup(entities, kPasses);
+    const double poolMs = BenchmarkPool(kPasses);
+    XR_TRACE(ComponentPool, ("%zu entities: FindComponent(): %.3fms, ForEach(): %.3fms, %.2fx",
+      count, lookupMs, poolMs, lookupMs / poolMs));
+    (void)lookupMs;
+    (void)poolMs;
+
+    // Both have moved every Mover.
+    for (auto& e : entities)
+    {
+      XM_ASSERT_EQ(e->FindComponent<Mover>()->position.x, float(kPasses * 2));
+    }
+  }
+}
+
+}
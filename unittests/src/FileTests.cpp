@@ -0,0 +1,111 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xm.hpp"
+#include "FileLifeCycleManager.hpp"
+#include "xr/FileWriter.hpp"
+#include <cstring>
+#include <vector>
+
+using namespace xr;
+
+namespace
+{
+
+class File
+{
+private:
+  FileLifeCycleManager  flcm;
+};
+
+void WriteFile(FilePath const& path, std::vector<uint8_t> const& data)
+{
+  FileWriter writer;
+  XM_ASSERT_TRUE(writer.Open(path, FileWriter::Mode::Truncate, false));
+  XM_ASSERT_TRUE(data.empty() || writer.Write(data.data(), 1, data.size()));
+}
+
+XM_TEST_F(File, Map)
+{
+  std::vector<uint8_t> data(100000);
+  for (size_t i = 0; i < data.size(); ++i)
+  {
+    data[i] = static_cast<uint8_t>(i * 7);
+  }
+
+  const FilePath path("mapped.bin");
+  WriteFile(path, data);
+
+  auto hMapping = xr::File::Map(path);
+  XM_ASSERT_NE(hMapping, nullptr);
+  XM_ASSERT_EQ(xr::File::GetMappedSize(hMapping), data.size());
+  XM_ASSERT_EQ(std::memcmp(xr::File::GetMappedData(hMapping), data.data(),
+    data.size()), 0);
+
+  // Mapping a file more than once.
+  auto hMapping2 = xr::File::Map(path);
+  XM_ASSERT_NE(hMapping2, nullptr);
+  XM_ASSERT_EQ(std::memcmp(xr::File::GetMappedData(hMapping2),
+    xr::File::GetMappedData(hMapping), data.size()), 0);
+
+  xr::File::Unmap(hMapping2);
+  xr::File::Unmap(hMapping);
+
+  // Once unmapped, the file may be rewritten (and deleted).
+  data.resize(data.size() / 2);
+  WriteFile(path, data);
+  hMapping = xr::File::Map(path);
+  XM_ASSERT_NE(hMapping, nullptr);
+  XM_ASSERT_EQ(xr::File::GetMappedSize(hMapping), data.size());
+  xr::File::Unmap(hMapping);
+
+  XM_ASSERT_TRUE(xr::File::Delete(path));
+}
+
+XM_TEST_F(File, MapFromRom)
+{
+  // Not in the RAM path; found in the ROM path.
+  const FilePath path("xontest1.xon");
+  XM_ASSERT_FALSE(xr::File::CheckExists(xr::File::kRawProto + xr::File::GetRamPath() / path));
+
+  auto hMapping = xr::File::Map(path);
+  XM_ASSERT_NE(hMapping, nullptr);
+
+  auto hFile = xr::File::Open(path, "rb");
+  XM_ASSERT_NE(hFile, nullptr);
+  const size_t size = xr::File::GetSize(hFile);
+  std::vector<uint8_t> data(size);
+  XM_ASSERT_EQ(xr::File::Read(hFile, 1, size, data.data()), size);
+  xr::File::Close(hFile);
+
+  XM_ASSERT_EQ(xr::File::GetMappedSize(hMapping), size);
+  XM_ASSERT_EQ(std::memcmp(xr::File::GetMappedData(hMapping), data.data(), size), 0);
+  xr::File::Unmap(hMapping);
+}
+
+XM_TEST_F(File, MapMissing)
+{
+  XM_ASSERT_EQ(xr::File::Map("there-is-no-such-file.bin"), nullptr);
+}
+
+XM_TEST_F(File, MapEmpty)
+{
+  // Empty files can't be mapped; they should be read instead.
+  const FilePath path("empty.bin");
+  WriteFile(path, {});
+  XM_ASSERT_TRUE(xr::File::CheckExists(path));
+  XM_ASSERT_EQ(xr::File::Map(path), nullptr);
+  XM_ASSERT_TRUE(xr::File::Delete(path));
+}
+
+XM_TEST_F(File, UnmapNull)
+{
+  xr::File::Unmap(nullptr);
+}
+
+}
@@ -0,0 +1,208 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xm.hpp"
+#include "Benchmark.hpp"
+#include "TestFont.hpp"
+#include "HeadlessGfx.hpp"
+#include "xr/AABB.hpp"
+#include <map>
+#include <vector>
+
+using namespace xr;
+
+namespace
+{
+
+const Px kCacheSize = 64;
+const Px kGlyphWidth = 24; // 4 blocks of the TextureCache; 2 fit in a row.
+const Px kGlyphHeight = 32; // i.e. there are 2 rows.
+
+Font::Ptr CreateFont(std::vector<uint32_t> const& codePoints)
+{
+  return CreateTestFont(codePoints, kCacheSize, kGlyphWidth, kGlyphHeight);
+}
+
+// Presents the frame, and waits for the rendering thread, if any, to process it.
+void Present()
+{
+  Gfx::Present();
+  Gfx::Flush();
+  Gfx::Flush();
+}
+
+XM_TEST(Font, GetGlyph)
+{
+  std::vector<uint32_t> codePoints{ ' ', 'a', 'b', 0xe9, 0x24f, 0x250, 0x3b1, 0x4e00 };
+  auto font = CreateFont(codePoints);
+  for (auto cp : codePoints)
+  {
+    auto glyph = font->GetGlyph(cp);
+    XM_ASSERT_NE(glyph, nullptr);
+    XM_ASSERT_EQ(glyph->codePoint, cp);
+  }
+
+  for (uint32_t cp : { 0u, uint32_t('c'), 0xeau, 0x251u, 0x4e01u, 0x10ffffu, uint32_t(-1) })
+  {
+    XM_ASSERT_EQ(font->GetGlyph(cp), nullptr);
+  }
+
+  // Only whitespace and ASCII.
+  font = CreateFont({ ' ', '!', '~' });
+  XM_ASSERT_NE(font->GetGlyph('~'), nullptr);
+  XM_ASSERT_EQ(font->GetGlyph('}'), nullptr);
+  XM_ASSERT_EQ(font->GetGlyph(0x3b1), nullptr);
+
+  font->Unload();
+  XM_ASSERT_EQ(font->GetGlyph('!'), nullptr);
+}
+
+XM_TEST(Font, CacheGlyphEvictsLeastRecentlyUsed)
+{
+  auto font = CreateFont({ ' ', 'a', 'b', 'c', 'd', 'e', 0x4e00 });
+  XM_ASSERT_EQ(font->CacheGlyph('z'), nullptr);
+
+  // Whitespace takes no space.
+  auto cg = font->CacheGlyph(' ');
+  XM_ASSERT_NE(cg, nullptr);
+  XM_ASSERT_EQ(cg->glyph, font->GetGlyph(' '));
+  XM_ASSERT_EQ(cg->uvs.right, 0.f);
+
+  // Fill the cache.
+  std::map<uint32_t, AABB> uvs;
+  for (uint32_t cp : { 'a', 'b', 'c', 'd' })
+  {
+    cg = font->CacheGlyph(cp);
+    XM_ASSERT_NE(cg, nullptr);
+    XM_ASSERT_EQ(cg->glyph, font->GetGlyph(cp));
+    XM_ASSERT_GT(cg->uvs.right, 0.f);
+    uvs[cp] = cg->uvs;
+  }
+
+  // Use 'a' again, then add 'e', which replaces 'b'.
+  cg = font->CacheGlyph('a');
+  XM_ASSERT_EQ(cg->uvs.left, uvs['a'].left);
+  XM_ASSERT_EQ(cg->uvs.top, uvs['a'].top);
+
+  cg = font->CacheGlyph('e');
+  XM_ASSERT_EQ(cg->glyph->codePoint, uint32_t('e'));
+  XM_ASSERT_EQ(cg->uvs.left, uvs['b'].left);
+  XM_ASSERT_EQ(cg->uvs.top, uvs['b'].top);
+
+  // 'b' then takes the place of 'c', and so on.
+  cg = font->CacheGlyph('b');
+  XM_ASSERT_EQ(cg->uvs.left, uvs['c'].left);
+  XM_ASSERT_EQ(cg->uvs.top, uvs['c'].top);
+
+  cg = font->CacheGlyph(0x4e00);
+  XM_ASSERT_EQ(cg->uvs.left, uvs['d'].left);
+  XM_ASSERT_EQ(cg->uvs.top, uvs['d'].top);
+
+  // The ones used most recently stay in place.
+  for (uint32_t cp : { uint32_t('a'), uint32_t('e'), uint32_t('b'), 0x4e00u })
+  {
+    cg = font->CacheGlyph(cp);
+    XM_ASSERT_EQ(cg->glyph->codePoint, cp);
+  }
+  XM_ASSERT_EQ(font->CacheGlyph('a')->uvs.top, uvs['a'].top);
+  XM_ASSERT_EQ(font->CacheGlyph(' ')->uvs.right, 0.f);
+
+  // Cleared cache is reused from the start.
+  font->ClearCache();
+  cg = font->CacheGlyph('d');
+  XM_ASSERT_EQ(cg->uvs.left, uvs['a'].left);
+  XM_ASSERT_EQ(cg->uvs.top, uvs['a'].top);
+}
+
+XM_TEST(Font, UpdateCacheUploadsNewGlyphsOnly)
+{
+  for (auto mode : { HeadlessGfx::Mode::Single, HeadlessGfx::Mode::Multi })
+  {
+    HeadlessGfx gfx(mode);
+    auto font = CreateFont({ ' ', 'a', 'b', 'c' });
+    font->UpdateCache();
+    Present();
+    XM_ASSERT_EQ(Gfx::GetFrameStats().numTextureUploadBytes, uint32_t(kCacheSize * kCacheSize));
+
+    font->CacheGlyph('a');
+    font->CacheGlyph('b');
+    font->CacheGlyph('c');
+    font->UpdateCache();
+    Present();
+    // Two rows; the first one includes the 8 pixels between 'a' and 'b'.
+    XM_ASSERT_EQ(Gfx::GetFrameStats().numTextureUploadBytes,
+      uint32_t((kGlyphWidth * 3 + 8) * kGlyphHeight));
+
+    // Nothing new to upload.
+    font->CacheGlyph('a');
+    font->UpdateCache();
+    Present();
+    XM_ASSERT_EQ(Gfx::GetFrameStats().numTextureUploadBytes, 0u);
+  }
+}
+
+XM_TEST(Font, GlyphLookupBenchmark)
+{
+  if (!IsBenchmarkEnabled())
+  {
+    return;
+  }
+
+  std::vector<uint32_t> codePoints;
+  for (uint32_t cp = 0x20; cp < 0x180; ++cp)
+  {
+    codePoints.push_back(cp);
+  }
+
+  for (uint32_t cp = 0x4e00; cp < 0x5600; ++cp)
+  {
+    codePoints.push_back(cp);
+  }
+  auto font = CreateFont(codePoints);
+
+  std::map<uint32_t, Font::Glyph> glyphMap;
+  for (auto cp : codePoints)
+  {
+    glyphMap[cp] = *font->GetGlyph(cp);
+  }
+
+  // Mostly Latin, with some of the rest.
+  std::vector<uint32_t> text;
+  uint32_t seed = 1;
+  for (int i = 0; i < 100000; ++i)
+  {
+    seed = seed * 1664525 + 1013904223;
+    text.push_back(codePoints[(seed >> 8) % (i % 8 == 0 ? codePoints.size() : 0x160)]);
+  }
+
+  const int kPasses = 10;
+  auto measure = [&text](auto fn) {
+    float advance = 0.f;
+    const double ms = TimeMs(kPasses, [&text, &fn, &advance] {
+      for (auto cp : text)
+      {
+        advance += fn(cp)->advance;
+      }
+    });
+    XM_ASSERT_GT(advance, 0.f);
+    return ms;
+  };
+
+  const double mapMs = measure([&glyphMap](uint32_t cp) {
+    return &glyphMap.find(cp)->second;
+  });
+  const double fontMs = measure([&font](uint32_t cp) {
+    return font->GetGlyph(cp);
+  });
+  XR_TRACE(Font, ("%zu lookups: std::map: %.3fms, GetGlyph(): %.3fms, %.2fx",
+    text.size(), mapMs, fontMs, mapMs / fontMs));
+  (void)mapMs;
+  (void)fontMs;
+}
+
+}
@@ -0,0 +1,210 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xm.hpp"
+#include "Benchmark.hpp"
+#include "xr/JsonDocument.hpp"
+#include "xr/JsonReader.hpp"
+#include <cstring>
+#include <memory>
+#include <string>
+
+using namespace xr;
+
+namespace
+{
+
+const char kJson[] = R"({
+  "name": "level01",
+  "size": [ 64, 48 ],
+  "gravity": -9.81,
+  "enabled": true,
+  "parent": null,
+  "empty": {},
+  "spawns": [
+    { "type": "player", "x": 1.5, "y": 2 },
+    { "type": "crate", "x": 10, "y": 2, "tags": [] }
+  ]
+})";
+
+bool Equals(const char* value, const char* expected)
+{
+  return value && std::strncmp(value, expected, strlen(expected)) == 0;
+}
+
+// Checks that the Document has the same structure and values as the Reader's.
+void AssertEqual(JSON::Document::Node const* node, JSON::Entity* entity)
+{
+  XM_ASSERT_EQ(node->GetType(), entity->GetType());
+  switch (node->GetType())
+  {
+  case JSON::VALUE:
+    XM_ASSERT_EQ(node->GetValueSize(), entity->GetValueSize());
+    if (entity->GetValue())
+    {
+      XM_ASSERT_EQ(std::memcmp(node->GetValue(), entity->GetValue(),
+        node->GetValueSize()), 0);
+    }
+    else
+    {
+      XM_ASSERT_EQ(node->GetValue(), nullptr);
+    }
+    break;
+
+  case JSON::OBJECT:
+    XM_ASSERT_EQ(node->GetNumChildren(), entity->GetNumChildren());
+    for (auto child = node->GetFirstChild(); child; child = child->GetNextSibling())
+    {
+      std::string key(child->GetKey(), child->GetKeySize());
+      auto entityChild = entity->GetChild(key.c_str());
+      XM_ASSERT_NE(entityChild, nullptr);
+      AssertEqual(child, entityChild);
+    }
+    break;
+
+  case JSON::ARRAY:
+    XM_ASSERT_EQ(node->GetNumElements(), entity->GetNumElements());
+    for (size_t i = 0; i < node->GetNumElements(); ++i)
+    {
+      AssertEqual(node->GetElement(i), entity->GetElement(i));
+    }
+    break;
+
+  default:
+    XM_ASSERT_TRUE(false);
+  }
+}
+
+XM_TEST(JsonDocument, Basics)
+{
+  JSON::Document doc;
+  XM_ASSERT_EQ(doc.GetRoot(), nullptr);
+  XM_ASSERT_TRUE(doc.Parse(kJson, sizeof(kJson) - 1));
+
+  auto root = doc.GetRoot();
+  XM_ASSERT_NE(root, nullptr);
+  XM_ASSERT_EQ(root->GetType(), JSON::OBJECT);
+  XM_ASSERT_EQ(root->GetNumChildren(), 7u);
+
+  auto name = root->GetChild("name", JSON::VALUE);
+  XM_ASSERT_NE(name, nullptr);
+  XM_ASSERT_EQ(name->GetValueSize(), 7u);
+  XM_ASSERT_TRUE(Equals(name->GetValue(), "level01"));
+  XM_ASSERT_TRUE(name->GetValue() > kJson && name->GetValue() < kJson + sizeof(kJson));  // in place
+
+  XM_ASSERT_EQ(root->GetChild("name", JSON::ARRAY), nullptr);
+  XM_ASSERT_EQ(root->GetChild("nope"), nullptr);
+
+  auto size = root->GetChild("size", JSON::ARRAY);
+  XM_ASSERT_EQ(size->GetNumElements(), 2u);
+  XM_ASSERT_EQ(std::strcmp(size->GetElement(1)->GetValue(), "48"), 0);
+  XM_ASSERT_EQ(size->GetElement(2), nullptr);
+
+  XM_ASSERT_EQ(std::strcmp(root->GetChild("enabled")->GetValue(), "1"), 0);
+  XM_ASSERT_EQ(root->GetChild("parent", JSON::VALUE)->GetValue(), nullptr);
+  XM_ASSERT_EQ(root->GetChild("empty", JSON::OBJECT)->GetFirstChild(), nullptr);
+
+  auto spawns = root->GetChild("spawns", JSON::ARRAY);
+  XM_ASSERT_EQ(spawns->GetNumElements(), 2u);
+  auto crate = spawns->GetElement(1, JSON::OBJECT);
+  XM_ASSERT_TRUE(Equals(crate->GetChild("type")->GetValue(), "crate"));
+  XM_ASSERT_EQ(crate->GetChild("tags")->GetNumElements(), 0u);
+
+  // Same as JSON::Reader.
+  JSON::Reader reader;
+  std::unique_ptr<JSON::Entity> entity(reader.Read(kJson, sizeof(kJson) - 1));
+  AssertEqual(root, entity.get());
+
+  doc.Clear();
+  XM_ASSERT_EQ(doc.GetRoot(), nullptr);
+  XM_ASSERT_EQ(doc.CalculateMemoryUsed(), 0u);
+}
+
+XM_TEST(JsonDocument, InSitu)
+{
+  std::string json(kJson);
+  JSON::Document doc;
+  XM_ASSERT_TRUE(doc.ParseInSitu(&json[0], json.size()));
+
+  auto root = doc.GetRoot();
+  auto name = root->GetChild("name");
+  XM_ASSERT_EQ(std::strcmp(name->GetValue(), "level01"), 0);
+  XM_ASSERT_EQ(std::strcmp(name->GetKey(), "name"), 0);
+
+  auto player = root->GetChild("spawns")->GetElement(0);
+  XM_ASSERT_EQ(std::strcmp(player->GetChild("type")->GetValue(), "player"), 0);
+  XM_ASSERT_EQ(std::strcmp(player->GetChild("x")->GetValue(), "1.5"), 0);
+}
+
+XM_TEST(JsonDocument, Invalid)
+{
+  JSON::Document doc;
+  XM_ASSERT_TRUE(doc.Parse(kJson, sizeof(kJson) - 1));
+
+  const char* invalid[] = {
+    "",
+    "\"string\"",
+    "{ \"a\": 1",
+    "{ \"a\" 1 }",
+    "[ 1, 2, ]",
+    "[ nope ]",
+  };
+  for (auto json : invalid)
+  {
+    XM_ASSERT_FALSE(doc.Parse(json, strlen(json)));
+    XM_ASSERT_EQ(doc.GetRoot(), nullptr);
+  }
+}
+
+std::string GenerateJson(size_t numRecords)
+{
+  std::string json = "{ \"records\": [\n";
+  for (size_t i = 0; i < numRecords; ++i)
+  {
+    json += i > 0 ? ",\n" : "";
+    json += "{ \"id\": " + std::to_string(i) +
+      ", \"name\": \"record" + std::to_string(i) + "\", \"position\": [ " +
+      std::to_string(i * .5) + ", 1.25, -3.75 ], \"visible\": true, " +
+      "\"material\": { \"shader\": \"shaders/default.shd\", \"textures\": [ \"a.png\", \"b.png\" ] } }";
+  }
+  json += "\n] }";
+  return json;
+}
+
+XM_TEST(JsonDocument, ParseBenchmark)
+{
+  if (!IsBenchmarkEnabled())
+  {
+    return;
+  }
+
+  const std::string json = GenerateJson(20000);
+  const int kPasses = 5;
+
+  JSON::Reader reader(8);
+  const double readerMs = TimeMs(kPasses, [&reader, &json] {
+    std::unique_ptr<JSON::Entity> root(reader.Read(json.c_str(), json.size()));
+    XM_ASSERT_NE(root, nullptr);
+  });
+
+  JSON::Document doc(8);
+  const double documentMs = TimeMs(kPasses, [&doc, &json] {
+    XM_ASSERT_TRUE(doc.Parse(json.c_str(), json.size()));
+  });
+  doc.Clear();
+
+  const double mb = json.size() / (1024. * 1024.);
+  XR_TRACE(JsonDocument, ("%.2fMB: Reader: %.3fms (%.1fMB/s), Document: %.3fms (%.1fMB/s), %.2fx",
+    mb, readerMs, mb * 1000. / readerMs, documentMs, mb * 1000. / documentMs,
+    readerMs / documentMs));
+  (void)readerMs;
+  (void)documentMs;
+  (void)mb;
+}
+
+}
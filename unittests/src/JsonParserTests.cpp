@@ -0,0 +1,138 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xm.hpp"
+#include "Benchmark.hpp"
+#include "xr/JsonParser.hpp"
+#include "xr/debug.hpp"
+#include "xr/utils.hpp"
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace xr;
+
+namespace
+{
+
+struct EventLog
+{
+  std::vector<JSON::Parser::Event> events;
+  std::vector<std::string> strings;
+
+  void OnEntity(JSON::Parser::Event e, JSON::Parser::String const* string)
+  {
+    events.push_back(e);
+    if (string && string->string)
+    {
+      strings.emplace_back(string->string, string->length);
+    }
+  }
+};
+
+bool Parse(const char* json, EventLog& log)
+{
+  JSON::Parser parser;
+  return parser.Parse(json, strlen(json),
+    MemberCallback<EventLog, void, JSON::Parser::Event, JSON::Parser::String const*>(
+      log, &EventLog::OnEntity));
+}
+
+XM_TEST(JsonParser, Events)
+{
+  EventLog log;
+  XM_ASSERT_TRUE(Parse("\r\n{ \"a\": [ 1, \"two\" ],\n\t\"b\": {} }", log));
+
+  using E = JSON::Parser::Event;
+  const E expected[] = { E::E_OBJECT_BEGIN, E::E_KEY, E::E_ARRAY_BEGIN, E::E_VALUE,
+    E::E_VALUE, E::E_ARRAY_END, E::E_KEY, E::E_OBJECT_BEGIN, E::E_OBJECT_END,
+    E::E_OBJECT_END };
+  XM_ASSERT_EQ(log.events.size(), XR_ARRAY_SIZE(expected));
+  for (size_t i = 0; i < log.events.size(); ++i)
+  {
+    XM_ASSERT_EQ(log.events[i], expected[i]);
+  }
+
+  const char* strings[] = { "a", "1", "two", "b" };
+  XM_ASSERT_EQ(log.strings.size(), XR_ARRAY_SIZE(strings));
+  for (size_t i = 0; i < log.strings.size(); ++i)
+  {
+    XM_ASSERT_EQ(log.strings[i], strings[i]);
+  }
+}
+
+XM_TEST(JsonParser, EscapedQuotes)
+{
+  EventLog log;
+  XM_ASSERT_TRUE(Parse(R"({ "say \"hi\"": "\"quoted\"", "path": "C:\\", "x": "\\\"" })", log));
+  XM_ASSERT_EQ(log.strings.size(), 6u);
+  XM_ASSERT_EQ(log.strings[0], R"(say \"hi\")");
+  XM_ASSERT_EQ(log.strings[1], R"(\"quoted\")");
+  XM_ASSERT_EQ(log.strings[3], R"(C:\\)");
+  XM_ASSERT_EQ(log.strings[5], R"(\\\")");
+
+  XM_ASSERT_FALSE(Parse(R"({ "a": "unterminated\" })", log));
+}
+
+// Pretty printed, with indentation and longer strings, like level and config
+// files tend to be.
+std::string GenerateJson(size_t numRecords)
+{
+  std::string json = "{\n  \"records\": [\n";
+  for (size_t i = 0; i < numRecords; ++i)
+  {
+    json += i > 0 ? ",\n" : "";
+    json += "    {\n      \"id\": " + std::to_string(i) + ",\n"
+      "      \"name\": \"record number " + std::to_string(i) + "\",\n"
+      "      \"description\": \"A somewhat longer string value, as found in localisation tables.\",\n"
+      "      \"position\": [ 1.25, -3.75, 10 ],\n"
+      "      \"material\": {\n"
+      "        \"shader\": \"shaders/default.shd\",\n"
+      "        \"textures\": [ \"textures/diffuse.png\", \"textures/normal.png\" ]\n"
+      "      }\n"
+      "    }";
+  }
+  json += "\n  ]\n}\n";
+  return json;
+}
+
+XM_TEST(JsonParser, ParseBenchmark)
+{
+  if (!IsBenchmarkEnabled())
+  {
+    return;
+  }
+
+  const std::string json = GenerateJson(20000);
+  const int kPasses = 5;
+
+  struct Counter
+  {
+    size_t numEvents = 0;
+
+    void OnEntity(JSON::Parser::Event, JSON::Parser::String const*)
+    {
+      ++numEvents;
+    }
+  } counter;
+
+  JSON::Parser parser;
+  const double ms = TimeMs(kPasses, [&parser, &json, &counter] {
+    XM_ASSERT_TRUE(parser.Parse(json.c_str(), json.size(),
+      MemberCallback<Counter, void, JSON::Parser::Event, JSON::Parser::String const*>(
+        counter, &Counter::OnEntity)));
+  });
+
+  const double mb = json.size() / (1024. * 1024.);
+  XR_TRACE(JsonParser, ("%.2fMB, %zu events: %.3fms (%.1fMB/s)", mb, counter.numEvents / kPasses,
+    ms, mb * 1000. / ms));
+  (void)ms;
+  (void)mb;
+}
+
+}
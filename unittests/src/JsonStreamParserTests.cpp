@@ -0,0 +1,188 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xm.hpp"
+#include "xr/JsonStreamParser.hpp"
+#include "xr/JsonParser.hpp"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace xr;
+
+namespace
+{
+
+struct EventLog
+{
+  std::vector<std::string> entries;
+
+  void OnEntity(JSON::Parser::Event e, JSON::Parser::String const* string)
+  {
+    std::string entry = std::to_string(int(e));
+    if (string)
+    {
+      entry += string->string ? ":" + std::string(string->string, string->length) : ":null";
+    }
+    entries.push_back(entry);
+  }
+
+  void OnAtMaxDepth(bool entered)
+  {
+    entries.push_back(entered ? "entered" : "left");
+  }
+};
+
+using EntityCallback = MemberCallback<EventLog, void, JSON::Parser::Event,
+  JSON::Parser::String const*>;
+using AtMaxDepthCallback = MemberCallback<EventLog, void, bool>;
+
+bool Parse(const char* json, int maxDepth, EventLog& log)
+{
+  JSON::Parser parser(maxDepth);
+  parser.SetAtMaxDepthCallback(AtMaxDepthCallback(log, &EventLog::OnAtMaxDepth));
+  return parser.Parse(json, strlen(json), EntityCallback(log, &EventLog::OnEntity));
+}
+
+bool StreamParse(const char* json, size_t chunkSize, int maxDepth, EventLog& log,
+  size_t maxTokenSize = JSON::StreamParser::kMaxTokenSizeDefault)
+{
+  JSON::StreamParser parser(maxDepth, maxTokenSize);
+  parser.SetAtMaxDepthCallback(AtMaxDepthCallback(log, &EventLog::OnAtMaxDepth));
+  parser.Start(EntityCallback(log, &EventLog::OnEntity));
+
+  // Feed from a copy of each chunk, which then gets trashed, to make sure that
+  // nothing is kept pointing to it.
+  bool result = true;
+  const size_t size = strlen(json);
+  std::vector<char> chunk;
+  for (size_t i = 0; result && i < size; i += chunkSize)
+  {
+    chunk.assign(json + i, json + std::min(size, i + chunkSize));
+    result = parser.Feed(chunk.data(), chunk.size());
+    std::fill(chunk.begin(), chunk.end(), '#');
+  }
+  return parser.Finish() && result;
+}
+
+const size_t kChunkSizes[] = { 1, 2, 3, 5, 8, 13, 64, 1 << 20 };
+
+XM_TEST(JsonStreamParser, MatchesParser)
+{
+  const char* documents[] = {
+    "{}",
+    " \r\n\t[]",
+    R"({ "a": [ 1, "two", -3.5, 4e2, 0.5e-3, true, false, null ], "b": {} })",
+    R"([ { "say \"hi\"": "\"quoted\"", "path": "C:\\" }, [ [], [ "\\\"" ] ] ] trailing)",
+    "{\r\n  \"nested\": { \"deeper\": { \"deepest\": [ 1, 2, { \"x\": 3 } ] } },\r\n"
+      "  \"after\": \"value\"\r\n}",
+    R"({"long":"lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod"})",
+  };
+
+  for (auto doc : documents)
+  {
+    for (int maxDepth : { 2, JSON::kMaxParseDepthDefault })
+    {
+      EventLog reference;
+      XM_ASSERT_TRUE(Parse(doc, maxDepth, reference));
+
+      for (auto chunkSize : kChunkSizes)
+      {
+        EventLog log;
+        XM_ASSERT_TRUE(StreamParse(doc, chunkSize, maxDepth, log));
+        XM_ASSERT_EQ(log.entries, reference.entries);
+      }
+    }
+  }
+}
+
+XM_TEST(JsonStreamParser, Invalid)
+{
+  const char* documents[] = {
+    "",
+    "  ",
+    R"("string")",
+    R"({ "a": 1, })",
+    R"([ 1, ])",
+    R"({ "a" 1 })",
+    R"({ "a": xyz })",
+    R"([ 1 2 ])",
+    R"({ "a": 1 ])",
+    R"([ 1e-5e ])",
+    R"([ --1 ])",
+    R"({ "a": 1)",
+    R"({ "a": "unterminated\" })",
+  };
+
+  for (auto doc : documents)
+  {
+    EventLog reference;
+    XM_ASSERT_FALSE(Parse(doc, JSON::kMaxParseDepthDefault, reference));
+
+    for (auto chunkSize : kChunkSizes)
+    {
+      EventLog log;
+      XM_ASSERT_FALSE(StreamParse(doc, chunkSize, JSON::kMaxParseDepthDefault, log));
+    }
+  }
+}
+
+XM_TEST(JsonStreamParser, ErrorPosition)
+{
+  const char* doc = "{\r\n  \"a\" 1 }";
+  for (auto chunkSize : kChunkSizes)
+  {
+    EventLog log;
+    JSON::StreamParser parser;
+    parser.Start(EntityCallback(log, &EventLog::OnEntity));
+    for (size_t i = 0; i < strlen(doc) && !parser.HasError(); i += chunkSize)
+    {
+      parser.Feed(doc + i, std::min(strlen(doc) - i, chunkSize));
+    }
+    XM_ASSERT_TRUE(parser.HasError());
+    XM_ASSERT_EQ(parser.GetRow(), 2);
+    XM_ASSERT_EQ(parser.GetColumn(), 7);
+  }
+}
+
+XM_TEST(JsonStreamParser, MaxTokenSize)
+{
+  const size_t kMaxTokenSize = 16;
+  for (auto chunkSize : kChunkSizes)
+  {
+    EventLog log;
+    XM_ASSERT_TRUE(StreamParse(R"({ "0123456789abcdef": [ "0123456789abcdef" ] })",
+      chunkSize, JSON::kMaxParseDepthDefault, log, kMaxTokenSize));
+    XM_ASSERT_FALSE(StreamParse(R"({ "0123456789abcdefg": 0 })", chunkSize,
+      JSON::kMaxParseDepthDefault, log, kMaxTokenSize));
+    XM_ASSERT_FALSE(StreamParse(R"([ "0123456789abcdefg" ])", chunkSize,
+      JSON::kMaxParseDepthDefault, log, kMaxTokenSize));
+  }
+}
+
+XM_TEST(JsonStreamParser, Restart)
+{
+  JSON::StreamParser parser;
+  EventLog log;
+  parser.Start(EntityCallback(log, &EventLog::OnEntity));
+  XM_ASSERT_FALSE(parser.Feed("{ x", 3));
+  XM_ASSERT_FALSE(parser.Feed("}", 1));
+  XM_ASSERT_FALSE(parser.Finish());
+
+  log.entries.clear();
+  parser.Start(EntityCallback(log, &EventLog::OnEntity));
+  XM_ASSERT_TRUE(parser.Feed("[ 1", 3));
+  XM_ASSERT_FALSE(parser.IsComplete());
+  XM_ASSERT_TRUE(parser.Feed(" ]", 2));
+  XM_ASSERT_TRUE(parser.IsComplete());
+  XM_ASSERT_TRUE(parser.Finish());
+  XM_ASSERT_EQ(log.entries.size(), 3u);
+}
+
+}
@@ -9,10 +9,13 @@
 #include "xm.hpp"
 #include "FileLifeCycleManager.hpp"
 #include "xr/File.hpp"
+#include "xr/FileBuffer.hpp"
 #include "xr/jsonutils.hpp"
 #include "xr/JsonReader.hpp"
 #include "xr/memory/ScopeGuard.hpp"
 #include "xr/debug.hpp"
+#include <string>
+#include <vector>
 
 using namespace xr;
 
@@ -77,4 +80,72 @@ XM_TEST_F(JsonUtils, LoadJson)
   XM_ASSERT_EQ(object->GetNumChildren(), 0u);
 }
 
+struct EventLog
+{
+  std::vector<std::string> entries;
+
+  void OnEntity(JSON::Parser::Event e, JSON::Parser::String const* string)
+  {
+    entries.push_back(std::to_string(int(e)) +
+      (string && string->string ? std::string(string->string, string->length) : ""));
+  }
+};
+
+XM_TEST_F(JsonUtils, StreamJson)
+{
+  using EntityCallback = MemberCallback<EventLog, void, JSON::Parser::Event,
+    JSON::Parser::String const*>;
+
+  FileBuffer file;
+  XM_ASSERT_TRUE(file.Open("loadjson.json"));
+
+  EventLog reference;
+  JSON::Parser parser(3);
+  XM_ASSERT_TRUE(parser.Parse(file.CastData<char>(), file.GetSize(),
+    EntityCallback(reference, &EventLog::OnEntity)));
+
+  for (size_t chunkSize : { 1, 7, 4096 })
+  {
+    auto hFile = File::Open("loadjson.json", "rb");
+    XM_ASSERT_NE(hFile, nullptr);
+    auto closeGuard = MakeScopeGuard([hFile]() {
+      File::Close(hFile);
+    });
+
+    EventLog log;
+    JSON::StreamParser streamParser(3);
+    streamParser.Start(EntityCallback(log, &EventLog::OnEntity));
+    XM_ASSERT_TRUE(StreamJSON(hFile, streamParser, chunkSize));
+    XM_ASSERT_EQ(log.entries, reference.entries);
+  }
+}
+
+XM_TEST_F(JsonUtils, JsonFileSink)
+{
+  FilePath path(File::kRawProto + File::GetRamPath() / "jsonfilesink.json");
+  {
+    FileWriter file;
+    XM_ASSERT_TRUE(file.Open(path, FileWriter::Mode::Truncate, false));
+
+    JsonFileSink sink(file);
+    JSON::Writer writer(sink);
+    auto root = writer.OpenObject();
+    auto array = root.OpenArray("values");
+    for (int i = 0; i < 10000; ++i)
+    {
+      array.WriteValue(i);
+    }
+  }
+
+  auto json = LoadJSON(path.c_str(), 2, false);
+  XM_ASSERT_NE(json, nullptr);
+  auto deleteGuard = MakeScopeGuard([json]() {
+    delete json;
+  });
+  auto values = json->GetChild("values");
+  XM_ASSERT_NE(values, nullptr);
+  XM_ASSERT_EQ(values->GetNumElements(), 10000u);
+  XM_ASSERT_STREQ(values->GetElement(9999)->GetValue(), "9999");
+}
+
 }
@@ -0,0 +1,284 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xm.hpp"
+#include "Benchmark.hpp"
+#include "xr/JsonWriter.hpp"
+#include "xr/JsonParser.hpp"
+#include "xr/debug.hpp"
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace xr;
+
+namespace
+{
+
+std::string GetOutput(JSON::Writer const& writer)
+{
+  return std::string(writer.GetData(), writer.GetSize());
+}
+
+void WriteDocument(JSON::Writer& writer)
+{
+  auto root = writer.OpenObject();
+  root.WriteValue("int", 17753623)
+    .WriteValue("negative", -2147483647 - 1)
+    .WriteValue("double", 0.2754182963)
+    .WriteValue("big", 1.5e300)
+    .WriteValue("whole", 3.0)
+    .WriteValue("bool", true)
+    .WriteValue("string", "lorem ipsum")
+    .WriteValue("null", static_cast<const char*>(nullptr));
+
+  auto array = root.OpenArray("array", true);
+  array.WriteValue(false).WriteValue(-1).WriteValue(0.5).WriteValue("a\tb");
+  array.OpenObject(true).WriteValue("x", 1);
+}
+
+XM_TEST(JsonWriter, Basics)
+{
+  JSON::Writer writer;
+  WriteDocument(writer);
+  XM_ASSERT_EQ(GetOutput(writer), "{\"int\":17753623,\"negative\":-2147483648,"
+    "\"double\":0.275418,\"big\":1.5e+300,\"whole\":3,\"bool\":true,"
+    "\"string\":\"lorem ipsum\",\"null\":null,\"array\":[false,-1,0.5,\"a\tb\",{\"x\":1}]}");
+
+  // Same as std::ostream's formatting.
+  std::ostringstream stream;
+  stream << 0.2754182963 << ',' << 1.5e300 << ',' << 3.0;
+  XM_ASSERT_EQ(stream.str(), "0.275418,1.5e+300,3");
+}
+
+XM_TEST(JsonWriter, Formatting)
+{
+  JSON::Writer writer;
+  writer.SetIndent("  ");
+  writer.SetLinebreaks(true);
+  writer.SetSpaces(true);
+  {
+    auto root = writer.OpenObject();
+    root.WriteValue("a", 1);
+    root.OpenArray("b", true).WriteValue(2).WriteValue(3);
+    root.OpenObject("c").WriteValue("d", "e");
+  }
+  XM_ASSERT_EQ(GetOutput(writer), "{\n"
+    "  \"a\": 1,\n"
+    "  \"b\": [ 2, 3 ],\n"
+    "  \"c\": {\n"
+    "    \"d\": \"e\"\n"
+    "  }\n"
+    "}");
+}
+
+XM_TEST(JsonWriter, AutoEscape)
+{
+  JSON::Writer writer;
+  writer.SetAutoEscape(true);
+  {
+    auto root = writer.OpenArray();
+    root.WriteValue("tab\there\nnewline \"quoted\" C:\\path/file\r\b\f");
+    root.OpenObject().WriteValue("key\"", "plain");
+  }
+  XM_ASSERT_EQ(GetOutput(writer),
+    R"(["tab\there\nnewline \"quoted\" C:\\path\/file\r\b\f",{"key\"":"plain"}])");
+}
+
+class VectorSink: public JSON::Writer::Sink
+{
+public:
+  std::vector<size_t> writes;
+  std::string output;
+
+  bool Write(char const* data, size_t size) override
+  {
+    writes.push_back(size);
+    output.append(data, size);
+    return true;
+  }
+};
+
+void WriteRecords(JSON::Writer& writer, int numRecords)
+{
+  auto root = writer.OpenObject();
+  auto records = root.OpenArray("records");
+  for (int i = 0; i < numRecords; ++i)
+  {
+    auto record = records.OpenObject();
+    record.WriteValue("id", i)
+      .WriteValue("name", "record")
+      .WriteValue("description", "A somewhat longer string value, as found in save games.")
+      .WriteValue("alive", i % 2 == 0);
+    record.OpenArray("position", true)
+      .WriteValue(i * 1.25)
+      .WriteValue(-3.75)
+      .WriteValue(i / 7.0);
+  }
+}
+
+// Writes what WriteRecords() does, with the default settings, the way that
+// JSON::Writer used to: formatting every token straight into a std::ostream.
+// MatchesStreamFormatting checks the output against it, and it is the baseline
+// for SerializationBenchmark.
+void WriteRecordsToStream(std::ostream& stream, int numRecords)
+{
+  auto writeKey = [&stream](char const* key) {
+    stream.put('"');
+    stream << key;
+    stream.put('"').put(':');
+  };
+
+  stream.put('{');
+  writeKey("records");
+  stream.put('[');
+  for (int i = 0; i < numRecords; ++i)
+  {
+    if (i > 0)
+    {
+      stream.put(',');
+    }
+    stream.put('{');
+    writeKey("id");
+    stream << i;
+    stream.put(',');
+    writeKey("name");
+    ((stream.put('"')) << "record").put('"');
+    stream.put(',');
+    writeKey("description");
+    ((stream.put('"')) << "A somewhat longer string value, as found in save games.").put('"');
+    stream.put(',');
+    writeKey("alive");
+    stream << std::boolalpha << (i % 2 == 0) << std::noboolalpha;
+    stream.put(',');
+    writeKey("position");
+    stream.put('[');
+    stream << i * 1.25;
+    stream.put(',');
+    stream << -3.75;
+    stream.put(',');
+    stream << i / 7.0;
+    stream.put(']');
+    stream.put('}');
+  }
+  stream.put(']');
+  stream.put('}');
+}
+
+XM_TEST(JsonWriter, Destinations)
+{
+  const int kNumRecords = 1000;
+  JSON::Writer memoryWriter;
+  memoryWriter.SetLinebreaks(true);
+  memoryWriter.SetIndent("\t");
+  WriteRecords(memoryWriter, kNumRecords);
+  const std::string output = GetOutput(memoryWriter);
+
+  // Sinks get the same output, in blocks of bounded size.
+  VectorSink sink;
+  JSON::Writer sinkWriter(sink);
+  sinkWriter.SetLinebreaks(true);
+  sinkWriter.SetIndent("\t");
+  WriteRecords(sinkWriter, kNumRecords);
+  XM_ASSERT_EQ(sinkWriter.GetSize(), 0u);
+  XM_ASSERT_EQ(sink.output, output);
+  XM_ASSERT_TRUE(sink.writes.size() > 1);
+  for (auto size : sink.writes)
+  {
+    XM_ASSERT_TRUE(size < JSON::Writer::kFlushSize + 256);
+  }
+
+  // So do streams.
+  std::ostringstream stream;
+  JSON::Writer streamWriter(stream);
+  streamWriter.SetLinebreaks(true);
+  streamWriter.SetIndent("\t");
+  WriteRecords(streamWriter, kNumRecords);
+  XM_ASSERT_EQ(stream.str(), output);
+
+  // Reuse
+  streamWriter.Reset();
+  WriteRecords(streamWriter, 1);
+  XM_ASSERT_TRUE(streamWriter.GetSize() > 0);
+  XM_ASSERT_EQ(stream.str(), output);
+
+  // The output is valid.
+  JSON::Parser parser;
+  struct Counter
+  {
+    size_t numValues = 0;
+
+    void OnEntity(JSON::Parser::Event e, JSON::Parser::String const*)
+    {
+      numValues += e == JSON::Parser::E_VALUE;
+    }
+  } counter;
+  XM_ASSERT_TRUE(parser.Parse(output.c_str(), output.size(),
+    MemberCallback<Counter, void, JSON::Parser::Event, JSON::Parser::String const*>(
+      counter, &Counter::OnEntity)));
+  XM_ASSERT_EQ(counter.numValues, kNumRecords * 7u);
+}
+
+XM_TEST(JsonWriter, MatchesStreamFormatting)
+{
+  const int kNumRecords = 100;
+  std::ostringstream legacyStream;
+  WriteRecordsToStream(legacyStream, kNumRecords);
+
+  JSON::Writer writer;
+  WriteRecords(writer, kNumRecords);
+  XM_ASSERT_EQ(GetOutput(writer), legacyStream.str());
+}
+
+XM_TEST(JsonWriter, SerializationBenchmark)
+{
+  if (!IsBenchmarkEnabled())
+  {
+    return;
+  }
+
+  const int kNumRecords = 20000;
+  const int kPasses = 5;
+
+  auto benchmark = [](JSON::Writer& writer, auto reset) {
+    return TimeMs(kPasses, [&writer, &reset] {
+      reset();
+      WriteRecords(writer, kNumRecords);
+    });
+  };
+
+  JSON::Writer memoryWriter;
+  const double memoryMs = benchmark(memoryWriter, [&memoryWriter]() {
+    memoryWriter.Reset();
+  });
+  const double mb = memoryWriter.GetSize() / (1024. * 1024.);
+
+  std::ostringstream stream;
+  JSON::Writer streamWriter(stream);
+  const double streamMs = benchmark(streamWriter, [&streamWriter, &stream]() {
+    stream.str(std::string());
+    streamWriter.Reset(stream);
+  });
+
+  // The previous implementation, which formatted each token with std::ostream.
+  std::ostringstream legacyStream;
+  const double legacyMs = TimeMs(kPasses, [&legacyStream] {
+    legacyStream.str(std::string());
+    WriteRecordsToStream(legacyStream, kNumRecords);
+  });
+
+  XR_TRACE(JsonWriter, ("%.2fMB: memory: %.3fms (%.1fMB/s), std::ostringstream: %.3fms (%.1fMB/s), "
+    "std::ostream formatting: %.3fms (%.1fMB/s), %.2fx", mb, memoryMs, mb * 1000. / memoryMs,
+    streamMs, mb * 1000. / streamMs, legacyMs, mb * 1000. / legacyMs, legacyMs / streamMs));
+  (void)memoryMs;
+  (void)streamMs;
+  (void)legacyMs;
+  (void)mb;
+}
+
+}
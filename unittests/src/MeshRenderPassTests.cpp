@@ -0,0 +1,258 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xm.hpp"
+#include "HeadlessGfx.hpp"
+#include "xr/MeshRenderPass.hpp"
+#include "xr/MeshRenderer.hpp"
+#include "xr/Camera.hpp"
+#include "xr/Mesh.hpp"
+#include "xr/Shader.hpp"
+#include "xr/Transforms.hpp"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace xr;
+
+namespace
+{
+
+struct Fixture
+{
+  Entity viewer;
+  Camera* camera;
+  std::vector<std::unique_ptr<Entity>> entities;
+
+  Fixture()
+  : viewer(nullptr),
+    camera(viewer.AddComponent<Camera>())
+  {
+    // Looking down -Z; near: 10, far: 1000.
+    camera->SetPerspective(float(kPi * .5f), 1.f, 10.f, 1000.f);
+  }
+
+  MeshRenderer* Add(Vector3 const& position, Mesh& mesh, Material::Ptr const& material,
+    float radius = 1.f)
+  {
+    entities.emplace_back(new Entity(nullptr));
+    entities.back()->SetTranslation(position);
+
+    auto r = entities.back()->AddComponent<MeshRenderer>();
+    r->SetMesh(&mesh);
+    r->material = material;
+    r->SetBounds(Vector3::Zero(), radius);
+    return r;
+  }
+};
+
+Material::Ptr MakeMaterial()
+{
+  return Material::Ptr(Material::Create(0, Asset::UnmanagedFlag));
+}
+
+Shader::Ptr MakeShader()
+{
+  char const source[] = "void main() {}";
+  ShaderComponent::Ptr vertex(ShaderComponent::Create(0, Asset::UnmanagedFlag));
+  vertex->SetSource(Gfx::ShaderType::Vertex, source);
+  ShaderComponent::Ptr fragment(ShaderComponent::Create(0, Asset::UnmanagedFlag));
+  fragment->SetSource(Gfx::ShaderType::Fragment, source);
+
+  Shader::Ptr shader(Shader::Create(0, Asset::UnmanagedFlag));
+  shader->SetComponents(vertex, fragment);
+  return shader;
+}
+
+size_t CountRecords(std::vector<Gfx::CommandRecord> const& records,
+  Gfx::CommandRecord::Type type)
+{
+  return std::count_if(records.begin(), records.end(),
+    [type](Gfx::CommandRecord const& r) {
+      return r.type == type;
+    });
+}
+
+XM_TEST(MeshRenderPass, WorldBounds)
+{
+  Entity e(nullptr);
+  auto r = e.AddComponent<MeshRenderer>();
+  XM_ASSERT_FALSE(r->HasBounds());
+
+  r->SetBounds(Vector3(1.f, 0.f, 0.f), 2.f);
+  XM_ASSERT_TRUE(r->HasBounds());
+
+  Vector3 center;
+  float radius;
+  r->GetWorldBounds(center, radius);
+  XM_ASSERT_EQ(center.x, 1.f);
+  XM_ASSERT_EQ(center.y, 0.f);
+  XM_ASSERT_EQ(radius, 2.f);
+
+  // Changes to the transform are picked up.
+  e.SetTranslation(Vector3(0.f, 5.f, 0.f));
+  e.SetScale(Vector3(1.f, 3.f, 2.f));
+  r->GetWorldBounds(center, radius);
+  XM_ASSERT_EQ(center.x, 1.f);
+  XM_ASSERT_EQ(center.y, 5.f);
+  XM_ASSERT_EQ(radius, 6.f);
+}
+
+XM_TEST(MeshRenderPass, Culling)
+{
+  Fixture f;
+  Mesh mesh;
+  auto material = MakeMaterial();
+
+  auto front = f.Add(Vector3(0.f, 0.f, -100.f), mesh, material);
+  auto behind = f.Add(Vector3(0.f, 0.f, 100.f), mesh, material);
+  f.Add(Vector3(0.f, 0.f, -2000.f), mesh, material);  // past far
+  f.Add(Vector3(500.f, 0.f, -100.f), mesh, material);  // right
+  f.Add(Vector3(0.f, -500.f, -100.f), mesh, material);  // below
+  auto overlapping = f.Add(Vector3(0.f, 0.f, -5.f), mesh, material, 10.f); // near plane
+  auto partial = f.Add(Vector3(105.f, 0.f, -100.f), mesh, material, 10.f); // right edge
+  auto unbounded = f.Add(Vector3(0.f, 0.f, 100.f), mesh, material, -1.f);
+  f.Add(Vector3(0.f, 0.f, -100.f), mesh, Material::Ptr());  // no material
+
+  MeshRenderPass pass;
+  pass.Cull(*f.camera);
+
+  auto& stats = pass.GetStats();
+  XM_ASSERT_EQ(stats.numRenderers, 8u);
+  XM_ASSERT_EQ(stats.numVisible, 4u);
+  XM_ASSERT_EQ(pass.GetNumVisible(), 4u);
+  XM_ASSERT_EQ(pass.GetVisible(0), front);
+  XM_ASSERT_EQ(pass.GetVisible(1), overlapping);
+  XM_ASSERT_EQ(pass.GetVisible(2), partial);
+  XM_ASSERT_EQ(pass.GetVisible(3), unbounded);
+
+  // Turning the viewer around.
+  f.viewer.SetRotation(Quaternion::FromAxisAngle(Vector3::UnitY(), float(kPi)));
+  pass.Cull(*f.camera);
+  XM_ASSERT_EQ(pass.GetNumVisible(), 2u);
+  XM_ASSERT_EQ(pass.GetVisible(0), behind);
+  XM_ASSERT_EQ(pass.GetVisible(1), unbounded);
+}
+
+XM_TEST(MeshRenderPass, Batching)
+{
+  Fixture f;
+  Mesh meshes[2];
+  Material::Ptr materials[] = { MakeMaterial(), MakeMaterial() };
+
+  // Interleave materials and meshes; 3 of each combination.
+  for (int i = 0; i < 12; ++i)
+  {
+    f.Add(Vector3(float(i), 0.f, -100.f), meshes[(i / 2) % 2], materials[i % 2]);
+  }
+
+  MeshRenderPass pass;
+  pass.Cull(*f.camera);
+  XM_ASSERT_EQ(pass.GetNumVisible(), 12u);
+  XM_ASSERT_EQ(pass.GetStats().numDrawCalls, 12u);
+  XM_ASSERT_EQ(pass.GetStats().numInstanced, 0u);
+
+  // Sorted by material, then mesh, i.e. into 4 runs of 3.
+  for (size_t i = 0; i < pass.GetNumVisible(); i += 3)
+  {
+    auto first = pass.GetVisible(i);
+    for (size_t j = i + 1; j < i + 3; ++j)
+    {
+      XM_ASSERT_EQ(pass.GetVisible(j)->material.Get(), first->material.Get());
+      XM_ASSERT_EQ(pass.GetVisible(j)->GetMesh(), first->GetMesh());
+    }
+  }
+  XM_ASSERT_EQ(pass.GetVisible(0)->material.Get(), pass.GetVisible(3)->material.Get());
+  XM_ASSERT_NE(pass.GetVisible(0)->GetMesh(), pass.GetVisible(3)->GetMesh());
+
+  // Instance the first material: its two runs are drawn in one call each.
+  pass.SetInstancedMaterial(materials[0], MakeMaterial());
+  pass.Cull(*f.camera);
+  XM_ASSERT_EQ(pass.GetStats().numDrawCalls, 8u);
+  XM_ASSERT_EQ(pass.GetStats().numInstanced, 6u);
+
+  // Runs of a single renderer aren't instanced.
+  f.entities.erase(f.entities.begin() + 4, f.entities.begin() + 10);
+  pass.Cull(*f.camera);
+  XM_ASSERT_EQ(pass.GetNumVisible(), 6u);
+  XM_ASSERT_EQ(pass.GetStats().numDrawCalls, 5u);
+  XM_ASSERT_EQ(pass.GetStats().numInstanced, 2u);
+
+  pass.SetInstancedMaterial(materials[0], Material::Ptr());
+  pass.Cull(*f.camera);
+  XM_ASSERT_EQ(pass.GetStats().numDrawCalls, 6u);
+  XM_ASSERT_EQ(pass.GetStats().numInstanced, 0u);
+}
+
+XM_TEST(MeshRenderPass, InstancedMaterialReferences)
+{
+  Fixture f;
+  auto material = MakeMaterial();
+  const int refCount = material->GetRefCount();
+
+  // The mapping holds on to the material, so that no other one may take its
+  // address while it's mapped.
+  MeshRenderPass pass;
+  pass.SetInstancedMaterial(material, MakeMaterial());
+  XM_ASSERT_EQ(material->GetRefCount(), refCount + 1);
+
+  pass.SetInstancedMaterial(material, Material::Ptr());
+  XM_ASSERT_EQ(material->GetRefCount(), refCount);
+}
+
+XM_TEST(MeshRenderPass, Rendering)
+{
+  HeadlessGfx gfx;
+  Transforms::Init();
+  {
+    Fixture f;
+    Mesh mesh;
+    Gfx::VertexFormat format;
+    format.Add(Gfx::Attribute::Position, 3, false);
+    auto hFormat = Gfx::RegisterVertexFormat(format);
+    float vertices[3 * 3] = {};
+    mesh.hVertexBuffer = Gfx::CreateVertexBuffer(hFormat, Buffer::FromArray(vertices));
+    mesh.numVertices = 3;
+    Gfx::Release(hFormat);
+
+    auto shader = MakeShader();
+    Material::Ptr materials[] = { MakeMaterial(), MakeMaterial(), MakeMaterial() };
+    for (auto& m : materials)
+    {
+      m->SetShader(shader);
+    }
+
+    for (int i = 0; i < 5; ++i)
+    {
+      f.Add(Vector3(float(i), 0.f, -100.f), mesh, materials[0]);
+      f.Add(Vector3(float(i), 0.f, -100.f), mesh, materials[1]);
+    }
+    f.Add(Vector3(0.f, 0.f, 100.f), mesh, materials[0]);  // culled
+
+    MeshRenderPass pass;
+    pass.SetInstancedMaterial(materials[0], materials[2]);
+    pass.Cull(*f.camera);
+
+    Gfx::StartRecording();
+    pass.Render();
+    Gfx::Flush();
+    auto records = Gfx::StopRecording();
+
+    using Type = Gfx::CommandRecord::Type;
+    XM_ASSERT_EQ(CountRecords(records, Type::Draw), pass.GetStats().numDrawCalls);
+    XM_ASSERT_EQ(CountRecords(records, Type::Draw), 6u);
+    XM_ASSERT_EQ(CountRecords(records, Type::CreateInstanceDataBuffer), 1u);
+    XM_ASSERT_EQ(CountRecords(records, Type::SetInstanceData), 1u);
+    XM_ASSERT_EQ(CountRecords(records, Type::ReleaseInstanceDataBuffer), 1u);
+
+    // Materials are applied once per batch, rather than per renderer.
+    XM_ASSERT_EQ(CountRecords(records, Type::SetState), 2u);
+  }
+}
+
+}
@@ -0,0 +1,155 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xm.hpp"
+#include "xr/strings/ParserCore.hpp"
+#include <cctype>
+#include <random>
+#include <string>
+
+using namespace xr;
+
+namespace
+{
+
+// Character by character reference of the scanning that ParserCore does.
+struct Reference
+{
+  const char* p;
+  const char* end;
+  int row = 1;
+  int column = 1;
+
+  void Skip()
+  {
+    if (p != end)
+    {
+      const bool isCR = *p == '\r';
+      if (isCR && p + 1 != end && p[1] == '\n')
+      {
+        ++p;
+      }
+
+      if (isCR || *p == '\n')
+      {
+        ++row;
+        column = 1;
+      }
+      else
+      {
+        ++column;
+      }
+      ++p;
+    }
+  }
+
+  void Expect()
+  {
+    while (p != end && isspace(*p))
+    {
+      Skip();
+    }
+  }
+
+  void Require(char c)
+  {
+    while (p != end && *p != c)
+    {
+      Skip();
+    }
+  }
+};
+
+void AssertSame(ParserCore const& pc, Reference const& ref)
+{
+  XM_ASSERT_EQ(pc.GetChar(), ref.p);
+  XM_ASSERT_EQ(pc.GetRow(), ref.row);
+  XM_ASSERT_EQ(pc.GetColumn(), ref.column);
+}
+
+XM_TEST(ParserCore, Basics)
+{
+  const char text[] = "  \t{\r\n  \"key\"\r: \n\n\"value\" }";
+  ParserCore pc;
+  pc.SetBuffer(text, sizeof(text) - 1);
+  XM_ASSERT_EQ(pc.GetRow(), 1);
+  XM_ASSERT_EQ(pc.GetColumn(), 1);
+
+  XM_ASSERT_EQ(*pc.ExpectChar(), '{');
+  XM_ASSERT_EQ(pc.GetColumn(), 4);
+
+  pc.SkipChar();
+  XM_ASSERT_EQ(*pc.ExpectChar(), '\"');
+  XM_ASSERT_EQ(pc.GetRow(), 2);
+  XM_ASSERT_EQ(pc.GetColumn(), 3);
+
+  pc.SkipChar();
+  XM_ASSERT_EQ(*pc.RequireChar(':'), ':');
+  XM_ASSERT_EQ(pc.GetRow(), 3);
+  XM_ASSERT_EQ(pc.GetColumn(), 1);
+
+  pc.SkipChar();
+  XM_ASSERT_EQ(pc.RequireChar('x'), text + sizeof(text) - 1);
+  XM_ASSERT_TRUE(pc.IsOver(pc.GetChar()));
+  XM_ASSERT_EQ(pc.GetRow(), 5);
+  XM_ASSERT_EQ(pc.GetColumn(), 10);
+}
+
+XM_TEST(ParserCore, MatchesReference)
+{
+  // Long runs of whitespace and text, with all sorts of line breaks, to
+  // exercise chunk boundaries.
+  const char kChars[] = { ' ', ' ', '\t', '\r', '\n', 'a', 'b', '\"', ':' };
+  std::mt19937 rng(1);
+  for (int i = 0; i < 200; ++i)
+  {
+    std::string text;
+    const size_t size = rng() % 300;
+    while (text.size() < size)
+    {
+      const char c = kChars[rng() % sizeof(kChars)];
+      text.append(rng() % 4 == 0 ? rng() % 40 : 1, c);
+      if (rng() % 8 == 0)
+      {
+        text += "\r\n";
+      }
+    }
+
+    ParserCore pc;
+    pc.SetBuffer(text.c_str(), text.size() > 0 ? text.size() : 1);
+    Reference ref{ text.c_str(), text.c_str() + (text.size() > 0 ? text.size() : 1) };
+    while (!pc.IsOver(pc.GetChar()))
+    {
+      switch (rng() % 4)
+      {
+      case 0:
+        pc.ExpectChar();
+        ref.Expect();
+        break;
+
+      case 1:
+        pc.RequireChar('\"');
+        ref.Require('\"');
+        break;
+
+      case 2:
+        pc.RequireChar(':');
+        ref.Require(':');
+        break;
+
+      case 3:
+        pc.SkipChar();
+        ref.Skip();
+        break;
+      }
+      AssertSame(pc, ref);
+    }
+  }
+}
+
+}
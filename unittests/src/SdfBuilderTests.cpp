@@ -0,0 +1,262 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xm.hpp"
+#include "Benchmark.hpp"
+#include "SdfBuilder.hpp"
+#include "xr/threading/TaskScheduler.hpp"
+#include "xr/math/mathutils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace xr;
+
+namespace
+{
+
+// A bitmap with a 1 pixel padding around it, which SdfBuilder reads.
+struct Bitmap
+{
+  Px width;
+  Px height;
+  std::vector<uint8_t> pixels;
+
+  Bitmap(Px w, Px h)
+  : width(w),
+    height(h),
+    pixels((w + 2) * (h + 2), 0)
+  {}
+
+  Px GetPitch() const
+  {
+    return width + 2;
+  }
+
+  uint8_t* GetData()
+  {
+    return pixels.data() + GetPitch() + 1;
+  }
+
+  void Set(int x, int y, uint8_t value)
+  {
+    if (x >= 0 && x < width && y >= 0 && y < height)
+    {
+      GetData()[x + y * GetPitch()] = value;
+    }
+  }
+};
+
+// Some thick strokes and a hollow disc, like glyphs have.
+Bitmap MakeGlyph(Px w, Px h, std::mt19937& rng)
+{
+  Bitmap bitmap(w, h);
+  std::uniform_real_distribution<float> coord(0.f, 1.f);
+  std::uniform_int_distribution<int> value(1, 3);
+  const float size = float(std::min(w, h));
+  for (int i = 0; i < 3; ++i)
+  {
+    const float x0 = coord(rng) * w;
+    const float y0 = coord(rng) * h;
+    const float x1 = coord(rng) * w;
+    const float y1 = coord(rng) * h;
+    const float radius = size * (.03f + coord(rng) * .05f);
+    const uint8_t v = uint8_t(value(rng) * 85);
+    const float steps = std::max(std::abs(x1 - x0), std::abs(y1 - y0));
+    for (float s = 0.f; s <= steps; s += .5f)
+    {
+      const float cx = x0 + (x1 - x0) * s / steps;
+      const float cy = y0 + (y1 - y0) * s / steps;
+      for (int y = int(cy - radius); y <= int(cy + radius); ++y)
+      {
+        for (int x = int(cx - radius); x <= int(cx + radius); ++x)
+        {
+          if ((x - cx) * (x - cx) + (y - cy) * (y - cy) <= radius * radius)
+          {
+            bitmap.Set(x, y, v);
+          }
+        }
+      }
+    }
+  }
+
+  const float cx = coord(rng) * w;
+  const float cy = coord(rng) * h;
+  const float outer = size * .3f;
+  const float inner = outer * .6f;
+  for (int y = 0; y < h; ++y)
+  {
+    for (int x = 0; x < w; ++x)
+    {
+      const float d = std::sqrt((x - cx) * (x - cx) + (y - cy) * (y - cy));
+      if (d <= outer && d >= inner)
+      {
+        bitmap.Set(x, y, 0xff);
+      }
+    }
+  }
+  return bitmap;
+}
+
+// Brute force distances to the closest border points, scaled the same way.
+std::vector<uint8_t> MakeReference(Bitmap& bitmap, Px fieldSize)
+{
+  const int pitch = bitmap.GetPitch();
+  uint8_t const* pixels = bitmap.GetData();
+  std::vector<std::pair<int, int>> borderPoints;
+  for (int y = 0; y < bitmap.height; ++y)
+  {
+    for (int x = 0; x < bitmap.width; ++x)
+    {
+      auto p = pixels + x + y * pitch;
+      if (p[-1] != *p || p[1] != *p || p[-pitch] != *p || p[pitch] != *p)
+      {
+        borderPoints.push_back({ x, y });
+      }
+    }
+  }
+
+  const float scale = fieldSize;
+  std::vector<uint8_t> result(bitmap.width * bitmap.height);
+  for (int y = 0; y < bitmap.height; ++y)
+  {
+    for (int x = 0; x < bitmap.width; ++x)
+    {
+      float d = std::numeric_limits<float>::max();
+      if (!borderPoints.empty())
+      {
+        int64_t dSqr = std::numeric_limits<int64_t>::max();
+        for (auto& b : borderPoints)
+        {
+          const int64_t dx = x - b.first;
+          const int64_t dy = y - b.second;
+          dSqr = std::min(dSqr, dx * dx + dy * dy);
+        }
+        d = std::sqrt(float(dSqr));
+      }
+
+      if (pixels[x + y * pitch] == 0)
+      {
+        d = -d;
+      }
+
+      d = Clamp(Clamp(d, -scale, scale) * (128.0f / scale), -127.0f, 128.0f);
+      result[x + y * bitmap.width] = uint8_t(d + 127.0f);
+    }
+  }
+  return result;
+}
+
+std::vector<uint8_t> Generate(SdfBuilder& sdf, Bitmap& bitmap)
+{
+  sdf.Generate(bitmap.GetData(), bitmap.GetPitch(), bitmap.width, bitmap.height);
+
+  std::vector<uint8_t> result(bitmap.width * bitmap.height);
+  sdf.ConvertToBitmap(bitmap.width, bitmap.height, result.data());
+  return result;
+}
+
+XM_TEST(SdfBuilder, ExactMatchesReference)
+{
+  std::mt19937 rng(1);
+  for (Px fieldSize : { 3, 8, 200 })
+  {
+    SdfBuilder sdf(96, fieldSize, SdfBuilder::Method::Exact);
+    for (auto size : { std::make_pair(96, 96), std::make_pair(37, 81),
+      std::make_pair(64, 1), std::make_pair(1, 50) })
+    {
+      for (int i = 0; i < 10; ++i)
+      {
+        auto bitmap = MakeGlyph(Px(size.first), Px(size.second), rng);
+        XM_ASSERT_EQ(Generate(sdf, bitmap), MakeReference(bitmap, fieldSize));
+      }
+    }
+
+    // No border points.
+    Bitmap empty(20, 10);
+    XM_ASSERT_EQ(Generate(sdf, empty), MakeReference(empty, fieldSize));
+    XM_ASSERT_EQ(Generate(sdf, empty)[0], 0);
+  }
+}
+
+XM_TEST(SdfBuilder, PropagationApproximatesExact)
+{
+  const Px kFieldSize = 8;
+  SdfBuilder exact(96, kFieldSize, SdfBuilder::Method::Exact);
+  SdfBuilder propagation(96, kFieldSize, SdfBuilder::Method::Propagation);
+  std::mt19937 rng(2);
+  for (int i = 0; i < 10; ++i)
+  {
+    auto bitmap = MakeGlyph(96, 96, rng);
+    auto exactField = Generate(exact, bitmap);
+    auto propagationField = Generate(propagation, bitmap);
+    for (size_t j = 0; j < exactField.size(); ++j)
+    {
+      // The propagated distances are never shorter, and only slightly longer.
+      XM_ASSERT_TRUE(std::abs(exactField[j] - 127) <= std::abs(propagationField[j] - 127));
+      XM_ASSERT_TRUE(std::abs(exactField[j] - propagationField[j]) <= 8);
+    }
+  }
+}
+
+XM_TEST(SdfBuilder, Benchmark)
+{
+  if (!IsBenchmarkEnabled())
+  {
+    return;
+  }
+
+  // A font's worth of glyphs, each done by its own (reused) SdfBuilder, as in
+  // the Font builder.
+  const Px kSize = 136;
+  const Px kFieldSize = 4;
+  const size_t kNumGlyphs = 1000;
+  std::mt19937 rng(3);
+  std::vector<Bitmap> glyphs;
+  glyphs.reserve(kNumGlyphs);
+  for (size_t i = 0; i < kNumGlyphs; ++i)
+  {
+    glyphs.push_back(MakeGlyph(kSize, kSize, rng));
+  }
+
+  std::vector<std::vector<uint8_t>> fields(kNumGlyphs);
+  auto generate = [&glyphs, &fields, kSize, kFieldSize](SdfBuilder::Method method,
+    size_t begin, size_t end) {
+    SdfBuilder sdf(kSize, kFieldSize, method);
+    for (; begin != end; ++begin)
+    {
+      fields[begin] = Generate(sdf, glyphs[begin]);
+    }
+  };
+
+  TaskScheduler scheduler;
+  double results[2][2];
+  for (auto method : { SdfBuilder::Method::Propagation, SdfBuilder::Method::Exact })
+  {
+    auto& r = results[int(method)];
+    r[0] = TimeMs(1, [&generate, method]() {
+      generate(method, 0, kNumGlyphs);
+    });
+    auto serialFields = fields;
+
+    r[1] = TimeMs(1, [&scheduler, &generate, method]() {
+      scheduler.ParallelFor(0, kNumGlyphs, 0, [&generate, method](size_t begin, size_t end) {
+        generate(method, begin, end);
+      });
+    });
+    XM_ASSERT_EQ(fields, serialFields);
+  }
+
+  XR_TRACE(SdfBuilder, ("%zu glyphs of %dpx: propagation: %.2fms, %.2fms on %u threads; "
+    "exact: %.2fms, %.2fms on %u threads", kNumGlyphs, kSize, results[0][0], results[0][1],
+    scheduler.GetNumThreads(), results[1][0], results[1][1], scheduler.GetNumThreads()));
+}
+
+}
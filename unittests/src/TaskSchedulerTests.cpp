@@ -0,0 +1,251 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xm.hpp"
+#include "Benchmark.hpp"
+#include "xr/threading/TaskScheduler.hpp"
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+using namespace xr;
+
+namespace
+{
+
+XM_TEST(TaskScheduler, Submit)
+{
+  TaskScheduler scheduler(4);
+  XM_ASSERT_EQ(scheduler.GetNumThreads(), 4u);
+
+  std::atomic<int> hits(0);
+  const int kNumTasks = 1000;
+  std::vector<TaskScheduler::Handle> handles;
+  for (int i = 0; i < kNumTasks; ++i)
+  {
+    handles.push_back(scheduler.Submit([&hits] {
+      ++hits;
+    }));
+  }
+
+  for (auto& h : handles)
+  {
+    scheduler.Wait(h);
+    XM_ASSERT_TRUE(scheduler.IsComplete(h));
+  }
+  XM_ASSERT_EQ(hits.load(), kNumTasks);
+
+  // Handles of completed tasks remain complete, even once slots are reused.
+  auto h = scheduler.Submit([] {});
+  scheduler.WaitAll();
+  XM_ASSERT_TRUE(scheduler.IsComplete(h));
+  XM_ASSERT_TRUE(scheduler.IsComplete(handles[0]));
+  XM_ASSERT_TRUE(scheduler.IsComplete(TaskScheduler::Handle()));
+}
+
+XM_TEST(TaskScheduler, Dependencies)
+{
+  TaskScheduler scheduler(4);
+
+  std::mutex mutex;
+  std::vector<int> order;
+  auto record = [&](int i) {
+    return [&, i] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(i == 0 ? 20 : 1));
+      std::unique_lock<std::mutex> lock(mutex);
+      order.push_back(i);
+    };
+  };
+
+  // Diamond: 0 -> (1, 2) -> 3
+  auto h0 = scheduler.Submit(record(0));
+  auto h1 = scheduler.Submit(record(1), { h0 });
+  auto h2 = scheduler.Submit(record(2), { h0 });
+  auto h3 = scheduler.Submit(record(3), { h1, h2 });
+  scheduler.Wait(h3);
+
+  XM_ASSERT_EQ(order.size(), 4u);
+  XM_ASSERT_EQ(order[0], 0);
+  XM_ASSERT_EQ(order[3], 3);
+
+  // Depending on completed and invalid handles.
+  bool done = false;
+  auto h4 = scheduler.Submit([&done] {
+    done = true;
+  }, { h0, TaskScheduler::Handle() });
+  scheduler.Wait(h4);
+  XM_ASSERT_TRUE(done);
+}
+
+XM_TEST(TaskScheduler, Chain)
+{
+  TaskScheduler scheduler(4);
+
+  const int kLength = 500;
+  int value = 0;  // only ever touched by one task at a time
+  int outOfOrder = 0;
+  TaskScheduler::Handle h;
+  for (int i = 0; i < kLength; ++i)
+  {
+    h = scheduler.Submit([&value, &outOfOrder, i] {
+      outOfOrder += value != i;
+      ++value;
+    }, { h });
+  }
+  scheduler.Wait(h);
+  XM_ASSERT_EQ(value, kLength);
+  XM_ASSERT_EQ(outOfOrder, 0);
+}
+
+struct ChunkedJob : Worker::Job
+{
+  int chunks = 0;
+  int processed = 0;
+  bool started = false;
+
+  void Start() override
+  {
+    started = true;
+  }
+
+  bool Process() override
+  {
+    return ++processed == chunks;
+  }
+};
+
+XM_TEST(TaskScheduler, WorkerJob)
+{
+  TaskScheduler scheduler(2);
+
+  ChunkedJob job;
+  job.chunks = 10;
+  auto h = scheduler.Submit(job);
+  scheduler.Wait(h);
+
+  XM_ASSERT_TRUE(job.started);
+  XM_ASSERT_EQ(job.processed, job.chunks);
+}
+
+XM_TEST(TaskScheduler, ParallelFor)
+{
+  TaskScheduler scheduler(4);
+
+  const size_t kCount = 100003;
+  std::vector<std::atomic<int>> hits(kCount);
+  for (size_t grain : { size_t(0), size_t(1000), kCount * 2 })
+  {
+    for (auto& h : hits)
+    {
+      h = 0;
+    }
+
+    scheduler.ParallelFor(0, kCount, grain, [&hits](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i)
+      {
+        ++hits[i];
+      }
+    });
+
+    for (auto& h : hits)
+    {
+      XM_ASSERT_EQ(h.load(), 1);
+    }
+  }
+}
+
+XM_TEST(TaskScheduler, NestedParallelFor)
+{
+  TaskScheduler scheduler(4);
+
+  std::atomic<int> hits(0);
+  scheduler.ParallelFor(0, 16, 1, [&](size_t, size_t) {
+    scheduler.ParallelFor(0, 100, 10, [&](size_t begin, size_t end) {
+      hits += static_cast<int>(end - begin);
+    });
+  });
+  XM_ASSERT_EQ(hits.load(), 1600);
+}
+
+XM_TEST(TaskScheduler, TooManyTasks)
+{
+  TaskScheduler scheduler(1);
+
+  // Keep the pool thread busy, so that nothing else completes until the
+  // submitting thread starts helping, once it has run out of tasks.
+  std::atomic<bool> started(false);
+  std::atomic<bool> release(false);
+  auto blocker = scheduler.Submit([&started, &release] {
+    started = true;
+    while (!release.load())
+    {
+      std::this_thread::yield();
+    }
+  });
+
+  while (!started.load())
+  {
+    std::this_thread::yield();
+  }
+
+  std::atomic<uint32_t> hits(0);
+  const uint32_t kNumTasks = TaskScheduler::kMaxTasks + 100;
+  for (uint32_t i = 0; i < kNumTasks; ++i)
+  {
+    scheduler.Submit([&hits] {
+      ++hits;
+    });
+  }
+  XM_ASSERT_FALSE(scheduler.IsComplete(blocker));
+  XM_ASSERT_GT(hits.load(), 0u);
+
+  release = true;
+  scheduler.WaitAll();
+  XM_ASSERT_EQ(hits.load(), kNumTasks);
+}
+
+double BenchmarkParallelFor(uint32_t numThreads, std::vector<float>& data)
+{
+  TaskScheduler scheduler(numThreads);
+  return TimeMs(8, [&scheduler, &data] {
+    scheduler.ParallelFor(0, data.size(), 0, [&data](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i)
+      {
+        data[i] = std::sqrt(data[i] * data[i] + 1.f) + std::sin(data[i]);
+      }
+    });
+  });
+}
+
+XM_TEST(TaskScheduler, ScalingBenchmark)
+{
+  if (!IsBenchmarkEnabled())
+  {
+    return;
+  }
+
+  std::vector<float> data(1 << 21);
+  for (size_t i = 0; i < data.size(); ++i)
+  {
+    data[i] = static_cast<float>(i);
+  }
+
+  const double baseline = BenchmarkParallelFor(1, data);
+  XR_TRACE(TaskScheduler, ("1 thread(s): %.2fms per pass", baseline));
+  (void)baseline;
+
+  for (uint32_t numThreads : { 2u, 4u, std::thread::hardware_concurrency() })
+  {
+    const double ms = BenchmarkParallelFor(numThreads, data);
+    XR_TRACE(TaskScheduler, ("%u thread(s): %.2fms per pass, %.2fx",
+      numThreads, ms, baseline / ms));
+    (void)ms;
+  }
+}
+
+}
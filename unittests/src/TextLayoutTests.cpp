@@ -0,0 +1,355 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xm.hpp"
+#include "Benchmark.hpp"
+#include "HeadlessGfx.hpp"
+#include "TestFont.hpp"
+#include "xr/TextLayout.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace xr;
+
+namespace
+{
+
+using RecordType = Gfx::CommandRecord::Type;
+
+Font::Ptr CreateFont()
+{
+  std::vector<uint32_t> codePoints;
+  for (uint32_t cp = ' '; cp <= '~'; ++cp)
+  {
+    codePoints.push_back(cp);
+  }
+  return CreateTestFont(codePoints, 256, 8, 8);
+}
+
+BoxText CreateBoxText(Font::Ptr const& font)
+{
+  BoxText boxText;
+  boxText.SetFont(font);
+  boxText.SetBoxSize(200.f, 100.f);
+  boxText.SetHorizontalAlignment(BoxText::Alignment::Centered);
+  boxText.SetVerticalAlignment(BoxText::Alignment::Negative);
+  return boxText;
+}
+
+// Checks that the vertices of the layout are the same as what BoxText would
+// generate for the whole of its text.
+void AssertMatchesBoxText(TextLayout const& layout)
+{
+  auto const& boxText = layout.GetBoxText();
+  BoxText::Measurement m;
+  boxText.Measure(layout.GetText().c_str(), layout.GetText().size(), m);
+  XM_ASSERT_EQ(layout.GetMeasurement().lines.size(), m.lines.size());
+
+  XM_ASSERT_EQ(layout.GetNumGlyphs(), m.numGlyphs);
+  if (m.numGlyphs == 0)
+  {
+    return;
+  }
+
+  std::vector<BoxText::Vertex> vertices(m.numGlyphs * Quad::Vertex::kCount);
+  boxText.Generate(m, vertices.data(), false, nullptr);
+
+  auto& layoutVertices = layout.GetVertices();
+  for (size_t i = 0; i < vertices.size(); ++i)
+  {
+    XM_ASSERT_EQ(layoutVertices[i].pos.x, vertices[i].pos.x);
+    XM_ASSERT_EQ(layoutVertices[i].pos.y, vertices[i].pos.y);
+    XM_ASSERT_EQ(layoutVertices[i].uv0.x, vertices[i].uv0.x);
+    XM_ASSERT_EQ(layoutVertices[i].uv0.y, vertices[i].uv0.y);
+  }
+}
+
+std::vector<Gfx::CommandRecord> FindRecords(std::vector<Gfx::CommandRecord> const& records,
+  RecordType type)
+{
+  std::vector<Gfx::CommandRecord> found;
+  std::copy_if(records.begin(), records.end(), std::back_inserter(found),
+    [type](Gfx::CommandRecord const& r) {
+      return r.type == type;
+    });
+  return found;
+}
+
+XM_TEST(TextLayout, Update)
+{
+  HeadlessGfx gfx;
+  auto font = CreateFont();
+  TextLayout layout;
+  layout.SetBoxText(CreateBoxText(font));
+
+  layout.SetText("Score: 100\nLives: 3");
+  XM_ASSERT_TRUE(layout.Update(false));
+  XM_ASSERT_EQ(layout.GetNumGlyphs(), 16u);
+  XM_ASSERT_EQ(layout.GetStats().numLines, 2u);
+  AssertMatchesBoxText(layout);
+  Gfx::Present();
+
+  // Nothing to do.
+  XM_ASSERT_TRUE(!layout.Update(false));
+  layout.SetText("Score: 100\nLives: 3");
+  XM_ASSERT_TRUE(!layout.Update(false));
+
+  // Only the last line is generated and uploaded.
+  const uint32_t kGlyphBytes = Quad::Vertex::kCount * BoxText::Vertex::kSize;
+  Gfx::StartRecording();
+  layout.SetText("Score: 100\nLives: 2");
+  XM_ASSERT_TRUE(layout.Update(false));
+  Gfx::Present();
+  auto records = Gfx::StopRecording();
+  AssertMatchesBoxText(layout);
+
+  XM_ASSERT_TRUE(FindRecords(records, RecordType::CreateVertexBuffer).empty());
+  auto updates = FindRecords(records, RecordType::UpdateVertexBuffer);
+  XM_ASSERT_EQ(updates.size(), 1u);
+  XM_ASSERT_EQ(updates[0].id, layout.GetMesh().hVertexBuffer.id);
+  XM_ASSERT_EQ(updates[0].params[0], 9u * kGlyphBytes);
+  XM_ASSERT_EQ(updates[0].params[1], 7u * kGlyphBytes);
+  XM_ASSERT_EQ(Gfx::GetFrameStats().numVertexUploadBytes, 7u * kGlyphBytes);
+
+  // More glyphs than there's room for; the mesh is re-created, with room to
+  // spare.
+  Gfx::StartRecording();
+  layout.SetText("Score: 1000\nLives: 2");
+  XM_ASSERT_TRUE(layout.Update(false));
+  records = Gfx::StopRecording();
+  AssertMatchesBoxText(layout);
+  XM_ASSERT_EQ(FindRecords(records, RecordType::CreateVertexBuffer).size(), 1u);
+  XM_ASSERT_GT(layout.GetVertices().size(), layout.GetNumGlyphs() * Quad::Vertex::kCount);
+
+  // Fewer glyphs; from the first line.
+  Gfx::StartRecording();
+  layout.SetText("Score: 99\nLives: 2");
+  XM_ASSERT_TRUE(layout.Update(false));
+  records = Gfx::StopRecording();
+  AssertMatchesBoxText(layout);
+  XM_ASSERT_TRUE(FindRecords(records, RecordType::CreateVertexBuffer).empty());
+  updates = FindRecords(records, RecordType::UpdateVertexBuffer);
+  XM_ASSERT_EQ(updates.size(), 1u);
+  XM_ASSERT_EQ(updates[0].params[0], 0u);
+  XM_ASSERT_EQ(updates[0].params[1], 15u * kGlyphBytes);
+
+  // A change that moves the rest of the text vertically.
+  auto boxText = CreateBoxText(font);
+  boxText.SetVerticalAlignment(BoxText::Alignment::Centered);
+  layout.SetBoxText(boxText);
+  XM_ASSERT_TRUE(layout.Update(false));
+  AssertMatchesBoxText(layout);
+
+  layout.SetText("Score: 99\nLives: 2\nLevel: 1");
+  XM_ASSERT_TRUE(layout.Update(false));
+  AssertMatchesBoxText(layout);
+
+  layout.SetText("");
+  XM_ASSERT_TRUE(layout.Update(false));
+  XM_ASSERT_EQ(layout.GetNumGlyphs(), 0u);
+  XM_ASSERT_EQ(layout.GetMeasurement().lines.size(), 0u);
+}
+
+XM_TEST(TextLayout, UpdateAfterEviction)
+{
+  HeadlessGfx gfx;
+
+  // Room for 4 glyphs.
+  auto font = CreateTestFont({ ' ', 'a', 'b', 'c', 'd', 'e', 'f' }, 64, 24, 32);
+  TextLayout layout;
+  layout.SetBoxText(CreateBoxText(font));
+  layout.SetText("ab");
+  XM_ASSERT_TRUE(layout.Update(false));
+  XM_ASSERT_TRUE(!layout.Update(false));
+
+  // Caching glyphs that fit doesn't affect the layout.
+  font->CacheGlyph('c');
+  font->CacheGlyph('d');
+  XM_ASSERT_TRUE(!layout.Update(false));
+
+  // 'a' and 'b' are evicted and the layout is generated again, with their new
+  // UVs.
+  font->CacheGlyph('e');
+  font->CacheGlyph('f');
+  XM_ASSERT_TRUE(layout.Update(false));
+  AssertMatchesBoxText(layout);
+
+  auto& vertices = layout.GetVertices();
+  auto cg = font->CacheGlyph('a');
+  XM_ASSERT_EQ(vertices[0].uv0.x, cg->uvs.left);
+  XM_ASSERT_EQ(vertices[0].uv0.y, cg->uvs.top);
+  cg = font->CacheGlyph('b');
+  XM_ASSERT_EQ(vertices[4].uv0.x, cg->uvs.left);
+  XM_ASSERT_EQ(vertices[4].uv0.y, cg->uvs.top);
+}
+
+XM_TEST(TextLayout, UpdateGlyphLimit)
+{
+  HeadlessGfx gfx;
+  auto font = CreateFont();
+  auto boxText = CreateBoxText(font);
+  boxText.SetBoxSize(1e9f, 100.f);
+  TextLayout layout;
+  layout.SetBoxText(boxText);
+
+  // 16-bit indices address 16384 glyphs; the rest of the text is cut.
+  const uint32_t kMaxGlyphs = 16384;
+  const std::string text(kMaxGlyphs + 100, 'a');
+  layout.SetText(text.c_str());
+  XM_ASSERT_TRUE(layout.Update(false));
+  XM_ASSERT_EQ(layout.GetNumGlyphs(), kMaxGlyphs);
+  XM_ASSERT_EQ(layout.GetMeasurement().lines.size(), 1u);
+  XM_ASSERT_EQ(layout.GetMeasurement().lines[0].end, layout.GetText().c_str() + kMaxGlyphs);
+  XM_ASSERT_EQ(layout.GetVertices().size(), kMaxGlyphs * Quad::Vertex::kCount);
+
+  // Shorter text is laid out in full again.
+  layout.SetText(text.c_str(), 100);
+  XM_ASSERT_TRUE(layout.Update(false));
+  AssertMatchesBoxText(layout);
+}
+
+XM_TEST(TextLayout, UpdateRandom)
+{
+  HeadlessGfx gfx;
+  std::vector<uint32_t> codePoints;
+  for (uint32_t cp = ' '; cp <= '~'; ++cp)
+  {
+    codePoints.push_back(cp);
+  }
+
+  // The characters of the text; 13 glyphs.
+  const char alphabet[] = "abcdef XYZ\n0123 ";
+  const size_t kAlphabetSize = sizeof(alphabet) - 1;
+
+  // Plenty of room in the cache, then room for 18 glyphs, which the text fits
+  // in, but whose glyphs we evict between some of the updates.
+  for (Px cacheSize : { 256, 48 })
+  {
+    auto font = CreateTestFont(codePoints, cacheSize, 8, 8);
+    std::mt19937 rng(7);
+    for (int i = 0; i < 200; ++i)
+    {
+      auto boxText = CreateBoxText(font);
+      boxText.SetBoxSize(float(rng() % 200 + 40), float(rng() % 120 + 20));
+      boxText.SetHorizontalAlignment(BoxText::Alignment(rng() % 3));
+      boxText.SetVerticalAlignment(BoxText::Alignment(rng() % 3));
+      boxText.SetHorizontalSpacing(float(rng() % 3));
+
+      TextLayout layout;
+      layout.SetBoxText(boxText);
+      std::string text;
+      for (int j = 0; j < 40; ++j)
+      {
+        // Insert, erase, replace or append characters.
+        const size_t pos = rng() % (text.size() + 1);
+        switch (text.empty() ? 0 : rng() % 4)
+        {
+        case 0:
+          for (int k = rng() % 6; k >= 0; --k)
+          {
+            text.insert(text.begin() + pos, alphabet[rng() % kAlphabetSize]);
+          }
+          break;
+
+        case 1:
+          text.erase(pos, rng() % 4);
+          break;
+
+        case 2:
+          if (pos < text.size())
+          {
+            text[pos] = alphabet[rng() % kAlphabetSize];
+          }
+          break;
+
+        default:
+          text += alphabet[rng() % kAlphabetSize];
+          break;
+        }
+
+        if (text.size() > 120)
+        {
+          text.resize(120);
+        }
+        layout.SetText(text.c_str(), text.size());
+
+        if (cacheSize < 256 && rng() % 3 == 0)
+        {
+          for (uint32_t cp = 'g'; cp < 'g' + 10; ++cp)
+          {
+            font->CacheGlyph(cp);
+          }
+        }
+
+        layout.Update(false);
+        AssertMatchesBoxText(layout);
+        Gfx::Present();
+      }
+    }
+  }
+}
+
+XM_TEST(TextLayout, UpdateBenchmark)
+{
+  if (!IsBenchmarkEnabled())
+  {
+    return;
+  }
+
+  HeadlessGfx gfx;
+  auto font = CreateFont();
+  auto boxText = CreateBoxText(font);
+
+  // Score labels, with the score of some of them changing every frame.
+  const int kNumLabels = 1000;
+  const int kNumFrames = 20;
+  auto getLabel = [](int i, int frame, char* buffer, size_t size) {
+    snprintf(buffer, size, "Player %d\nScore: %d", i, (i % 10 == 0) ? i + frame : i);
+  };
+
+  std::vector<TextLayout> layouts(kNumLabels);
+  for (auto& layout : layouts)
+  {
+    layout.SetBoxText(boxText);
+  }
+
+  char buffer[64];
+  int frame = 0;
+  const double layoutMs = TimeMs(kNumFrames, [&] {
+    for (int i = 0; i < kNumLabels; ++i)
+    {
+      getLabel(i, frame, buffer, sizeof(buffer));
+      layouts[i].SetText(buffer);
+      layouts[i].Update(false);
+    }
+    Gfx::Present();
+    ++frame;
+  });
+
+  frame = 0;
+  const double createMeshMs = TimeMs(kNumFrames, [&] {
+    for (int i = 0; i < kNumLabels; ++i)
+    {
+      getLabel(i, frame, buffer, sizeof(buffer));
+      auto mesh = boxText.CreateMesh(buffer, false, nullptr);
+    }
+    Gfx::Present();
+    ++frame;
+  });
+
+  XR_TRACE(TextLayout, ("%d labels, %d frames: CreateMesh(): %.3fms, TextLayout: %.3fms per frame, %.2fx",
+    kNumLabels, kNumFrames, createMeshMs, layoutMs, createMeshMs / layoutMs));
+  (void)createMeshMs;
+  (void)layoutMs;
+}
+
+}
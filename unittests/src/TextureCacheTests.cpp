@@ -0,0 +1,83 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xm.hpp"
+#include "xr/TextureCache.hpp"
+#include "xr/AABB.hpp"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using namespace xr;
+
+namespace
+{
+
+const Px kCacheSize = 64;
+const Px kRowHeight = 32;
+
+XM_TEST(TextureCache, DirtyRegions)
+{
+  TextureCache cache(kCacheSize, TextureCache::Format::U8, 8, kRowHeight);
+  std::vector<std::pair<Rect, std::vector<uint8_t>>> regions;
+  auto consume = [&cache, &regions]() {
+    regions.clear();
+    cache.ConsumeDirtyRegions([&regions](Rect const& rect, Buffer const& buffer) {
+      regions.push_back({ rect, std::vector<uint8_t>(buffer.data, buffer.data + buffer.size) });
+    });
+  };
+
+  consume();
+  XM_ASSERT_TRUE(regions.empty());
+
+  // Allocations in the same row are merged; the pixels come tightly packed.
+  AABB uvs;
+  for (uint8_t value : { 1, 2, 3 })
+  {
+    auto buffer = cache.Allocate(20, value * 4, uvs); // 3 blocks.
+    XM_ASSERT_NE(buffer, nullptr);
+    for (Px y = 0; y < value * 4; ++y)
+    {
+      std::fill(buffer + y * cache.GetPitch(), buffer + y * cache.GetPitch() + 20, value);
+    }
+  }
+
+  consume();
+  XM_ASSERT_EQ(regions.size(), 2u);
+  auto& rect = regions[0].first;
+  XM_ASSERT_EQ(rect.x, 0);
+  XM_ASSERT_EQ(rect.y, 0);
+  XM_ASSERT_EQ(rect.w, 24 + 20);
+  XM_ASSERT_EQ(rect.h, 8);
+
+  auto& pixels = regions[0].second;
+  XM_ASSERT_EQ(pixels.size(), size_t(rect.w * rect.h));
+  XM_ASSERT_EQ(pixels[0], 1);
+  XM_ASSERT_EQ(pixels[20], 0);
+  XM_ASSERT_EQ(pixels[24], 2);
+  XM_ASSERT_EQ(pixels[rect.w * 4], 0);
+  XM_ASSERT_EQ(pixels[rect.w * 4 + 24], 2);
+  XM_ASSERT_EQ(pixels[rect.w * 8 - 1], 2);
+
+  XM_ASSERT_EQ(regions[1].first.x, 0);
+  XM_ASSERT_EQ(regions[1].first.y, kRowHeight);
+  XM_ASSERT_EQ(regions[1].first.w, 20);
+  XM_ASSERT_EQ(regions[1].first.h, 12);
+  XM_ASSERT_EQ(regions[1].second, std::vector<uint8_t>(20 * 12, 3));
+
+  // Consumed regions aren't reported again.
+  consume();
+  XM_ASSERT_TRUE(regions.empty());
+
+  cache.Allocate(10, 4, uvs);
+  cache.ClearDirtyRegions();
+  consume();
+  XM_ASSERT_TRUE(regions.empty());
+}
+
+}
@@ -0,0 +1,448 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xm.hpp"
+#include "Benchmark.hpp"
+#include "xr/TransformStore.hpp"
+#include "xr/Entity.hpp"
+#include "xr/threading/TaskScheduler.hpp"
+#include "xr/utils.hpp"
+#include <cstring>
+#include <memory>
+#include <random>
+
+using namespace xr;
+
+namespace
+{
+
+bool IsEqual(Matrix const& m0, Matrix const& m1)
+{
+  float diff = (m1.t - m0.t).Dot();
+  for (size_t i = 0; i < XR_ARRAY_SIZE(m0.linear); ++i)
+  {
+    diff += std::abs(m1.linear[i] - m0.linear[i]);
+  }
+  return diff < 1e-4f;
+}
+
+XM_TEST(TransformStore, Basics)
+{
+  TransformStore store;
+  auto root = store.Create();
+  auto child = store.Create(root);
+  auto grandChild = store.Create(child);
+  XM_ASSERT_EQ(store.GetSize(), 3u);
+  XM_ASSERT_EQ(store.GetParent(root), TransformStore::kInvalidId);
+  XM_ASSERT_EQ(store.GetParent(grandChild), child);
+
+  store.SetTranslation(root, Vector3::UnitX());
+  store.SetRotation(root, Quaternion::FromAxisAngle(Vector3::UnitZ(), float(M_PI) * .5f));
+  store.SetTranslation(child, Vector3::UnitY());
+  store.SetScale(grandChild, Vector3(2.f, 2.f, 2.f));
+  XM_ASSERT_TRUE(store.IsUpdateNeeded());
+  store.Update();
+  XM_ASSERT_FALSE(store.IsUpdateNeeded());
+
+  Matrix expectChild = store.GetLocalTransform(child) * store.GetLocalTransform(root);
+  XM_ASSERT_TRUE(IsEqual(store.GetWorldTransform(child), expectChild));
+  XM_ASSERT_TRUE(IsEqual(store.GetWorldTransform(grandChild),
+    store.GetLocalTransform(grandChild) * expectChild));
+
+  // Changes propagate to descendants.
+  store.SetTranslation(root, Vector3::Zero());
+  store.Update();
+  expectChild = store.GetLocalTransform(child) * store.GetLocalTransform(root);
+  XM_ASSERT_TRUE(IsEqual(store.GetWorldTransform(grandChild),
+    store.GetLocalTransform(grandChild) * expectChild));
+
+  // Releasing a transform makes roots of its children.
+  store.Release(child);
+  XM_ASSERT_EQ(store.GetSize(), 2u);
+  XM_ASSERT_EQ(store.GetParent(grandChild), TransformStore::kInvalidId);
+  store.Update();
+  XM_ASSERT_TRUE(IsEqual(store.GetWorldTransform(grandChild),
+    store.GetLocalTransform(grandChild)));
+
+  // Ids get reused.
+  auto another = store.Create(grandChild);
+  XM_ASSERT_EQ(another, child);
+
+  store.Release(another);
+  store.Release(grandChild);
+  store.Release(root);
+  XM_ASSERT_EQ(store.GetSize(), 0u);
+}
+
+XM_TEST(TransformStore, Reparenting)
+{
+  TransformStore store;
+  // Create children before their (future) parents, so that the layout must change.
+  TransformStore::Id ids[8];
+  for (auto& id : ids)
+  {
+    id = store.Create();
+    store.SetTranslation(id, Vector3(1.f, float(&id - ids), 0.f));
+  }
+
+  for (int i = 0; i < 7; ++i)
+  {
+    store.SetParent(ids[i], ids[i + 1]);
+  }
+  store.Update();
+
+  Matrix expect = store.GetLocalTransform(ids[7]);
+  for (int i = 6; i >= 0; --i)
+  {
+    expect = store.GetLocalTransform(ids[i]) * expect;
+    XM_ASSERT_TRUE(IsEqual(store.GetWorldTransform(ids[i]), expect));
+  }
+  XM_ASSERT_EQ(store.GetWorldTransform(ids[0]).t.x, 8.f);
+
+  store.SetParent(ids[3], TransformStore::kInvalidId);
+  store.Update();
+  XM_ASSERT_EQ(store.GetWorldTransform(ids[0]).t.x, 4.f);
+
+  for (auto id : ids)
+  {
+    store.Release(id);
+  }
+}
+
+XM_TEST(TransformStore, EntityBacked)
+{
+  TransformStore store;
+  Entity root(Name("root"), nullptr);
+  root.SetTranslation(Vector3::UnitX());
+  auto child = new Entity(Name("child"), &root);
+  child->SetTranslation(Vector3::UnitY());
+  child->SetRotation(Quaternion::FromAxisAngle(Vector3::UnitZ(), float(M_PI) * .5f));
+  auto grandChild = new Entity(Name("grandChild"), child);
+  grandChild->SetScale(Vector3(1.f, 2.f, 3.f));
+
+  const Matrix expect = grandChild->GetWorldTransform();
+
+  root.SetTransformStore(&store);
+  XM_ASSERT_EQ(store.GetSize(), 3u);
+  XM_ASSERT_EQ(child->GetTransformStore(), &store);
+  XM_ASSERT_EQ(store.GetParent(grandChild->GetTransformId()), child->GetTransformId());
+  XM_ASSERT_EQ(child->GetTranslation().y, 1.f);
+  XM_ASSERT_TRUE(IsEqual(grandChild->GetWorldTransform(), expect));
+
+  // Children added are moved to the store.
+  auto other = new Entity(Name("other"), nullptr);
+  other->SetTranslation(Vector3::UnitZ());
+  grandChild->AddChild(*other);
+  XM_ASSERT_EQ(other->GetTransformStore(), &store);
+  XM_ASSERT_TRUE(IsEqual(other->GetWorldTransform(),
+    other->GetLocalTransform() * expect));
+
+  // Changes propagate.
+  root.SetXTranslation(5.f);
+  XM_ASSERT_EQ(other->GetWorldTransform(false).t.x, expect.t.x);
+  XM_ASSERT_EQ(other->GetWorldTransform().t.x, expect.t.x + 4.f);
+
+  // Detached entities remain in the store.
+  child->DetachFromParent();
+  XM_ASSERT_EQ(child->GetTransformStore(), &store);
+  XM_ASSERT_TRUE(IsEqual(child->GetWorldTransform(), child->GetLocalTransform()));
+  delete child;
+  XM_ASSERT_EQ(store.GetSize(), 1u);
+
+  // Back into the entity.
+  root.SetTransformStore(nullptr);
+  XM_ASSERT_EQ(store.GetSize(), 0u);
+  XM_ASSERT_EQ(root.GetTranslation().x, 5.f);
+  XM_ASSERT_EQ(root.GetWorldTransform().t.x, 5.f);
+}
+
+// Builds a tree of @a depth levels, with @a branching children per entity.
+void BuildTree(Entity& parent, int depth, int branching, std::vector<Entity*>& leaves)
+{
+  for (int i = 0; i < branching; ++i)
+  {
+    auto e = new Entity(&parent);
+    e->SetName(Name(std::to_string(i).c_str()));
+    e->SetTranslation(Vector3(1.f, float(i), 0.f));
+    e->SetRotation(Quaternion::FromAxisAngle(Vector3::UnitZ(), .1f * i));
+    if (depth > 1)
+    {
+      BuildTree(*e, depth - 1, branching, leaves);
+    }
+    else
+    {
+      leaves.push_back(e);
+    }
+  }
+}
+
+// Returns the average milliseconds per frame, and the sum of the leaves' world
+// translations in @a checksum.
+double BenchmarkUpdates(TransformStore* store, int frames, float& checksum)
+{
+  Entity root(nullptr);
+  std::vector<Entity*> leaves;
+  BuildTree(root, 3, 32, leaves);  // 33k entities.
+  root.SetTransformStore(store);
+  root.UpdateWorldTransform();
+
+  float sum = 0.f;
+  int i = 0;
+  const double ms = TimeMs(frames, [&] {
+    // Move the whole hierarchy and a tenth of the leaves, then query the leaves.
+    root.SetRotation(Quaternion::FromAxisAngle(Vector3::UnitY(), .01f * i));
+    for (size_t j = i % 10; j < leaves.size(); j += 10)
+    {
+      leaves[j]->SetYTranslation(float(i));
+    }
+
+    for (auto e : leaves)
+    {
+      sum += e->GetWorldTransform().t.x;
+    }
+    ++i;
+  });
+  checksum = sum;
+  return ms;
+}
+
+XM_TEST(TransformStore, UpdateBenchmark)
+{
+  if (!IsBenchmarkEnabled())
+  {
+    return;
+  }
+
+  const int kFrames = 20;
+  float inlineSum;
+  const double inlineMs = BenchmarkUpdates(nullptr, kFrames, inlineSum);
+  TransformStore store;
+  float storeSum;
+  const double storeMs = BenchmarkUpdates(&store, kFrames, storeSum);
+  XM_ASSERT_LT(std::abs(storeSum - inlineSum), std::abs(inlineSum) * 1e-5f + 1e-3f);
+  XR_TRACE(TransformStore, ("Entity: %.3fms per frame; TransformStore: %.3fms per frame, %.2fx",
+    inlineMs, storeMs, inlineMs / storeMs));
+  (void)inlineMs;
+  (void)storeMs;
+}
+
+// Creates @a count transforms in a random hierarchy, in both stores.
+std::vector<TransformStore::Id> BuildRandomHierarchy(size_t count,
+  TransformStore& store0, TransformStore& store1)
+{
+  std::mt19937 rng(1337);
+  std::vector<TransformStore::Id> ids;
+  for (size_t i = 0; i < count; ++i)
+  {
+    // Mostly shallow, with the occasional root and long chain.
+    auto parent = TransformStore::kInvalidId;
+    const auto r = rng() % 100;
+    if (!ids.empty() && r > 0)
+    {
+      parent = ids[r < 10 ? ids.size() - 1 : rng() % ids.size()];
+    }
+
+    auto id = store0.Create(parent);
+    XM_ASSERT_EQ(store1.Create(parent), id);
+    ids.push_back(id);
+  }
+  return ids;
+}
+
+XM_TEST(TransformStore, ParallelUpdate)
+{
+  TaskScheduler scheduler(4);
+  TransformStore serial;
+  TransformStore parallel;
+  auto ids = BuildRandomHierarchy(20000, serial, parallel);
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> dist(-10.f, 10.f);
+  for (int frame = 0; frame < 8; ++frame)
+  {
+    for (int i = 0; i < 500; ++i)
+    {
+      const auto id = ids[rng() % ids.size()];
+      const Vector3 t(dist(rng), dist(rng), dist(rng));
+      const auto r = Quaternion::FromAxisAngle(Vector3::UnitZ(), dist(rng));
+      serial.SetTranslation(id, t);
+      parallel.SetTranslation(id, t);
+      serial.SetRotation(id, r);
+      parallel.SetRotation(id, r);
+    }
+
+    if (frame == 4)  // restructure
+    {
+      for (int i = 0; i < 100; ++i)
+      {
+        const auto id = ids[rng() % ids.size()];
+        serial.SetParent(id, TransformStore::kInvalidId);
+        parallel.SetParent(id, TransformStore::kInvalidId);
+      }
+    }
+
+    serial.Update();
+    parallel.Update(scheduler);
+    for (auto id : ids)
+    {
+      XM_ASSERT_EQ(std::memcmp(&serial.GetWorldTransform(id),
+        &parallel.GetWorldTransform(id), sizeof(Matrix)), 0);
+    }
+  }
+
+  for (auto id : ids)
+  {
+    serial.Release(id);
+    parallel.Release(id);
+  }
+}
+
+XM_TEST(TransformStore, ParallelUpdateStructureChanges)
+{
+  TaskScheduler scheduler(4);
+  TransformStore store;
+
+  // Roots only.
+  std::vector<TransformStore::Id> roots;
+  for (int i = 0; i < 8; ++i)
+  {
+    roots.push_back(store.Create());
+    store.SetTranslation(roots.back(), Vector3(float(i), 0.f, 0.f));
+  }
+  store.Update(scheduler);
+  for (auto id : roots)
+  {
+    XM_ASSERT_TRUE(IsEqual(store.GetWorldTransform(id), store.GetLocalTransform(id)));
+  }
+
+  // Children, some of which are then released from the end of the layout.
+  const auto root = roots[0];
+  std::vector<TransformStore::Id> children;
+  for (int i = 0; i < 100; ++i)
+  {
+    children.push_back(store.Create(root));
+    store.SetTranslation(children.back(), Vector3(0.f, float(i), 0.f));
+  }
+  store.Update(scheduler);
+
+  for (int i = 0; i < 50; ++i)
+  {
+    store.Release(children.back());
+    children.pop_back();
+  }
+  store.SetTranslation(root, Vector3(0.f, 0.f, 1.f));
+  store.Update(scheduler);
+  for (auto id : children)
+  {
+    XM_ASSERT_TRUE(IsEqual(store.GetWorldTransform(id),
+      store.GetLocalTransform(id) * store.GetLocalTransform(root)));
+  }
+
+  // A root, and a child of another, created after the last update.
+  roots.push_back(store.Create());
+  store.SetTranslation(roots.back(), Vector3(0.f, 2.f, 0.f));
+  auto child = store.Create(roots[1]);
+  store.SetTranslation(child, Vector3(0.f, 0.f, 3.f));
+  children.push_back(child);
+  store.Update(scheduler);
+  XM_ASSERT_TRUE(IsEqual(store.GetWorldTransform(roots.back()),
+    store.GetLocalTransform(roots.back())));
+  XM_ASSERT_TRUE(IsEqual(store.GetWorldTransform(child),
+    store.GetLocalTransform(child) * store.GetLocalTransform(roots[1])));
+
+  // Detaching a child, then releasing its former parent.
+  store.SetParent(child, TransformStore::kInvalidId);
+  store.Release(roots[1]);
+  roots.erase(roots.begin() + 1);
+  store.SetTranslation(child, Vector3(1.f, 1.f, 1.f));
+  store.SetTranslation(root, Vector3::Zero());
+  store.Update(scheduler);
+  XM_ASSERT_TRUE(IsEqual(store.GetWorldTransform(child), store.GetLocalTransform(child)));
+  for (auto id : children)
+  {
+    if (id != child)
+    {
+      XM_ASSERT_TRUE(IsEqual(store.GetWorldTransform(id), store.GetLocalTransform(id)));
+    }
+  }
+
+  for (auto id : children)
+  {
+    store.Release(id);
+  }
+  for (auto id : roots)
+  {
+    store.Release(id);
+  }
+  XM_ASSERT_EQ(store.GetSize(), 0u);
+}
+
+XM_TEST(TransformStore, ParallelUpdateBenchmark)
+{
+  if (!IsBenchmarkEnabled())
+  {
+    return;
+  }
+
+  const size_t kCount = 100000;
+  const int kFrames = 20;
+  TransformStore serial;
+  TransformStore parallel;
+  auto ids = BuildRandomHierarchy(kCount, serial, parallel);
+
+  auto benchmark = [&ids](TransformStore& store, TaskScheduler* scheduler) {
+    int i = 0;
+    return TimeMs(kFrames, [&] {
+      // Dirty all of the roots, so that everything gets recalculated.
+      for (auto id : ids)
+      {
+        if (store.GetParent(id) == TransformStore::kInvalidId)
+        {
+          store.SetTranslation(id, Vector3(float(i), 0.f, 0.f));
+        }
+      }
+
+      if (scheduler)
+      {
+        store.Update(*scheduler);
+      }
+      else
+      {
+        store.Update();
+      }
+      ++i;
+    });
+  };
+
+  const double serialMs = benchmark(serial, nullptr);
+  XR_TRACE(TransformStore, ("%zu transforms, serial: %.3fms", kCount, serialMs));
+  (void)serialMs;
+
+  for (uint32_t numThreads : { 2u, 4u, std::thread::hardware_concurrency() })
+  {
+    TaskScheduler scheduler(numThreads);
+    const double ms = benchmark(parallel, &scheduler);
+    XR_TRACE(TransformStore, ("%u thread(s): %.3fms, %.2fx", numThreads, ms,
+      serialMs / ms));
+    (void)ms;
+
+    for (auto id : ids)
+    {
+      XM_ASSERT_EQ(std::memcmp(&serial.GetWorldTransform(id),
+        &parallel.GetWorldTransform(id), sizeof(Matrix)), 0);
+    }
+  }
+
+  for (auto id : ids)
+  {
+    serial.Release(id);
+    parallel.Release(id);
+  }
+}
+
+}
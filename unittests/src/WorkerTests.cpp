@@ -7,9 +7,11 @@
 //
 //==============================================================================
 #include "xm.hpp"
+#include "Benchmark.hpp"
 #include "xr/threading/Worker.hpp"
 #include "xr/memory/ScopeGuard.hpp"
 #include <list>
+#include <vector>
 #include <chrono>
 
 using namespace xr;
@@ -58,9 +60,9 @@ private:
   mutable std::mutex mutex; // we're operating on the same instance, might be executing and cancelling at the same time.
 };
 
-XM_TEST(Worker, SuspendResume)
+void TestSuspendResume(Worker::QueueMode mode)
 {
-  auto worker = std::make_unique<Worker>();
+  auto worker = std::make_unique<Worker>(mode);
   auto guard = MakeScopeGuard([&] {
     worker->Finalize();
   });
@@ -97,9 +99,9 @@ XM_TEST(Worker, SuspendResume)
   XM_ASSERT_EQ(j.GetExecutedCount(), j.chunks);
 }
 
-XM_TEST(Worker, CancelPendingJobs)
+void TestCancelPendingJobs(Worker::QueueMode mode)
 {
-  auto worker = std::make_unique<Worker>();
+  auto worker = std::make_unique<Worker>(mode);
   auto workerGuard = MakeScopeGuard([&worker]()
   {
     worker->Finalize();
@@ -125,9 +127,9 @@ XM_TEST(Worker, CancelPendingJobs)
   XM_ASSERT_EQ(executedPlusCancelled, kNumIterations);
 }
 
-XM_TEST(Worker, EnqueueBeforeFinalize)
+void TestEnqueueBeforeFinalize(Worker::QueueMode mode)
 {
-  auto worker = std::make_unique<Worker>();
+  auto worker = std::make_unique<Worker>(mode);
 
   Job j;
   j.durationMs = 20;
@@ -143,9 +145,9 @@ XM_TEST(Worker, EnqueueBeforeFinalize)
   worker.reset();
 }
 
-XM_TEST(Worker, EnqueueAfterFinalize)
+void TestEnqueueAfterFinalize(Worker::QueueMode mode)
 {
-  auto worker = std::make_unique<Worker>();
+  auto worker = std::make_unique<Worker>(mode);
 
   Job j;
   j.durationMs = 250;
@@ -186,9 +188,9 @@ struct SpawnerJob : Worker::Job
   }
 };
 
-XM_TEST(Worker, EnqueueMultithreaded)
+void TestEnqueueMultithreaded(Worker::QueueMode mode)
 {
-  auto worker = std::make_unique<Worker>();
+  auto worker = std::make_unique<Worker>(mode);
 
   std::atomic<int> hits(0);
   std::list<SpawnerJob> jobs;
@@ -207,4 +209,177 @@ XM_TEST(Worker, EnqueueMultithreaded)
   XM_ASSERT_EQ(hits, j.depth + 1);
 }
 
+XM_TEST(Worker, SuspendResume)
+{
+  TestSuspendResume(Worker::QueueMode::Locking);
+  TestSuspendResume(Worker::QueueMode::LockFree);
+}
+
+XM_TEST(Worker, CancelPendingJobs)
+{
+  TestCancelPendingJobs(Worker::QueueMode::Locking);
+  TestCancelPendingJobs(Worker::QueueMode::LockFree);
+}
+
+XM_TEST(Worker, EnqueueBeforeFinalize)
+{
+  TestEnqueueBeforeFinalize(Worker::QueueMode::Locking);
+  TestEnqueueBeforeFinalize(Worker::QueueMode::LockFree);
+}
+
+XM_TEST(Worker, EnqueueAfterFinalize)
+{
+  TestEnqueueAfterFinalize(Worker::QueueMode::Locking);
+  TestEnqueueAfterFinalize(Worker::QueueMode::LockFree);
+}
+
+XM_TEST(Worker, EnqueueMultithreaded)
+{
+  TestEnqueueMultithreaded(Worker::QueueMode::Locking);
+  TestEnqueueMultithreaded(Worker::QueueMode::LockFree);
+}
+
+XM_TEST(Worker, LockFreeFullQueue)
+{
+  // A tiny queue forces Enqueue() to wait for the worker thread to make space.
+  auto worker = std::make_unique<Worker>(Worker::QueueMode::LockFree, 2);
+
+  Job j;
+  j.durationMs = 1;
+
+  const int kNumIterations = 50;
+  for (int i = 0; i < kNumIterations; ++i)
+  {
+    worker->Enqueue(j);
+  }
+  worker->Finalize();
+  XM_ASSERT_EQ(j.GetExecutedCount(), kNumIterations);
+  XM_ASSERT_EQ(j.cancelled, 0);
+}
+
+struct CountingJob : Worker::Job
+{
+  std::atomic<int>* hits;
+  std::atomic<int>* cancels = nullptr;
+
+  virtual bool Process() override
+  {
+    hits->fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  virtual void Cancel() override
+  {
+    if (cancels)
+    {
+      cancels->fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+};
+
+XM_TEST(Worker, LockFreeManyProducers)
+{
+  // With many producers, the worker thread will find slots that were claimed
+  // but not yet published, having been posted the next one; it must not take
+  // these for Finalize()'s post and quit.
+  const int kNumProducers = 16;
+  const int kJobsPerProducer = 20000;
+  for (size_t capacity : { size_t(16), Worker::kDefaultCapacity })
+  {
+    std::atomic<int> hits(0);
+    std::atomic<int> cancels(0);
+    std::vector<CountingJob> jobs(kNumProducers);
+    for (auto& j : jobs)
+    {
+      j.hits = &hits;
+      j.cancels = &cancels;
+    }
+
+    Worker worker(Worker::QueueMode::LockFree, capacity);
+    std::vector<std::thread> producers;
+    for (int i = 0; i < kNumProducers; ++i)
+    {
+      producers.emplace_back([&worker, &job = jobs[i]] {
+        for (int j = 0; j < kJobsPerProducer; ++j)
+        {
+          worker.Enqueue(job);
+        }
+      });
+    }
+
+    for (auto& t : producers)
+    {
+      t.join();
+    }
+    worker.Finalize();
+
+    XM_ASSERT_EQ(cancels.load(), 0);
+    XM_ASSERT_EQ(hits.load(), kNumProducers * kJobsPerProducer);
+  }
+}
+
+double BenchmarkEnqueue(Worker::QueueMode mode, int numProducers, int jobsPerProducer)
+{
+  std::atomic<int> hits(0);
+  std::vector<CountingJob> jobs(numProducers);
+  for (auto& j : jobs)
+  {
+    j.hits = &hits;
+  }
+
+  Worker worker(mode);
+  std::atomic<bool> go(false);
+  std::vector<std::thread> producers;
+  for (int i = 0; i < numProducers; ++i)
+  {
+    producers.emplace_back([&, i] {
+      while (!go.load())
+      {
+        std::this_thread::yield();
+      }
+
+      // Jobs don't carry state, so it's fine to enqueue the same instance.
+      auto& job = jobs[i];
+      for (int j = 0; j < jobsPerProducer; ++j)
+      {
+        worker.Enqueue(job);
+      }
+    });
+  }
+
+  const double ms = TimeMs(1, [&] {
+    go = true;
+    for (auto& t : producers)
+    {
+      t.join();
+    }
+    worker.Finalize();
+  });
+
+  XM_ASSERT_EQ(hits.load(), numProducers * jobsPerProducer);
+  return ms;
+}
+
+XM_TEST(Worker, ContentionBenchmark)
+{
+  if (!IsBenchmarkEnabled())
+  {
+    return;
+  }
+
+  const int kNumJobs = 160000;
+  for (int numProducers : { 1, 4, 16 })
+  {
+    const int jobsPerProducer = kNumJobs / numProducers;
+    const double locking = BenchmarkEnqueue(Worker::QueueMode::Locking,
+      numProducers, jobsPerProducer);
+    const double lockFree = BenchmarkEnqueue(Worker::QueueMode::LockFree,
+      numProducers, jobsPerProducer);
+    XR_TRACE(Worker, ("%d jobs from %d producer(s): locking %.2fms, lock-free %.2fms",
+      kNumJobs, numProducers, locking, lockFree));
+    (void)locking;
+    (void)lockFree;
+  }
+}
+
 }
@@ -0,0 +1,262 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xm.hpp"
+#include "Benchmark.hpp"
+#include "FileLifeCycleManager.hpp"
+#include "xr/FileBuffer.hpp"
+#include "xr/xon/XonBinary.hpp"
+#include "xr/xon/XonBuildTree.hpp"
+#include "xr/xon/XonRead.hpp"
+#include "xr/debug.hpp"
+#include <cstring>
+#include <sstream>
+
+using namespace xr;
+
+namespace
+{
+
+class XonBinary
+{
+private:
+  FileLifeCycleManager  flcm;
+};
+
+std::unique_ptr<XonObject> BuildTree(char const* xon)
+{
+  return std::unique_ptr<XonObject>(XonBuildTree(xon, strlen(xon)));
+}
+
+void Compare(XonEntity const& xon, xr::XonBinary::Entity const& bin)
+{
+  XM_ASSERT_EQ(bin.GetType(), xon.GetType());
+  if (xon.Is(XonEntity::Type::Value))
+  {
+    auto& value = xon.ToValue();
+    auto& binValue = bin.ToValue();
+    if (value.GetString())
+    {
+      XM_ASSERT_EQ(binValue.GetLength(), value.GetLength());
+      XM_ASSERT_EQ(std::memcmp(binValue.GetString(), value.GetString(), value.GetLength()), 0);
+      XM_ASSERT_EQ(binValue.GetString()[binValue.GetLength()], '\0');
+    }
+    else
+    {
+      XM_ASSERT_EQ(binValue.GetString(), nullptr);
+    }
+  }
+  else
+  {
+    auto& object = xon.ToObject();
+    auto& binObject = bin.ToObject();
+    XM_ASSERT_EQ(binObject.GetNumElements(), object.GetNumElements());
+    for (size_t i = 0; i < object.GetNumElements(); ++i)
+    {
+      Compare(object[i], binObject[i]);
+    }
+
+    std::vector<std::string> keys;
+    object.GetKeys(keys);
+    XM_ASSERT_EQ(binObject.GetNumKeys(), keys.size());
+
+    size_t i = 0;
+    binObject.GetKeys([&](std::string_view key) {
+      XM_ASSERT_EQ(key, keys[i]);
+      ++i;
+
+      // The same element.
+      auto element = binObject.TryGet(key);
+      XM_ASSERT_NE(element, nullptr);
+      XM_ASSERT_EQ(element, &binObject.Get(key));
+
+      size_t index = 0;
+      while (&object[index] != &object.Get(std::string(key)))
+      {
+        ++index;
+      }
+      XM_ASSERT_EQ(element, &binObject[index]);
+    });
+  }
+}
+
+XM_TEST(XonBinary, Basics)
+{
+  auto tree = BuildTree("{ a: 1, b: null, \"say \\\"hi\\\"\": \"\", { nested: { } },"
+    "anonymous, a: overridden, zero: 0, \"\": empty_key }");
+  XM_ASSERT_NE(tree, nullptr);
+
+  std::vector<uint8_t> buffer;
+  xr::XonBinary::Write(*tree, buffer);
+  XM_ASSERT_EQ(buffer.size() % 4, 0u);
+
+  auto root = xr::XonBinary::GetRoot(buffer.data(), buffer.size());
+  XM_ASSERT_NE(root, nullptr);
+  Compare(*tree, *root);
+
+  XM_ASSERT_STREQ(root->Get("a").ToValue().GetString(), "overridden");
+  XM_ASSERT_STREQ((*root)[0].ToValue().GetString(), "1");
+  XM_ASSERT_EQ(root->Get("b").ToValue().GetString(), nullptr);
+  XM_ASSERT_STREQ(root->Get(R"(say \"hi\")").ToValue().GetString(), ""); // keys are verbatim
+  XM_ASSERT_STREQ(root->Get("").ToValue().GetString(), "empty_key");
+  XM_ASSERT_EQ(root->TryGet("c"), nullptr);
+  XM_ASSERT_EQ(root->TryGet("a0"), nullptr);
+  XM_ASSERT_EQ((*root)[3].ToObject().Get("nested").ToObject().GetNumElements(), 0u);
+
+  size_t count = 0;
+  for (auto e : *root)
+  {
+    XM_ASSERT_EQ(e, &(*root)[count]);
+    ++count;
+  }
+  XM_ASSERT_EQ(count, root->GetNumElements());
+
+  // Same exceptions as XON trees.
+  XM_ASSERT_THROW(root->Get("c"), XonEntity::Exception);
+  XM_ASSERT_THROW((*root)[root->GetNumElements()], XonEntity::Exception);
+  XM_ASSERT_THROW(root->ToValue(), XonEntity::Exception);
+  XM_ASSERT_THROW((*root)[0].ToObject(), XonEntity::Exception);
+
+  // Streams get the same.
+  std::ostringstream stream;
+  XM_ASSERT_TRUE(xr::XonBinary::Write(*tree, stream));
+  XM_ASSERT_EQ(stream.str().size(), buffer.size());
+  XM_ASSERT_EQ(std::memcmp(stream.str().data(), buffer.data(), buffer.size()), 0);
+}
+
+XM_TEST_F(XonBinary, File)
+{
+  FileBuffer file;
+  XM_ASSERT_TRUE(file.Open("xontest1.xon"));
+
+  std::unique_ptr<XonObject> tree(XonBuildTree(file.CastData<char>(), file.GetSize()));
+  XM_ASSERT_NE(tree, nullptr);
+
+  std::vector<uint8_t> buffer;
+  xr::XonBinary::Write(*tree, buffer);
+  auto root = xr::XonBinary::GetRoot(buffer.data(), buffer.size());
+  XM_ASSERT_NE(root, nullptr);
+  Compare(*tree, *root);
+}
+
+XM_TEST(XonBinary, Invalid)
+{
+  auto tree = BuildTree("{ a: 1 }");
+  std::vector<uint8_t> buffer;
+  xr::XonBinary::Write(*tree, buffer);
+
+  XM_ASSERT_EQ(xr::XonBinary::GetRoot(buffer.data(), buffer.size() - 1), nullptr);
+
+  auto text = "{ a: 1 } is not binary XON";
+  std::vector<uint32_t> aligned(strlen(text) / 4 + 1);
+  std::memcpy(aligned.data(), text, strlen(text));
+  XM_ASSERT_EQ(xr::XonBinary::GetRoot(aligned.data(), strlen(text)), nullptr);
+
+  buffer[4] = xr::XonBinary::kVersion + 1;
+  XM_ASSERT_EQ(xr::XonBinary::GetRoot(buffer.data(), buffer.size()), nullptr);
+}
+
+struct Order
+{
+  struct Item
+  {
+    uint64_t id;
+    uint32_t quantity;
+  };
+
+  std::vector<Item> items;
+  std::string recipientName;
+  uint32_t houseNo;
+};
+
+auto kOrderItemReader = std::move(XonBinaryReader<Order::Item>()
+  .Register("id", Structured::MakeProperty<Order::Item>(XonBinaryRead::Number<uint64_t>, &Order::Item::id), Structured::REQUIRED)
+  .Register("quantity", Structured::MakeProperty<Order::Item>(XonBinaryRead::Number<uint32_t>, &Order::Item::quantity))
+);
+
+auto kOrderReader = std::move(XonBinaryReader<Order>()
+  .Register("items", Structured::MakeProperty<Order>(
+    XonBinaryRead::Array<Order::Item, decltype(kOrderItemReader)::Read>,
+    &Order::items))
+  .Register("recipientName", Structured::MakeProperty<Order>(XonBinaryRead::String, &Order::recipientName))
+  .Register("houseNo", Structured::MakeProperty<Order>(XonBinaryRead::Number<uint32_t>, &Order::houseNo))
+);
+
+XM_TEST(XonBinary, Reader)
+{
+  auto tree = BuildTree("{ items: { { id: 274634674, quantity: 5428 }, { id: 653764 } },"
+    "recipientName: \"Johan Fucek\", houseNo: 126 }");
+  std::vector<uint8_t> buffer;
+  xr::XonBinary::Write(*tree, buffer);
+  auto root = xr::XonBinary::GetRoot(buffer.data(), buffer.size());
+
+  kOrderItemReader.SetInstance();
+
+  Order order{ {}, {}, 0 };
+  kOrderReader.Process(*root, order);
+  XM_ASSERT_EQ(order.items.size(), 2u);
+  XM_ASSERT_EQ(order.items[0].id, 274634674u);
+  XM_ASSERT_EQ(order.items[0].quantity, 5428u);
+  XM_ASSERT_EQ(order.items[1].id, 653764u);
+  XM_ASSERT_EQ(order.recipientName, "Johan Fucek");
+  XM_ASSERT_EQ(order.houseNo, 126u);
+
+  auto xon = BuildTree("{ 1, 2, 3 }");
+  xr::XonBinary::Write(*xon, buffer);
+  auto numbers = XonBinaryRead::Array<int, XonBinaryRead::Number<int>>(
+    *xr::XonBinary::GetRoot(buffer.data(), buffer.size()));
+  XM_ASSERT_EQ(numbers, (std::vector<int>{ 1, 2, 3 }));
+}
+
+XM_TEST(XonBinary, LoadBenchmark)
+{
+  if (!IsBenchmarkEnabled())
+  {
+    return;
+  }
+
+  std::string xon = "{\n";
+  for (int i = 0; i < 5000; ++i)
+  {
+    xon += "  sprite" + std::to_string(i) + ": { x: " + std::to_string(i % 512) +
+      ", y: " + std::to_string(i / 512) + ", w: 32, h: 32, pivot: { 0.5, 0.5 } },\n";
+  }
+  xon += "}\n";
+
+  auto tree = BuildTree(xon.c_str());
+  std::vector<uint8_t> buffer;
+  xr::XonBinary::Write(*tree, buffer);
+  tree.reset();
+
+  const int kPasses = 5;
+  int sum = 0;
+  auto lookUp = [&sum](auto const& root) {
+    for (int i = 0; i < 5000; i += 7)
+    {
+      auto& sprite = root.Get("sprite" + std::to_string(i)).ToObject();
+      sum += sprite.Get("w").ToValue().GetString()[0];
+    }
+  };
+
+  const double treeMs = TimeMs(kPasses, [&xon, &lookUp] {
+    auto root = BuildTree(xon.c_str());
+    lookUp(*root);
+  });
+
+  const double binaryMs = TimeMs(kPasses, [&buffer, &lookUp] {
+    lookUp(*xr::XonBinary::GetRoot(buffer.data(), buffer.size()));
+  });
+
+  XM_ASSERT_NE(sum, 0);
+  XR_TRACE(XonBinary, ("%zu bytes of XON (%zu binary); parse + lookups: %.3fms, binary lookups: %.3fms",
+    xon.size(), buffer.size(), treeMs, binaryMs));
+  (void)treeMs;
+  (void)binaryMs;
+}
+
+}
@@ -7,12 +7,17 @@
 //
 //==============================================================================
 #include "xm.hpp"
+#include "Benchmark.hpp"
 #include "FileLifeCycleManager.hpp"
 #include "xr/FileBuffer.hpp"
 #include "xr/xon/XonParser.hpp"
 #include "xr/xon/XonBuildTree.hpp"
+#include "xr/memory/Arena.hpp"
+#include <algorithm>
+#include <cstring>
 #include <list>
 #include <functional>
+#include <iterator>
 
 using namespace xr;
 
@@ -306,6 +311,193 @@ XM_TEST_F(Xon, ReadInvalid)  // Read a bunch of invalid xon files. All should fa
   }
 }
 
+void AssertEqual(XonEntity const& a, XonEntity const& b)
+{
+  XM_ASSERT_EQ(a.GetType(), b.GetType());
+  if (a.Is(XonEntity::Type::Object))
+  {
+    auto& objectA = a.ToObject();
+    auto& objectB = b.ToObject();
+    XM_ASSERT_EQ(objectA.GetNumElements(), objectB.GetNumElements());
+    for (size_t i = 0; i < objectA.GetNumElements(); ++i)
+    {
+      AssertEqual(objectA[i], objectB[i]);
+    }
+
+    std::vector<std::string> keysA;
+    objectA.GetKeys(keysA);
+    std::vector<std::string> keysB;
+    objectB.GetKeys(keysB);
+    XM_ASSERT_EQ(keysA, keysB);
+    for (auto& k : keysA)
+    {
+      AssertEqual(objectA.Get(k), objectB.Get(k));
+    }
+  }
+  else
+  {
+    auto& valueA = a.ToValue();
+    auto& valueB = b.ToValue();
+    XM_ASSERT_EQ(valueA.GetLength(), valueB.GetLength());
+    XM_ASSERT_EQ(valueA.GetString() == nullptr, valueB.GetString() == nullptr);
+    if (valueA.GetString())
+    {
+      XM_ASSERT_STREQ(valueA.GetString(), valueB.GetString());
+    }
+  }
+}
+
+XM_TEST_F(Xon, ReadValidArena)
+{
+  xr::FileBuffer  buffer;
+  buffer.Open("xontest1.xon");
+
+  std::unique_ptr<XonObject> root(XonBuildTree(buffer.CastData<char>(), buffer.GetSize()));
+  XM_ASSERT_NE(root, nullptr);
+
+  Arena arena;
+  XonParser::State  readState;
+  XonObject* arenaRoot = XonBuildTree(buffer.CastData<char>(), buffer.GetSize(), arena,
+    &readState);
+  XM_ASSERT_NE(arenaRoot, nullptr);
+  XM_ASSERT_EQ(readState.cursor, buffer.CastData<char>() + buffer.GetSize());
+
+  AssertEqual(*root, *arenaRoot);
+
+  // The tree, with all of its storage, is in the arena - in its only block.
+  auto isInArena = [&arena](void const* p) {
+    auto bytes = static_cast<uint8_t const*>(p);
+    auto start = static_cast<uint8_t const*>(arena.Allocate(0, 1)) - arena.CalculateUsed();
+    return arena.GetNumBlocks() == 1 && bytes >= start && bytes < start + arena.CalculateUsed();
+  };
+  XM_ASSERT_TRUE(isInArena(arenaRoot));
+  XM_ASSERT_TRUE(isInArena(&(*arenaRoot)[0]));
+  XM_ASSERT_TRUE(isInArena((*arenaRoot)[0].ToValue().GetString()));
+  XM_ASSERT_TRUE(isInArena(arenaRoot->begin()));
+
+  char arBuffer[256];
+  for (int i = 0; i < 5; ++i)
+  {
+    sprintf(arBuffer, "invalid%d.xon", i + 1);
+    buffer.Open(arBuffer);
+
+    XM_ASSERT_EQ(XonBuildTree(buffer.CastData<char>(), buffer.GetSize(), arena), nullptr);
+  }
+}
+
+XM_TEST(Xon, Keys)
+{
+  for (int numKeys : { 3, 100 }) // linear search / indexed
+  {
+    XonObject object;
+    std::vector<std::string> names;
+    for (int i = 0; i < numKeys; ++i)
+    {
+      names.push_back("key" + std::to_string(i));
+      object.AddElement(std::string_view{ names.back() }, *new XonValue(names.back()));
+    }
+    XM_ASSERT_EQ(object.GetNumKeys(), size_t(numKeys));
+
+    for (auto& n : names)
+    {
+      XM_ASSERT_STREQ(object.Get(n).ToValue().GetString(), n.c_str());
+      XM_ASSERT_EQ(object.TryGet(std::string_view{ n }), &object.Get(n));
+    }
+    XM_ASSERT_EQ(object.TryGet("key"), nullptr);
+    XM_ASSERT_EQ(object.TryGet(std::string_view{ "key10", 4 }), &object.Get("key1"));
+
+    // Overrides keep the order of first declaration.
+    auto v = new XonValue("override", 8);
+    object.AddElement(std::string_view{ "key0" }, *v);
+    XM_ASSERT_EQ(&object.Get("key0"), v);
+    XM_ASSERT_EQ(object.GetNumKeys(), size_t(numKeys));
+    XM_ASSERT_EQ(object.GetNumElements(), size_t(numKeys + 1));
+
+    size_t i = 0;
+    object.ForEachKeyInOrder([&names, &i](std::string_view key) {
+      XM_ASSERT_EQ(key, names[i]);
+      ++i;
+    });
+    XM_ASSERT_EQ(i, names.size());
+
+    // GetKeys() sorts them.
+    std::vector<std::string> keys;
+    object.GetKeys(keys);
+    std::sort(names.begin(), names.end());
+    XM_ASSERT_EQ(keys, names);
+
+    std::vector<std::string> keysFn;
+    object.GetKeys([&keysFn](std::string const& key) {
+      keysFn.push_back(key);
+    });
+    XM_ASSERT_EQ(keysFn, names);
+
+    std::vector<std::string> keysIt;
+    object.GetKeys(std::back_inserter(keysIt));
+    XM_ASSERT_EQ(keysIt, names);
+  }
+}
+
+XM_TEST(Xon, BuildTreeBenchmark)
+{
+  if (!IsBenchmarkEnabled())
+  {
+    return;
+  }
+
+  std::string xon = "{\n";
+  for (int i = 0; i < 5000; ++i)
+  {
+    xon += "  sprite" + std::to_string(i) + ": { x: " + std::to_string(i % 512) +
+      ", y: " + std::to_string(i / 512) + ", w: 32, h: 32, pivot: { 0.5, 0.5 } },\n";
+  }
+  xon += "}\n";
+
+  std::vector<std::string> names;
+  for (int i = 0; i < 5000; i += 7)
+  {
+    names.push_back("sprite" + std::to_string(i));
+  }
+
+  const int kPasses = 5;
+  const int kLookupPasses = 20;
+  int sum = 0;
+  auto lookUp = [&sum, &names](XonObject const& root) {
+    for (auto& n : names)
+    {
+      auto& sprite = root.Get(n).ToObject();
+      sum += sprite.Get("w").ToValue().GetString()[0];
+    }
+  };
+
+  const double heapParseMs = TimeMs(kPasses, [&xon]() {
+    std::unique_ptr<XonObject> root(XonBuildTree(xon.c_str(), xon.size()));
+    XM_ASSERT_NE(root, nullptr);
+  });
+
+  Arena arena;
+  const double arenaParseMs = TimeMs(kPasses, [&xon, &arena]() {
+    arena.Reset();
+    XM_ASSERT_NE(XonBuildTree(xon.c_str(), xon.size(), arena), nullptr);
+  });
+
+  std::unique_ptr<XonObject> root(XonBuildTree(xon.c_str(), xon.size()));
+  const double heapLookupMs = TimeMs(kLookupPasses, [&root, &lookUp]() { lookUp(*root); });
+
+  arena.Reset();
+  auto arenaRoot = XonBuildTree(xon.c_str(), xon.size(), arena);
+  const double arenaLookupMs = TimeMs(kLookupPasses, [arenaRoot, &lookUp]() { lookUp(*arenaRoot); });
+
+  XM_ASSERT_NE(sum, 0);
+  XR_TRACE(Xon, ("%zu bytes of XON; parse: %.3fms (heap), %.3fms (arena, %zu bytes); "
+    "%zu lookups: %.3fms (heap), %.3fms (arena)", xon.size(), heapParseMs, arenaParseMs,
+    arena.CalculateUsed(), names.size() * 2, heapLookupMs, arenaLookupMs));
+  (void)heapParseMs;
+  (void)arenaParseMs;
+  (void)heapLookupMs;
+  (void)arenaLookupMs;
+}
+
 void TestXonError(std::function<void()> fn, XonEntity::Exception::Type testType)
 {
   XM_ASSERT_THROW(fn(), XonEntity::Exception);
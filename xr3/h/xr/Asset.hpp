@@ -33,8 +33,9 @@ class FileWriter;
 /// assets, while managing dependencies and ownership.
 ///@par The Asset::Manager builds assets from their raw format upon loading, in
 /// ENABLE_ASSET_BUILDING versions of XRhodes (as Debug is), if the raw asset is
-/// newer than its built counterpart, or the asset version was mismatched, or if
-/// the ForceBuild flag was specified.
+/// newer than its built counterpart (and its contents have changed since it was
+/// last built), or the asset version was mismatched, or if the ForceBuild flag
+/// was specified.
 ///@par The location that the built assets are saved to is ${ram_path}/${asset_path}
 /// (refer to xr::File for more information).
 ///@par Built assets are identified by a hash of their original (relative) path.
@@ -201,7 +202,11 @@ public:
     /// will be stripped from the supplied path.
     ///@note The asset path should not contain any other data, at the risk of
     /// being overwrittens.
-    static void Init(FilePath path = kDefaultPath, Allocator* alloc = nullptr);
+    ///@param numLoaderThreads The number of threads that asset data is read on,
+    /// asynchronously. 0 means one per hardware thread. Assets are still
+    /// processed on the thread that calls Update(), dependencies first.
+    static void Init(FilePath path = kDefaultPath, Allocator* alloc = nullptr,
+      uint32_t numLoaderThreads = 1);
 
     ///@return The path that the Asset::Manager was initialised with.
     static const FilePath& GetAssetPath();
@@ -213,6 +218,34 @@ public:
     /// stripping of ram / rom and asset paths (but not the rest of the path).
     static HashType HashPath(FilePath path);
 
+    ///@brief Mounts the archive of built assets at @a path, which is then
+    /// searched for assets when loading them. Archives mounted later take
+    /// precedence. With asset building enabled, loose built assets in the asset
+    /// path are looked for first; otherwise archives are.
+    ///@note Must not be called concurrently with the loading of assets.
+    ///@return The success of the operation.
+    static bool MountArchive(FilePath const& path);
+
+    ///@brief Writes the built assets of the given descriptors, from the asset
+    /// path, into a single archive at @a path, which is indexed by their hashes.
+    ///@return The success of the operation.
+    static bool WriteArchive(FilePath const& path,
+      std::vector<DescriptorCore> const& assets);
+
+#ifdef ENABLE_ASSET_BUILDING
+    ///@brief Builds the raw assets at the given @a paths, where needed, on
+    /// @a numThreads threads (0 means one per hardware thread), blocking until
+    /// done. Doesn't load the assets.
+    ///@par The hashes of the contents of the sources are recorded in a build
+    /// cache in the asset path, and assets whose sources have only been touched
+    /// since they were last built, are not rebuilt (unless ForceBuildFlag is set).
+    ///@note The Builders of the types involved must support being invoked
+    /// concurrently.
+    ///@return The number of assets that failed to build.
+    static size_t BuildAll(std::vector<FilePath> const& paths, uint32_t numThreads = 0,
+      FlagType flags = 0);
+#endif
+
     ///@brief Attempts to load a built asset from the asset path that the given
     /// @a path hashes to. If asset building is enabled, the actual @a path will
     /// be checked for a raw asset either more recently modified than its built
@@ -458,7 +491,8 @@ protected:
 
   // virtual
   ///@brief Performs the actual processing of the data. Called when asset data is
-  /// ready to process -- by ProcessData().
+  /// ready to process -- by ProcessData(). The data of @a buffer is aligned to
+  /// alignof(std::max_align_t), and only valid for the duration of the call.
   ///@return The success of the operation.
   virtual bool OnLoaded(Buffer buffer) = 0;
 
@@ -531,7 +565,7 @@ template<class T>
 inline
 Counted<T> Asset::Manager::FindOrCreate(Descriptor<T> const& desc, FlagType flags)
 {
-  return FindOrCreateInternal(desc, flags);
+  return FindOrCreateInternal<T>(desc, flags);
 }
 
 //==============================================================================
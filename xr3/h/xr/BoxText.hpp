@@ -151,6 +151,19 @@ public:
   void Generate(Measurement const& m, uint32_t attribStride, Vector3* positions,
     Vector2* uvs, bool updateGlyphCache, Stats* statsOut) const;
 
+  ///@brief Calculates vertex positions and UVs for the lines of the given
+  /// Measurement from @a firstLine onwards, as the above would, to support the
+  /// partial update of a mesh.
+  ///@param firstLine index of the first line to generate vertices for.
+  ///@param positions, uvs Arrays to write the vertices of the first glyph of
+  /// @a firstLine, and onwards, to.
+  ///@param lineGlyphCountsOut Optional array to write the number of glyphs that
+  /// were generated for each line from @a firstLine, to.
+  ///@note Stats are for all lines.
+  void Generate(Measurement const& m, size_t firstLine, uint32_t attribStride,
+    Vector3* positions, Vector2* uvs, uint32_t* lineGlyphCountsOut,
+    bool updateGlyphCache, Stats* statsOut) const;
+
   ///@brief Convenience function to calculate vertex positions and UVs for the
   /// given Measurement into the given array of vertices, in the given vertex format
   /// (which must have Vector3 position and Vector2 uv). Currently restricted to
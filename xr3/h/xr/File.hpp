@@ -36,6 +36,9 @@ public:
   // types
   using Handle = void*;
 
+  struct Mapping;
+  using MappingHandle = Mapping*;
+
   enum class SeekFrom
   {
     Start,
@@ -105,6 +108,21 @@ public:
   ///@brief Closes and invalidates the file handle.
   static void Close(Handle hFile);
 
+  ///@brief Attempts to map the whole of a file into memory, for reading. See
+  /// the class docs about the application of RAM and ROM paths.
+  ///@return Handle to the mapping, nullptr if the file couldn't be mapped, i.e.
+  /// it couldn't be opened, it was empty, or the platform doesn't support it.
+  [[nodiscard]] static MappingHandle Map(FilePath const& path);
+
+  ///@return The address that the file of the given mapping starts at.
+  static uint8_t const* GetMappedData(MappingHandle hMapping);
+
+  ///@return The size of the file of the given mapping, in bytes.
+  static size_t GetMappedSize(MappingHandle hMapping);
+
+  ///@brief Unmaps the file and invalidates the mapping handle.
+  static void Unmap(MappingHandle hMapping);
+
   ///@brief Deletes the file in ramPath, at the given @a path. A raw path may
   /// be used instead by prefixing path with kRawProto.
   ///@return Whether the operation was successful.
@@ -14,7 +14,8 @@
 #include "AABB.hpp"
 #include "IMaterialisable.hpp"
 #include "xr/math/Vector2.hpp"
-#include <map>
+#include <unordered_map>
+#include <vector>
 
 namespace xr
 {
@@ -86,50 +87,75 @@ public:
   ///@return Glyph data, if it exists for the given @a codePoint in the Font.
   Glyph const* GetGlyph(uint32_t codePoint) const;
 
+  ///@brief Looks up the glyphs for @a count code points from @a codePoints,
+  /// writing them to @a glyphsOut; nullptr for the ones the font doesn't have.
+  void GetGlyphs(uint32_t const* codePoints, size_t count, Glyph const** glyphsOut) const;
+
   ///@return The binary blob of glyph bitmaps, indexible into using Glyph::dataOffset,
   /// fieldWidth and fieldHeight.
   uint8_t const* GetGlyphBitmapData() const;
 
   ///@brief Attempts to copy a glyph's data to the cache and return its UVs.
+  /// If there isn't enough room in the cache, the least recently used glyphs
+  /// are evicted, to make room.
   ///@return A pointer to the UVs of of the glyph over the cache texture; nullptr
-  /// in case of a failure, which might mean a failure to allocate space, or that
-  /// the font didn't have the glyph.
+  /// if the font didn't have the glyph. The UVs are empty if the glyph has no
+  /// bitmap, or space couldn't be allocated even with all glyphs evicted.
   ///@note There is no guarantee for the returned pointer to remain valid past
   /// a subsequent call to CacheGlyph(), therefore you should not store it.
+  ///@note Meshes that were created with the UVs of glyphs since evicted, will
+  /// show whatever took their place in the cache; the number of glyphs used at
+  /// any one time should fit in the cache.
   CachedGlyph const* CacheGlyph(uint32_t codePoint);
 
   ///@brief Updates the texture used for caching the glyphs; this needs to be
   /// called after caching glyphs.
-  ///@note It will only re-upload the texture if any glyphs have been successfully
-  /// cached since last call.
+  ///@note The first call creates the texture; subsequent ones only upload the
+  /// regions of the glyphs that were cached since the last call, if any.
   void UpdateCache();
 
   ///@brief Removes all cached glyphs.
   void ClearCache();
 
+  ///@return A number that changes whenever glyphs are evicted from the cache,
+  /// or it's cleared. UVs obtained from CacheGlyph() remain valid until then.
+  uint32_t GetCacheGeneration() const;
+
   ///@brief Returns the Texture used by the Font as glyph cache.
   Texture::Ptr GetTexture() const override;
 
 protected:
   // types
-  typedef std::map<uint32_t, Glyph>  GlyphMap;
-
   struct CachedGlyphInternal
   {
     uint8_t* buffer;
     CachedGlyph glyph;
+    uint32_t prev;  // more recently used
+    uint32_t next;  // less recently used, or next free one.
   };
 
+  // static
+  static constexpr uint32_t kNumDenseCodePoints = 0x250; // Basic Latin to Latin Extended-B
+  static constexpr uint32_t kNoIndex = uint32_t(-1);
+
   // data
   float m_lineHeight;
   float m_ascent;
 
   std::vector<CachedGlyphInternal> m_cachedGlyphs;
+  uint32_t m_mostRecentlyUsed = kNoIndex; // only glyphs with a buffer are listed.
+  uint32_t m_leastRecentlyUsed = kNoIndex;
+  uint32_t m_firstFreeCachedGlyph = kNoIndex;
+  CachedGlyphInternal m_uncachedGlyph;  // for glyphs that couldn't be allocated space.
   Texture::Ptr m_texture;
   class TextureCache* m_textureCache = nullptr;
-  bool m_cacheDirty = false;
+  bool m_uploadWholeCache = false;
+  uint32_t m_cacheGeneration = 0;
 
-  GlyphMap  m_glyphs;
+  std::vector<Glyph>  m_glyphs;
+  std::vector<uint32_t> m_denseGlyphIndices;  // by code point; no larger than kNumDenseCodePoints.
+  std::unordered_map<uint32_t, uint32_t> m_sparseGlyphIndices; // the rest of the code points.
+  std::vector<uint32_t> m_cachedGlyphIndices; // to m_cachedGlyphs, for each of m_glyphs.
   std::vector<uint8_t>  m_glyphBitmaps;
 
   Px m_cacheSideSizePixels;
@@ -138,7 +164,13 @@ protected:
   virtual bool OnLoaded(Buffer buffer) override;
   virtual void OnUnload() override;
 
+  uint32_t FindGlyphIndex(uint32_t codePoint) const;
+
   CachedGlyphInternal* CacheGlyphInternal(uint32_t codePoint);
+
+  void LinkMostRecentlyUsed(uint32_t index);
+  void Unlink(uint32_t index);
+  void EvictLeastRecentlyUsed();
 };
 
 //==============================================================================
@@ -168,8 +200,28 @@ float Font::GetScaleForHeight(float hPixels) const
 inline
 Font::Glyph const*  Font::GetGlyph(uint32_t codePoint) const
 {
-  GlyphMap::const_iterator iFind(m_glyphs.find(codePoint));
-  return iFind != m_glyphs.end() ? &iFind->second : nullptr;
+  auto index = FindGlyphIndex(codePoint);
+  return index != kNoIndex ? m_glyphs.data() + index : nullptr;
+}
+
+//==============================================================================
+inline
+void Font::GetGlyphs(uint32_t const* codePoints, size_t count,
+  Glyph const** glyphsOut) const
+{
+  for (auto iEnd = codePoints + count; codePoints != iEnd; ++codePoints)
+  {
+    auto index = FindGlyphIndex(*codePoints);
+    *glyphsOut = index != kNoIndex ? m_glyphs.data() + index : nullptr;
+    ++glyphsOut;
+  }
+}
+
+//==============================================================================
+inline
+uint32_t Font::GetCacheGeneration() const
+{
+  return m_cacheGeneration;
 }
 
 //==============================================================================
@@ -179,6 +231,19 @@ uint8_t const* Font::GetGlyphBitmapData() const
   return m_glyphBitmaps.data();
 }
 
+//==============================================================================
+inline
+uint32_t Font::FindGlyphIndex(uint32_t codePoint) const
+{
+  if (codePoint < m_denseGlyphIndices.size())
+  {
+    return m_denseGlyphIndices[codePoint];
+  }
+
+  auto iFind = m_sparseGlyphIndices.find(codePoint);
+  return iFind != m_sparseGlyphIndices.end() ? iFind->second : kNoIndex;
+}
+
 } // xr
 
 #endif  //XR_FONT_HPP
@@ -19,6 +19,7 @@
 #include "xr/debug.hpp"
 #include "xr/utils.hpp"
 #include <cstring>
+#include <vector>
 
 namespace xr
 {
@@ -281,6 +282,65 @@ struct TextureInfo
   FlagType flags;
 };
 
+//=============================================================================
+///@brief Statistics of the commands that the renderer has processed for a frame.
+struct FrameStats
+{
+  uint32_t numCommands; // state and draw commands issued by the client.
+  uint32_t numDraws;
+  uint32_t numEliminatedCommands; // redundant state commands that were dropped.
+  uint32_t numCommandBytes; // size of all commands recorded for the frame.
+  uint32_t peakCommandBytes; // the largest numCommandBytes of any frame so far.
+  uint32_t numTextureUploadBytes; // texel data passed to CreateTexture() and UpdateTexture().
+  uint32_t numVertexUploadBytes; // vertex data passed to CreateVertexBuffer() and UpdateVertexBuffer().
+};
+
+//=============================================================================
+///@brief A command that has reached the renderer, in headless mode (see Init()
+/// and StartRecording()).
+struct CommandRecord
+{
+  enum class Type: uint8_t
+  {
+    ReleaseVertexFormat,
+    CreateVertexBuffer,
+    UpdateVertexBuffer,
+    ReleaseVertexBuffer,
+    CreateIndexBuffer,
+    ReleaseIndexBuffer,
+    CreateInstanceDataBuffer,
+    ReleaseInstanceDataBuffer,
+    CreateTexture,
+    UpdateTexture,
+    ReleaseTexture,
+    CreateFrameBuffer,
+    ReleaseFrameBuffer,
+    CreateShader,
+    ReleaseShader,
+    CreateProgram,
+    ReleaseProgram,
+    Clear,
+    SetViewport,
+    SetScissor,
+    SetUniform,
+    SetTexture,
+    SetState,
+    SetStencilState,
+    SetInstanceData,
+    SetProgram,
+    SetFrameBuffer,
+    Draw,
+    DrawIndexed,
+    Flush,
+    Present,
+    ReadFrameBuffer,
+  };
+
+  Type type;
+  uint16_t id; // of the resource that the command concerns, if any.
+  uint32_t params[4]; // command specific, in the order of Core's parameters.
+};
+
 //=============================================================================
 enum class ShaderType: uint8_t
 {
@@ -350,6 +410,7 @@ GFX_HANDLE_DECL(FrameBufferHandle)
 GFX_HANDLE_DECL(ShaderHandle)
 GFX_HANDLE_DECL(ProgramHandle)
 GFX_HANDLE_DECL(UniformHandle)
+GFX_HANDLE_DECL(CommandListHandle)
 #undef GFX_HANDLE_DECL
 
 //=============================================================================
@@ -417,11 +478,32 @@ constexpr FlagType StencilToState(uint8_t ref, uint8_t mask,
 /// Flush()ed or a frame was Present()ed.<br/>
 /// Multithreaded rendering may be configured using the following options:<br />
 /// XR_GFX_MULTITHREADED: 0 (off, default) / 1 (on).
-/// XR_GFX_COMMAND_BUFFER_SIZE: size of command buffer in bytes. Default is 64KB.
+/// XR_GFX_COMMAND_BUFFER_SIZE: size of command buffer pages in bytes; further
+/// pages are chained on, from a pool, when a page fills up. Default is 64KB.
+/// XR_GFX_FRAMES_IN_FLIGHT: the number of submissions (Flush()es and
+/// Present()s) that may be queued up for the render thread before the caller
+/// blocks. Default is 1; 2 is equivalent to triple buffering.
+/// XR_GFX_SORT_DRAWS: 0 (off, default) / 1 (on). Sorts the draws between
+/// commands that draws may not be moved across (clearing, setting the viewport,
+/// scissor or frame buffer, resource creation, flushing), by their program,
+/// textures, state and sort depth (see SetSortDepth()), and drops redundant
+/// state commands. Only draws with depth test enabled, a depth function other
+/// than EQUAL, and stencil test disabled are reordered; opaque ones must also
+/// have depth write enabled. Alpha blended ones are drawn after the opaque
+/// ones, back to front. Sorting is off by default, since it adds CPU time per
+/// draw on the render thread; it pays off where the state changes it removes
+/// cost the driver more than that.
+/// Gfx may be run headless, i.e. with a renderer that does no rendering, but
+/// tracks resources and (optionally) records the commands that it receives
+/// (see StartRecording()) - for testing and benchmarking, without a GPU:<br />
+/// XR_GFX_HEADLESS: 0 (off, default) / 1 (on). @a context may be null in
+/// headless mode, in which case XR_DISPLAY_WIDTH and XR_DISPLAY_HEIGHT
+/// determine the size of the rendering area.
 ///@note Multithreaded rendering may be useful when you find your game update
 /// expensive; otherwise it is not guaranteed to perform better than single
 /// threaded.
-///@note Gfx APIs must still only be called from a single thread.
+///@note Gfx APIs must still only be called from a single thread, except
+/// between BeginCommandList() and EndCommandList() (see ReserveCommandList()).
 void Init(Context* context);
 
 ///@return Logical width of rendering area in pixels.
@@ -477,6 +559,12 @@ void Release(VertexFormatHandle h);
 VertexBufferHandle  CreateVertexBuffer(VertexFormatHandle hFormat,
   Buffer const& buffer, FlagType flags = F_BUFFER_NONE);
 
+///@brief Replaces the data of the vertex buffer @a h from @a offset bytes
+/// onwards, with the contents of @a buffer.
+///@note The range must be within the size that the buffer was created with.
+///@note The vertex data isn't kept around by Gfx.
+void UpdateVertexBuffer(VertexBufferHandle h, uint32_t offset, Buffer const& buffer);
+
 ///@brief Signifies the end of ownership of a vertex buffer, destroying it if
 /// no other owners were left.
 void Release(VertexBufferHandle h);
@@ -513,6 +601,14 @@ TextureHandle CreateTexture(TextureFormat format, Px width, Px height,
 TextureHandle CreateTexture(TextureFormat format, Px width, Px height,
   Px depth, FlagType flags);
 
+///@brief Replaces the texels of the @a width by @a height pixel region at
+/// @a x, @a y of the top mipmap level of the 2D texture @a h, with the ones in
+/// @a buffer, which are tightly packed, in the format of the texture.
+///@note Mipmaps are not regenerated; compressed formats are not supported.
+///@note The texel data isn't kept around by Gfx.
+void UpdateTexture(TextureHandle h, Px x, Px y, Px width, Px height,
+  Buffer const& buffer);
+
 ///@return Description of the texture that @a h is for.
 TextureInfo GetTextureInfo(TextureHandle h);
 
@@ -639,6 +735,11 @@ void SetProgram(ProgramHandle h);
 ///@brief Sets a frame buffer that subsequent Draw() calls will to render to.
 void SetFrameBuffer(FrameBufferHandle h);
 
+///@brief Sets the depth of subsequent Draw() calls for the purposes of sorting;
+/// greater values are further away. Only has an effect in multithreaded mode
+/// with XR_GFX_SORT_DRAWS enabled.
+void SetSortDepth(uint16_t depth);
+
 ///@brief Draws the contents of the given vertex buffer; @a count vertices
 /// starting from @a offset.
 void Draw(VertexBufferHandle vbh, Primitive primitive, uint32_t offset, uint32_t count);
@@ -694,6 +795,44 @@ void ReadFrameBuffer(Px x, Px y, Px width, Px height,
   TextureFormat format, uint8_t colorAttachment, void* mem,
   ReadFrameBufferCompleteCallback* onComplete = nullptr);
 
+///@brief Reserves a command list at the current point of the command stream,
+/// for recording on another thread. The commands recorded into it are
+/// executed after the ones issued before, and before the ones issued after
+/// this call, regardless of when or on which thread they were recorded.<br/>
+/// Every list that was reserved must be recorded into - between a call to
+/// BeginCommandList() and EndCommandList() - exactly once, before the next
+/// Flush(), Present() or ReadFrameBuffer(), which will block until all lists
+/// have ended (in debug builds, the lists that haven't are reported, if this
+/// takes longer than a second). The handle is invalid after that.
+///@return The handle to the list, which is invalid in single threaded mode,
+/// where recording on other threads isn't supported.
+///@note Must be called from the main thread.
+CommandListHandle ReserveCommandList();
+
+///@brief Makes the subsequent Gfx calls of the calling thread record into the
+/// list identified by @a h, until EndCommandList(). Flush(), Present(),
+/// ReadFrameBuffer(), ReserveCommandList() and Shutdown() may not be called
+/// while recording.
+void BeginCommandList(CommandListHandle h);
+
+///@brief Ends recording into the list that the calling thread has begun.
+void EndCommandList();
+
+///@brief Starts recording the commands that reach the renderer, discarding
+/// any previous records. Only supported in headless mode.
+void StartRecording();
+
+///@brief Stops recording.
+///@return The commands that have reached the renderer since StartRecording().
+///@note In multithreaded mode, this doesn't include commands that haven't
+/// been processed yet.
+std::vector<CommandRecord> StopRecording();
+
+///@return Statistics of the commands processed for the last Present()ed frame.
+///@note Only numTextureUploadBytes and numVertexUploadBytes are gathered in
+/// single threaded mode; the rest are zeroes.
+FrameStats GetFrameStats();
+
 ///@return A signal which is emitted upon Flush().
 ///@note In multithreaded mode, this means the issuing of a Flush command, not
 /// the execution.
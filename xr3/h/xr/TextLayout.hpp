@@ -0,0 +1,176 @@
+#ifndef XR_TEXTLAYOUT_HPP
+#define XR_TEXTLAYOUT_HPP
+//==============================================================================
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "BoxText.hpp"
+#include "IndexMesh.hpp"
+#include <string>
+#include <vector>
+
+namespace xr
+{
+
+//==============================================================================
+///@brief Keeps a copy of a string of text, its layout by a BoxText, and an
+/// IndexMesh created from it, for text that is shown over multiple frames and
+/// changes occasionally (e.g. a label with a score). When the text changes,
+/// only the lines from the first one that has changed are re-generated and
+/// their vertices uploaded. Unchanged text costs nothing to Update().
+///@note The whole of the text is measured again on each change; BoxText
+/// carries the state of its line breaking from one line to the next, e.g. the
+/// part of a word that is wrapped, so it can't restart from a given line. The
+/// cost of Update() therefore grows with the length of the text, rather than
+/// just that of the change.
+///@note The mesh has 16-bit indices; text with more glyphs than those can
+/// address is cut at the last glyph that they can.
+///@note The vertices use the UVs of the glyphs in the cache of the Font at the
+/// time of their generation; if any glyphs are evicted from it since, the whole
+/// of the text is re-generated.
+class TextLayout
+{
+public:
+  // structors
+  TextLayout();
+
+  // general
+  ///@brief Sets the BoxText whose Font and parameters to lay the text out with,
+  /// taking a copy of it. The whole text will be re-generated on Update().
+  ///@note A font must be set.
+  void SetBoxText(BoxText const& boxText);
+
+  ///@return The BoxText that the text is laid out with.
+  BoxText const& GetBoxText() const;
+
+  ///@brief Sets the UTF-8 encoded @a text, up to the first null terminator.
+  /// If it differs from the current text, the lines from the first change
+  /// onwards will be re-generated on Update().
+  void SetText(char const* text);
+
+  ///@brief Sets @a numBytes bytes of UTF-8 encoded @a text. If it differs from
+  /// the current text, the lines from the first change onwards will be
+  /// re-generated on Update().
+  void SetText(char const* text, size_t numBytes);
+
+  ///@return The current text.
+  std::string const& GetText() const;
+
+  ///@brief Lays out the text, if it or the BoxText have changed, or glyphs were
+  /// evicted from the Font's cache, since the last call, and updates the mesh.
+  /// Lines from the first one that differs from the previous layout are
+  /// re-generated, and only their vertices are uploaded, unless more glyphs are
+  /// required than there was room for, in which case the mesh is re-created.
+  ///@param updateGlyphCache whether the glyph cache of the Font should be
+  /// updated, if any glyphs were generated.
+  ///@return Whether the mesh has changed.
+  bool Update(bool updateGlyphCache);
+
+  ///@return The result of the last layout. Its lines point into GetText().
+  BoxText::Measurement const& GetMeasurement() const;
+
+  ///@return The stats of the last layout.
+  BoxText::Stats const& GetStats() const;
+
+  ///@return The number of glyphs in the mesh.
+  uint32_t GetNumGlyphs() const;
+
+  ///@return The vertices of the glyphs, 4 for each; there may be room for
+  /// more than GetNumGlyphs().
+  std::vector<BoxText::Vertex> const& GetVertices() const;
+
+  ///@return The mesh of the text, whose vertex and index buffers may have room
+  /// for more than GetNumGlyphs() glyphs; only Quad::kIndexCount indices are
+  /// to be rendered for each of those.
+  IndexMesh const& GetMesh() const;
+
+  ///@brief Renders the glyphs in the mesh as triangles.
+  ///@note A Shader, states and the Font's texture must be set prior to this.
+  void Render() const;
+
+private:
+  // types
+  struct Line
+  {
+    size_t start;  // byte offsets into m_text.
+    size_t end;
+    float width;
+  };
+
+  // data
+  BoxText m_boxText;
+  std::string m_text;
+
+  size_t m_firstChange; // byte offset into m_text; npos if it hasn't changed.
+  bool m_relayoutAll;
+  uint32_t m_cacheGeneration;
+
+  BoxText::Measurement m_measurement;
+  BoxText::Stats m_stats;
+  std::vector<Line> m_lines;
+  std::vector<uint32_t> m_lineGlyphStarts; // for each line, and the end.
+  std::vector<uint32_t> m_lineGlyphCounts; // scratch
+
+  std::vector<BoxText::Vertex> m_vertices;  // 4 for each glyph we have room for.
+  IndexMesh m_mesh;
+};
+
+//==============================================================================
+//  implementation
+//==============================================================================
+inline
+BoxText const& TextLayout::GetBoxText() const
+{
+  return m_boxText;
+}
+
+//==============================================================================
+inline
+std::string const& TextLayout::GetText() const
+{
+  return m_text;
+}
+
+//==============================================================================
+inline
+BoxText::Measurement const& TextLayout::GetMeasurement() const
+{
+  return m_measurement;
+}
+
+//==============================================================================
+inline
+BoxText::Stats const& TextLayout::GetStats() const
+{
+  return m_stats;
+}
+
+//==============================================================================
+inline
+uint32_t TextLayout::GetNumGlyphs() const
+{
+  return m_lineGlyphStarts.back();
+}
+
+//==============================================================================
+inline
+std::vector<BoxText::Vertex> const& TextLayout::GetVertices() const
+{
+  return m_vertices;
+}
+
+//==============================================================================
+inline
+IndexMesh const& TextLayout::GetMesh() const
+{
+  return m_mesh;
+}
+
+} // xr
+
+#endif // XR_TEXTLAYOUT_HPP
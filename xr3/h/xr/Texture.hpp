@@ -92,6 +92,14 @@ public:
   bool Upload(Gfx::TextureFormat format, Px width, Px height,
     Gfx::FlagType createFlags, uint8_t numBuffers, Buffer const* buffers);
 
+  ///@brief Replaces the texels of the region of @a width by @a height pixels
+  /// at @a x, @a y, of the texture that was Upload()ed, with the tightly packed
+  /// ones in @a buffer.
+  ///@return Whether there was a texture to update.
+  ///@note The data kept with KeepSourceDataFlag is not updated.
+  ///@note Must be called from the render thread.
+  bool Update(Px x, Px y, Px width, Px height, Buffer buffer);
+
   ///@brief Binds texture to its target, for the given texture @a stage.
   ///@note Must be called from the render thread.
   void Bind(uint8_t stage) const;
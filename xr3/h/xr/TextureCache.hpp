@@ -63,11 +63,24 @@ public:
   /// heightPixels, its pitch being GetPitch() bytes.
   uint8_t* Allocate(Px widthPixels, Px heightPixels, AABB& uvsOut);
 
-  ///@brief Creates a texture with the contents of the buffer.
+  ///@brief Creates a texture with the contents of the buffer, and clears the
+  /// dirty regions.
   ///@return The handle to and the ownership of, the texture.
-  /// TODO: actual update instead of (re-)creation.
+  ///@note Use ConsumeDirtyRegions() to update an existing texture.
   Gfx::TextureHandle UpdateTexture(uint32_t flags = 0); // ownership transfer
 
+  ///@brief Passes the regions of the buffer that were allocated since they
+  /// were last cleared, to @a fn, along with their pixels, tightly packed, as
+  /// (Rect const& pixels, Buffer const& buffer), then clears them. There is at
+  /// most one region per row.
+  ///@note The buffer is only valid during the call to @a fn.
+  template <typename Fn>
+  void ConsumeDirtyRegions(Fn fn);
+
+  ///@brief Clears the record of the regions that were allocated, e.g. once
+  /// the whole of the buffer was uploaded.
+  void ClearDirtyRegions();
+
   ///@brief Releases the use of the buffer starting at @a buffer, which must
   /// come from a call to Allocate().
   void Deallocate(uint8_t* buffer);
@@ -99,6 +112,7 @@ private:
   {
     Block* blocks;
     Block* firstAvailable;
+    Rect dirty; // in pixels
   };
 
   struct Allocation
@@ -141,13 +155,34 @@ private:
   uint32_t m_numAllocs;
 
   std::vector<uint8_t> m_buffer;
+  std::vector<uint8_t> m_packBuffer; // for ConsumeDirtyRegions().
 
   // internal
   Allocation& Next();
 
+  uint32_t GetNumAllocsToEnd() const; // the rest of them wrap around.
+
   void Deallocate(AllocId id);
+
+  Buffer PackRegion(Rect const& rect);
 };
 
+//==============================================================================
+// implementation
+//==============================================================================
+template <typename Fn>
+void TextureCache::ConsumeDirtyRegions(Fn fn)
+{
+  for (auto& r : m_rows)
+  {
+    if (!r.dirty.IsZero())
+    {
+      fn(r.dirty, PackRegion(r.dirty));
+      r.dirty = Rect();
+    }
+  }
+}
+
 }
 
 #endif
@@ -10,7 +10,11 @@
 //
 //==============================================================================
 
+#include "xr/File.hpp"
+#include "xr/FileWriter.hpp"
 #include "xr/JsonEntity.hpp"
+#include "xr/JsonStreamParser.hpp"
+#include "xr/JsonWriter.hpp"
 
 namespace xr
 {
@@ -23,6 +27,28 @@ namespace xr
 /// an error has occurred, this will be nullptr.
 [[nodiscard]] JSON::Entity* LoadJSON(const char* filename, int maxDepth, bool quietErrors);
 
+//==============================================================================
+///@brief Reads @a hFile from its current position to the end, in chunks of
+/// @a chunkSize bytes, and passes them to @a parser, which must have been
+/// Start()ed. The memory used doesn't depend on the size of the file.
+///@return Whether a complete and valid document was read. In case of an error,
+/// @a parser can tell where it has occurred.
+bool StreamJSON(File::Handle hFile, JSON::StreamParser& parser, size_t chunkSize = 4096);
+
+//==============================================================================
+///@brief Writes the output of a JSON::Writer to a FileWriter, which must be
+/// open, and outlive the JsonFileSink.
+class JsonFileSink: public JSON::Writer::Sink
+{
+public:
+  explicit JsonFileSink(FileWriter& file);
+
+  bool Write(char const* data, size_t size) override;
+
+private:
+  FileWriter& m_file;
+};
+
 } //XR
 
 #endif //XR_JSONUTILS_HPP
@@ -7,16 +7,24 @@
 //
 //==============================================================================
 #include "AssetLoadJob.hpp"
+#include "AssetArchive.hpp"
+#include "AssetBuildCache.hpp"
 #include "xr/Asset.hpp"
 #include "xr/FileBuffer.hpp"
 #include "xr/FileWriter.hpp"
 #include "xr/threading/Worker.hpp"
 #include "xr/memory/ScopeGuard.hpp"
+#include "xr/memory/BufferReader.hpp"
 #include "xr/utility/Hash.hpp"
 #include <map>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <atomic>
 
 #ifdef ENABLE_ASSET_BUILDING
 #include <unordered_map>
+#include <thread>
 #endif
 
 #define LTRACE(format) XR_TRACE(Asset::Manager, format)
@@ -31,18 +39,27 @@ struct AssetHeader
 {
   Asset::TypeId typeId;
   Asset::VersionType version;
-  uint16_t reserved{};
+  uint16_t dataAlignment{}; // from the start of the asset; 0 if the data isn't padded.
 };
 
+// The data of built assets is padded to this, so that when mapped, it may be
+// passed to OnLoaded() as suitably aligned as if it had been allocated.
+const uint16_t kDataAlignment = alignof(std::max_align_t);
+
 using NumDependenciesType = uint16_t;
 using DependencyPathLenType = uint16_t;
 
+#ifdef ENABLE_ASSET_BUILDING
+// Lives in the root of the asset path, where it can't clash with built assets.
+char const* const kBuildCacheName = "buildcache";
+#endif
+
 //==============================================================================
 class AssetManagerImpl // TODO: improve encapsulation of members
 {
 public:
   // structors
-  AssetManagerImpl(FilePath const& path, Allocator* alloc)
+  AssetManagerImpl(FilePath const& path, Allocator* alloc, uint32_t numLoaderThreads)
   : m_path(path)
   {
     if (!alloc)
@@ -52,14 +69,48 @@ public:
     }
 
     m_allocator = alloc;
+
+    if (numLoaderThreads == 0)
+    {
+      numLoaderThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    m_workers.reserve(numLoaderThreads);
+    for (uint32_t i = 0; i < numLoaderThreads; ++i)
+    {
+      m_workers.emplace_back(new Worker());
+    }
+
+#ifdef ENABLE_ASSET_BUILDING
+    m_buildCache.Load(GetBuildCachePath());
+#endif
   }
 
   ~AssetManagerImpl()
   {
-    m_worker.CancelPendingJobs();
-    m_worker.Finalize();
+    for (auto& w : m_workers)
+    {
+      w->CancelPendingJobs();
+    }
+
+    for (auto& w : m_workers)
+    {
+      w->Finalize();
+    }
+
+    // Jobs that were cancelled or didn't get to be processed hold references
+    // to their assets.
+    for (auto j : m_pending)
+    {
+      DeleteJob(*j);
+    }
+    m_pending.clear();
 
     ClearManaged();
+
+#ifdef ENABLE_ASSET_BUILDING
+    m_buildCache.Save(GetBuildCachePath());
+#endif
   }
 
   // general
@@ -126,7 +177,10 @@ public:
       m_pending.push_back(&lj);
     }
 
-    m_worker.Enqueue(lj);
+    // Loader threads are fed in a round robin fashion; the order of processing
+    // is determined by m_pending.
+    auto iWorker = m_nextWorker.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
+    m_workers[iWorker]->Enqueue(lj);
   }
 
   void UpdateJobs()
@@ -134,19 +188,26 @@ public:
     decltype(m_pending) q;
     {
       std::unique_lock<decltype(m_pendingLock)> lock(m_pendingLock);
-      auto i = m_pending.begin();
-      while (i != m_pending.end() &&
-        CheckAllMaskBits((*i)->asset->GetFlags(), Asset::ProcessingFlag))
-      {
-        ++i;
-      }
-
-      q.adopt(m_pending, i);
+      q.adopt(m_pending);
     }
 
+    // Jobs may finish loading out of order. Process the ones that have, unless
+    // they depend on an asset whose job precedes them and is still pending.
+    // Dependencies are enqueued before their dependants, which guarantees that
+    // they are processed first.
+    decltype(m_pending) deferred;
+    m_deferredAssets.clear();
     for (auto i0 = q.begin(), i1 = q.end(); i0 != i1; ++i0)
     {
       auto j = *i0;
+      if (!j->IsLoaded() ||
+        j->DependsOnAny(m_deferredAssets.data(), m_deferredAssets.size()))
+      {
+        deferred.push_back(j);
+        m_deferredAssets.push_back(j->asset.Get());
+        continue;
+      }
+
       if (!CheckAllMaskBits(j->asset->GetFlags(), Asset::ErrorFlag))
       {
         j->ProcessData();
@@ -154,16 +215,29 @@ public:
 
       DeleteJob(*j);
     }
+
+    if (!deferred.empty())
+    {
+      std::unique_lock<decltype(m_pendingLock)> lock(m_pendingLock);
+      deferred.adopt(m_pending);
+      m_pending.swap(deferred);
+    }
   }
 
   void SuspendJobs()
   {
-    m_worker.Suspend();
+    for (auto& w : m_workers)
+    {
+      w->Suspend();
+    }
   }
 
   void ResumeJobs()
   {
-    m_worker.Resume();
+    for (auto& w : m_workers)
+    {
+      w->Resume();
+    }
   }
 
   void DeleteJob(AssetLoadJob& lj)
@@ -172,6 +246,44 @@ public:
     m_allocator->Deallocate(&lj);
   }
 
+#ifdef ENABLE_ASSET_BUILDING
+  AssetBuildCache& GetBuildCache()
+  {
+    return m_buildCache;
+  }
+
+  FilePath GetBuildCachePath() const
+  {
+    return m_path / kBuildCacheName;
+  }
+#endif
+
+  bool MountArchive(FilePath const& path)
+  {
+    std::unique_ptr<AssetArchive> archive(new AssetArchive());
+    bool success = archive->Mount(path);
+    if (success)
+    {
+      m_archives.push_back(std::move(archive));
+    }
+    return success;
+  }
+
+  AssetArchive const* FindArchived(Asset::HashType hash,
+    AssetArchive::Entry const*& outEntry) const
+  {
+    // Later archives take precedence.
+    for (auto i0 = m_archives.rbegin(), i1 = m_archives.rend(); i0 != i1; ++i0)
+    {
+      if (auto entry = (*i0)->Find(hash))
+      {
+        outEntry = entry;
+        return i0->get();
+      }
+    }
+    return nullptr;
+  }
+
   void UnloadUnused()
   {
     std::unique_lock<decltype(m_assetsLock)> lock(m_assetsLock);
@@ -194,7 +306,14 @@ private:
   FilePath m_path;
   Allocator* m_allocator;
 
-  Worker m_worker;
+  std::vector<std::unique_ptr<AssetArchive>> m_archives; // must outlive pending jobs.
+
+#ifdef ENABLE_ASSET_BUILDING
+  AssetBuildCache m_buildCache;
+#endif
+
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  std::atomic<uint32_t> m_nextWorker{ 0 };
 
   Spinlock m_assetsLock;
   std::map<Asset::DescriptorCore, Asset::Ptr> m_assets;
@@ -202,6 +321,8 @@ private:
   Spinlock m_pendingLock;
   Queue<AssetLoadJob*> m_pending;
 
+  std::vector<Asset const*> m_deferredAssets; // main thread only; retains capacity across UpdateJobs().
+
   // internal
   void ClearManaged()
   {
@@ -289,14 +410,16 @@ bool BuildAsset(FilePath const& path, Asset::VersionType version,
   XR_ASSERT(Asset, path.GetExt());
   auto iOptions = (path.GetExt() - path.c_str()) + strcspn(path.GetExt(), Asset::kOptionDelimiter);
   auto purePath = FilePath(path.c_str(), iOptions);
+  bool isBuiltCurrent = false; // built asset exists and is of the current version.
+  time_t tsRaw = 0;
   if (rebuild)
   {
     // Check for raw and built asset, compare last modification time.
-    auto tsRaw = File::GetModifiedTime(purePath); // must use original path!
+    tsRaw = File::GetModifiedTime(purePath); // must use original path!
     XR_ASSERTMSG(Asset::Manager, tsRaw > 0, ("'%s' doesn't exist.", path.c_str()));
     auto tsBuilt = File::GetModifiedTime(builtPath.c_str());
 
-    if (tsBuilt > 0 && tsBuilt >= tsRaw) // if built asset exists and isn't older
+    if (tsBuilt > 0) // if built asset exists
     {
       auto hFile = File::Open(builtPath, "rb");
       auto guard = MakeScopeGuard([&hFile] {
@@ -307,7 +430,7 @@ bool BuildAsset(FilePath const& path, Asset::VersionType version,
       // or can't be read, we'll rebuild. Persistent I/O errors will be dealt with
       // later.
       AssetHeader header = { 0, 0 };
-      if (File::Read(hFile, sizeof(header), 1, &header) == 1) // asset [header] is readable
+      if (hFile && File::Read(hFile, sizeof(header), 1, &header) == 1) // asset [header] is readable
       {
         if (header.typeId != desc.type)
         {
@@ -315,9 +438,10 @@ bool BuildAsset(FilePath const& path, Asset::VersionType version,
             path.c_str(), builtPath.c_str(), sizeof(header.typeId), &header.typeId));
           return false;
         }
-        else if (header.version == version)
+        else if (header.version == version && header.dataAlignment == kDataAlignment)
         {
-          rebuild = false;  // version matches -- rebuild not required;
+          isBuiltCurrent = true;
+          rebuild = tsBuilt < tsRaw;  // version matches -- rebuild not required unless older;
         }
       }
     }
@@ -336,6 +460,16 @@ bool BuildAsset(FilePath const& path, Asset::VersionType version,
     return false;
   }
 
+  // The source may have been touched (e.g. by a checkout) without its content
+  // changing, in which case the build cache lets us off rebuilding - and once
+  // we've recorded the time it was touched at, off hashing it again, too.
+  auto& buildCache = s_assetMan->GetBuildCache();
+  const bool checkCache = !forceBuild && isBuiltCurrent;
+  if (checkCache && buildCache.IsSourceUnchanged(desc, version, tsRaw))
+  {
+    return true;
+  }
+
   FileBuffer srcBuf;
   if (!srcBuf.Open(purePath))  // read source file
   {
@@ -343,6 +477,13 @@ bool BuildAsset(FilePath const& path, Asset::VersionType version,
     return false;
   }
 
+  const uint64_t contentHash = Hash::Data(srcBuf.GetData(), srcBuf.GetSize());
+  if (checkCache && buildCache.IsUpToDate(desc, version, contentHash))
+  {
+    buildCache.Update(desc, version, contentHash, tsRaw);
+    return true;
+  }
+
   srcBuf.Close();
 
   builtPath = File::GetRamPath() / builtPath;
@@ -367,7 +508,7 @@ bool BuildAsset(FilePath const& path, Asset::VersionType version,
     return false;
   }
 
-  AssetHeader header{ desc.type, version, 0 };
+  AssetHeader header{ desc.type, version, kDataAlignment };
   if (!assetWriter.Write(&header, sizeof(header), 1))
   {
     LTRACE(("%s: failed to write asset header to '%s'.", path.c_str(),
@@ -391,6 +532,7 @@ bool BuildAsset(FilePath const& path, Asset::VersionType version,
     return false;
   }
 
+  size_t headerSize = sizeof(header) + sizeof(NumDependenciesType);
   for (auto i0 = dependencies.begin(), i1 = dependencies.end(); i0 != i1; ++i0)
   {
     if (!(assetWriter.Write(DependencyPathLenType(i0->size())) &&
@@ -400,6 +542,16 @@ bool BuildAsset(FilePath const& path, Asset::VersionType version,
         builtPath.c_str()));
       return false;
     }
+    headerSize += sizeof(DependencyPathLenType) + i0->size();
+  }
+
+  const char padding[kDataAlignment] = {};
+  const size_t paddingSize = (kDataAlignment - headerSize % kDataAlignment) % kDataAlignment;
+  if (paddingSize > 0 && !assetWriter.Write(padding, 1, paddingSize))
+  {
+    LTRACE(("%s: failed to pad asset data in %s.", path.c_str(),
+      builtPath.c_str()));
+    return false;
   }
 
   auto str = assetData.str();
@@ -411,6 +563,7 @@ bool BuildAsset(FilePath const& path, Asset::VersionType version,
   }
 
   assetGuard.Release();
+  buildCache.Update(desc, version, contentHash, tsRaw);
   return true;
 }
 #endif  // ENABLE_ASSET_BUILDING
@@ -424,6 +577,73 @@ bool IsAssetLoadable(Asset::FlagType oldFlags, Asset::FlagType newFlags)
       !CheckAnyMaskBits(newFlags, Asset::ForceReloadFlag)));
 }
 
+//==============================================================================
+///@brief The location of the data of a built asset; either a file, or [part of]
+/// a file mapped into memory.
+struct BuiltAssetSource
+{
+  File::Handle hFile = nullptr; // positioned at the start of the asset.
+  File::MappingHandle hMapping = nullptr; // owned mapping, if any.
+  Buffer mapped{ 0, nullptr };
+  size_t size = 0;
+
+  ///@brief Attempts to locate the asset of the given @a hash, amongst the loose
+  /// files in the asset path (at @a path), and the mounted archives. With asset
+  /// building enabled, loose files take precedence, since that's where the
+  /// builders write to; otherwise archives do.
+  bool Open(FilePath const& path, Asset::HashType hash)
+  {
+#ifdef ENABLE_ASSET_BUILDING
+    return OpenLoose(path) || OpenArchived(hash);
+#else
+    return OpenArchived(hash) || OpenLoose(path);
+#endif
+  }
+
+  void Close()
+  {
+    File::Unmap(hMapping);
+    hMapping = nullptr;
+    File::Close(hFile);
+    hFile = nullptr;
+  }
+
+private:
+  bool OpenLoose(FilePath const& path)
+  {
+    hMapping = File::Map(path);
+    if (hMapping)
+    {
+      mapped = { File::GetMappedSize(hMapping), File::GetMappedData(hMapping) };
+      size = mapped.size;
+    }
+    else
+    {
+      hFile = File::Open(path, "rb");
+      if (hFile)
+      {
+        size = File::GetSize(hFile);
+      }
+    }
+    return hMapping || hFile;
+  }
+
+  bool OpenArchived(Asset::HashType hash)
+  {
+    AssetArchive::Entry const* entry = nullptr;
+    if (auto archive = s_assetMan->FindArchived(hash, entry))
+    {
+      mapped = archive->GetMappedData(*entry);
+      if (!mapped.data)
+      {
+        hFile = archive->Open(*entry);
+      }
+      size = static_cast<size_t>(entry->size);
+    }
+    return mapped.data || hFile;
+  }
+};
+
 //==============================================================================
 void LoadAsset(Asset::VersionType version, Asset& asset, Asset::FlagType flags)
 {
@@ -433,18 +653,44 @@ void LoadAsset(Asset::VersionType version, Asset& asset, Asset::FlagType flags)
     asset.FlagError();
   });
 
-  FilePath path = Asset::Manager::GetAssetPath() / asset.GetDescriptor().ToPath();
-  File::Handle hFile = File::Open(path, "rb");
-  if (hFile == nullptr)
+  // Map the built asset if we can, so that the buffer passed to OnLoaded() may
+  // point straight into it; fall back to reading otherwise.
+  auto const& desc = asset.GetDescriptor();
+  FilePath path = Asset::Manager::GetAssetPath() / desc.ToPath();
+  BuiltAssetSource src;
+  if (!src.Open(path, desc.hash))
   {
     LTRACE(("%s: failed to open.", path.c_str()));
     return;
   }
 
+  auto srcGuard = MakeScopeGuard([&src]() {
+    src.Close();
+  });
+
+  File::Handle hFile = src.hFile;
+  size_t size = src.size;
+  BufferReader mappedReader(src.mapped);
+  auto read = [hFile, &mappedReader](void* buffer, size_t numBytes) {
+    bool success;
+    if (hFile)
+    {
+      success = File::Read(hFile, numBytes, 1, buffer) == 1;
+    }
+    else if (auto bytes = mappedReader.ReadBytes(numBytes))
+    {
+      std::memcpy(buffer, bytes, numBytes);
+      success = true;
+    }
+    else
+    {
+      success = false;
+    }
+    return success;
+  };
+
   AssetHeader header;
-  size_t size = File::GetSize(hFile);
-  if (size < sizeof(AssetHeader) ||
-    File::Read(hFile, sizeof(header), 1, &header) < 1)
+  if (size < sizeof(AssetHeader) || !read(&header, sizeof(header)))
   {
     LTRACE(("%s: failed to read header.", path.c_str()));
     return;
@@ -467,7 +713,7 @@ void LoadAsset(Asset::VersionType version, Asset& asset, Asset::FlagType flags)
   }
 
   NumDependenciesType numDependencies;
-  if (File::Read(hFile, sizeof(numDependencies), 1, &numDependencies) < 1)
+  if (!read(&numDependencies, sizeof(numDependencies)))
   {
     LTRACE(("%s: failed to read number of dependencies.", path.c_str()));
     return;
@@ -475,13 +721,16 @@ void LoadAsset(Asset::VersionType version, Asset& asset, Asset::FlagType flags)
 
   size -= sizeof(numDependencies);
 
+  std::vector<Asset::Ptr> dependencies;
+  dependencies.reserve(numDependencies);
+
   NumDependenciesType i = 0;
   DependencyPathLenType len;
   FilePath pathDep;
   while (i < numDependencies)
   {
-    if (File::Read(hFile, sizeof(len), 1, &len) < 1 || len > FilePath::kCapacity ||
-      len > size || File::Read(hFile, len, 1, pathDep.data()) < 1)
+    if (!read(&len, sizeof(len)) || len > FilePath::kCapacity ||
+      len > size || !read(pathDep.data(), len))
     {
       LTRACE(("%s: failed to read dependency name %d of %d.", path.c_str(), i,
         numDependencies));
@@ -500,27 +749,61 @@ void LoadAsset(Asset::VersionType version, Asset& asset, Asset::FlagType flags)
         LTRACE(("%s: error loading dependency '%s'.", path.c_str(), pathDep.c_str()));
         return;
       }
+      dependencies.push_back(dependency);
       ++i;
     }
   }
 
+  // Skip the padding that the data is aligned with.
+  if (header.dataAlignment > 0)
+  {
+    const size_t headerSize = src.size - size;
+    const size_t paddingSize = (header.dataAlignment - headerSize % header.dataAlignment) %
+      header.dataAlignment;
+    if (paddingSize > size || (paddingSize > 0 && !(hFile ?
+      File::Seek(hFile, paddingSize, File::SeekFrom::Current) :
+      mappedReader.ReadBytes(paddingSize) != nullptr)))
+    {
+      LTRACE(("%s: failed to skip padding.", path.c_str()));
+      return;
+    }
+
+    size -= paddingSize;
+  }
+
+  // The job takes ownership of the handles.
+  srcGuard.Release();
+  auto createJob = [&src, &mappedReader, size, &asset](void* buffer) {
+    return src.hFile ?
+      new (buffer) AssetLoadJob(src.hFile, size, Asset::Ptr(&asset)) :
+      new (buffer) AssetLoadJob(src.hMapping,
+        { size, src.mapped.data + (src.mapped.size - mappedReader.GetRemainingSize()) },
+        Asset::Ptr(&asset));
+  };
+
   if (CheckAllMaskBits(flags, Asset::LoadSyncFlag))
   {
-    AssetLoadJob lj(hFile, size, Asset::Ptr(&asset));
-    lj.Start();
-    while (!lj.Process())
+    alignas(AssetLoadJob) char jobBuffer[sizeof(AssetLoadJob)];
+    auto lj = createJob(jobBuffer);
+    auto jobGuard = MakeScopeGuard([lj]() {
+      lj->~AssetLoadJob();
+    });
+
+    lj->Start();
+    while (!lj->Process())
     {
     }
 
-    if (CheckAllMaskBits(lj.asset->GetFlags(), Asset::ProcessingFlag))
+    if (CheckAllMaskBits(lj->asset->GetFlags(), Asset::ProcessingFlag))
     {
-      lj.ProcessData();
+      lj->ProcessData();
     }
   }
   else
   {
     void* jobBuffer = s_assetMan->GetAllocator()->Allocate(sizeof(AssetLoadJob));
-    auto lj = new (jobBuffer) AssetLoadJob(hFile, size, Asset::Ptr(&asset));
+    auto lj = createJob(jobBuffer);
+    lj->dependencies = std::move(dependencies);
     s_assetMan->EnqueueJob(*lj);
   }
 
@@ -542,7 +825,7 @@ Asset::Builder::~Builder() = default;
 char const* const Asset::Manager::kDefaultPath = "assets";
 
 //==============================================================================
-void Asset::Manager::Init(FilePath path, Allocator* alloc)
+void Asset::Manager::Init(FilePath path, Allocator* alloc, uint32_t numLoaderThreads)
 {
   if (path.StartsWith(File::kRawProto))
   {
@@ -560,7 +843,7 @@ void Asset::Manager::Init(FilePath path, Allocator* alloc)
   File::MakeDirs(path);
 #endif
 
-  s_assetMan.reset(new AssetManagerImpl(path, alloc));
+  s_assetMan.reset(new AssetManagerImpl(path, alloc, numLoaderThreads));
 
   detail::AssetReflector::Base::ForEach(RegisterReflector);
 #ifdef ENABLE_ASSET_BUILDING
@@ -623,6 +906,105 @@ Asset::HashType Asset::Manager::HashPath(FilePath path)
   return hash;
 }
 
+//==============================================================================
+bool Asset::Manager::MountArchive(FilePath const& path)
+{
+  return s_assetMan->MountArchive(path);
+}
+
+//==============================================================================
+bool Asset::Manager::WriteArchive(FilePath const& path,
+  std::vector<DescriptorCore> const& assets)
+{
+  std::vector<HashType> hashes;
+  hashes.reserve(assets.size());
+  for (auto& d : assets)
+  {
+    hashes.push_back(d.hash);
+  }
+  return AssetArchive::Write(path, GetAssetPath(), std::move(hashes));
+}
+
+#ifdef ENABLE_ASSET_BUILDING
+//==============================================================================
+size_t Asset::Manager::BuildAll(std::vector<FilePath> const& paths,
+  uint32_t numThreads, FlagType flags)
+{
+  struct BuildTask
+  {
+    FilePath path;
+    DescriptorCore desc;
+    VersionType version;
+  };
+
+  std::vector<BuildTask> tasks;
+  tasks.reserve(paths.size());
+
+  size_t numFailed = 0;
+  for (auto& p : paths)
+  {
+    auto ext = p.GetExt();
+    auto iFind = ext ? s_extensions.find(Hash::String32(ext, strcspn(ext, kOptionDelimiter))) :
+      s_extensions.end();
+    if (iFind == s_extensions.end())
+    {
+      LTRACE(("%s: unknown asset type.", p.c_str()));
+      ++numFailed;
+      continue;
+    }
+
+    auto reflector = iFind->second->second;
+    tasks.push_back({ p, DescriptorCore(reflector->type, HashPath(p)),
+      reflector->version });
+  }
+
+  // Multiple paths may resolve to the same built asset; build it once.
+  std::sort(tasks.begin(), tasks.end(), [](BuildTask const& t0, BuildTask const& t1) {
+    return t0.desc < t1.desc;
+  });
+  tasks.erase(std::unique(tasks.begin(), tasks.end(),
+    [](BuildTask const& t0, BuildTask const& t1) {
+      return t0.desc.hash == t1.desc.hash;
+    }), tasks.end());
+
+  if (numThreads == 0)
+  {
+    numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  numThreads = static_cast<uint32_t>(std::min(size_t(numThreads), tasks.size()));
+
+  std::atomic<size_t> next{ 0 };
+  std::atomic<size_t> failed{ 0 };
+  auto build = [&tasks, &next, &failed, flags]() {
+    size_t i;
+    while ((i = next.fetch_add(1, std::memory_order_relaxed)) < tasks.size())
+    {
+      auto& t = tasks[i];
+      if (!BuildAsset(t.path, t.version, t.desc, flags))
+      {
+        ++failed;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads);
+  for (uint32_t i = 1; i < numThreads; ++i)
+  {
+    threads.emplace_back(build);
+  }
+  build();
+
+  for (auto& t : threads)
+  {
+    t.join();
+  }
+
+  s_assetMan->GetBuildCache().Save(s_assetMan->GetBuildCachePath());
+  return numFailed + failed;
+}
+#endif  // ENABLE_ASSET_BUILDING
+
 //==============================================================================
 Asset::Ptr Asset::Manager::LoadReflected(FilePath const& path, FlagType flags)
 {
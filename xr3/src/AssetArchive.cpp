@@ -0,0 +1,262 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "AssetArchive.hpp"
+#include "xr/FileBuffer.hpp"
+#include "xr/FileWriter.hpp"
+#include "xr/memory/BufferReader.hpp"
+#include "xr/memory/ScopeGuard.hpp"
+#include "xr/memory/memory.hpp"
+#include <algorithm>
+#include <cstddef>
+
+#define LTRACE(format) XR_TRACE(Asset::Manager, format)
+
+namespace xr
+{
+namespace
+{
+
+//==============================================================================
+struct ArchiveHeader
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved{};
+  uint32_t numEntries;
+  uint32_t reserved2{};
+};
+
+const uint32_t kArchiveMagic = XR_FOURCC('X', 'R', 'A', 'A');
+const uint16_t kArchiveVersion = 1;
+
+//==============================================================================
+// Whether an index of @a numEntries fits in an archive of @a archiveSize bytes,
+// following the header.
+bool IsIndexInBounds(uint32_t numEntries, uint64_t archiveSize)
+{
+  return archiveSize >= sizeof(ArchiveHeader) &&
+    numEntries <= (archiveSize - sizeof(ArchiveHeader)) / sizeof(AssetArchive::Entry);
+}
+
+} // nonamespace
+
+//==============================================================================
+bool AssetArchive::Write(FilePath const& path, FilePath const& assetPath,
+  std::vector<Asset::HashType> hashes)
+{
+  std::sort(hashes.begin(), hashes.end());
+  hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+  std::vector<Entry> index;
+  index.reserve(hashes.size());
+
+  uint64_t offset = sizeof(ArchiveHeader) + sizeof(Entry) * hashes.size();
+  for (auto h : hashes)
+  {
+    FilePath builtPath = assetPath / Asset::DescriptorCore(0, h).ToPath();
+    auto hFile = File::Open(builtPath, "rb");
+    if (!hFile)
+    {
+      LTRACE(("%s: failed to open built asset '%s' for archiving.", path.c_str(),
+        builtPath.c_str()));
+      return false;
+    }
+
+    const uint64_t size = File::GetSize(hFile);
+    File::Close(hFile);
+
+    // Keep the data of built assets as aligned as it is in their own files.
+    offset = Align(offset, uint64_t(alignof(std::max_align_t)));
+    index.push_back({ h, offset, size });
+    offset += size;
+  }
+
+  auto archiveGuard = MakeScopeGuard([&path]() {
+    if (!File::Delete(path))
+    {
+      LTRACE(("Failed to remove half-written archive at '%s'.", path.c_str()));
+    }
+  });
+  FileWriter writer; // must be declared after the guard since it'll be cleared up backwards.
+  if (!writer.Open(path, FileWriter::Mode::Truncate, false))
+  {
+    LTRACE(("%s: failed to create archive.", path.c_str()));
+    return false;
+  }
+
+  ArchiveHeader header{ kArchiveMagic, kArchiveVersion, 0,
+    static_cast<uint32_t>(index.size()), 0 };
+  if (!(writer.Write(header) &&
+    (index.empty() || writer.Write(index.data(), sizeof(Entry), index.size()))))
+  {
+    LTRACE(("%s: failed to write archive index.", path.c_str()));
+    return false;
+  }
+
+  const char padding[alignof(std::max_align_t)] = {};
+  uint64_t written = sizeof(ArchiveHeader) + sizeof(Entry) * index.size();
+  FileBuffer buffer;
+  for (auto& e : index)
+  {
+    FilePath builtPath = assetPath / Asset::DescriptorCore(0, e.hash).ToPath();
+    if (!buffer.Open(builtPath) || buffer.GetSize() != e.size ||
+      !writer.Write(padding, 1, size_t(e.offset - written)) ||
+      !writer.Write(buffer.GetData(), 1, buffer.GetSize()))
+    {
+      LTRACE(("%s: failed to archive '%s'.", path.c_str(), builtPath.c_str()));
+      return false;
+    }
+    written = e.offset + e.size;
+  }
+
+  archiveGuard.Release();
+  return true;
+}
+
+//==============================================================================
+AssetArchive::~AssetArchive()
+{
+  File::Unmap(m_hMapping);
+}
+
+//==============================================================================
+bool AssetArchive::Mount(FilePath const& path)
+{
+  XR_ASSERTMSG(AssetArchive, m_path.empty(), ("Already mounted '%s'.", m_path.c_str()));
+
+  // Don't keep the mapping or any part of the index, if we fail.
+  auto failGuard = MakeScopeGuard([this]() {
+    File::Unmap(m_hMapping);
+    m_hMapping = nullptr;
+    m_index.clear();
+  });
+
+  ArchiveHeader header;
+  std::vector<Entry> entries;
+  uint64_t archiveSize;
+  if (auto hMapping = File::Map(path))
+  {
+    m_hMapping = hMapping;
+    archiveSize = File::GetMappedSize(hMapping);
+
+    BufferReader reader({ size_t(archiveSize), File::GetMappedData(hMapping) });
+    auto indexData = reader.Read(header) && header.magic == kArchiveMagic &&
+      IsIndexInBounds(header.numEntries, archiveSize) ?
+      reader.ReadBytes(sizeof(Entry) * header.numEntries) : nullptr;
+    if (indexData)
+    {
+      entries.resize(header.numEntries);
+      std::memcpy(entries.data(), indexData, sizeof(Entry) * header.numEntries);
+    }
+    else
+    {
+      LTRACE(("%s: failed to read archive index.", path.c_str()));
+      return false;
+    }
+  }
+  else if (auto hFile = File::Open(path, "rb"))
+  {
+    auto fileGuard = MakeScopeGuard([hFile]() {
+      File::Close(hFile);
+    });
+
+    archiveSize = File::GetSize(hFile);
+    if (File::Read(hFile, sizeof(header), 1, &header) == 1 &&
+      header.magic == kArchiveMagic)
+    {
+      if (!IsIndexInBounds(header.numEntries, archiveSize))
+      {
+        LTRACE(("%s: archive index of %d entries is out of bounds.", path.c_str(),
+          header.numEntries));
+        return false;
+      }
+
+      entries.resize(header.numEntries);
+      if (!entries.empty() &&
+        File::Read(hFile, sizeof(Entry), entries.size(), entries.data()) != entries.size())
+      {
+        LTRACE(("%s: failed to read archive index.", path.c_str()));
+        return false;
+      }
+    }
+    else
+    {
+      LTRACE(("%s: failed to read archive header.", path.c_str()));
+      return false;
+    }
+  }
+  else
+  {
+    LTRACE(("%s: failed to open archive.", path.c_str()));
+    return false;
+  }
+
+  if (header.version != kArchiveVersion)
+  {
+    LTRACE(("%s: archive version mismatch, expected: %d, got: %d", path.c_str(),
+      kArchiveVersion, header.version));
+    return false;
+  }
+
+  // Data may only follow the index, and IsIndexInBounds() has ensured that
+  // the index ends within the archive.
+  const uint64_t dataOffset = sizeof(ArchiveHeader) + sizeof(Entry) * entries.size();
+  m_index.reserve(entries.size());
+  for (auto& e : entries)
+  {
+    if (e.offset < dataOffset || e.offset > archiveSize ||
+      e.size > archiveSize - e.offset)
+    {
+      LTRACE(("%s: entry %.16" PRIx64 " is out of bounds.", path.c_str(), e.hash));
+      return false;
+    }
+
+    if (!m_index.insert({ e.hash, e }).second)
+    {
+      LTRACE(("%s: duplicate entry %.16" PRIx64 ".", path.c_str(), e.hash));
+      return false;
+    }
+  }
+
+  failGuard.Release();
+  m_path = path;
+  return true;
+}
+
+//==============================================================================
+AssetArchive::Entry const* AssetArchive::Find(Asset::HashType hash) const
+{
+  auto iFind = m_index.find(hash);
+  return iFind != m_index.end() ? &iFind->second : nullptr;
+}
+
+//==============================================================================
+Buffer AssetArchive::GetMappedData(Entry const& entry) const
+{
+  Buffer buffer{ 0, nullptr };
+  if (m_hMapping)
+  {
+    buffer = { static_cast<size_t>(entry.size), File::GetMappedData(m_hMapping) + entry.offset };
+  }
+  return buffer;
+}
+
+//==============================================================================
+File::Handle AssetArchive::Open(Entry const& entry) const
+{
+  auto hFile = File::Open(m_path, "rb");
+  if (hFile && !File::Seek(hFile, static_cast<size_t>(entry.offset), File::SeekFrom::Start))
+  {
+    File::Close(hFile);
+    hFile = nullptr;
+  }
+  return hFile;
+}
+
+} // xr
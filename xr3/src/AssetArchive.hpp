@@ -0,0 +1,73 @@
+#ifndef XR_ASSETARCHIVE_HPP
+#define XR_ASSETARCHIVE_HPP
+//==============================================================================
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xr/Asset.hpp"
+#include <unordered_map>
+
+namespace xr
+{
+
+//==============================================================================
+///@brief A single file holding a number of built assets, verbatim and aligned
+/// to alignof(std::max_align_t), and an index of their hashes, sorted, to the
+/// offsets and sizes of their data.
+class AssetArchive
+{
+  XR_NONCOPY_DECL(AssetArchive)
+
+public:
+  // types
+  struct Entry
+  {
+    Asset::HashType hash;
+    uint64_t offset;  // from the start of the archive
+    uint64_t size;
+  };
+
+  // static
+  ///@brief Writes the built assets of the given @a hashes, from @a assetPath,
+  /// into a new archive at @a path.
+  ///@return The success of the operation.
+  static bool Write(FilePath const& path, FilePath const& assetPath,
+    std::vector<Asset::HashType> hashes);
+
+  // structors
+  AssetArchive() = default;
+  ~AssetArchive();
+
+  // general
+  ///@brief Opens the archive at @a path and reads its index. The file is mapped
+  /// into memory if possible, or is kept open otherwise.
+  ///@return The success of the operation.
+  bool Mount(FilePath const& path);
+
+  ///@return The entry for the given @a hash, nullptr if the archive has none.
+  Entry const* Find(Asset::HashType hash) const;
+
+  ///@return The data of the given @a entry, if the archive is mapped; the
+  /// data is valid for the lifetime of the AssetArchive. Otherwise an empty
+  /// buffer.
+  Buffer GetMappedData(Entry const& entry) const;
+
+  ///@return A new handle to the archive positioned at the start of the data of
+  /// @a entry, nullptr if it couldn't be opened. The caller takes ownership.
+  File::Handle Open(Entry const& entry) const;
+
+private:
+  // data
+  FilePath m_path;
+  File::MappingHandle m_hMapping = nullptr;
+  std::unordered_map<Asset::HashType, Entry> m_index;
+};
+
+} // xr
+
+#endif //XR_ASSETARCHIVE_HPP
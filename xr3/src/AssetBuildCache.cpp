@@ -0,0 +1,157 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#ifdef ENABLE_ASSET_BUILDING
+#include "AssetBuildCache.hpp"
+#include "xr/FileBuffer.hpp"
+#include "xr/FileWriter.hpp"
+#include "xr/memory/BufferReader.hpp"
+#include <algorithm>
+#include <mutex>
+
+#define LTRACE(format) XR_TRACE(Asset::Manager, format)
+
+namespace xr
+{
+namespace
+{
+
+//==============================================================================
+struct BuildCacheHeader
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t reserved{};
+  uint32_t numEntries;
+};
+
+const uint32_t kBuildCacheMagic = XR_FOURCC('X', 'R', 'B', 'C');
+const uint16_t kBuildCacheVersion = 2;
+
+} // nonamespace
+
+//==============================================================================
+bool AssetBuildCache::Load(FilePath const& path)
+{
+  Clear();
+  if (!File::CheckExists(path))
+  {
+    return true;
+  }
+
+  FileBuffer buffer;
+  if (!buffer.Open(path))
+  {
+    LTRACE(("%s: failed to read build cache.", path.c_str()));
+    return false;
+  }
+
+  BufferReader reader({ buffer.GetSize(), buffer.GetData() });
+  BuildCacheHeader header;
+  if (!reader.Read(header) || header.magic != kBuildCacheMagic ||
+    header.version != kBuildCacheVersion)
+  {
+    LTRACE(("%s: build cache header mismatch; ignoring.", path.c_str()));
+    return false;
+  }
+
+  std::unique_lock<decltype(m_lock)> lock(m_lock);
+  m_entries.reserve(header.numEntries);
+  Entry e;
+  for (uint32_t i = 0; i < header.numEntries; ++i)
+  {
+    if (!reader.Read(e))
+    {
+      LTRACE(("%s: failed to read build cache entry %d of %d.", path.c_str(), i,
+        header.numEntries));
+      m_entries.clear();
+      return false;
+    }
+    m_entries[e.hash] = e;
+  }
+  return true;
+}
+
+//==============================================================================
+bool AssetBuildCache::Save(FilePath const& path)
+{
+  std::vector<Entry> entries;
+  {
+    std::unique_lock<decltype(m_lock)> lock(m_lock);
+    if (!m_isDirty)
+    {
+      return true;
+    }
+
+    entries.reserve(m_entries.size());
+    for (auto& e : m_entries)
+    {
+      entries.push_back(e.second);
+    }
+    m_isDirty = false;
+  }
+
+  // Sorted, so that the same records produce the same file.
+  std::sort(entries.begin(), entries.end(), [](Entry const& e0, Entry const& e1) {
+    return e0.hash < e1.hash;
+  });
+
+  FileWriter writer;
+  BuildCacheHeader header{ kBuildCacheMagic, kBuildCacheVersion, 0,
+    static_cast<uint32_t>(entries.size()) };
+  bool success = writer.Open(path, FileWriter::Mode::Truncate, false) &&
+    writer.Write(header) &&
+    (entries.empty() || writer.Write(entries.data(), sizeof(Entry), entries.size()));
+  if (!success)
+  {
+    LTRACE(("%s: failed to write build cache.", path.c_str()));
+  }
+  return success;
+}
+
+//==============================================================================
+bool AssetBuildCache::IsSourceUnchanged(Asset::DescriptorCore const& desc,
+  Asset::VersionType version, time_t sourceTime) const
+{
+  std::unique_lock<decltype(m_lock)> lock(m_lock);
+  auto iFind = m_entries.find(desc.hash);
+  return iFind != m_entries.end() && iFind->second.typeId == desc.type &&
+    iFind->second.version == version && iFind->second.sourceTime == sourceTime;
+}
+
+//==============================================================================
+bool AssetBuildCache::IsUpToDate(Asset::DescriptorCore const& desc,
+  Asset::VersionType version, uint64_t contentHash) const
+{
+  std::unique_lock<decltype(m_lock)> lock(m_lock);
+  auto iFind = m_entries.find(desc.hash);
+  return iFind != m_entries.end() && iFind->second.typeId == desc.type &&
+    iFind->second.version == version && iFind->second.contentHash == contentHash;
+}
+
+//==============================================================================
+void AssetBuildCache::Update(Asset::DescriptorCore const& desc,
+  Asset::VersionType version, uint64_t contentHash, time_t sourceTime)
+{
+  std::unique_lock<decltype(m_lock)> lock(m_lock);
+  m_entries[desc.hash] = Entry{ desc.hash, contentHash, sourceTime, desc.type,
+    version, 0 };
+  m_isDirty = true;
+}
+
+//==============================================================================
+void AssetBuildCache::Clear()
+{
+  std::unique_lock<decltype(m_lock)> lock(m_lock);
+  m_entries.clear();
+  m_isDirty = false;
+}
+
+} // xr
+
+#endif  // ENABLE_ASSET_BUILDING
@@ -0,0 +1,79 @@
+#ifndef XR_ASSETBUILDCACHE_HPP
+#define XR_ASSETBUILDCACHE_HPP
+//==============================================================================
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#ifdef ENABLE_ASSET_BUILDING
+#include "xr/Asset.hpp"
+#include "xr/threading/Spinlock.hpp"
+#include <ctime>
+#include <unordered_map>
+
+namespace xr
+{
+
+//==============================================================================
+///@brief Records the hash of the contents of the raw assets, that built assets
+/// were built from, so that the rebuilding of assets whose sources were merely
+/// touched, may be skipped.
+///@note Thread safe.
+class AssetBuildCache
+{
+public:
+  // general
+  ///@brief Reads the index from the file at @a path, replacing our records.
+  /// A missing file is not an error.
+  ///@return The success of the operation.
+  bool Load(FilePath const& path);
+
+  ///@brief Writes the index to @a path, if it has changed since loading.
+  ///@return The success of the operation.
+  bool Save(FilePath const& path);
+
+  ///@return Whether the asset of the given descriptor was last built, at the
+  /// given @a version, from a source whose content was since found unchanged
+  /// at the modification time @a sourceTime - i.e. without hashing it again.
+  bool IsSourceUnchanged(Asset::DescriptorCore const& desc,
+    Asset::VersionType version, time_t sourceTime) const;
+
+  ///@return Whether the asset of the given descriptor was last built from
+  /// a source of the given @a contentHash, at the given @a version.
+  bool IsUpToDate(Asset::DescriptorCore const& desc, Asset::VersionType version,
+    uint64_t contentHash) const;
+
+  ///@brief Records that the asset of the given descriptor was built from
+  /// a source of the given @a contentHash, at the given @a version, and that
+  /// the source was last modified at @a sourceTime.
+  void Update(Asset::DescriptorCore const& desc, Asset::VersionType version,
+    uint64_t contentHash, time_t sourceTime);
+
+  void Clear();
+
+private:
+  // types
+  struct Entry
+  {
+    Asset::HashType hash;
+    uint64_t contentHash;
+    int64_t sourceTime;
+    Asset::TypeId typeId;
+    Asset::VersionType version;
+    uint16_t reserved;
+  };
+
+  // data
+  mutable Spinlock m_lock;
+  std::unordered_map<Asset::HashType, Entry> m_entries;
+  bool m_isDirty = false;
+};
+
+} // xr
+
+#endif  // ENABLE_ASSET_BUILDING
+#endif //XR_ASSETBUILDCACHE_HPP
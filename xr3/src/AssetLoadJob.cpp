@@ -7,6 +7,9 @@
 //
 //==============================================================================
 #include "AssetLoadJob.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 
 namespace xr
 {
@@ -14,11 +17,26 @@ namespace xr
 //==============================================================================
 const size_t kChunkSizeBytes = XR_KBYTES(16);
 
+// Mapped data is paged in by touching it on the loader thread, which is a lot
+// cheaper per byte than reading it.
+const size_t kMappedChunkSizeBytes = XR_KBYTES(256);
+const size_t kPageSizeBytes = XR_KBYTES(4);
+
 //==============================================================================
 AssetLoadJob::AssetLoadJob(File::Handle hFile, size_t size, Asset::Ptr const & a)
 : asset(a),
   mHFile(hFile),
-  mData(size)
+  mData(size),
+  mBuffer{ mData.size(), mData.data() }
+{}
+
+//==============================================================================
+AssetLoadJob::AssetLoadJob(File::MappingHandle hMapping, Buffer const& buffer,
+  Asset::Ptr const& a)
+: asset(a),
+  mHMapping(hMapping),
+  mIsMapped(true),
+  mBuffer(buffer)
 {}
 
 //==============================================================================
@@ -30,42 +48,84 @@ AssetLoadJob::~AssetLoadJob()
 //==============================================================================
 void AssetLoadJob::Start()
 {
-  mNextWrite = mData.data();
+  mProgress = 0;
 }
 
 //==============================================================================
 bool AssetLoadJob::Process()
 {
-  const auto progress = mNextWrite - mData.data();
-  const size_t nextChunkSize = std::min(kChunkSizeBytes, mData.size() - progress);
-  const size_t readSize = File::Read(mHFile, 1, nextChunkSize, mNextWrite);
   bool done = false;
-  if (readSize != nextChunkSize)
+  if (mIsMapped)
   {
-    XR_TRACE(Asset::Manager, ("Failed to read %d bytes of asset '%s' @ %d of %d bytes",
-      nextChunkSize, asset->GetDescriptor().ToPath().c_str(), progress,
-      mData.size()));
-    asset->FlagError();
-    done = true;
+    const size_t nextChunkSize = std::min(kMappedChunkSizeBytes, mBuffer.size - mProgress);
+    auto p = static_cast<uint8_t const volatile*>(mBuffer.data + mProgress);
+    uint8_t sum = 0;
+    for (size_t i = 0; i < nextChunkSize; i += kPageSizeBytes)
+    {
+      sum += p[i];
+    }
+    (void)sum;
+
+    mProgress += nextChunkSize;
+
+    // Assets built before their data was padded may be misaligned in the
+    // mapping; OnLoaded() gets a copy of those.
+    if (mProgress == mBuffer.size && mBuffer.size > 0 &&
+      reinterpret_cast<uintptr_t>(mBuffer.data) % alignof(std::max_align_t) != 0)
+    {
+      mData.assign(mBuffer.data, mBuffer.data + mBuffer.size);
+      mBuffer = { mData.size(), mData.data() };
+    }
   }
   else
   {
-    mNextWrite += readSize;
-
-    if (progress + readSize == mData.size())
+    const size_t nextChunkSize = std::min(kChunkSizeBytes, mData.size() - mProgress);
+    const size_t readSize = File::Read(mHFile, 1, nextChunkSize, mData.data() + mProgress);
+    if (readSize != nextChunkSize)
     {
-      asset->OverrideFlags(Asset::LoadingFlag, Asset::ProcessingFlag);
+      XR_TRACE(Asset::Manager, ("Failed to read %d bytes of asset '%s' @ %d of %d bytes",
+        nextChunkSize, asset->GetDescriptor().ToPath().c_str(), mProgress,
+        mData.size()));
+      asset->FlagError();
       done = true;
     }
+    else
+    {
+      mProgress += readSize;
+    }
+  }
+
+  if (!done && mProgress == mBuffer.size)
+  {
+    asset->OverrideFlags(Asset::LoadingFlag, Asset::ProcessingFlag);
+    done = true;
   }
 
   return done;
 }
 
+//==============================================================================
+bool AssetLoadJob::IsLoaded() const
+{
+  return CheckAnyMaskBits(asset->GetFlags(), Asset::ProcessingFlag | Asset::ErrorFlag);
+}
+
+//==============================================================================
+bool AssetLoadJob::DependsOnAny(Asset const* const* assets, size_t numAssets) const
+{
+  auto iEnd = assets + numAssets;
+  return std::any_of(dependencies.begin(), dependencies.end(),
+    [assets, iEnd](Asset::Ptr const& dep) {
+      return std::find(assets, iEnd, dep.Get()) != iEnd;
+    });
+}
+
 //==============================================================================
 bool AssetLoadJob::ProcessData()
 {
-  return asset->ProcessData({ mData.size(), mData.data() });
+  bool success = asset->ProcessData(mBuffer);
+  CloseHandle();
+  return success;
 }
 
 //==============================================================================
@@ -76,6 +136,13 @@ void AssetLoadJob::CloseHandle()
     File::Close(mHFile);
     mHFile = nullptr;
   }
+
+  if (mIsMapped)
+  {
+    File::Unmap(mHMapping);
+    mHMapping = nullptr;
+    mBuffer = { 0, nullptr };
+  }
 }
 
 }
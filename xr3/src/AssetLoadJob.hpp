@@ -16,14 +16,27 @@ namespace xr
 {
 
 //==============================================================================
+///@brief Gets the data of an asset ready for processing. It either reads the
+/// data from a file, or with a file that was mapped into memory, it pages in
+/// the data in place.
 class AssetLoadJob : public Worker::Job
 {
 public:
   // data
   Asset::Ptr asset;
 
+  ///@brief Assets that must be processed before this one.
+  std::vector<Asset::Ptr> dependencies;
+
   // structors
+  ///@brief Reads the next @a size bytes from @a hFile, taking ownership of it.
   AssetLoadJob(File::Handle hFile, size_t size, Asset::Ptr const& a);
+
+  ///@brief Uses @a buffer, which is [part of] a file mapped into memory, taking
+  /// ownership of @a hMapping. If @a hMapping is nullptr, the mapping must stay
+  /// valid for the lifetime of the job.
+  AssetLoadJob(File::MappingHandle hMapping, Buffer const& buffer, Asset::Ptr const& a);
+
   ~AssetLoadJob();
 
   // general
@@ -31,13 +44,25 @@ public:
 
   virtual bool Process() override;
 
+  ///@return Whether the reading of data has finished, successfully or otherwise.
+  bool IsLoaded() const;
+
+  ///@return Whether any of the @a assets [count: @a numAssets] are amongst
+  /// our dependencies.
+  bool DependsOnAny(Asset const* const* assets, size_t numAssets) const;
+
+  ///@brief Processes the data of the asset, then releases the file mapping,
+  /// if any.
   bool ProcessData();
 
 private:
   // data
   File::Handle          mHFile = nullptr;
-  std::vector<uint8_t>  mData;
-  uint8_t*              mNextWrite = nullptr;
+  File::MappingHandle   mHMapping = nullptr;
+  bool                  mIsMapped = false;
+  std::vector<uint8_t>  mData;  // when reading from mHFile, or if the mapping is misaligned.
+  Buffer                mBuffer;  // into either mData or the mapping.
+  size_t                mProgress = 0;
 
   void CloseHandle();
 };
@@ -12,11 +12,134 @@
 #include "xr/IndexMesh.hpp"
 #include "xr/meshutil.hpp"
 #include "utf8/unchecked.h"
+#include <algorithm>
+#include <limits>
+#include <vector>
 
 namespace utf8u = utf8::unchecked;
 
 namespace xr {
 
+namespace
+{
+
+const ptrdiff_t kNone = -1;
+
+enum CharFlags: uint8_t
+{
+  kPrintable = 0x1, // has a glyph with a bitmap
+  kSpace = 0x2,
+  kLineBreak = 0x4,
+};
+
+// A glyph that was laid out, to create a quad from.
+struct GlyphQuad
+{
+  float x;  // of the cursor, scaled
+  float y;
+  float xBearing; // unscaled, like the rest of the metrics
+  float yBearing;
+  float width;
+  float height;
+  AABB uvs;
+};
+
+// Per code point metrics, for the line breaking.
+struct CharMetrics
+{
+  float advance;
+  float bearing;
+  uint8_t flags;
+};
+
+// Scratch memory for the layout of text, reused across calls on the same
+// thread. The arrays only ever grow.
+struct LayoutBuffers
+{
+  std::vector<uint32_t> codePoints;
+  std::vector<uint32_t> offsets;  // of the code points and the end, from the start of the text.
+  std::vector<Font::Glyph const*> glyphs;
+  std::vector<CharMetrics> metrics;
+  std::vector<GlyphQuad> quads;
+};
+
+thread_local LayoutBuffers tLayoutBuffers;
+
+template <typename T>
+T* Reserve(std::vector<T>& v, size_t size)
+{
+  if (v.size() < size)
+  {
+    v.resize(size);
+  }
+  return v.data();
+}
+
+// Decodes UTF-8 @a text up to @a end, into the code points and offsets of @a lb.
+// If @a validate is set, decoding stops at the first invalid sequence; the
+// validation only kicks in once a multi-byte sequence is found.
+//@return The number of code points decoded.
+size_t Decode(char const* text, char const* end, bool validate, LayoutBuffers& lb)
+{
+  XR_ASSERT(BoxText, end - text < std::numeric_limits<uint32_t>::max());
+  const size_t numBytes = end - text;
+  auto codePoints = Reserve(lb.codePoints, numBytes);
+  auto offsets = Reserve(lb.offsets, numBytes + 1);
+
+  auto const base = text;
+  size_t i = 0;
+  while (text != end)
+  {
+    const auto c = static_cast<uint8_t>(*text);
+    offsets[i] = static_cast<uint32_t>(text - base);
+    if (c < 0x80)
+    {
+      codePoints[i] = c;
+      ++text;
+    }
+    else
+    {
+      if (validate)
+      {
+        end = utf8::find_invalid(text, end);
+        validate = false;
+        if (text == end)
+        {
+          break;
+        }
+      }
+      codePoints[i] = utf8u::next(text);
+    }
+    ++i;
+  }
+  offsets[i] = static_cast<uint32_t>(text - base);
+  return i;
+}
+
+// Looks up the glyphs for the first @a numCodePoints code points of @a lb, and
+// sets their advance, bearing and flags; missing glyphs take no space.
+void ResolveMetrics(Font const& font, size_t numCodePoints, LayoutBuffers& lb)
+{
+  auto codePoints = lb.codePoints.data();
+  auto glyphs = Reserve(lb.glyphs, numCodePoints);
+  font.GetGlyphs(codePoints, numCodePoints, glyphs);
+
+  auto metrics = Reserve(lb.metrics, numCodePoints);
+  for (size_t i = 0; i < numCodePoints; ++i)
+  {
+    const auto cp = codePoints[i];
+    auto glyph = glyphs[i];
+    auto& cm = metrics[i];
+    cm.advance = glyph ? glyph->advance : 0.f;
+    cm.bearing = glyph ? glyph->xBearing : 0.f;
+    cm.flags = ((glyph && glyph->fieldHeight != 0) ? kPrintable : 0) |
+      (IsSpaceUtf8(cp) ? kSpace : 0) |
+      ((cp == '\r' || cp == '\n') ? kLineBreak : 0);
+  }
+}
+
+}
+
 //==============================================================================
 BoxText::BoxText()
 : m_scale(1.f),
@@ -107,8 +230,6 @@ void BoxText::Measure(char const* text, size_t numBytes, Measurement& m) const
 {
   const Font& font = *m_font;
 
-  const float missingGlyphAdvance = 0.f;
-  const float missingGlyphBearing = 0.f;
   const float lineHeight = font.GetLineHeight();
 
   // convert boxSize into font units, since that's what glyph metrics are stored in.
@@ -122,80 +243,83 @@ void BoxText::Measure(char const* text, size_t numBytes, Measurement& m) const
   const float hSpacing = m_horizontalSpacing / m_scale;
   const float vSpacing = m_verticalSpacing / m_scale;
 
+  // Decode the text and look up the metrics of its glyphs up front, then work
+  // with indices of code points.
+  auto& lb = tLayoutBuffers;
+  const ptrdiff_t numCodePoints = Decode(text, text + numBytes, true, lb);
+  ResolveMetrics(font, numCodePoints, lb);
+
+  uint32_t const* codePoints = lb.codePoints.data();
+  uint32_t const* offsets = lb.offsets.data();
+  CharMetrics const* metrics = lb.metrics.data();
+
   float position = 0.f;  // of current row, world units
   float widthLineStart = 0.f;
   float widthWordEnd = 0.f; // width at the end of the last completed word, world units
   float widthWordStart = 0.f; // width at the start of the current word, world units
-  char const* wordStart = nullptr;
-  char const* wordEnd = nullptr;
-  char const* nextLineStart = nullptr;
+  ptrdiff_t wordStart = kNone;
+  ptrdiff_t wordEnd = kNone;
+  ptrdiff_t nextLineStart = kNone;
 
-  Measurement tm{ Vector2::Zero(), 0, {} };
+  Measurement tm{ Vector2::Zero(), 0, std::move(m.lines) }; // reuse its storage
+  tm.lines.clear();
   tm.lines.reserve(size_t(std::floor(boxSize.y / (lineHeight + vSpacing))));
 
-  Measurement::Line line{ nullptr, nullptr, 0.f };
+  ptrdiff_t lineStart = kNone;
+  ptrdiff_t lineEnd = kNone;
+  ptrdiff_t lastLineEnd = 0;
+  float lineWidth = 0.f;
 
-  auto endText = utf8::find_invalid(text, text + numBytes);
-  while (text != endText)
+  ptrdiff_t i = 0;
+  while (i != numCodePoints)
   {
-    const auto cp = utf8u::peek_next(text);
-    const bool isCr = cp == '\r';
-    if (isCr || cp == '\n')  // line break
+    const uint8_t flags = metrics[i].flags;
+    if (flags & kLineBreak)
     {
-      line.end = text;
-      line.width = position - widthLineStart;
+      lineEnd = i;
+      lineWidth = position - widthLineStart;
 
-      wordStart = nullptr;
+      wordStart = kNone;
 
-      utf8u::advance(text, 1);  // skip newline
-      if (isCr && text != endText && utf8u::peek_next(text) == '\n')  // if CR/LF, keep going
+      ++i;  // skip newline
+      if (codePoints[i - 1] == '\r' && i != numCodePoints && codePoints[i] == '\n')  // if CR/LF, keep going
       {
-        utf8u::advance(text, 1);
+        ++i;
       }
 
-      nextLineStart = text;
+      nextLineStart = i;
       position = 0.f;
     }
     else
     {
-      // Get glyph.
-      auto glyph = font.GetGlyph(cp);
-      float glyphAdvance = missingGlyphAdvance;
-      float glyphBearing = missingGlyphBearing;
-      if (glyph)
-      {
-        glyphAdvance = glyph->advance;
-        glyphBearing = glyph->xBearing;
-        if (glyph->fieldHeight != 0)
-        {
-          ++tm.numGlyphs;
-        }
-      }
+      float glyphAdvance = metrics[i].advance;
+      const float glyphBearing = metrics[i].bearing;
 
       // If glyph is wider than row, terminate processing.
       if (glyphAdvance > boxSize.x)
       {
-        wordStart = nullptr;
+        wordStart = kNone;
         break;
       }
+      tm.numGlyphs += (flags & kPrintable) != 0;
 
       // Check word boundary and line start.
-      const bool isSpace = IsSpaceUtf8(cp);
-      if ((wordStart != nullptr) == isSpace) // If we have a word started, and hit space, or if have no word started and hit non-whitespace.
+      const bool isSpace = (flags & kSpace) != 0;
+      if ((wordStart != kNone) == isSpace) // If we have a word started, and hit space, or if have no word started and hit non-whitespace.
       {
-        if (wordStart)  // Had word, now finished.
+        if (wordStart != kNone)  // Had word, now finished.
         {
           widthWordEnd = position;
-          wordEnd = text;
-          wordStart = nullptr;
+          wordEnd = i;
+          wordStart = kNone;
         }
         else
         {
           widthWordStart = position;
-          wordStart = text;
-          if (!line.start)
+          wordStart = i;
+          if (lineStart == kNone)
           {
-            line.start = text;
+            lineStart = i;
             widthLineStart = position;
             glyphAdvance -= glyphBearing;
           }
@@ -204,11 +328,11 @@ void BoxText::Measure(char const* text, size_t numBytes, Measurement& m) const
 
       if (position + glyphAdvance > boxSize.x) // We've reached the end of the row.
       {
-        if (line.start && wordEnd > line.start) // There was at least one complete word.
+        if (lineStart != kNone && wordEnd > lineStart) // There was at least one complete word.
         {
-          line.end = wordEnd;
-          line.width = widthWordEnd - widthLineStart;
-          if (wordStart)
+          lineEnd = wordEnd;
+          lineWidth = widthWordEnd - widthLineStart;
+          if (wordStart != kNone)
           {
             position = position - widthWordStart + glyphAdvance + hSpacing;
           }
@@ -220,16 +344,16 @@ void BoxText::Measure(char const* text, size_t numBytes, Measurement& m) const
         }
         else // We're either amidst whitespace, or in a word that has spanned the whole row -- we have to linebreak.
         {
-          line.end = text;
-          line.width = position - widthLineStart;
+          lineEnd = i;
+          lineWidth = position - widthLineStart;
           if (isSpace)
           {
-            wordStart = nullptr;
+            wordStart = kNone;
             position = 0.f;
           }
           else  // in a word; just break on the character and signal new line start.
           {
-            wordStart = text;
+            wordStart = i;
             position = glyphAdvance - glyphBearing + hSpacing;
 
             widthLineStart = 0.f;
@@ -242,19 +366,26 @@ void BoxText::Measure(char const* text, size_t numBytes, Measurement& m) const
         position += glyphAdvance + hSpacing;
       }
 
-      utf8u::advance(text, 1);
+      ++i;
     }
 
     // Process new line
-    if (line.end)
+    if (lineEnd != kNone)
     {
-      XR_ASSERT(BoxText, line.start && line.end);
-      auto lineChars = utf8u::distance(line.start, line.end);
-      line.width -= hSpacing * (lineChars > 0);
-      line.width *= m_scale;  // Convert to scaled units.
+      if (lineStart == kNone) // nothing but whitespace; an empty line.
+      {
+        lineStart = lineEnd;
+        lineWidth = 0.f;
+      }
 
-      tm.size.x = std::max(line.width, tm.size.x);
-      tm.lines.push_back(line);
+      const auto lineChars = lineEnd - lineStart;
+      lineWidth -= hSpacing * (lineChars > 0);
+      lineWidth *= m_scale;  // Convert to scaled units.
+
+      tm.size.x = std::max(lineWidth, tm.size.x);
+      tm.lines.push_back(Measurement::Line{ text + offsets[lineStart],
+        text + offsets[lineEnd], lineWidth });
+      lastLineEnd = lineEnd;
 
       tm.size.y += lineHeight + vSpacing;
       if (tm.size.y + lineHeight > boxSize.y)  // Prevent vertical overflow.
@@ -263,24 +394,32 @@ void BoxText::Measure(char const* text, size_t numBytes, Measurement& m) const
       }
 
       // new line starts here
-      line.start = nextLineStart;
-      line.end = nullptr;
-      // NOTE: nextLineStart = nullptr; not required - we only read it on the previous line and end-of-line scenarios are supposed to set it.
+      lineStart = nextLineStart;
+      lineEnd = kNone;
+      // NOTE: nextLineStart = kNone; not required - we only read it on the previous line and end-of-line scenarios are supposed to set it.
     }
   }
 
   // Process last row - if there's enough vertical space and row not empty.
-  if (text == endText && line.start && tm.size.y + lineHeight <= boxSize.y)
+  if (i == numCodePoints && lineStart != kNone && tm.size.y + lineHeight <= boxSize.y)
   {
-    line.end = text;
+    lineEnd = i;
 
-    auto lineChars = utf8u::distance(line.start, line.end);
-    line.width = position - widthLineStart - hSpacing * (lineChars > 0);
-    line.width *= m_scale;
+    const auto lineChars = lineEnd - lineStart;
+    lineWidth = position - widthLineStart - hSpacing * (lineChars > 0);
+    lineWidth *= m_scale;
 
-    tm.size.x = std::max(line.width, tm.size.x);
+    tm.size.x = std::max(lineWidth, tm.size.x);
     tm.size.y += lineHeight;
-    tm.lines.push_back(line);
+    tm.lines.push_back(Measurement::Line{ text + offsets[lineStart],
+      text + offsets[lineEnd], lineWidth });
+    lastLineEnd = lineEnd;
+  }
+
+  // Glyphs that we've counted past the last line that fits aren't generated.
+  for (ptrdiff_t j = lastLineEnd; j < i; ++j)
+  {
+    tm.numGlyphs -= (metrics[j].flags & kPrintable) != 0;
   }
 
   // TODO: ellipses for truncated text?
@@ -308,14 +447,21 @@ const Aligner kHorizontalAligners[] = {
 void BoxText::Generate(Measurement const& m, uint32_t attribStride,
   Vector3* positions, Vector2* uvs, bool updateGlyphCache, Stats* statsOut) const
 {
+  Generate(m, 0, attribStride, positions, uvs, nullptr, updateGlyphCache, statsOut);
+}
+
+//==============================================================================
+void BoxText::Generate(Measurement const& m, size_t firstLine, uint32_t attribStride,
+  Vector3* positions, Vector2* uvs, uint32_t* lineGlyphCountsOut,
+  bool updateGlyphCache, Stats* statsOut) const
+{
+  XR_ASSERT(BoxText, firstLine <= m.lines.size());
   Font& font = *m_font;
 
   const float lineHeight = font.GetLineHeight() * m_scale;
   float maxLineWidth = 0.f;
   float height = m.size.y;
 
-  XR_DEBUG_ONLY(auto posEnd = meshutil::AdvancePointer(positions, attribStride *
-    m.numGlyphs * Quad::Vertex::kCount);)
   if (m.numGlyphs > 0)
   {
     // Calculate the starting position -- offset by ascent (i.e. to baseline).
@@ -339,63 +485,88 @@ void BoxText::Generate(Measurement const& m, uint32_t attribStride,
 
     cursor.y -= font.GetAscent() * m_scale;
 
-    // Build mesh.
-    Font::CachedGlyph const* cg;
-    for (auto const& line : m.lines)
+    // Lay out the glyphs - caching them, in order - then build the mesh from
+    // the quads.
+    auto& lb = tLayoutBuffers;
+    lb.quads.clear();
+    for (size_t iLine = 0; iLine < m.lines.size(); ++iLine)
     {
-      hAligner(m_boxSize.x - line.width, cursor.x);
+      auto const& line = m.lines[iLine];
       maxLineWidth = std::max(maxLineWidth, line.width);
+      if (iLine < firstLine)
+      {
+        cursor.y -= lineHeight + m_verticalSpacing;
+        continue;
+      }
 
-      auto i = line.start;
+      hAligner(m_boxSize.x - line.width, cursor.x);
+
+      const size_t numQuads = lb.quads.size();
       XR_ASSERT(BoxText, utf8::is_valid(line.start, line.end));
-      while (i != line.end)
+      const size_t numCodePoints = Decode(line.start, line.end, false, lb);
+      for (auto codePoint = lb.codePoints.data(), iEnd = codePoint + numCodePoints;
+        codePoint != iEnd; ++codePoint)
       {
-        auto codePoint = utf8u::peek_next(i);
-        cg = font.CacheGlyph(codePoint);
+        auto cg = font.CacheGlyph(*codePoint);
         if (cg)
         {
-          XR_ASSERT(BoxText, positions < posEnd);
+          auto const& glyph = *cg->glyph;
           if (cg->uvs.right > 0.f)
           {
-            // set pos, uv
-            const float gx = cursor.x + cg->glyph->xBearing * m_scale;
-            const float gy = cursor.y + cg->glyph->yBearing * m_scale;
-            const float gw = cg->glyph->width * m_scale;
-            const float gh = cg->glyph->height * m_scale;
-
-            namespace mu = meshutil;
-
-            *positions = Vector3(gx, gy + gh, 0.f);
-            *uvs = Vector2(cg->uvs.left, cg->uvs.top);
-            positions = mu::AdvancePointer(positions, attribStride);
-            uvs = mu::AdvancePointer(uvs, attribStride);
-
-            *positions = Vector3(gx, gy, 0.f);
-            *uvs = Vector2(cg->uvs.left, cg->uvs.bottom);
-            positions = mu::AdvancePointer(positions, attribStride);
-            uvs = mu::AdvancePointer(uvs, attribStride);
-
-            *positions = Vector3(gx + gw, gy + gh, 0.f);
-            *uvs = Vector2(cg->uvs.right, cg->uvs.top);
-            positions = mu::AdvancePointer(positions, attribStride);
-            uvs = mu::AdvancePointer(uvs, attribStride);
-
-            *positions = Vector3(gx + gw, gy, 0.f);
-            *uvs = Vector2(cg->uvs.right, cg->uvs.bottom);
-            positions = mu::AdvancePointer(positions, attribStride);
-            uvs = mu::AdvancePointer(uvs, attribStride);
+            lb.quads.push_back(GlyphQuad{ cursor.x, cursor.y, glyph.xBearing,
+              glyph.yBearing, glyph.width, glyph.height, cg->uvs });
           }
 
-          cursor.x += cg->glyph->advance * m_scale;
+          cursor.x += glyph.advance * m_scale;
         }
         cursor.x += m_horizontalSpacing;
+      }
 
-        utf8u::advance(i, 1);
+      if (lineGlyphCountsOut)
+      {
+        *lineGlyphCountsOut = static_cast<uint32_t>(lb.quads.size() - numQuads);
+        ++lineGlyphCountsOut;
       }
 
       cursor.y -= lineHeight + m_verticalSpacing;
       cursor.x = x0;
     }
+
+    XR_ASSERT(BoxText, lb.quads.size() <= m.numGlyphs);
+    const float scale = m_scale;
+    for (auto const& q : lb.quads)
+    {
+      const float gx = q.x + q.xBearing * scale;
+      const float gy = q.y + q.yBearing * scale;
+      const float gw = q.width * scale;
+      const float gh = q.height * scale;
+
+      namespace mu = meshutil;
+
+      *positions = Vector3(gx, gy + gh, 0.f);
+      *uvs = Vector2(q.uvs.left, q.uvs.top);
+      positions = mu::AdvancePointer(positions, attribStride);
+      uvs = mu::AdvancePointer(uvs, attribStride);
+
+      *positions = Vector3(gx, gy, 0.f);
+      *uvs = Vector2(q.uvs.left, q.uvs.bottom);
+      positions = mu::AdvancePointer(positions, attribStride);
+      uvs = mu::AdvancePointer(uvs, attribStride);
+
+      *positions = Vector3(gx + gw, gy + gh, 0.f);
+      *uvs = Vector2(q.uvs.right, q.uvs.top);
+      positions = mu::AdvancePointer(positions, attribStride);
+      uvs = mu::AdvancePointer(uvs, attribStride);
+
+      *positions = Vector3(gx + gw, gy, 0.f);
+      *uvs = Vector2(q.uvs.right, q.uvs.bottom);
+      positions = mu::AdvancePointer(positions, attribStride);
+      uvs = mu::AdvancePointer(uvs, attribStride);
+    }
+  }
+  else if (lineGlyphCountsOut)
+  {
+    std::fill(lineGlyphCountsOut, lineGlyphCountsOut + (m.lines.size() - firstLine), 0);
   }
 
   if (updateGlyphCache)
@@ -432,7 +603,11 @@ IndexMesh BoxText::CreateMesh(const char* text, size_t numBytes, bool updateGlyp
       m.numGlyphs, indices.data());
   }
 
-  Generate(m, vertices.data(), updateGlyphCache, statsOut);
+  // Without glyphs there are no vertices, so no attributes to point to; still
+  // call Generate() for the stats and the glyph cache update.
+  auto verts = vertices.data();
+  Generate(m, Vertex::kSize, verts ? &verts->pos : nullptr,
+    verts ? &verts->uv0 : nullptr, updateGlyphCache, statsOut);
 
   return IndexMesh::Create(static_cast<uint32_t>(vertices.size()), vertices.data(),
     static_cast<uint32_t>(indices.size()), indices.data());
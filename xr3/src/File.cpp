@@ -18,6 +18,15 @@
 #include "xr/memory/ScopeGuard.hpp"
 #endif
 
+#if defined(XR_PLATFORM_WINDOWS)
+#define XR_FILE_MAPPING_WINDOWS
+#elif !defined(XR_PLATFORM_EMSCRIPTEN)
+#define XR_FILE_MAPPING_POSIX
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include <sys/stat.h>
 #include <algorithm>
 #include <fstream>
@@ -118,6 +127,17 @@ private:
 
 }
 
+//==============================================================================
+struct File::Mapping
+{
+  uint8_t const* data;
+  size_t size;
+#ifdef XR_FILE_MAPPING_WINDOWS
+  HANDLE hFile;
+  HANDLE hMapping;
+#endif
+};
+
 //==============================================================================
 FilePath const File::kRawProto("raw://");
 
@@ -315,6 +335,126 @@ void File::Close(Handle hFile)
   }
 }
 
+//==============================================================================
+File::MappingHandle File::Map(FilePath const& name)
+{
+  Mapping* mapping = nullptr;
+  struct MapOp : FileOp
+  {
+    Mapping*& mapping;
+
+    MapOp(Mapping*& outMapping)
+    : mapping(outMapping)
+    {}
+
+    bool Process(char const* path) override
+    {
+#if defined(XR_FILE_MAPPING_WINDOWS)
+      HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (hFile == INVALID_HANDLE_VALUE)
+      {
+        return false;
+      }
+
+      LARGE_INTEGER size;
+      HANDLE hMapping = nullptr;
+      void const* data = nullptr;
+      if (GetFileSizeEx(hFile, &size) && size.QuadPart > 0)
+      {
+        hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (hMapping)
+        {
+          data = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+        }
+      }
+
+      if (!data)
+      {
+        if (hMapping)
+        {
+          CloseHandle(hMapping);
+        }
+        CloseHandle(hFile);
+        return false;
+      }
+
+      mapping = new Mapping{ static_cast<uint8_t const*>(data),
+        static_cast<size_t>(size.QuadPart), hFile, hMapping };
+      return true;
+#elif defined(XR_FILE_MAPPING_POSIX)
+      int fd = open(path, O_RDONLY);
+      if (fd == -1)
+      {
+        return false;
+      }
+
+      // The mapping stays valid once the descriptor is closed.
+      auto fdGuard = MakeScopeGuard([fd]() {
+        close(fd);
+      });
+
+      struct stat statBuffer;
+      if (fstat(fd, &statBuffer) != 0 || statBuffer.st_size <= 0)
+      {
+        return false;
+      }
+
+      const size_t size = static_cast<size_t>(statBuffer.st_size);
+      void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED)
+      {
+        return false;
+      }
+
+      mapping = new Mapping{ static_cast<uint8_t const*>(data), size };
+      return true;
+#else
+      (void)path;
+      return false;
+#endif
+    }
+
+    bool RomApplicable() const override
+    {
+      return true;
+    }
+  } op(mapping);
+
+  op.Perform(name);
+  return mapping;
+}
+
+//==============================================================================
+uint8_t const* File::GetMappedData(MappingHandle hMapping)
+{
+  XR_ASSERT_HANDLE_VALID(hMapping);
+  return hMapping->data;
+}
+
+//==============================================================================
+size_t File::GetMappedSize(MappingHandle hMapping)
+{
+  XR_ASSERT_HANDLE_VALID(hMapping);
+  return hMapping->size;
+}
+
+//==============================================================================
+void File::Unmap(MappingHandle hMapping)
+{
+  if (hMapping)
+  {
+#if defined(XR_FILE_MAPPING_WINDOWS)
+    UnmapViewOfFile(hMapping->data);
+    CloseHandle(hMapping->hMapping);
+    CloseHandle(hMapping->hFile);
+#elif defined(XR_FILE_MAPPING_POSIX)
+    munmap(const_cast<uint8_t*>(hMapping->data), hMapping->size);
+#endif
+    delete hMapping;
+  }
+}
+
 //==============================================================================
 bool File::Delete(FilePath const & path)
 {
@@ -415,7 +555,8 @@ bool File::MakeDirs(FilePath const& path)
     {
       dir.append(start, end - start);
       dir.AppendDirSeparator();
-      if (!IsDir(dir, false) && !MakeDir(dir))
+      // Another thread may have created the directory since we've checked.
+      if (!IsDir(dir, false) && !MakeDir(dir) && !IsDir(dir, false))
       {
         success = false;
         break;
@@ -10,8 +10,10 @@
 #include "xr/TextureCache.hpp"
 #include "xr/Font.hpp"
 #include "xr/memory/BufferReader.hpp"
+#include <algorithm>
 #ifdef ENABLE_ASSET_BUILDING
 #include "SdfBuilder.hpp"
+#include "xr/threading/TaskScheduler.hpp"
 #include "xr/xon/XonBuildTree.hpp"
 #include "xr/FileBuffer.hpp"
 #include "xr/io/streamutils.hpp"
@@ -20,8 +22,12 @@
 #include "xr/debug.hpp"
 #include "xr/types/intutils.hpp"
 #include "stb_truetype.h"
+#include <atomic>
+#include <cstring>
 #include <iostream>
 #include <list>
+#include <memory>
+#include <mutex>
 #include <regex>
 #include <locale>
 #endif
@@ -47,6 +53,7 @@ XR_ASSET_DEF(Font, "xfnt", 4, "fnt")
     fontSize: 128,
     fontIndex: 0,
     sdfSize: 4,
+    sdfMethod: propagation, # or exact
     codePoints: {
       '\\'',          # ascii character, escaped
       '!'-'z',        # ascii character range
@@ -99,6 +106,27 @@ const Px kDefaultCacheSize = 1024;
 
 const float kUnitsToPixel = 1.0f / 64.0f;
 
+// The number of glyphs rasterized in parallel, before they're written.
+const size_t kGlyphBatchSize = 256;
+
+// Shared by the Font builds that run at the same time, e.g. from
+// Asset::Manager::BuildAll(), so that those don't each start a thread per core.
+// The builds own it; its threads are stopped once the last of them finishes.
+// Builds calling ParallelFor() help out, so they're never starved.
+std::shared_ptr<TaskScheduler> AcquireGlyphScheduler()
+{
+  static std::mutex mutex;
+  static std::weak_ptr<TaskScheduler> shared;
+  std::unique_lock<std::mutex> lock(mutex);
+  auto scheduler = shared.lock();
+  if (!scheduler)
+  {
+    scheduler = std::make_shared<TaskScheduler>();
+    shared = scheduler;
+  }
+  return scheduler;
+}
+
 const std::string kStrValueRegex("('(\\\\?.)'|(0x[0-9a-z]{1,4}))");
 const std::regex kValueRegex(kStrValueRegex + "( *- *" + kStrValueRegex + ")?", std::regex::icase);
 
@@ -235,6 +263,174 @@ void SplitRanges(uint32_t value, std::vector<Range>& ranges)
   }
 }
 
+// The parameters of rasterizing glyphs, common to all of them.
+struct GlyphRasterParams
+{
+  stbtt_fontinfo const* font;
+  char const* rawNameExt;
+  float pixelScale;
+  float sdfSizeUnits;
+  int32_t ascentPixels;
+  int32_t glyphPadding;
+  int32_t glyphWidthPadded;
+  int32_t glyphHeightPadded;
+  Px fontSize;
+  Px sdfSize;
+  SdfBuilder::Method sdfMethod;
+};
+
+// A glyph, and its bitmap of fieldWidth x fieldHeight pixels, if it has one.
+struct RasterizedGlyph
+{
+  Font::Glyph glyph;
+  bool hasBitmap;
+  std::vector<uint8_t> bitmap;
+};
+
+// Rasterizes glyphs - and generates their SDF if needed - reusing its buffers.
+// Use one per thread.
+class GlyphRasterizer
+{
+public:
+  explicit GlyphRasterizer(GlyphRasterParams const& params)
+  : m_params(params),
+    m_buffer(params.glyphWidthPadded * params.glyphHeightPadded)
+  {
+    if (params.sdfSize > 0)
+    {
+      m_sdf.reset(new SdfBuilder(params.fontSize, params.sdfSize, params.sdfMethod));
+    }
+  }
+
+  bool Rasterize(uint32_t codePoint, RasterizedGlyph& result)
+  {
+    auto const& params = m_params;
+    auto const font = params.font;
+    auto const iGlyph = stbtt_FindGlyphIndex(font, codePoint);
+    XR_ASSERT(Font, iGlyph > 0);
+
+    auto& glyph = result.glyph;
+    glyph.codePoint = codePoint;
+
+    // Get glyph metrics.
+    int32_t advance;
+    int32_t xBearing;
+    stbtt_GetGlyphHMetrics(font, iGlyph, &advance, &xBearing);
+    glyph.advance = advance * kUnitsToPixel;
+    glyph.xBearing = (xBearing - params.sdfSizeUnits) * kUnitsToPixel;
+
+    // Get glyph box in font units.
+    // Y increases upwards and the origin is the baseline / ascent.
+    // Y0 is bottom, Y1 is top.
+    int32_t x0 = 0, x1 = 0, y0 = 0, y1 = 0;  // left alone for glyphs without outlines.
+    stbtt_GetGlyphBox(font, iGlyph, &x0, &y0, &x1, &y1);
+
+    glyph.width = (x1 - x0 + 2.0f * params.sdfSizeUnits) * kUnitsToPixel;
+    glyph.height = (y1 - y0 + 2.0f * params.sdfSizeUnits) * kUnitsToPixel;
+    glyph.yBearing = (y0 - params.sdfSizeUnits) * kUnitsToPixel;
+
+    result.hasBitmap = !IsSpaceUtf8(codePoint);
+    if (!result.hasBitmap) // if whitespace, don't waste memory.
+    {
+      glyph.fieldHeight = 0;
+      glyph.fieldWidth = 0;
+      glyph.dataOffset = uint32_t(-1);
+      result.bitmap.clear();
+      return true;
+    }
+
+    // Get glyph bitmap box coordinates.
+    // Y increases downwards and the origin is the baseline / ascent.
+    // Y0 is top (ascent + y0 for absolute coords), Y1 is bottom.
+    const float pixelScale = params.pixelScale;
+    stbtt_GetGlyphBitmapBox(font, iGlyph, pixelScale, pixelScale, &x0, &y0, &x1, &y1);
+    int32_t w = x1 - x0;
+    int32_t h = y1 - y0;
+
+    if (!Representable<Px>(w))
+    {
+      XR_TRACE(Font, ("%s: glyph %u bitmap has excessive width: %u; must fit on 16 bits.", params.rawNameExt, codePoint, w));
+      return false;
+    }
+
+    if (!Representable<Px>(h))
+    {
+      XR_TRACE(Font, ("%s: glyph %u bitmap has excessive height: %u; must fit on 16 bits.", params.rawNameExt, codePoint, h));
+      return false;
+    }
+
+    if (m_sdf)
+    {
+      // Copy glyph bitmap data to an area padded for SDF.
+      std::fill(m_buffer.begin(), m_buffer.end(), uint8_t(0x00));
+      const int32_t glyphWidthPadded = params.glyphWidthPadded;
+      uint8_t* glyphBitmapPadded = m_buffer.data() + glyphWidthPadded + params.glyphPadding;
+
+      // Blit the glyph at its absolute position (sdf padding and ascent applies).
+      const int32_t sdfSize = params.sdfSize;
+      auto xBearingPixels = int32_t(std::ceil(glyph.xBearing * pixelScale));
+      auto xPixelOffs = std::max(0, sdfSize + xBearingPixels);
+      auto yPixelOffs = std::max(0, sdfSize + params.ascentPixels + y0);
+      auto bufferOffset = xPixelOffs + yPixelOffs * glyphWidthPadded;
+
+      stbtt_MakeGlyphBitmap(font, glyphBitmapPadded + bufferOffset,
+        w, h, glyphWidthPadded, pixelScale, pixelScale, iGlyph);
+
+#ifdef ENABLE_GLYPH_DEBUG
+      printf("%04x: ", codePoint);
+      VisualizeBuffer(glyphBitmapPadded + bufferOffset, w, h, glyphWidthPadded);
+#endif
+
+      // Calculate SDF metrics & generate SDF around glyph.
+      auto sx0 = std::max(xPixelOffs - sdfSize, 0);
+      auto sy0 = std::max(yPixelOffs - sdfSize, 0);  // ascentPixels + y0; never really < 0.
+      auto sx1 = std::min<int32_t>(xPixelOffs + w + sdfSize, params.fontSize);
+      auto sy1 = std::min<int32_t>(yPixelOffs + h + sdfSize, params.fontSize);
+      w = sx1 - sx0;
+      h = sy1 - sy0;
+      if (!Representable<Px>(w))
+      {
+        XR_TRACE(Font, ("%s: glyph %u SDF has excessive width: %u; must fit on 16 bits.", params.rawNameExt, codePoint, w));
+        return false;
+      }
+
+      if (!Representable<Px>(h))
+      {
+        XR_TRACE(Font, ("%s: glyph %u SDF has excessive height: %u; must fit on 16 bits.", params.rawNameExt, codePoint, h));
+        return false;
+      }
+
+      bufferOffset = sx0 + sy0 * glyphWidthPadded;
+      m_sdf->Generate(glyphBitmapPadded + bufferOffset, Px(glyphWidthPadded),
+        Px(w), Px(h));
+
+      result.bitmap.resize(w * h);
+      m_sdf->ConvertToBitmap(Px(w), Px(h), result.bitmap.data());
+    }
+    else
+    {
+      // Blit the glyph at its absolute position (ascent applies).
+      result.bitmap.assign(w * h, uint8_t(0x00));
+      stbtt_MakeGlyphBitmap(font, result.bitmap.data(), w, h, w, pixelScale,
+        pixelScale, iGlyph);
+    }
+
+    glyph.fieldWidth = Px(w);
+    glyph.fieldHeight = Px(h);
+
+#ifdef ENABLE_GLYPH_DEBUG
+    printf("%s%04x: ", m_sdf ? "SDF " : "", codePoint);
+    VisualizeBuffer(result.bitmap.data(), w, h, w);
+#endif
+    return true;
+  }
+
+private:
+  GlyphRasterParams const& m_params;
+  std::vector<uint8_t> m_buffer;
+  std::unique_ptr<SdfBuilder> m_sdf;
+};
+
 XR_ASSET_BUILDER_DECL(Font)
 
 XR_ASSET_BUILDER_BUILD_SIG(Font)
@@ -355,6 +551,30 @@ XR_ASSET_BUILDER_BUILD_SIG(Font)
     }
   }
 
+  auto sdfMethod = SdfBuilder::Method::Propagation;
+  if (auto xon = root->TryGet("sdfMethod"))
+  {
+    try
+    {
+      auto method = xon->ToValue().GetString();
+      if (method && strcmp(method, "exact") == 0)
+      {
+        sdfMethod = SdfBuilder::Method::Exact;
+      }
+      else if (!method || strcmp(method, "propagation") != 0)
+      {
+        LTRACE(("%s: '%s' is invalid for %s; defaulting to %s.", rawNameExt,
+          method ? method : "null", "sdfMethod", "propagation"));
+      }
+    }
+    catch (XonEntity::Exception const& e)
+    {
+      XR_ASSERT(Font, e.type == XonEntity::Exception::Type::InvalidType);
+      LTRACE(("%s: %s has invalid type.", rawNameExt, "sdfMethod"));
+      return false;
+    }
+  }
+
   if (auto xon = root->TryGet("cacheSize"))
   {
     try
@@ -496,124 +716,52 @@ XR_ASSET_BUILDER_BUILD_SIG(Font)
   printf("max: %d x %d\n", glyphWidthPadded, glyphHeightPadded);
 #endif
 
-  std::vector<uint8_t> glyphBitmap(glyphWidthPadded * glyphHeightPadded);
-  uint8_t* glyphBitmapPadded = glyphBitmap.data() + glyphWidthPadded + glyphPadding;
+  const GlyphRasterParams params{ &stbFont, rawNameExt, pixelScale, sdfSizeUnits,
+    ascentPixels, glyphPadding, glyphWidthPadded, glyphHeightPadded, fontSize, sdfSize,
+    sdfMethod };
 
-  std::unique_ptr<SdfBuilder> sdf;
-  if (sdfSize > 0)
+  std::vector<uint32_t> codePoints;
+  codePoints.reserve(numGlyphs);
+  for (auto& r: ranges)
   {
-    sdf.reset(new SdfBuilder(fontSize, sdfSize));
+    for(auto i0 = r.start, i1 = r.end; i0 != i1; ++i0)
+    {
+      codePoints.push_back(i0);
+    }
   }
 
-  Font::Glyph glyph;
+  // Rasterize the glyphs in batches, in parallel, then write them in order;
+  // the output is the same as if they were done one by one.
+  auto scheduler = AcquireGlyphScheduler();
+  std::vector<RasterizedGlyph> batch(std::min(codePoints.size(), kGlyphBatchSize));
   std::ostringstream glyphBitmaps;
   size_t glyphBytesWritten = 0;
-  for (auto& r: ranges)
+  for (size_t i = 0; i < codePoints.size(); i += batch.size())
   {
-    for(auto i0 = r.start, i1 = r.end; i0 != i1; ++i0)
-    {
-      auto const iGlyph = stbtt_FindGlyphIndex(&stbFont, i0);
-      XR_ASSERT(Font, iGlyph > 0);
-
-      glyph.codePoint = i0;
-
-      // Get glyph metrics.
-      int32_t advance;
-      int32_t xBearing;
-      stbtt_GetGlyphHMetrics(&stbFont, iGlyph, &advance, &xBearing);
-      glyph.advance = advance * kUnitsToPixel;
-      glyph.xBearing = (xBearing - sdfSizeUnits) * kUnitsToPixel;
-
-      // Get glyph box in font units.
-      // Y increases upwards and the origin is the baseline / ascent.
-      // Y0 is bottom, Y1 is top.
-      stbtt_GetGlyphBox(&stbFont, iGlyph, &x0, &y0, &x1, &y1);
-
-      glyph.width = (x1 - x0 + 2.0f * sdfSizeUnits) * kUnitsToPixel;
-      glyph.height = (y1 - y0 + 2.0f * sdfSizeUnits) * kUnitsToPixel;
-      glyph.yBearing = (y0 - sdfSizeUnits) * kUnitsToPixel;
-
-      if (IsSpaceUtf8(i0)) // if whitespace, don't waste memory.
-      {
-        glyph.fieldHeight = 0;
-        glyph.fieldWidth = 0;
-        glyph.dataOffset = uint32_t(-1);
-      }
-      else
+    const size_t batchSize = std::min(batch.size(), codePoints.size() - i);
+    std::atomic<bool> success{ true };
+    scheduler->ParallelFor(0, batchSize, 0, [&](size_t begin, size_t end) {
+      GlyphRasterizer rasterizer(params);
+      for (; begin != end && success.load(std::memory_order_relaxed); ++begin)
       {
-        // Copy glyph bitmap data to an area padded for SDF.
-        std::fill(glyphBitmap.begin(), glyphBitmap.end(), uint8_t(0x00));
-
-        // Get glyph bitmap box coordinates.
-        // Y increases downwards and the origin is the baseline / ascent.
-        // Y0 is top (ascent + y0 for absolute coords), Y1 is bottom.
-        stbtt_GetGlyphBitmapBox(&stbFont, iGlyph, pixelScale, pixelScale,
-          &x0, &y0, &x1, &y1);
-        int32_t w = x1 - x0;
-        int32_t h = y1 - y0;
-
-        if (!Representable<Px>(w))
-        {
-          XR_TRACE(Font, ("%s: glyph %u bitmap has excessive width: %u; must fit on 16 bits.", rawNameExt, i0, w));
-          return false;
-        }
-
-        if (!Representable<Px>(h))
+        if (!rasterizer.Rasterize(codePoints[i + begin], batch[begin]))
         {
-          XR_TRACE(Font, ("%s: glyph %u bitmap has excessive height: %u; must fit on 16 bits.", rawNameExt, i0, h));
-          return false;
-        }
-
-        if (sdf)
-        {
-          // Blit the glyph at its absolute position (sdf padding and ascent applies).
-          auto xBearingPixels = int32_t(std::ceil(glyph.xBearing * pixelScale));
-          auto xPixelOffs = std::max(0, sdfSize + xBearingPixels);
-          auto yPixelOffs = std::max(0, sdfSize + ascentPixels + y0);
-          auto bufferOffset = xPixelOffs + yPixelOffs * glyphWidthPadded;
-
-          stbtt_MakeGlyphBitmap(&stbFont, glyphBitmapPadded + bufferOffset,
-            w, h, glyphWidthPadded, pixelScale, pixelScale, iGlyph);
-
-#ifdef ENABLE_GLYPH_DEBUG
-          printf("%04x: ", i0);
-          VisualizeBuffer(glyphBitmapPadded + bufferOffset, w, h, glyphWidthPadded);
-#endif
-
-          // Calculate SDF metrics & generate SDF around glyph.
-          auto sx0 = std::max(xPixelOffs - sdfSize, 0);
-          auto sy0 = std::max(yPixelOffs - sdfSize, 0);  // ascentPixels + y0; never really < 0.
-          auto sx1 = std::min<int32_t>(xPixelOffs + w + sdfSize, fontSize);
-          auto sy1 = std::min<int32_t>(yPixelOffs + h + sdfSize, fontSize);
-          w = sx1 - sx0;
-          h = sy1 - sy0;
-          if (!Representable<Px>(w))
-          {
-            XR_TRACE(Font, ("%s: glyph %u SDF has excessive width: %u; must fit on 16 bits.", rawNameExt, i0, w));
-            return false;
-          }
-
-          if (!Representable<Px>(h))
-          {
-            XR_TRACE(Font, ("%s: glyph %u SDF has excessive height: %u; must fit on 16 bits.", rawNameExt, i0, h));
-            return false;
-          }
-
-          bufferOffset = sx0 + sy0 * glyphWidthPadded;
-          sdf->Generate(glyphBitmapPadded + bufferOffset, Px(glyphWidthPadded),
-            Px(w), Px(h));
-          sdf->ConvertToBitmap(Px(w), Px(h), glyphBitmap.data());
-        }
-        else
-        {
-          // Blit the glyph at its absolute position (ascent applies).
-          stbtt_MakeGlyphBitmap(&stbFont, glyphBitmap.data(), w, h, w, pixelScale,
-            pixelScale, iGlyph);
+          success.store(false, std::memory_order_relaxed);
         }
+      }
+    });
 
-        glyph.fieldWidth = Px(w);
-        glyph.fieldHeight = Px(h);
+    if (!success)
+    {
+      return false;
+    }
 
+    for (size_t j = 0; j < batchSize; ++j)
+    {
+      auto& rasterized = batch[j];
+      auto& glyph = rasterized.glyph;
+      if (rasterized.hasBitmap)
+      {
         if (!Representable<uint32_t>(glyphBytesWritten))
         {
           LTRACE(("%s: number of bytes written exceeds 32 bits %llu.", rawNameExt, glyphBytesWritten));
@@ -621,25 +769,22 @@ XR_ASSET_BUILDER_BUILD_SIG(Font)
         }
         glyph.dataOffset = static_cast<uint32_t>(glyphBytesWritten);
 
-        auto p = glyphBitmap.data();
-#ifdef ENABLE_GLYPH_DEBUG
-        printf("%s%04x: ", sdf ? "SDF " : "", i0);
-        VisualizeBuffer(p, w, h, w);
-#endif
-
-        // write glyph bitmap data to other stream.
-        if (!WriteRangeBinaryStream<uint32_t>(p, p + (w * h), glyphBitmaps,
-          &glyphBytesWritten))
+        // write glyph bitmap data to other stream, as WriteRangeBinaryStream()
+        // would, in one go.
+        auto& bitmap = rasterized.bitmap;
+        if (!(WriteBinaryStream(static_cast<uint32_t>(bitmap.size()), glyphBitmaps) &&
+          glyphBitmaps.write(reinterpret_cast<char const*>(bitmap.data()), bitmap.size())))
         {
-          LTRACE(("%s: failed to write glyph bitmap data for 0x%x.", rawNameExt, i0));
+          LTRACE(("%s: failed to write glyph bitmap data for 0x%x.", rawNameExt, glyph.codePoint));
           return false;
         }
+        glyphBytesWritten += bitmap.size();
       }
 
       // write glyph.
       if(!WriteBinaryStream(glyph, data))
       {
-        LTRACE(("%s: failed to write glyph data for 0x%x.", rawNameExt, i0));
+        LTRACE(("%s: failed to write glyph data for 0x%x.", rawNameExt, glyph.codePoint));
         return false;
       }
     }
@@ -688,8 +833,10 @@ bool Font::OnLoaded(Buffer buffer)
   }
 
   Px maxHeight = 0;
+  uint32_t numDenseCodePoints = 0;
   Glyph g;
   uint32_t i = 0;
+  m_glyphs.reserve(numGlyphs);
   while (i < numGlyphs)
   {
     if (reader.Read(g))
@@ -699,7 +846,12 @@ bool Font::OnLoaded(Buffer buffer)
       {
         maxHeight = h;
       }
-      m_glyphs[g.codePoint] = g;
+
+      if (g.codePoint < kNumDenseCodePoints && g.codePoint >= numDenseCodePoints)
+      {
+        numDenseCodePoints = g.codePoint + 1;
+      }
+      m_glyphs.push_back(g);
       ++i;
     }
     else
@@ -709,6 +861,24 @@ bool Font::OnLoaded(Buffer buffer)
     }
   }
 
+  // Index glyphs by code point; ones that are defined more than once, are
+  // found by their last definition.
+  m_denseGlyphIndices.assign(numDenseCodePoints, kNoIndex);
+  m_sparseGlyphIndices.reserve(numGlyphs);
+  for (i = 0; i < numGlyphs; ++i)
+  {
+    auto codePoint = m_glyphs[i].codePoint;
+    if (codePoint < numDenseCodePoints)
+    {
+      m_denseGlyphIndices[codePoint] = i;
+    }
+    else
+    {
+      m_sparseGlyphIndices[codePoint] = i;
+    }
+  }
+  m_cachedGlyphIndices.assign(numGlyphs, kNoIndex);
+
   uint32_t glyphBitmapsSize;
   if(!reader.Read(glyphBitmapsSize))
   {
@@ -751,7 +921,7 @@ bool Font::OnLoaded(Buffer buffer)
     8, maxHeight);
   m_cachedGlyphs.reserve(128);
 
-  m_cacheDirty = true; // We do want a texture update even if no glyphs were cached.
+  m_uploadWholeCache = true; // We do want a texture even if no glyphs were cached.
 
   return true;
 }
@@ -759,13 +929,20 @@ bool Font::OnLoaded(Buffer buffer)
 //==============================================================================
 void Font::OnUnload()
 {
-  m_glyphs.clear();
+  std::vector<Glyph>().swap(m_glyphs);
+  std::vector<uint32_t>().swap(m_denseGlyphIndices);
+  m_sparseGlyphIndices = decltype(m_sparseGlyphIndices)();
+  std::vector<uint32_t>().swap(m_cachedGlyphIndices);
   std::vector<uint8_t>().swap(m_glyphBitmaps);
 
   std::vector<CachedGlyphInternal>().swap(m_cachedGlyphs);
+  m_mostRecentlyUsed = kNoIndex;
+  m_leastRecentlyUsed = kNoIndex;
+  m_firstFreeCachedGlyph = kNoIndex;
   delete m_textureCache;
   m_textureCache = nullptr;
-  m_cacheDirty = false;
+  m_uploadWholeCache = false;
+  ++m_cacheGeneration;
 
   m_texture.Reset(nullptr);
 }
@@ -785,32 +962,44 @@ Font::CachedGlyph const* Font::CacheGlyph(uint32_t codePoint)
 void Font::UpdateCache()
 {
   XR_ASSERT(Font, m_textureCache);
-  if (m_cacheDirty)
+  if (m_uploadWholeCache)
   {
     auto size = m_textureCache->GetSize();
     Buffer buffer = { size * m_textureCache->GetPitch(), m_textureCache->GetBuffer() };
     m_texture->Upload(Gfx::TextureFormat::R8, size, size, Gfx::F_TEXTURE_NONE,
       1, &buffer);
-    m_cacheDirty = false;
+    m_textureCache->ClearDirtyRegions();
+    m_uploadWholeCache = false;
+  }
+  else
+  {
+    m_textureCache->ConsumeDirtyRegions([this](Rect const& rect, Buffer const& buffer) {
+      m_texture->Update(rect.x, rect.y, rect.w, rect.h, buffer);
+    });
+  }
 
 #ifdef ENABLE_GLYPH_DEBUG
-    Image img;
-    img.SetPixelData(m_textureCache->GetBuffer(), m_textureCache->GetSize(),
-      m_textureCache->GetSize(), 1);
+  Image img;
+  img.SetPixelData(m_textureCache->GetBuffer(), m_textureCache->GetSize(),
+    m_textureCache->GetSize(), 1);
 
-    img.Save("font-cache.tga", true);
+  img.Save("font-cache.tga", true);
 #endif
-  }
 }
 
 //==============================================================================
 void Font::ClearCache()
 {
   m_cachedGlyphs.clear();
+  std::fill(m_cachedGlyphIndices.begin(), m_cachedGlyphIndices.end(), kNoIndex);
+  m_mostRecentlyUsed = kNoIndex;
+  m_leastRecentlyUsed = kNoIndex;
+  m_firstFreeCachedGlyph = kNoIndex;
   if(m_textureCache)
   {
     m_textureCache->Reset();
   }
+  ++m_cacheGeneration;
 }
 
 //==============================================================================
@@ -822,54 +1011,116 @@ Texture::Ptr Font::GetTexture() const
 //==============================================================================
 Font::CachedGlyphInternal* Font::CacheGlyphInternal(uint32_t codePoint)
 {
-  CachedGlyphInternal* result = nullptr;
-  auto iCached = std::lower_bound(m_cachedGlyphs.begin(), m_cachedGlyphs.end(),
-    codePoint, [](CachedGlyphInternal const& cg, uint32_t cp) {
-    return cg.glyph.glyph->codePoint < cp;
-  });
-  if (iCached == m_cachedGlyphs.end() || iCached->glyph.glyph->codePoint != codePoint) // not cached
-  {
-    auto iGlyph = m_glyphs.find(codePoint);
-    if (iGlyph != m_glyphs.end())
-    {
-      Glyph const& glyph = iGlyph->second;
-      CachedGlyphInternal cg = { nullptr, { &glyph, AABB() } };
-      if (glyph.fieldWidth > 0)
-      {
-        cg.buffer = m_textureCache->Allocate(glyph.fieldWidth, glyph.fieldHeight,
-          cg.glyph.uvs);
-        if (cg.buffer)
-        {
-          // copy the bitmap data to the texture
-          auto writep = cg.buffer;
-          auto readp = m_glyphBitmaps.data() + glyph.dataOffset;
-          auto readEnd = readp + glyph.fieldWidth * glyph.fieldHeight;
-          auto pitch = m_textureCache->GetPitch();
-          while (readp != readEnd)
-          {
-            memcpy(writep, readp, glyph.fieldWidth);
-            writep += pitch;
-            readp += glyph.fieldWidth;
-          }
-
-          m_cacheDirty = true;
-        }
-        else
-        {
-          LTRACE(("%s: Failed to allocate cache space for glyph 0x%x.",
-            m_debugPath.c_str(), codePoint));
-        }
-      }
+  auto iGlyph = FindGlyphIndex(codePoint);
+  if (iGlyph == kNoIndex)
+  {
+    return nullptr;
+  }
 
-      iCached = m_cachedGlyphs.insert(iCached, cg);
-      result = &*iCached;
+  auto& iCached = m_cachedGlyphIndices[iGlyph];
+  if (iCached != kNoIndex) // already cached
+  {
+    if (m_cachedGlyphs[iCached].buffer && iCached != m_mostRecentlyUsed)
+    {
+      Unlink(iCached);
+      LinkMostRecentlyUsed(iCached);
     }
+    return &m_cachedGlyphs[iCached];
+  }
+
+  Glyph const& glyph = m_glyphs[iGlyph];
+  CachedGlyphInternal cg = { nullptr, { &glyph, AABB() }, kNoIndex, kNoIndex };
+  if (glyph.fieldWidth > 0)
+  {
+    cg.buffer = m_textureCache->Allocate(glyph.fieldWidth, glyph.fieldHeight,
+      cg.glyph.uvs);
+    while (!cg.buffer && m_leastRecentlyUsed != kNoIndex)
+    {
+      EvictLeastRecentlyUsed();
+      cg.buffer = m_textureCache->Allocate(glyph.fieldWidth, glyph.fieldHeight,
+        cg.glyph.uvs);
+    }
+
+    if (!cg.buffer)
+    {
+      LTRACE(("%s: Failed to allocate cache space for glyph 0x%x.",
+        m_debugPath.c_str(), codePoint));
+      m_uncachedGlyph = { nullptr, { &glyph, AABB() }, kNoIndex, kNoIndex };
+      return &m_uncachedGlyph;
+    }
+
+    // copy the bitmap data to the texture
+    auto writep = cg.buffer;
+    auto readp = m_glyphBitmaps.data() + glyph.dataOffset;
+    auto readEnd = readp + glyph.fieldWidth * glyph.fieldHeight;
+    auto pitch = m_textureCache->GetPitch();
+    while (readp != readEnd)
+    {
+      memcpy(writep, readp, glyph.fieldWidth);
+      writep += pitch;
+      readp += glyph.fieldWidth;
+    }
+  }
+
+  if (m_firstFreeCachedGlyph != kNoIndex)
+  {
+    iCached = m_firstFreeCachedGlyph;
+    m_firstFreeCachedGlyph = m_cachedGlyphs[iCached].next;
+    m_cachedGlyphs[iCached] = cg;
+  }
+  else
+  {
+    iCached = static_cast<uint32_t>(m_cachedGlyphs.size());
+    m_cachedGlyphs.push_back(cg);
+  }
+
+  if (cg.buffer) // glyphs without bitmaps take no space and aren't evicted.
+  {
+    LinkMostRecentlyUsed(iCached);
+  }
+  return &m_cachedGlyphs[iCached];
+}
+
+//==============================================================================
+void Font::LinkMostRecentlyUsed(uint32_t index)
+{
+  auto& cg = m_cachedGlyphs[index];
+  cg.prev = kNoIndex;
+  cg.next = m_mostRecentlyUsed;
+  if (m_mostRecentlyUsed != kNoIndex)
+  {
+    m_cachedGlyphs[m_mostRecentlyUsed].prev = index;
   }
   else
   {
-    result = &*iCached;
+    m_leastRecentlyUsed = index;
   }
-  return result;
+  m_mostRecentlyUsed = index;
+}
+
+//==============================================================================
+void Font::Unlink(uint32_t index)
+{
+  auto& cg = m_cachedGlyphs[index];
+  (cg.prev != kNoIndex ? m_cachedGlyphs[cg.prev].next : m_mostRecentlyUsed) = cg.next;
+  (cg.next != kNoIndex ? m_cachedGlyphs[cg.next].prev : m_leastRecentlyUsed) = cg.prev;
+}
+
+//==============================================================================
+void Font::EvictLeastRecentlyUsed()
+{
+  XR_ASSERT(Font, m_leastRecentlyUsed != kNoIndex);
+  auto index = m_leastRecentlyUsed;
+  Unlink(index);
+
+  auto& cg = m_cachedGlyphs[index];
+  m_textureCache->Deallocate(cg.buffer);
+  m_cachedGlyphIndices[cg.glyph.glyph - m_glyphs.data()] = kNoIndex;
+
+  cg.buffer = nullptr;
+  cg.next = m_firstFreeCachedGlyph;
+  m_firstFreeCachedGlyph = index;
+  ++m_cacheGeneration;
 }
 
 } // xr
@@ -7,7 +7,7 @@
 //
 //==============================================================================
 #include "GfxResourceManager.hpp"
-#include "GfxCore.hpp"
+#include "GfxCoreGL.hpp"
 #include "GfxContext.hpp"
 #include "xrgl.hpp"
 #include "xr/math/Matrix.hpp"
@@ -611,7 +611,7 @@ void CreateDefaultTexture(TextureHandle const& handle, GLenum target)
 } // nonamespace
 
 //=============================================================================
-void Core::Init(Context* context, ResourceManager* resources)
+void GLCore::Init(Context* context, ResourceManager* resources)
 {
   LTRACE(("Initialising..."));
   sContext = new CoreContext;
@@ -686,12 +686,12 @@ void Core::Init(Context* context, ResourceManager* resources)
   LTRACE(("Initialisation complete."));
 }
 
-void Core::Release(VertexFormatHandle h)
+void GLCore::Release(VertexFormatHandle h)
 {
   sContext->mResources->Release(h);
 }
 
-void Core::CreateVertexBuffer(VertexFormatHandle hFormat, Buffer const& buffer,
+void GLCore::CreateVertexBuffer(VertexFormatHandle hFormat, Buffer const& buffer,
   FlagType flags, VertexBufferObject& vbo)
 {
   XR_ASSERT(Gfx, hFormat.IsValid());
@@ -703,7 +703,17 @@ void Core::CreateVertexBuffer(VertexFormatHandle hFormat, Buffer const& buffer,
   CreateVertexBufferInternal(hFormat, buffer, flags & ~F_BUFFER_INSTANCE_DATA, vbo);
 }
 
-void Core::Release(VertexBufferHandle h)
+void GLCore::UpdateVertexBuffer(VertexBufferHandle h, uint32_t offset,
+  Buffer const& buffer)
+{
+  auto& vbo = sContext->mResources->GetVbos()[h.id];
+  XR_ASSERT(Gfx, vbo.name != 0);
+  BindVertexBuffer(vbo);
+  XR_GL_CALL(glBufferSubData(vbo.target, offset, buffer.size, buffer.data));
+  XR_GL_CALL(glBindBuffer(vbo.target, 0));
+}
+
+void GLCore::Release(VertexBufferHandle h)
 {
   auto& vbos = sContext->mResources->GetVbos();
   VertexBufferObject& vbo = vbos[h.id];
@@ -720,7 +730,7 @@ void Core::Release(VertexBufferHandle h)
   vbos.server.Release(h.id);
 }
 
-void Core::CreateIndexBuffer(Buffer const& buffer, FlagType flags, IndexBufferObject& ibo)
+void GLCore::CreateIndexBuffer(Buffer const& buffer, FlagType flags, IndexBufferObject& ibo)
 {
   XR_GL_CALL(glGenBuffers(1, &ibo.name));
   BindIndexBuffer(ibo);
@@ -731,7 +741,7 @@ void Core::CreateIndexBuffer(Buffer const& buffer, FlagType flags, IndexBufferOb
   ibo.flags = flags;
 }
 
-void Core::Release(IndexBufferHandle h)
+void GLCore::Release(IndexBufferHandle h)
 {
   auto& ibos = sContext->mResources->GetIbos();
   IndexBufferObject& ibo = ibos[h.id];
@@ -743,7 +753,7 @@ void Core::Release(IndexBufferHandle h)
   ibos.server.Release(h.id);
 }
 
-void Core::CreateInstanceDataBuffer(Buffer const& buffer, InstanceDataStrideType stride,
+void GLCore::CreateInstanceDataBuffer(Buffer const& buffer, InstanceDataStrideType stride,
   VertexBufferObject& idbo)
 {
   XR_ASSERT(Gfx, buffer.data);
@@ -760,14 +770,14 @@ void Core::CreateInstanceDataBuffer(Buffer const& buffer, InstanceDataStrideType
   CreateVertexBufferInternal(VertexFormatHandle(), buffer, flags, idbo);
 }
 
-void Core::Release(InstanceDataBufferHandle h)
+void GLCore::Release(InstanceDataBufferHandle h)
 {
   VertexBufferHandle hConv;
   hConv.id = h.id;
-  Core::Release(hConv);
+  GLCore::Release(hConv);
 }
 
-void Core::CreateTexture(Buffer const* buffers, uint8_t numBuffers, TextureRef& tr)
+void GLCore::CreateTexture(Buffer const* buffers, uint8_t numBuffers, TextureRef& tr)
 {
   auto& t = tr.inst;
   XR_ASSERT(Gfx, numBuffers > 0);
@@ -872,7 +882,32 @@ void Core::CreateTexture(Buffer const* buffers, uint8_t numBuffers, TextureRef&
   }
 }
 
-void Core::Release(TextureHandle h)
+void GLCore::UpdateTexture(TextureHandle h, Px x, Px y, Px width, Px height,
+  Buffer const& buffer)
+{
+  auto& t = sContext->mResources->GetTextures()[h.id].inst;
+  XR_ASSERT(Gfx, t.target == GL_TEXTURE_2D);
+  auto& formatDesc = kTextureFormats[static_cast<int>(t.info.format)];
+  XR_ASSERTMSG(Gfx, !formatDesc.compressed, ("Can't update compressed texture."));
+  XR_ASSERT(Gfx, x + width <= t.info.width && y + height <= t.info.height);
+
+  BindTexture(t);
+
+  // Rows are tightly packed, which they may not be to the default 4 bytes.
+  XR_GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+  XR_GL_CALL(glTexSubImage2D(t.target, 0, x, y, width, height, formatDesc.format,
+    formatDesc.type, buffer.data));
+  XR_GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+
+  XR_ASSERT(Gfx, sContext->mActiveTextureStage < kMaxTextureStages);
+  auto hActiveTexture = sContext->mActiveTextures[sContext->mActiveTextureStage];
+  if (hActiveTexture.IsValid())
+  {
+    BindTexture(sContext->mResources->GetTextures()[hActiveTexture.id].inst);
+  }
+}
+
+void GLCore::Release(TextureHandle h)
 {
   auto& textures = sContext->mResources->GetTextures();
   TextureRef& texture = textures[h.id];
@@ -896,14 +931,14 @@ void Core::Release(TextureHandle h)
   }
 }
 
-bool Core::CreateFrameBuffer(TextureFormat format, Px width, Px height,
+bool GLCore::CreateFrameBuffer(TextureFormat format, Px width, Px height,
   FlagType flags, FrameBufferObject& fbo)
 {
   TextureHandle h = Gfx::CreateTexture(format, width, height, 0, flags);
-  return Core::CreateFrameBuffer(1, &h, true, fbo);
+  return GLCore::CreateFrameBuffer(1, &h, true, fbo);
 }
 
-bool Core::CreateFrameBuffer(uint8_t textureCount, TextureHandle const* hTextures,
+bool GLCore::CreateFrameBuffer(uint8_t textureCount, TextureHandle const* hTextures,
   bool ownTextures, FrameBufferObject& fbo)
 {
   std::vector<FrameBufferAttachment>  attachments(textureCount);
@@ -912,10 +947,10 @@ bool Core::CreateFrameBuffer(uint8_t textureCount, TextureHandle const* hTexture
     ++hTextures;
     return a;
   });
-  return Core::CreateFrameBuffer(textureCount, attachments.data(), ownTextures, fbo);
+  return GLCore::CreateFrameBuffer(textureCount, attachments.data(), ownTextures, fbo);
 }
 
-bool Core::CreateFrameBuffer(uint8_t textureCount, FrameBufferAttachment const* attachments,
+bool GLCore::CreateFrameBuffer(uint8_t textureCount, FrameBufferAttachment const* attachments,
   bool ownTextures, FrameBufferObject& fbo)
 {
   XR_ASSERT(Gfx, textureCount < XR_ARRAY_SIZE(FrameBufferObject::hTextures));
@@ -971,7 +1006,7 @@ bool Core::CreateFrameBuffer(uint8_t textureCount, FrameBufferAttachment const*
     {
       for (uint8_t i = 0; i < textureCount; ++i)
       {
-        Core::Release(attachments[i].hTexture);
+        GLCore::Release(attachments[i].hTexture);
       }
     }
   }
@@ -984,7 +1019,7 @@ bool Core::CreateFrameBuffer(uint8_t textureCount, FrameBufferAttachment const*
   return result;
 }
 
-void Core::Release(FrameBufferHandle h)
+void GLCore::Release(FrameBufferHandle h)
 {
   auto& fbos = sContext->mResources->GetFbos();
   FrameBufferObject& fbo = fbos[h.id];
@@ -992,7 +1027,7 @@ void Core::Release(FrameBufferHandle h)
 
   for (uint8_t i = 0; i < fbo.numTextures; ++i)
   {
-    Core::Release(fbo.hTextures[i]);
+    GLCore::Release(fbo.hTextures[i]);
   }
   fbo = FrameBufferObject();
 
@@ -1010,7 +1045,7 @@ void Core::Release(FrameBufferHandle h)
   }
 }
 
-bool Core::CreateShader(ShaderType type, Buffer const& buffer, ShaderRef& sr)
+bool GLCore::CreateShader(ShaderType type, Buffer const& buffer, ShaderRef& sr)
 {
   Shader& shader = sr.inst;
 
@@ -1065,7 +1100,7 @@ bool Core::CreateShader(ShaderType type, Buffer const& buffer, ShaderRef& sr)
   return success;
 }
 
-void Core::Release(ShaderHandle h)
+void GLCore::Release(ShaderHandle h)
 {
   auto& shaders = sContext->mResources->GetShaders();
   ShaderRef& sr = shaders[h.id];
@@ -1080,7 +1115,7 @@ void Core::Release(ShaderHandle h)
   }
 }
 
-bool Core::CreateProgram(ShaderHandle hVertex, ShaderHandle hFragment, Program& program)
+bool GLCore::CreateProgram(ShaderHandle hVertex, ShaderHandle hFragment, Program& program)
 {
   // Create program
   XR_GL_CALL(program.name = glCreateProgram());
@@ -1240,7 +1275,7 @@ bool Core::CreateProgram(ShaderHandle hVertex, ShaderHandle hFragment, Program&
   return success;
 }
 
-void Core::Release(ProgramHandle h)
+void GLCore::Release(ProgramHandle h)
 {
   auto& programs = sContext->mResources->GetPrograms();
   Program& p = programs[h.id];
@@ -1251,13 +1286,13 @@ void Core::Release(ProgramHandle h)
 
   if (p.hVertex.IsValid())
   {
-    Core::Release(p.hVertex);
+    GLCore::Release(p.hVertex);
     p.hVertex.Invalidate();
   }
 
   if (p.hFragment.IsValid())
   {
-    Core::Release(p.hFragment);
+    GLCore::Release(p.hFragment);
     p.hFragment.Invalidate();
   }
 
@@ -1275,7 +1310,7 @@ void Core::Release(ProgramHandle h)
   }
 }
 
-void Core::Clear(FlagType flags, Color const& color, float depth, uint8_t stencil)
+void GLCore::Clear(FlagType flags, Color const& color, float depth, uint8_t stencil)
 {
   GLbitfield flagls = 0;
   if (CheckAllMaskBits(flags, F_CLEAR_COLOR))
@@ -1312,12 +1347,12 @@ void Core::Clear(FlagType flags, Color const& color, float depth, uint8_t stenci
   }
 }
 
-void Core::SetViewport(Rect const& rect)
+void GLCore::SetViewport(Rect const& rect)
 {
   XR_GL_CALL(glViewport(rect.x, rect.y, rect.w, rect.h));
 }
 
-void Core::SetScissor(Rect const* rect)
+void GLCore::SetScissor(Rect const* rect)
 {
   bool state = rect != nullptr;
   gl::SwitchEnabledState(GL_SCISSOR_TEST, state);
@@ -1327,13 +1362,13 @@ void Core::SetScissor(Rect const* rect)
   }
 }
 
-void Core::SetUniform(UniformHandle h, Buffer const& buffer)
+void GLCore::SetUniform(UniformHandle h, Buffer const& buffer)
 {
   auto uniformData = sContext->mResources->GetUniformData();
   std::memcpy(uniformData[h.id], buffer.data, buffer.size);
 }
 
-void Core::SetTexture(TextureHandle h, uint8_t stage)
+void GLCore::SetTexture(TextureHandle h, uint8_t stage)
 {
   if (sContext->mActiveTextures[stage] != h)
   {
@@ -1347,7 +1382,7 @@ void Core::SetTexture(TextureHandle h, uint8_t stage)
   }
 }
 
-void Core::SetState(FlagType flags)
+void GLCore::SetState(FlagType flags)
 {
   const uint32_t deltaFlags = flags ^ sContext->mActiveState;
 
@@ -1447,7 +1482,7 @@ void Core::SetState(FlagType flags)
   sContext->mActiveState = flags;
 }
 
-void Core::SetStencilState(FlagType front, FlagType back)
+void GLCore::SetStencilState(FlagType front, FlagType back)
 {
   if (back == F_STENCIL_SAME)
   {
@@ -1500,7 +1535,7 @@ void Core::SetStencilState(FlagType front, FlagType back)
   }
 }
 
-void Core::SetInstanceData(InstanceDataBufferHandle h, uint32_t offset, uint32_t count)
+void GLCore::SetInstanceData(InstanceDataBufferHandle h, uint32_t offset, uint32_t count)
 {
   sContext->mActiveInstDataBuffer = h;
   if (h.IsValid())
@@ -1513,7 +1548,7 @@ void Core::SetInstanceData(InstanceDataBufferHandle h, uint32_t offset, uint32_t
   }
 }
 
-void Core::SetProgram(ProgramHandle h)
+void GLCore::SetProgram(ProgramHandle h)
 {
   if (sContext->mActiveProgram != h)
   {
@@ -1524,7 +1559,7 @@ void Core::SetProgram(ProgramHandle h)
   }
 }
 
-void Core::SetFrameBuffer(FrameBufferHandle h)
+void GLCore::SetFrameBuffer(FrameBufferHandle h)
 {
   if (sContext->mActiveFrameBuffer != h)
   {
@@ -1535,7 +1570,7 @@ void Core::SetFrameBuffer(FrameBufferHandle h)
   }
 }
 
-void Core::Draw(VertexBufferHandle vbh, Primitive pt, uint32_t offset, uint32_t count)
+void GLCore::Draw(VertexBufferHandle vbh, Primitive pt, uint32_t offset, uint32_t count)
 {
   XR_ASSERT(Gfx, sContext->mActiveProgram.IsValid());
   auto& programs = sContext->mResources->GetPrograms();
@@ -1564,7 +1599,7 @@ void Core::Draw(VertexBufferHandle vbh, Primitive pt, uint32_t offset, uint32_t
     instCount));
 }
 
-void Core::Draw(VertexBufferHandle vbh, IndexBufferHandle ibh, Primitive pt,
+void GLCore::Draw(VertexBufferHandle vbh, IndexBufferHandle ibh, Primitive pt,
   uint32_t offset, uint32_t count)
 {
   XR_ASSERT(Gfx, sContext->mActiveProgram.id != ProgramHandle::INVALID_ID);
@@ -1601,18 +1636,18 @@ void Core::Draw(VertexBufferHandle vbh, IndexBufferHandle ibh, Primitive pt,
     UINT_PTR_CAST(offset * ibo.indexSize), instCount));
 }
 
-void Core::Flush()
+void GLCore::Flush()
 {
   XR_GL_CALL(glFlush());
 }
 
-void Core::Present(bool /*resetState*/)
+void GLCore::Present(bool /*resetState*/)
 {
   Flush();
   sContext->mContext->Swap();
 }
 
-void  Core::ReadFrameBuffer(Px x, Px y, Px width,
+void  GLCore::ReadFrameBuffer(Px x, Px y, Px width,
   Px height, TextureFormat format, uint8_t colorAttachment, void* mem,
   ReadFrameBufferCompleteCallback* onComplete)
 {
@@ -1634,27 +1669,27 @@ void  Core::ReadFrameBuffer(Px x, Px y, Px width,
   }
 }
 
-Signal<void>& Core::FlushSignal()
+Signal<void>& GLCore::FlushSignal()
 {
   return sContext->mOnFlush;
 }
 
-void Core::OnFlush()
+void GLCore::OnFlush()
 {
   sContext->mOnFlush.Broadcast();
 }
 
-Signal<void>& Core::ShutdownSignal()
+Signal<void>& GLCore::ShutdownSignal()
 {
   return sContext->mOnShutdown;
 }
 
-void Core::OnShutdown()
+void GLCore::OnShutdown()
 {
   sContext->mOnShutdown.Broadcast();
 }
 
-void Core::Shutdown()
+void GLCore::Shutdown()
 {
   LTRACE(("Shutting down."));
   if (sContext->mVao != 0)
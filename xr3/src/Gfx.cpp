@@ -10,10 +10,12 @@
 #include "GfxM.hpp"
 #include "GfxS.hpp"
 #include "GfxResourceManager.hpp"
+#include "GfxNullCore.hpp"
 #include "xr/Config.hpp"
 #include "xr/memory/memory.hpp"
 #include "xr/utility/Hash.hpp"
 #include "xr/debug.hpp"
+#include <algorithm>
 #include <cinttypes>
 
 namespace xr
@@ -23,14 +25,20 @@ namespace Gfx
 namespace
 {
 const uint32_t kDefaultMessageBufferSize = XR_KBYTES(64);
+const int32_t kDefaultFramesInFlight = 1;
 
 Context* sContext = nullptr;
 ResourceManager* sResources = nullptr;
 
+bool sHeadless = false;
+Px sHeadlessWidth = 0;  // if there's no context.
+Px sHeadlessHeight = 0;
+
 VertexFormatHandle(*sRegisterVertexFormat)(VertexFormat const&) = nullptr;
 void(*sReleaseVertexFormat)(VertexFormatHandle h) = nullptr;
 
 VertexBufferHandle(*sCreateVertexBuffer)(VertexFormatHandle hFormat, Buffer const& buffer, FlagType flags) = nullptr;
+void(*sUpdateVertexBuffer)(VertexBufferHandle h, uint32_t offset, Buffer const& buffer) = nullptr;
 void(*sReleaseVertexBuffer)(VertexBufferHandle h) = nullptr;
 
 IndexBufferHandle(*sCreateIndexBuffer)(Buffer const& buffer, FlagType flags) = nullptr;
@@ -41,6 +49,8 @@ void(*sReleaseInstanceDataBuffer)(InstanceDataBufferHandle h) = nullptr;
 
 TextureHandle(*sCreateTexture)(TextureFormat format, Px width, Px height,
   Px depth, FlagType flags, Buffer const* buffer, uint8_t numBuffers) = nullptr;
+void(*sUpdateTexture)(TextureHandle h, Px x, Px y, Px width, Px height,
+  Buffer const& buffer) = nullptr;
 
 TextureInfo(*sGetTextureInfo)(TextureHandle h) = nullptr;
 void(*sReleaseTexture)(TextureHandle h) = nullptr;
@@ -72,6 +82,7 @@ void(*sSetStencilState)(FlagType front, FlagType back) = nullptr;
 void(*sSetInstanceData)(InstanceDataBufferHandle h, uint32_t offset, uint32_t count) = nullptr;
 void(*sSetProgram)(ProgramHandle h) = nullptr;
 void(*sSetFrameBuffer)(FrameBufferHandle h) = nullptr;
+void(*sSetSortDepth)(uint16_t depth) = nullptr;
 
 void(*sDraw)(VertexBufferHandle vbh, Primitive pt, uint32_t offset, uint32_t count) = nullptr;
 void(*sDrawIndexed)(VertexBufferHandle vbh, IndexBufferHandle ibh, Primitive pt, uint32_t offset, uint32_t count) = nullptr;
@@ -82,6 +93,12 @@ void(*sReadFrameBuffer)(Px x, Px y, Px width, Px height,
   TextureFormat format, uint8_t colorAttachment, void* mem,
   ReadFrameBufferCompleteCallback* onComplete) = nullptr;
 
+CommandListHandle(*sReserveCommandList)() = nullptr;
+void(*sBeginCommandList)(CommandListHandle h) = nullptr;
+void(*sEndCommandList)() = nullptr;
+
+FrameStats(*sGetFrameStats)() = nullptr;
+
 Signal<void>&(*sFlushSignal)() = nullptr;
 Signal<void>&(*sShutdownSignal)() = nullptr;
 
@@ -105,10 +122,19 @@ uint8_t TextureInfo::CalculateMipLevels(Px width, Px height, FlagType flags)
 //==============================================================================
 void  Init(Context* ctx)
 {
-  XR_ASSERTMSG(Gfx, !sContext, ("Already initialised."));
-  XR_ASSERTMSG(Gfx, ctx, ("Can't initialise with empty context."));
+  XR_ASSERTMSG(Gfx, !sResources, ("Already initialised."));
+  sHeadless = Config::GetInt("XR_GFX_HEADLESS", 0) == 1;
+  XR_ASSERTMSG(Gfx, ctx || sHeadless, ("Can't initialise with empty context."));
   sContext = ctx;
 
+  if (sHeadless)
+  {
+    sHeadlessWidth = Config::GetInt("XR_DISPLAY_WIDTH", 800);
+    sHeadlessHeight = Config::GetInt("XR_DISPLAY_HEIGHT", 600);
+    XR_TRACE(Gfx, ("Headless mode."));
+  }
+  Core::Select(sHeadless ? CoreType::Null : CoreType::Native);
+
   auto resources = new ResourceManager();
   sResources = resources;
 
@@ -116,10 +142,16 @@ void  Init(Context* ctx)
   {
     uint32_t commandBufferSize = Config::GetInt("XR_GFX_COMMAND_BUFFER_SIZE",
       kDefaultMessageBufferSize);
-    XR_TRACE(Gfx, ("Multithreaded mode; command buffer size: %" PRIu32 " bytes.",
-      commandBufferSize));
+    uint32_t numFramesInFlight = std::max(Config::GetInt("XR_GFX_FRAMES_IN_FLIGHT",
+      kDefaultFramesInFlight), int32_t(1));
+    XR_TRACE(Gfx, ("Multithreaded mode; command buffer size: %" PRIu32
+      " bytes, %" PRIu32 " frame(s) in flight.", commandBufferSize,
+      numFramesInFlight));
+
+    const bool sortDraws = Config::GetInt("XR_GFX_SORT_DRAWS", 0) == 1;
+    XR_TRACEIF(Gfx, sortDraws, ("Sorting draws."));
 
-    M::Init(ctx, resources, commandBufferSize);
+    M::Init(ctx, resources, commandBufferSize, numFramesInFlight + 1, sortDraws);
 
 #define M_API(x) s##x = M::x
 #define M_APIS(x, suffix) s##x##suffix = M::x
@@ -127,6 +159,7 @@ void  Init(Context* ctx)
     M_APIS(Release, VertexFormat);
 
     M_API(CreateVertexBuffer);
+    M_API(UpdateVertexBuffer);
     M_APIS(Release, VertexBuffer);
 
     M_API(CreateIndexBuffer);
@@ -136,6 +169,7 @@ void  Init(Context* ctx)
     M_APIS(Release, InstanceDataBuffer);
 
     M_API(CreateTexture);
+    M_API(UpdateTexture);
     M_API(GetTextureInfo);
     M_APIS(Release, Texture);
 
@@ -163,6 +197,7 @@ void  Init(Context* ctx)
     M_API(SetInstanceData);
     M_API(SetProgram);
     M_API(SetFrameBuffer);
+    M_API(SetSortDepth);
 
     M_API(Draw);
     M_APIS(Draw, Indexed);
@@ -171,6 +206,12 @@ void  Init(Context* ctx)
 
     M_API(ReadFrameBuffer);
 
+    M_API(ReserveCommandList);
+    M_API(BeginCommandList);
+    M_API(EndCommandList);
+
+    M_API(GetFrameStats);
+
     M_API(FlushSignal);
     M_API(ShutdownSignal);
 
@@ -188,6 +229,7 @@ void  Init(Context* ctx)
     S_APIS(Release, VertexFormat);
 
     S_API(CreateVertexBuffer);
+    S_API(UpdateVertexBuffer);
     S_APIS(Release, VertexBuffer);
 
     S_API(CreateIndexBuffer);
@@ -197,6 +239,7 @@ void  Init(Context* ctx)
     S_APIS(Release, InstanceDataBuffer);
 
     S_API(CreateTexture);
+    S_API(UpdateTexture);
     S_API(GetTextureInfo);
     S_APIS(Release, Texture);
 
@@ -224,6 +267,7 @@ void  Init(Context* ctx)
     S_API(SetInstanceData);
     S_API(SetProgram);
     S_API(SetFrameBuffer);
+    sSetSortDepth = [](uint16_t) {};
 
     S_API(Draw);
     S_APIS(Draw, Indexed);
@@ -232,6 +276,14 @@ void  Init(Context* ctx)
 
     S_API(ReadFrameBuffer);
 
+    sReserveCommandList = []() { return CommandListHandle(); };
+    sBeginCommandList = [](CommandListHandle) {
+      XR_ERROR(("Command lists are only supported in multithreaded mode."));
+    };
+    sEndCommandList = []() {};
+
+    S_API(GetFrameStats);
+
     S_API(FlushSignal);
     S_API(ShutdownSignal);
 
@@ -244,13 +296,13 @@ void  Init(Context* ctx)
 //=============================================================================
 Px GetLogicalWidth()
 {
-  return sContext->GetLogicalWidth();
+  return sContext ? sContext->GetLogicalWidth() : sHeadlessWidth;
 }
 
 //=============================================================================
 Px GetLogicalHeight()
 {
-  return sContext->GetLogicalHeight();
+  return sContext ? sContext->GetLogicalHeight() : sHeadlessHeight;
 }
 
 //=============================================================================
@@ -262,13 +314,13 @@ float GetLogicalAspectRatio()
 //=============================================================================
 Px GetPhysicalWidth()
 {
-  return sContext->GetPhysicalWidth();
+  return sContext ? sContext->GetPhysicalWidth() : sHeadlessWidth;
 }
 
 //=============================================================================
 Px GetPhysicalHeight()
 {
-  return sContext->GetPhysicalHeight();
+  return sContext ? sContext->GetPhysicalHeight() : sHeadlessHeight;
 }
 
 //=============================================================================
@@ -322,6 +374,13 @@ VertexBufferHandle CreateVertexBuffer(VertexFormatHandle hFormat, Buffer const&
   return sCreateVertexBuffer(hFormat, buffer, flags);
 }
 
+//==============================================================================
+void UpdateVertexBuffer(VertexBufferHandle h, uint32_t offset, Buffer const& buffer)
+{
+  XR_ASSERT(Gfx, h.IsValid());
+  sUpdateVertexBuffer(h, offset, buffer);
+}
+
 //==============================================================================
 void Release(VertexBufferHandle h)
 {
@@ -376,6 +435,14 @@ TextureHandle CreateTexture(TextureFormat format, Px width, Px height,
   return sCreateTexture(format, width, height, depth, flags, &buffer, 1);
 }
 
+//==============================================================================
+void UpdateTexture(TextureHandle h, Px x, Px y, Px width, Px height,
+  Buffer const& buffer)
+{
+  XR_ASSERT(Gfx, h.IsValid());
+  sUpdateTexture(h, x, y, width, height, buffer);
+}
+
 //==============================================================================
 TextureInfo GetTextureInfo(TextureHandle h)
 {
@@ -543,6 +610,12 @@ void SetFrameBuffer(FrameBufferHandle h)
   sSetFrameBuffer(h);
 }
 
+//==============================================================================
+void SetSortDepth(uint16_t depth)
+{
+  sSetSortDepth(depth);
+}
+
 //==============================================================================
 void Draw(VertexBufferHandle vbh, Primitive pt, uint32_t offset, uint32_t count)
 {
@@ -592,6 +665,46 @@ void ReadFrameBuffer(Px x, Px y, Px width, Px height,
   sReadFrameBuffer(x, y, width, height, format, colorAttachment, mem, onComplete);
 }
 
+//==============================================================================
+CommandListHandle ReserveCommandList()
+{
+  return sReserveCommandList();
+}
+
+//==============================================================================
+void BeginCommandList(CommandListHandle h)
+{
+  sBeginCommandList(h);
+}
+
+//==============================================================================
+void EndCommandList()
+{
+  sEndCommandList();
+}
+
+//==============================================================================
+void StartRecording()
+{
+  XR_ASSERTMSG(Gfx, sHeadless, ("Recording is only supported in headless mode."));
+  if (sHeadless)
+  {
+    NullCore::StartRecording();
+  }
+}
+
+//==============================================================================
+std::vector<CommandRecord> StopRecording()
+{
+  return sHeadless ? NullCore::StopRecording() : std::vector<CommandRecord>();
+}
+
+//==============================================================================
+FrameStats GetFrameStats()
+{
+  return sGetFrameStats();
+}
+
 //==============================================================================
 Signal<void>& FlushSignal()
 {
@@ -607,7 +720,7 @@ Signal<void>& ShutdownSignal()
 //==============================================================================
 void Shutdown()
 {
-  XR_ASSERTMSG(Gfx, sContext, ("Shutdown failed: not initialised."));
+  XR_ASSERTMSG(Gfx, sResources, ("Shutdown failed: not initialised."));
   sContext = nullptr;
 
   (*sShutdown)();
@@ -620,6 +733,7 @@ void Shutdown()
   API_SHUTDOWN(ReleaseVertexFormat);
 
   API_SHUTDOWN(CreateVertexBuffer);
+  API_SHUTDOWN(UpdateVertexBuffer);
   API_SHUTDOWN(ReleaseVertexBuffer);
 
   API_SHUTDOWN(CreateIndexBuffer);
@@ -629,6 +743,7 @@ void Shutdown()
   API_SHUTDOWN(ReleaseInstanceDataBuffer);
 
   API_SHUTDOWN(CreateTexture);
+  API_SHUTDOWN(UpdateTexture);
   API_SHUTDOWN(GetTextureInfo);
   API_SHUTDOWN(ReleaseTexture);
 
@@ -657,12 +772,18 @@ void Shutdown()
   API_SHUTDOWN(SetInstanceData);
   API_SHUTDOWN(SetProgram);
   API_SHUTDOWN(SetFrameBuffer);
+  API_SHUTDOWN(SetSortDepth);
 
   API_SHUTDOWN(Draw);
   API_SHUTDOWN(DrawIndexed);
   API_SHUTDOWN(Flush);
   API_SHUTDOWN(Present);
 
+  API_SHUTDOWN(ReserveCommandList);
+  API_SHUTDOWN(BeginCommandList);
+  API_SHUTDOWN(EndCommandList);
+  API_SHUTDOWN(GetFrameStats);
+
   API_SHUTDOWN(FlushSignal);
   API_SHUTDOWN(ShutdownSignal);
 
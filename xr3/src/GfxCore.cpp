@@ -0,0 +1,370 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "GfxCore.hpp"
+#include "GfxNullCore.hpp"
+#include "GL/GfxCoreGL.hpp"
+
+namespace xr
+{
+namespace Gfx
+{
+namespace
+{
+
+void(*sInit)(Context* context, ResourceManager* resources) = nullptr;
+void(*sReleaseVertexFormat)(VertexFormatHandle h) = nullptr;
+void(*sCreateVertexBuffer)(VertexFormatHandle hFormat, Buffer const& buffer, FlagType flags, VertexBufferObject& vbo) = nullptr;
+void(*sUpdateVertexBuffer)(VertexBufferHandle h, uint32_t offset, Buffer const& buffer) = nullptr;
+void(*sReleaseVertexBuffer)(VertexBufferHandle h) = nullptr;
+void(*sCreateIndexBuffer)(Buffer const& buffer, FlagType flags, IndexBufferObject& ibo) = nullptr;
+void(*sReleaseIndexBuffer)(IndexBufferHandle h) = nullptr;
+void(*sCreateInstanceDataBuffer)(Buffer const& buffer, InstanceDataStrideType stride, VertexBufferObject& idbo) = nullptr;
+void(*sReleaseInstanceDataBuffer)(InstanceDataBufferHandle h) = nullptr;
+void(*sCreateTexture)(Buffer const* buffers, uint8_t numBuffers, TextureRef& texture) = nullptr;
+void(*sUpdateTexture)(TextureHandle h, Px x, Px y, Px width, Px height, Buffer const& buffer) = nullptr;
+void(*sReleaseTexture)(TextureHandle h) = nullptr;
+bool(*sCreateFrameBufferWithPrivateTexture)(TextureFormat format, Px width, Px height, FlagType flags, FrameBufferObject& fbo) = nullptr;
+bool(*sCreateFrameBufferWithTextures)(uint8_t textureCount, TextureHandle const* hTextures, bool ownTextures, FrameBufferObject& fbo) = nullptr;
+bool(*sCreateFrameBufferWithAttachments)(uint8_t textureCount, FrameBufferAttachment const* attachments, bool ownTextures, FrameBufferObject& fbo) = nullptr;
+void(*sReleaseFrameBuffer)(FrameBufferHandle h) = nullptr;
+bool(*sCreateShader)(ShaderType type, Buffer const& buffer, ShaderRef& shader) = nullptr;
+void(*sReleaseShader)(ShaderHandle h) = nullptr;
+bool(*sCreateProgram)(ShaderHandle hVertex, ShaderHandle hFragment, Program& program) = nullptr;
+void(*sReleaseProgram)(ProgramHandle h) = nullptr;
+void(*sClear)(FlagType flags, Color const& color, float depth, uint8_t stencil) = nullptr;
+void(*sSetViewport)(Rect const& rect) = nullptr;
+void(*sSetScissor)(Rect const* rect) = nullptr;
+void(*sSetUniform)(UniformHandle h, Buffer const& buffer) = nullptr;
+void(*sSetTexture)(TextureHandle h, uint8_t stage) = nullptr;
+void(*sSetState)(FlagType flags) = nullptr;
+void(*sSetStencilState)(FlagType front, FlagType back) = nullptr;
+void(*sSetInstanceData)(InstanceDataBufferHandle h, uint32_t offset, uint32_t count) = nullptr;
+void(*sSetProgram)(ProgramHandle h) = nullptr;
+void(*sSetFrameBuffer)(FrameBufferHandle h) = nullptr;
+void(*sDraw)(VertexBufferHandle vbh, Primitive pt, uint32_t offset, uint32_t count) = nullptr;
+void(*sDrawIndexed)(VertexBufferHandle vbh, IndexBufferHandle ibh, Primitive pt, uint32_t offset, uint32_t count) = nullptr;
+void(*sFlush)() = nullptr;
+void(*sPresent)(bool resetState) = nullptr;
+void(*sReadFrameBuffer)(Px x, Px y, Px width, Px height, TextureFormat format, uint8_t colorAttachment, void* mem, ReadFrameBufferCompleteCallback* onComplete) = nullptr;
+Signal<void>&(*sFlushSignal)() = nullptr;
+void(*sOnFlush)() = nullptr;
+Signal<void>&(*sShutdownSignal)() = nullptr;
+void(*sOnShutdown)() = nullptr;
+void(*sShutdown)() = nullptr;
+
+template <class Impl>
+void SelectImpl()
+{
+#define CORE_API(x) s##x = Impl::x
+#define CORE_APIS(x, suffix) s##x##suffix = Impl::x
+  CORE_API(Init);
+  CORE_APIS(Release, VertexFormat);
+  CORE_API(CreateVertexBuffer);
+  CORE_API(UpdateVertexBuffer);
+  CORE_APIS(Release, VertexBuffer);
+  CORE_API(CreateIndexBuffer);
+  CORE_APIS(Release, IndexBuffer);
+  CORE_API(CreateInstanceDataBuffer);
+  CORE_APIS(Release, InstanceDataBuffer);
+  CORE_API(CreateTexture);
+  CORE_API(UpdateTexture);
+  CORE_APIS(Release, Texture);
+  CORE_APIS(CreateFrameBuffer, WithPrivateTexture);
+  CORE_APIS(CreateFrameBuffer, WithTextures);
+  CORE_APIS(CreateFrameBuffer, WithAttachments);
+  CORE_APIS(Release, FrameBuffer);
+  CORE_API(CreateShader);
+  CORE_APIS(Release, Shader);
+  CORE_API(CreateProgram);
+  CORE_APIS(Release, Program);
+  CORE_API(Clear);
+  CORE_API(SetViewport);
+  CORE_API(SetScissor);
+  CORE_API(SetUniform);
+  CORE_API(SetTexture);
+  CORE_API(SetState);
+  CORE_API(SetStencilState);
+  CORE_API(SetInstanceData);
+  CORE_API(SetProgram);
+  CORE_API(SetFrameBuffer);
+  CORE_API(Draw);
+  CORE_APIS(Draw, Indexed);
+  CORE_API(Flush);
+  CORE_API(Present);
+  CORE_API(ReadFrameBuffer);
+  CORE_API(FlushSignal);
+  CORE_API(OnFlush);
+  CORE_API(ShutdownSignal);
+  CORE_API(OnShutdown);
+  CORE_API(Shutdown);
+#undef CORE_API
+#undef CORE_APIS
+}
+
+} // nonamespace
+
+//==============================================================================
+void Core::Select(CoreType type)
+{
+  switch (type)
+  {
+  case CoreType::Native:
+    SelectImpl<GLCore>();
+    break;
+
+  case CoreType::Null:
+    SelectImpl<NullCore>();
+    break;
+  }
+}
+
+//==============================================================================
+void Core::Init(Context* context, ResourceManager* resources)
+{
+  sInit(context, resources);
+}
+
+//==============================================================================
+void Core::Release(VertexFormatHandle h)
+{
+  sReleaseVertexFormat(h);
+}
+
+//==============================================================================
+void Core::CreateVertexBuffer(VertexFormatHandle hFormat, Buffer const& buffer, FlagType flags, VertexBufferObject& vbo)
+{
+  sCreateVertexBuffer(hFormat, buffer, flags, vbo);
+}
+
+//==============================================================================
+void Core::UpdateVertexBuffer(VertexBufferHandle h, uint32_t offset,
+  Buffer const& buffer)
+{
+  sUpdateVertexBuffer(h, offset, buffer);
+}
+
+//==============================================================================
+void Core::Release(VertexBufferHandle h)
+{
+  sReleaseVertexBuffer(h);
+}
+
+//==============================================================================
+void Core::CreateIndexBuffer(Buffer const& buffer, FlagType flags, IndexBufferObject& ibo)
+{
+  sCreateIndexBuffer(buffer, flags, ibo);
+}
+
+//==============================================================================
+void Core::Release(IndexBufferHandle h)
+{
+  sReleaseIndexBuffer(h);
+}
+
+//==============================================================================
+void Core::CreateInstanceDataBuffer(Buffer const& buffer, InstanceDataStrideType stride, VertexBufferObject& idbo)
+{
+  sCreateInstanceDataBuffer(buffer, stride, idbo);
+}
+
+//==============================================================================
+void Core::Release(InstanceDataBufferHandle h)
+{
+  sReleaseInstanceDataBuffer(h);
+}
+
+//==============================================================================
+void Core::CreateTexture(Buffer const* buffers, uint8_t numBuffers, TextureRef& texture)
+{
+  sCreateTexture(buffers, numBuffers, texture);
+}
+
+//==============================================================================
+void Core::UpdateTexture(TextureHandle h, Px x, Px y, Px width, Px height,
+  Buffer const& buffer)
+{
+  sUpdateTexture(h, x, y, width, height, buffer);
+}
+
+//==============================================================================
+void Core::Release(TextureHandle h)
+{
+  sReleaseTexture(h);
+}
+
+//==============================================================================
+bool Core::CreateFrameBuffer(TextureFormat format, Px width, Px height, FlagType flags, FrameBufferObject& fbo)
+{
+  return sCreateFrameBufferWithPrivateTexture(format, width, height, flags, fbo);
+}
+
+//==============================================================================
+bool Core::CreateFrameBuffer(uint8_t textureCount, TextureHandle const* hTextures, bool ownTextures, FrameBufferObject& fbo)
+{
+  return sCreateFrameBufferWithTextures(textureCount, hTextures, ownTextures, fbo);
+}
+
+//==============================================================================
+bool Core::CreateFrameBuffer(uint8_t textureCount, FrameBufferAttachment const* attachments, bool ownTextures, FrameBufferObject& fbo)
+{
+  return sCreateFrameBufferWithAttachments(textureCount, attachments, ownTextures, fbo);
+}
+
+//==============================================================================
+void Core::Release(FrameBufferHandle h)
+{
+  sReleaseFrameBuffer(h);
+}
+
+//==============================================================================
+bool Core::CreateShader(ShaderType type, Buffer const& buffer, ShaderRef& shader)
+{
+  return sCreateShader(type, buffer, shader);
+}
+
+//==============================================================================
+void Core::Release(ShaderHandle h)
+{
+  sReleaseShader(h);
+}
+
+//==============================================================================
+bool Core::CreateProgram(ShaderHandle hVertex, ShaderHandle hFragment, Program& program)
+{
+  return sCreateProgram(hVertex, hFragment, program);
+}
+
+//==============================================================================
+void Core::Release(ProgramHandle h)
+{
+  sReleaseProgram(h);
+}
+
+//==============================================================================
+void Core::Clear(FlagType flags, Color const& color, float depth, uint8_t stencil)
+{
+  sClear(flags, color, depth, stencil);
+}
+
+//==============================================================================
+void Core::SetViewport(Rect const& rect)
+{
+  sSetViewport(rect);
+}
+
+//==============================================================================
+void Core::SetScissor(Rect const* rect)
+{
+  sSetScissor(rect);
+}
+
+//==============================================================================
+void Core::SetUniform(UniformHandle h, Buffer const& buffer)
+{
+  sSetUniform(h, buffer);
+}
+
+//==============================================================================
+void Core::SetTexture(TextureHandle h, uint8_t stage)
+{
+  sSetTexture(h, stage);
+}
+
+//==============================================================================
+void Core::SetState(FlagType flags)
+{
+  sSetState(flags);
+}
+
+//==============================================================================
+void Core::SetStencilState(FlagType front, FlagType back)
+{
+  sSetStencilState(front, back);
+}
+
+//==============================================================================
+void Core::SetInstanceData(InstanceDataBufferHandle h, uint32_t offset, uint32_t count)
+{
+  sSetInstanceData(h, offset, count);
+}
+
+//==============================================================================
+void Core::SetProgram(ProgramHandle h)
+{
+  sSetProgram(h);
+}
+
+//==============================================================================
+void Core::SetFrameBuffer(FrameBufferHandle h)
+{
+  sSetFrameBuffer(h);
+}
+
+//==============================================================================
+void Core::Draw(VertexBufferHandle vbh, Primitive pt, uint32_t offset, uint32_t count)
+{
+  sDraw(vbh, pt, offset, count);
+}
+
+//==============================================================================
+void Core::Draw(VertexBufferHandle vbh, IndexBufferHandle ibh, Primitive pt, uint32_t offset, uint32_t count)
+{
+  sDrawIndexed(vbh, ibh, pt, offset, count);
+}
+
+//==============================================================================
+void Core::Flush()
+{
+  sFlush();
+}
+
+//==============================================================================
+void Core::Present(bool resetState)
+{
+  sPresent(resetState);
+}
+
+//==============================================================================
+void Core::ReadFrameBuffer(Px x, Px y, Px width, Px height, TextureFormat format, uint8_t colorAttachment, void* mem, ReadFrameBufferCompleteCallback* onComplete)
+{
+  sReadFrameBuffer(x, y, width, height, format, colorAttachment, mem, onComplete);
+}
+
+//==============================================================================
+Signal<void>& Core::FlushSignal()
+{
+  return sFlushSignal();
+}
+
+//==============================================================================
+void Core::OnFlush()
+{
+  sOnFlush();
+}
+
+//==============================================================================
+Signal<void>& Core::ShutdownSignal()
+{
+  return sShutdownSignal();
+}
+
+//==============================================================================
+void Core::OnShutdown()
+{
+  sOnShutdown();
+}
+
+//==============================================================================
+void Core::Shutdown()
+{
+  sShutdown();
+}
+
+} // Gfx
+}
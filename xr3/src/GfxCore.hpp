@@ -20,17 +20,34 @@ namespace Gfx
 
 class ResourceManager;
 
+//==============================================================================
+///@brief The implementations of the Core API.
+enum class CoreType
+{
+  Native, // GLCore
+  Null, // NullCore
+};
+
+//==============================================================================
+///@brief Low level rendering API, which GfxS and GfxM are built on. Forwards
+/// to the implementation that was Select()ed.
 class Core
 {
   XR_NONOBJECT_DECL(Core)
 
 public:
+  ///@brief Sets the implementation that the rest of the functions forward to.
+  /// Must be called before Init().
+  static void Select(CoreType type);
+
   static void Init(Context* context, ResourceManager* resources);
 
   static void Release(VertexFormatHandle h);
 
   static void CreateVertexBuffer(VertexFormatHandle hFormat, Buffer const& buffer,
     FlagType flags, VertexBufferObject& vbo);
+  static void UpdateVertexBuffer(VertexBufferHandle h, uint32_t offset,
+    Buffer const& buffer);
   static void Release(VertexBufferHandle h);
 
   static void CreateIndexBuffer(Buffer const& buffer, FlagType flags,
@@ -42,6 +59,8 @@ public:
   static void Release(InstanceDataBufferHandle h);
 
   static void CreateTexture(Buffer const* buffers, uint8_t numBuffers, TextureRef& texture);
+  static void UpdateTexture(TextureHandle h, Px x, Px y, Px width, Px height,
+    Buffer const& buffer);
   static void Release(TextureHandle h);
 
   static bool CreateFrameBuffer(TextureFormat format, Px width, Px height,
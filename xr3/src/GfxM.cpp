@@ -11,10 +11,14 @@
 #include "SyncJob.hpp"
 #include "xr/threading/Worker.hpp"
 #include "xr/threading/Spinlock.hpp"
-#include "xr/memory/Pool.hpp"
 #include "xr/memory/BufferReader.hpp"
 #include "xr/events/SignalBroadcaster.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cinttypes>
+#include <thread>
+#include <vector>
 
 namespace xr
 {
@@ -57,9 +61,11 @@ using BufferGuard = Guard<uint8_t const*>;
 //==============================================================================
 enum class Command: uint8_t
 {
+  // Resource commands; these must all precede Clear.
   ReleaseVertexFormat,
 
   CreateVertexBuffer,
+  UpdateVertexBuffer,
   ReleaseVertexBuffer,
 
   CreateIndexBuffer,
@@ -69,6 +75,7 @@ enum class Command: uint8_t
   ReleaseInstanceDataBuffer,
 
   CreateTexture,
+  UpdateTexture,
   ReleaseTexture,
 
   CreateFrameBufferWithPrivateTexture,
@@ -95,6 +102,7 @@ enum class Command: uint8_t
   SetInstanceData,
   SetProgram,
   SetFrameBuffer,
+  SetSortDepth,
 
   Draw,
   DrawIndexed,
@@ -122,60 +130,243 @@ Command GetCommand(CommandHeaderType header)
   return static_cast<Command>(header >> 24);
 }
 
+///@return Whether @a cmd creates, updates or releases a resource.
+bool IsResourceCommand(Command cmd)
+{
+  return cmd < Command::Clear;
+}
+
+///@return Whether @a cmd is one of the commands which draws can be sorted
+/// across, i.e. setting state for, and performing draws.
+bool IsDrawCommand(Command cmd)
+{
+  switch (cmd)
+  {
+  case Command::SetUniform:
+  case Command::SetTexture:
+  case Command::SetState:
+  case Command::SetStencilState:
+  case Command::SetInstanceData:
+  case Command::SetProgram:
+  case Command::SetSortDepth:
+  case Command::Draw:
+  case Command::DrawIndexed:
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+//==============================================================================
+///@brief A page of memory that commands are written to. Pages are chained to
+/// make up the contents of a MessageQueue; commands never straddle pages.
+struct CommandPage
+{
+  CommandPage* next;
+  uint32_t capacity;
+  uint32_t used;
+
+  uint8_t* GetData();
+
+  BufferReader GetReader()
+  {
+    return BufferReader({ used, GetData() });
+  }
+};
+
+///@brief The offset of the command data from the start of its page; it must be
+/// 16 aligned, whatever the size of the header is on the given platform.
+const size_t kCommandPageDataOffset = (sizeof(CommandPage) + 15) & ~size_t(15);
+
+uint8_t* CommandPage::GetData()
+{
+  return reinterpret_cast<uint8_t*>(this) + kCommandPageDataOffset;
+}
+
 //==============================================================================
-class MessageQueue
+///@brief Recycles CommandPages of a given size between the queues; pages are
+/// acquired on the recording thread and returned on the render thread. Pages
+/// that are too large for a single command are allocated on demand and freed
+/// once they're returned.
+class CommandPagePool
 {
 public: // structors
-  MessageQueue()
-  : mBuffer{ nullptr }
+  CommandPagePool()
+  : mPageSize{ 0 },
+    mFree{ nullptr }
   {}
 
-  ~MessageQueue()
+  ~CommandPagePool()
   {
-    Reset();
-    free(mBuffer);
+    while (mFree)
+    {
+      auto next = mFree->next;
+      free(mFree);
+      mFree = next;
+    }
   }
 
 public: // general
-  void Init(size_t size)
+  void Init(uint32_t pageSize)
   {
-    uint8_t* buffer = static_cast<uint8_t*>(malloc(size));
-    mBuffer = buffer;
-    mPool.SetBuffer(size, false, buffer);
+    mPageSize = pageSize;
+  }
+
+  CommandPage* Acquire(uint32_t minSize)
+  {
+    CommandPage* page = nullptr;
+    if (minSize <= mPageSize)
+    {
+      std::unique_lock<Spinlock> lock(mLock);
+      page = mFree;
+      if (page)
+      {
+        mFree = page->next;
+      }
+    }
+    else
+    {
+      minSize = XR_ALIGN16(minSize);
+    }
+
+    if (!page)
+    {
+      const uint32_t capacity = std::max(minSize, mPageSize);
+      page = static_cast<CommandPage*>(malloc(kCommandPageDataOffset + capacity));
+      XR_ASSERTMSG(Gfx, page, ("Failed to allocate command page of %" PRIu32
+        " bytes.", capacity));
+      page->capacity = capacity;
+    }
+
+    page->next = nullptr;
+    page->used = 0;
+    return page;
+  }
+
+  void Release(CommandPage* pages)
+  {
+    std::unique_lock<Spinlock> lock(mLock);
+    while (pages)
+    {
+      auto next = pages->next;
+      if (pages->capacity == mPageSize)
+      {
+        pages->next = mFree;
+        mFree = pages;
+      }
+      else
+      {
+        free(pages);
+      }
+      pages = next;
+    }
+  }
+
+private: // data
+  uint32_t mPageSize;
+  CommandPage* mFree; // guarded by mLock
+  Spinlock mLock;
+};
+
+//==============================================================================
+///@brief A chain of CommandPages, which grows by a page from the pool
+/// whenever a command doesn't fit the current one.
+class CommandStream
+{
+public: // structors
+  CommandStream()
+  : mPages{ nullptr },
+    mFirst{ nullptr },
+    mLast{ nullptr },
+    mSize{ 0 },
+    mSealed{ false }
+  {}
+
+  ~CommandStream()
+  {
+    Clear();
+  }
+
+public: // general
+  void Init(CommandPagePool& pages)
+  {
+    mPages = &pages;
   }
 
   template <typename... Args>
   void WriteCommand(Command cmd, Args... args)
   {
-    size_t size = sizeof(CommandHeaderType) + CountSize(args...);
-    uint8_t*  chunk = static_cast<uint8_t*>(mPool.Allocate(size));
-    if (chunk)
+    const uint32_t size = sizeof(CommandHeaderType) + CountSize(args...);
+    if (mSealed || !mLast || mLast->capacity - mLast->used < size)
     {
-      chunk = WriteCommandInternal(chunk, cmd);
-
-      WriteParams(chunk, args...);
+      auto page = mPages->Acquire(size);
+      (mLast ? mLast->next : mFirst) = page;
+      mLast = page;
+      mSealed = false;
     }
-    else
+
+    uint8_t* chunk = mLast->GetData() + mLast->used;
+    mLast->used += size;
+    mSize += size;
+
+    chunk = WriteCommandInternal(chunk, cmd);
+    WriteParams(chunk, args...);
+  }
+
+  ///@brief Makes subsequent commands go to a new page, so that commands may be
+  /// spliced in after the current page.
+  ///@return The current page, or nullptr if there's none yet.
+  CommandPage* Seal()
+  {
+    mSealed = true;
+    return mLast;
+  }
+
+  ///@brief Moves the pages of @a other into this stream, after @a page, which
+  /// must be one of ours, or to the front if it's nullptr.
+  void Splice(CommandPage* page, CommandStream& other)
+  {
+    if (other.mFirst)
     {
-      XR_TRACE(Gfx, ("Failed to allocate %" PRIu32 " bytes for a command %d.",
-        cmd, size));
+      CommandPage*& next = page ? page->next : mFirst;
+      other.mLast->next = next;
+      next = other.mFirst;
+      if (mLast == page)
+      {
+        mLast = other.mLast;
+        mSealed = other.mSealed;
+      }
+      mSize += other.mSize;
+
+      other.mFirst = other.mLast = nullptr;
+      other.mSize = 0;
+      other.mSealed = false;
     }
   }
 
-  void Reset()
+  ///@brief Returns all pages to the pool.
+  void Clear()
   {
-    mPool.Flush();
-    mSemaphore.Post();
+    if (mFirst)
+    {
+      mPages->Release(mFirst);
+    }
+    mFirst = mLast = nullptr;
+    mSize = 0;
+    mSealed = false;
   }
 
-  BufferReader GetReader() const
+  CommandPage* GetFirstPage() const
   {
-    return BufferReader({ mPool.CalculateUsed(), mBuffer });
+    return mFirst;
   }
 
-  void Wait()
+  ///@return The total number of bytes of commands written since the last
+  /// Clear().
+  uint32_t GetSize() const
   {
-    mSemaphore.Wait();
+    return mSize;
   }
 
 private: // static
@@ -192,12 +383,9 @@ private: // static
 
   static uint8_t* WriteCommandInternal(uint8_t* buffer, Command cmd)
   {
-    if (buffer)
-    {
-      *reinterpret_cast<CommandHeaderType*>(buffer) = FormatCommandHeader(cmd);
-      buffer += sizeof(CommandHeaderType);
-    }
-    return buffer;
+    const CommandHeaderType header = FormatCommandHeader(cmd);
+    memcpy(buffer, &header, sizeof(header));
+    return buffer + sizeof(header);
   }
 
   static void WriteParams(void*)
@@ -211,11 +399,57 @@ private: // static
   }
 
 private: // data
-  Pool  mPool;
-  uint8_t* mBuffer; // no ownership
+  CommandPagePool* mPages; // no ownership
+  CommandPage* mFirst;
+  CommandPage* mLast;
+  uint32_t mSize;
+  bool mSealed;
+};
+
+//==============================================================================
+///@brief The commands of a submission; written to by the main thread, then
+/// handed over to the render thread, which Reset()s it once processed.
+class MessageQueue: public CommandStream
+{
+public: // general
+  ///@brief Returns the pages to the pool, and signals the queue's availability
+  /// for recording.
+  void Reset()
+  {
+    Clear();
+    mSemaphore.Post();
+  }
+
+  void Wait()
+  {
+    mSemaphore.Wait();
+  }
+
+private: // data
   Semaphore mSemaphore;
 };
 
+//==============================================================================
+///@brief Commands recorded on another thread, to be spliced into the active
+/// MessageQueue after the page that it was reserved at.
+struct CommandList
+{
+  enum State : uint8_t
+  {
+    Reserved,
+    Recording,
+    Ended
+  };
+
+  CommandStream stream;
+  CommandPage* position = nullptr;
+  std::atomic<uint8_t> state{ Ended };
+};
+
+// The command list that the Gfx calls of the current thread are recorded to,
+// if any.
+thread_local CommandList* tCommandList = nullptr;
+
 //==============================================================================
 struct CreateVertexBufferMessage
 {
@@ -225,6 +459,13 @@ struct CreateVertexBufferMessage
   VertexBufferObject* vbo;
 };
 
+struct UpdateVertexBufferMessage
+{
+  VertexBufferHandle h;
+  uint32_t offset;
+  Buffer buffer;  // ownership
+};
+
 struct CreateIndexBufferMessage
 {
   Buffer buffer;
@@ -246,6 +487,16 @@ struct CreateTextureMessage
   TextureRef* texture;
 };
 
+struct UpdateTextureMessage
+{
+  TextureHandle h;
+  Px x;
+  Px y;
+  Px width;
+  Px height;
+  Buffer buffer;  // ownership
+};
+
 struct CreateFrameBufferWithPrivateTextureMessage
 {
   TextureFormat format;
@@ -345,107 +596,592 @@ struct ReadFrameBufferMessage
   ReadFrameBufferCompleteCallback* onComplete;
 };
 
+//==============================================================================
+///@brief Collects the draws between two commands that draws may not be moved
+/// across, sorts them, then replays them only issuing the state commands that
+/// change the state that Core is in. Must only be used from the render thread.
+class DrawSorter
+{
+public: // structors
+  ~DrawSorter()
+  {
+    ReleaseUniformRecords();
+  }
+
+public: // general
+  void SetUniform(SetUniformMessage m)  // ownership of m.buffer
+  {
+    ++mNumReceived;
+    auto iUniform = FindUniform(m.hUniform);
+    if (iUniform == mUniforms.size())
+    {
+      // A uniform that the batched draws don't know the value of; they must
+      // be drawn before we change it.
+      if (!mPackets.empty())
+      {
+        Flush();
+      }
+      iUniform = mUniforms.size();
+      mUniforms.push_back(m.hUniform);
+      mCurrentUniforms.push_back(kNoRecord);
+      mAppliedUniforms.push_back(kNoRecord);
+    }
+
+    auto iRecord = mCurrentUniforms[iUniform];
+    if (iRecord != kNoRecord && IsSameData(mUniformRecords[iRecord], m.buffer))
+    {
+      ReleaseBuffer(&m.buffer.data);
+    }
+    else
+    {
+      mCurrentUniforms[iUniform] = static_cast<uint32_t>(mUniformRecords.size());
+      mUniformRecords.push_back(m.buffer);
+    }
+  }
+
+  void SetTexture(SetTextureMessage const& m)
+  {
+    ++mNumReceived;
+    XR_ASSERT(Gfx, m.stage < kMaxTextureStages);
+    SetField(DrawState::TextureBit(m.stage), [&m](DrawState& s) {
+      s.hTextures[m.stage] = m.hTexture;
+    });
+  }
+
+  void SetState(FlagType flags)
+  {
+    ++mNumReceived;
+    SetField(DrawState::kState, [flags](DrawState& s) {
+      s.flags = flags;
+    });
+  }
+
+  void SetStencilState(SetStencilStateMessage const& m)
+  {
+    ++mNumReceived;
+    SetField(DrawState::kStencil, [&m](DrawState& s) {
+      s.stencil = m;
+    });
+  }
+
+  void SetInstanceData(SetInstanceDataMessage const& m)
+  {
+    ++mNumReceived;
+    mInstanceData = m;
+  }
+
+  void SetProgram(ProgramHandle h)
+  {
+    ++mNumReceived;
+    SetField(DrawState::kProgram, [h](DrawState& s) {
+      s.hProgram = h;
+    });
+  }
+
+  void SetSortDepth(uint16_t depth)
+  {
+    mDepth = depth;
+  }
+
+  void Draw(DrawIndexedMessage const& m)
+  {
+    Packet p;
+    p.state = mCurrent;
+    p.instanceData = mInstanceData;
+    p.draw = m;
+    p.sequence = static_cast<uint32_t>(mPackets.size());
+    p.uniformsOffset = static_cast<uint32_t>(mPacketUniforms.size());
+    mInstanceData.hIdbo.Invalidate(); // consumed.
+
+    const bool isSortable = mCurrent.IsKnown(DrawState::kState) &&
+      IsSortable(mCurrent.flags);
+    if (isSortable)
+    {
+      p.key = CalculateKey(mCurrent, mDepth);
+    }
+    else if (!mPackets.empty())
+    {
+      // Must be drawn after everything before, and before everything after.
+      Flush();
+      p.sequence = 0;
+      p.uniformsOffset = 0;
+    }
+
+    mPacketUniforms.insert(mPacketUniforms.end(), mCurrentUniforms.begin(),
+      mCurrentUniforms.end());
+    mPackets.push_back(p);
+
+    if (!isSortable)
+    {
+      Flush();
+    }
+  }
+
+  ///@brief Replays the batched draws, then brings Core up to date with all
+  /// state commands received.
+  void Flush()
+  {
+    mOrder.clear();
+    for (uint32_t i = 0; i < mPackets.size(); ++i)
+    {
+      mOrder.push_back(i);
+    }
+
+    std::sort(mOrder.begin(), mOrder.end(), [this](uint32_t i0, uint32_t i1) {
+      auto& p0 = mPackets[i0];
+      auto& p1 = mPackets[i1];
+      return p0.key < p1.key || (p0.key == p1.key && p0.sequence < p1.sequence);
+    });
+
+    for (auto i : mOrder)
+    {
+      auto& p = mPackets[i];
+      Apply(p.state, mPacketUniforms.data() + p.uniformsOffset);
+      if (p.instanceData.hIdbo.IsValid())
+      {
+        Core::SetInstanceData(p.instanceData.hIdbo, p.instanceData.offset,
+          p.instanceData.count);
+        ++mNumIssued;
+      }
+
+      if (p.draw.hIbo.IsValid())
+      {
+        Core::Draw(p.draw.hVbo, p.draw.hIbo, p.draw.primitive, p.draw.offset,
+          p.draw.count);
+      }
+      else
+      {
+        Core::Draw(p.draw.hVbo, p.draw.primitive, p.draw.offset, p.draw.count);
+      }
+    }
+
+    Apply(mCurrent, mCurrentUniforms.data());
+    if (mInstanceData.hIdbo.IsValid())
+    {
+      Core::SetInstanceData(mInstanceData.hIdbo, mInstanceData.offset,
+        mInstanceData.count);
+      mInstanceData.hIdbo.Invalidate();
+      ++mNumIssued;
+    }
+
+    mPackets.clear();
+    mPacketUniforms.clear();
+    CompactUniformRecords();
+
+    if (mNumReceived > mNumIssued)
+    {
+      mNumEliminated += mNumReceived - mNumIssued;
+    }
+    mNumReceived = 0;
+    mNumIssued = 0;
+  }
+
+  ///@brief Forgets about the state that Core is in; it will be set again as
+  /// required, before the next draw.
+  void Invalidate()
+  {
+    XR_ASSERT(Gfx, mPackets.empty());
+    mApplied.known = 0;
+    ReleaseUniformRecords();
+  }
+
+  ///@return The number of state commands eliminated since the last call.
+  uint32_t ConsumeNumEliminated()
+  {
+    auto result = mNumEliminated;
+    mNumEliminated = 0;
+    return result;
+  }
+
+private: // types
+  struct DrawState
+  {
+    enum : uint32_t
+    {
+      kProgram = XR_MASK_ID(uint32_t, 0),
+      kState = XR_MASK_ID(uint32_t, 1),
+      kStencil = XR_MASK_ID(uint32_t, 2),
+      kTextureBase = 3
+    };
+
+    static constexpr uint32_t TextureBit(uint8_t stage)
+    {
+      return XR_MASK_ID(uint32_t, kTextureBase + stage);
+    }
+
+    uint32_t known = 0;
+    ProgramHandle hProgram;
+    FlagType flags = F_STATE_NONE;
+    SetStencilStateMessage stencil{ 0, 0 };
+    TextureHandle hTextures[kMaxTextureStages];
+
+    bool IsKnown(uint32_t fields) const
+    {
+      return CheckAllMaskBits(known, fields);
+    }
+  };
+
+  struct Packet
+  {
+    uint64_t key = 0;
+    uint32_t sequence;
+    uint32_t uniformsOffset;
+    DrawState state;
+    SetInstanceDataMessage instanceData;
+    DrawIndexedMessage draw;
+  };
+
+private: // static
+  static constexpr uint32_t kNoRecord = ~0u;
+
+  static bool IsSameData(Buffer const& b0, Buffer const& b1)
+  {
+    return b0.size == b1.size && std::memcmp(b0.data, b1.data, b0.size) == 0;
+  }
+
+  // Draws that use stencil, or rely on equality with the depth that an earlier
+  // draw has written, may not be reordered. Opaque draws must test and write
+  // depth, so that it decides their visibility regardless of their order;
+  // alpha blended ones are drawn back to front.
+  static bool IsSortable(FlagType flags)
+  {
+    if (!CheckAllMaskBits(flags, F_STATE_DEPTH_TEST) ||
+      CheckAllMaskBits(flags, F_STATE_STENCIL_TEST) ||
+      (flags & F_STATE_DEPTH_COMPF_MASK) == DepthFuncToState(Comparison::EQUAL))
+    {
+      return false;
+    }
+
+    return CheckAnyMaskBits(flags, F_STATE_DEPTH_WRITE | F_STATE_ALPHA_BLEND);
+  }
+
+  // Masks @a value to @a bits bits and moves it to @a shift in the key.
+  static uint64_t KeyField(uint64_t value, uint32_t bits, uint32_t shift)
+  {
+    return (value & ((uint64_t(1) << bits) - 1)) << shift;
+  }
+
+  // Opaque draws: program, texture 0, state, then front to back.
+  // Alpha blended draws: after opaque ones, back to front, then in the order
+  // they were issued.
+  // Bits: 63: alpha; 47-62: program / inverse depth; 31-46: texture 0;
+  // 15-30: state; 0-14: depth.
+  static uint64_t CalculateKey(DrawState const& s, uint16_t depth)
+  {
+    static_assert(sizeof(HandleCoreCore::id) <= 2, "Handle ids don't fit in 16 bits.");
+    if (CheckAllMaskBits(s.flags, F_STATE_ALPHA_BLEND))
+    {
+      return KeyField(1, 1, 63) | KeyField(0xffff - depth, 16, 47);
+    }
+
+    const uint64_t stateHash = s.flags ^ (s.flags >> 16);
+    return KeyField(s.hProgram.id, 16, 47) |
+      KeyField(s.hTextures[0].id, 16, 31) |
+      KeyField(stateHash, 16, 15) |
+      KeyField(depth >> 1, 15, 0);
+  }
+
+private: // data
+  DrawState mCurrent; // as received
+  DrawState mApplied; // as issued to Core
+  SetInstanceDataMessage mInstanceData{ InstanceDataBufferHandle(), 0, 0 };
+  uint16_t mDepth = 0;
+
+  std::vector<UniformHandle> mUniforms;  // that were set in this batch
+  std::vector<uint32_t> mCurrentUniforms; // record index per uniform, as received
+  std::vector<uint32_t> mAppliedUniforms; // record index per uniform, as issued
+  std::vector<Buffer> mUniformRecords;  // ownership of data
+  std::vector<Buffer> mCompactedRecords;
+
+  std::vector<Packet> mPackets;
+  std::vector<uint32_t> mPacketUniforms;  // record index per uniform, per packet
+  std::vector<uint32_t> mOrder;
+
+  uint32_t mNumReceived = 0;
+  uint32_t mNumIssued = 0;
+  uint32_t mNumEliminated = 0;
+
+private: // internal
+  size_t FindUniform(UniformHandle h) const
+  {
+    return std::find(mUniforms.begin(), mUniforms.end(), h) - mUniforms.begin();
+  }
+
+  template <typename Setter>
+  void SetField(uint32_t field, Setter setter)
+  {
+    // The batched draws don't know what it was before; they must be drawn
+    // before we change it.
+    if (!mCurrent.IsKnown(field) && !mPackets.empty())
+    {
+      Flush();
+    }
+
+    setter(mCurrent);
+    mCurrent.known |= field;
+  }
+
+  void Apply(DrawState const& s, uint32_t const* uniforms)
+  {
+    auto update = [this, &s](uint32_t field, bool isSame) {
+      bool result = s.IsKnown(field) && !(mApplied.IsKnown(field) && isSame);
+      mNumIssued += result;
+      return result;
+    };
+
+    if (update(DrawState::kProgram, mApplied.hProgram == s.hProgram))
+    {
+      Core::SetProgram(s.hProgram);
+      mApplied.hProgram = s.hProgram;
+    }
+
+    if (update(DrawState::kState, mApplied.flags == s.flags))
+    {
+      Core::SetState(s.flags);
+      mApplied.flags = s.flags;
+    }
+
+    if (update(DrawState::kStencil, mApplied.stencil.front == s.stencil.front &&
+      mApplied.stencil.back == s.stencil.back))
+    {
+      Core::SetStencilState(s.stencil.front, s.stencil.back);
+      mApplied.stencil = s.stencil;
+    }
+
+    for (uint8_t i = 0; i < kMaxTextureStages; ++i)
+    {
+      if (update(DrawState::TextureBit(i), mApplied.hTextures[i] == s.hTextures[i]))
+      {
+        Core::SetTexture(s.hTextures[i], i);
+        mApplied.hTextures[i] = s.hTextures[i];
+      }
+    }
+    mApplied.known |= s.known;
+
+    for (size_t i = 0; i < mUniforms.size(); ++i)
+    {
+      const auto iRecord = uniforms[i];
+      auto& iApplied = mAppliedUniforms[i];
+      if (iRecord != kNoRecord && iRecord != iApplied)
+      {
+        auto& buffer = mUniformRecords[iRecord];
+        if (iApplied == kNoRecord || !IsSameData(mUniformRecords[iApplied], buffer))
+        {
+          Core::SetUniform(mUniforms[i], buffer);
+          ++mNumIssued;
+        }
+        iApplied = iRecord;
+      }
+    }
+  }
+
+  // Keeps the records of the current values only, so that we may carry on
+  // eliminating redundant uniform updates across batches.
+  void CompactUniformRecords()
+  {
+    for (size_t i = 0; i < mUniformRecords.size(); ++i)
+    {
+      if (std::find(mCurrentUniforms.begin(), mCurrentUniforms.end(), i) ==
+        mCurrentUniforms.end())
+      {
+        ReleaseBuffer(&mUniformRecords[i].data);
+      }
+    }
+
+    mCompactedRecords.clear();
+    for (size_t i = 0; i < mCurrentUniforms.size(); ++i)
+    {
+      auto& iCurrent = mCurrentUniforms[i];
+      if (iCurrent != kNoRecord)
+      {
+        mCompactedRecords.push_back(mUniformRecords[iCurrent]);
+        iCurrent = static_cast<uint32_t>(mCompactedRecords.size() - 1);
+      }
+      mAppliedUniforms[i] = iCurrent;
+    }
+    mUniformRecords.swap(mCompactedRecords);
+  }
+
+  void ReleaseUniformRecords()
+  {
+    for (auto& b : mUniformRecords)
+    {
+      ReleaseBuffer(&b.data);
+    }
+    mUniformRecords.clear();
+    mUniforms.clear();
+    mCurrentUniforms.clear();
+    mAppliedUniforms.clear();
+  }
+};
+
+//==============================================================================
+///@brief Accumulates FrameStats on the render thread, and publishes them upon
+/// Present().
+class FrameStatsCollector
+{
+public: // general
+  FrameStats& GetCurrent()
+  {
+    return mCurrent;
+  }
+
+  void Publish()
+  {
+    mPeakCommandBytes = std::max(mPeakCommandBytes, mCurrent.numCommandBytes);
+    mCurrent.peakCommandBytes = mPeakCommandBytes;
+
+    std::unique_lock<Spinlock> lock(mLock);
+    mLast = mCurrent;
+    mCurrent = FrameStats{};
+  }
+
+  FrameStats GetLast() const
+  {
+    std::unique_lock<Spinlock> lock(mLock);
+    return mLast;
+  }
+
+private: // data
+  FrameStats mCurrent{}; // render thread only
+  uint32_t mPeakCommandBytes = 0; // render thread only
+  FrameStats mLast{};
+  mutable Spinlock mLock;
+};
+
 #define LOCK_RESOURCES std::unique_lock<Spinlock> lock(mResources->GetLock())
 
 class RenderJob: public Worker::Job
 {
 public: // structors
-  RenderJob(ResourceManager* resources, MessageQueue* messenger)
+  RenderJob(ResourceManager* resources, MessageQueue* messenger,
+    DrawSorter* sorter, FrameStatsCollector* stats)
   : mResources(resources),
-    mMessenger(messenger)
+    mMessenger(messenger),
+    mSorter(sorter),
+    mStats(stats)
   {}
 
 public: // general
   virtual bool Process() override
   {
-    BufferReader reader = mMessenger->GetReader();
+    auto& stats = mStats->GetCurrent();
+    stats.numCommandBytes += mMessenger->GetSize();
 
     CommandHeaderType commandHeader;
     // TODO: error communication
     bool more = true;
-    while (more && reader.Read(commandHeader))
+    for (auto page = mMessenger->GetFirstPage(); more && page; page = page->next)
     {
-      Command command = GetCommand(commandHeader);
+      BufferReader reader = page->GetReader();
+      while (more && reader.Read(commandHeader))
+      {
+        Command command = GetCommand(commandHeader);
+        const bool isDrawCommand = IsDrawCommand(command);
+        if (isDrawCommand)
+        {
+          stats.numCommands += command != Command::SetSortDepth;
+          stats.numDraws += command == Command::Draw || command == Command::DrawIndexed;
+        }
+        else if (mSorter)
+        {
+          mSorter->Flush();
+        }
 
 #define COMMAND_CASE(x) case Command::x: x(reader); break;
-      switch(command)
-      {
-      case Command::ReleaseVertexFormat:
-        Release<VertexFormatHandle>(reader, Core::Release);
-        break;
+        switch(command)
+        {
+        case Command::ReleaseVertexFormat:
+          Release<VertexFormatHandle>(reader, Core::Release);
+          break;
 
-      COMMAND_CASE(CreateVertexBuffer)
+        COMMAND_CASE(CreateVertexBuffer)
+        COMMAND_CASE(UpdateVertexBuffer)
 
-      case Command::ReleaseVertexBuffer:
-        Release<VertexBufferHandle>(reader, Core::Release);
-        break;
+        case Command::ReleaseVertexBuffer:
+          Release<VertexBufferHandle>(reader, Core::Release);
+          break;
 
-      COMMAND_CASE(CreateIndexBuffer)
+        COMMAND_CASE(CreateIndexBuffer)
 
-      case Command::ReleaseIndexBuffer:
-        Release<IndexBufferHandle>(reader, Core::Release);
-        break;
+        case Command::ReleaseIndexBuffer:
+          Release<IndexBufferHandle>(reader, Core::Release);
+          break;
 
-      COMMAND_CASE(CreateInstanceDataBuffer);
+        COMMAND_CASE(CreateInstanceDataBuffer);
 
-      case Command::ReleaseInstanceDataBuffer:
-        Release<InstanceDataBufferHandle>(reader, Core::Release);
-        break;
+        case Command::ReleaseInstanceDataBuffer:
+          Release<InstanceDataBufferHandle>(reader, Core::Release);
+          break;
 
-      COMMAND_CASE(CreateTexture)
+        COMMAND_CASE(CreateTexture)
+        COMMAND_CASE(UpdateTexture)
 
-      case Command::ReleaseTexture:
-        Release<TextureHandle>(reader, Core::Release);
-        break;
+        case Command::ReleaseTexture:
+          Release<TextureHandle>(reader, Core::Release);
+          break;
 
-      COMMAND_CASE(CreateFrameBufferWithPrivateTexture)
-      COMMAND_CASE(CreateFrameBufferWithTextures)
-      COMMAND_CASE(CreateFrameBufferWithAttachments)
+        COMMAND_CASE(CreateFrameBufferWithPrivateTexture)
+        COMMAND_CASE(CreateFrameBufferWithTextures)
+        COMMAND_CASE(CreateFrameBufferWithAttachments)
 
-      case Command::ReleaseFrameBuffer:
-        Release<FrameBufferHandle>(reader, Core::Release);
-        break;
+        case Command::ReleaseFrameBuffer:
+          Release<FrameBufferHandle>(reader, Core::Release);
+          break;
 
-      COMMAND_CASE(ReleaseUniform)
+        COMMAND_CASE(ReleaseUniform)
 
-      COMMAND_CASE(CreateShader)
+        COMMAND_CASE(CreateShader)
 
-      case Command::ReleaseShader:
-        Release<ShaderHandle>(reader, Core::Release);
-        break;
+        case Command::ReleaseShader:
+          Release<ShaderHandle>(reader, Core::Release);
+          break;
 
-      COMMAND_CASE(CreateProgram)
+        COMMAND_CASE(CreateProgram)
 
-      case Command::ReleaseProgram:
-        Release<ProgramHandle>(reader, Core::Release);
-        break;
+        case Command::ReleaseProgram:
+          Release<ProgramHandle>(reader, Core::Release);
+          break;
 
-      COMMAND_CASE(Clear)
-      COMMAND_CASE(SetViewport)
-      COMMAND_CASE(SetScissor)
-      COMMAND_CASE(SetUniform)
-      COMMAND_CASE(SetTexture)
-      COMMAND_CASE(SetState)
-      COMMAND_CASE(SetStencilState)
-      COMMAND_CASE(SetInstanceData)
-      COMMAND_CASE(SetProgram)
-      COMMAND_CASE(SetFrameBuffer)
-      COMMAND_CASE(Draw)
-      COMMAND_CASE(DrawIndexed)
+        COMMAND_CASE(Clear)
+        COMMAND_CASE(SetViewport)
+        COMMAND_CASE(SetScissor)
+        COMMAND_CASE(SetUniform)
+        COMMAND_CASE(SetTexture)
+        COMMAND_CASE(SetState)
+        COMMAND_CASE(SetStencilState)
+        COMMAND_CASE(SetInstanceData)
+        COMMAND_CASE(SetProgram)
+        COMMAND_CASE(SetFrameBuffer)
+        COMMAND_CASE(SetSortDepth)
+        COMMAND_CASE(Draw)
+        COMMAND_CASE(DrawIndexed)
 
-      case Command::Flush:
-        Flush();
-        break;
+        case Command::Flush:
+          Flush();
+          break;
 
-      COMMAND_CASE(Present)
+        COMMAND_CASE(Present)
 
-      COMMAND_CASE(ReadFrameBuffer)
+        COMMAND_CASE(ReadFrameBuffer)
 
-      case Command::End:
-        more = false;
-        break;
-      }
+        case Command::End:
+          more = false;
+          break;
+        }
 #undef COMMAND_CASE
+
+        if (mSorter && IsResourceCommand(command))
+        {
+          mSorter->Invalidate();
+        }
+      }
+    }
+
+    if (mSorter)
+    {
+      mSorter->Flush();
+      stats.numEliminatedCommands += mSorter->ConsumeNumEliminated();
     }
 
     mMessenger->Reset();
@@ -455,6 +1191,8 @@ public: // general
 private:// data
   ResourceManager* mResources;  // no ownership
   MessageQueue* mMessenger; // no ownership
+  DrawSorter* mSorter; // no ownership
+  FrameStatsCollector* mStats; // no ownership
 
 private: // internal
   template <class T>
@@ -474,11 +1212,26 @@ private: // internal
     BufferGuard bufferGuard(&m.buffer.data, ReleaseBuffer);
     if (reader.Read(m))
     {
+      mStats->GetCurrent().numVertexUploadBytes += static_cast<uint32_t>(m.buffer.size);
+
       LOCK_RESOURCES;
       Core::CreateVertexBuffer(m.hFormat, m.buffer, m.flags, *m.vbo);
     }
   }
 
+  void UpdateVertexBuffer(BufferReader& reader)
+  {
+    UpdateVertexBufferMessage m;
+    BufferGuard bufferGuard(&m.buffer.data, ReleaseBuffer);
+    if (reader.Read(m))
+    {
+      mStats->GetCurrent().numVertexUploadBytes += static_cast<uint32_t>(m.buffer.size);
+
+      LOCK_RESOURCES;
+      Core::UpdateVertexBuffer(m.h, m.offset, m.buffer);
+    }
+  }
+
   void CreateIndexBuffer(BufferReader& reader)
   {
     CreateIndexBufferMessage m;
@@ -516,11 +1269,30 @@ private: // internal
 
     if (reader.Read(m))
     {
+      auto& stats = mStats->GetCurrent();
+      for (auto i = m.buffers, iEnd = i + m.numBuffers; i != iEnd; ++i)
+      {
+        stats.numTextureUploadBytes += static_cast<uint32_t>(i->size);
+      }
+
       LOCK_RESOURCES;
       Core::CreateTexture(m.buffers, m.numBuffers, *m.texture);
     }
   }
 
+  void UpdateTexture(BufferReader& reader)
+  {
+    UpdateTextureMessage m;
+    BufferGuard bufferGuard(&m.buffer.data, ReleaseBuffer);
+    if (reader.Read(m))
+    {
+      mStats->GetCurrent().numTextureUploadBytes += static_cast<uint32_t>(m.buffer.size);
+
+      LOCK_RESOURCES;
+      Core::UpdateTexture(m.h, m.x, m.y, m.width, m.height, m.buffer);
+    }
+  }
+
   void CreateFrameBufferWithPrivateTexture(BufferReader& reader)
   {
     CreateFrameBufferWithPrivateTextureMessage m;
@@ -627,7 +1399,15 @@ private: // internal
     BufferGuard guard(&m.buffer.data, ReleaseBuffer);
     if (reader.Read(m))
     {
-      Core::SetUniform(m.hUniform, m.buffer);
+      if (mSorter)
+      {
+        mSorter->SetUniform(m);
+        m.buffer.data = nullptr;  // ownership transferred
+      }
+      else
+      {
+        Core::SetUniform(m.hUniform, m.buffer);
+      }
     }
   }
 
@@ -636,7 +1416,14 @@ private: // internal
     SetTextureMessage m;
     if (reader.Read(m))
     {
-      Core::SetTexture(m.hTexture, m.stage);
+      if (mSorter)
+      {
+        mSorter->SetTexture(m);
+      }
+      else
+      {
+        Core::SetTexture(m.hTexture, m.stage);
+      }
     }
   }
 
@@ -645,7 +1432,14 @@ private: // internal
     FlagType flags;
     if (reader.Read(flags))
     {
-      Core::SetState(flags);
+      if (mSorter)
+      {
+        mSorter->SetState(flags);
+      }
+      else
+      {
+        Core::SetState(flags);
+      }
     }
   }
 
@@ -654,7 +1448,14 @@ private: // internal
     SetStencilStateMessage m;
     if (reader.Read(m))
     {
-      Core::SetStencilState(m.front, m.back);
+      if (mSorter)
+      {
+        mSorter->SetStencilState(m);
+      }
+      else
+      {
+        Core::SetStencilState(m.front, m.back);
+      }
     }
   }
 
@@ -663,7 +1464,14 @@ private: // internal
     SetInstanceDataMessage m;
     if (reader.Read(m))
     {
-      Core::SetInstanceData(m.hIdbo, m.offset, m.count);
+      if (mSorter)
+      {
+        mSorter->SetInstanceData(m);
+      }
+      else
+      {
+        Core::SetInstanceData(m.hIdbo, m.offset, m.count);
+      }
     }
   }
 
@@ -672,7 +1480,23 @@ private: // internal
     ProgramHandle h;
     if (reader.Read(h))
     {
-      Core::SetProgram(h);
+      if (mSorter)
+      {
+        mSorter->SetProgram(h);
+      }
+      else
+      {
+        Core::SetProgram(h);
+      }
+    }
+  }
+
+  void SetSortDepth(BufferReader& reader)
+  {
+    uint16_t depth;
+    if (reader.Read(depth) && mSorter)
+    {
+      mSorter->SetSortDepth(depth);
     }
   }
 
@@ -690,7 +1514,15 @@ private: // internal
     DrawMessage m;
     if (reader.Read(m))
     {
-      Core::Draw(m.hVbo, m.primitive, m.offset, m.count);
+      if (mSorter)
+      {
+        mSorter->Draw(DrawIndexedMessage{ m.hVbo, IndexBufferHandle(),
+          m.primitive, m.offset, m.count });
+      }
+      else
+      {
+        Core::Draw(m.hVbo, m.primitive, m.offset, m.count);
+      }
     }
   }
 
@@ -699,7 +1531,14 @@ private: // internal
     DrawIndexedMessage m;
     if (reader.Read(m))
     {
-      Core::Draw(m.hVbo, m.hIbo, m.primitive, m.offset, m.count);
+      if (mSorter)
+      {
+        mSorter->Draw(m);
+      }
+      else
+      {
+        Core::Draw(m.hVbo, m.hIbo, m.primitive, m.offset, m.count);
+      }
     }
   }
 
@@ -714,6 +1553,12 @@ private: // internal
     if (reader.Read(resetState))
     {
       Core::Present(resetState);
+
+      if (mSorter)
+      {
+        mStats->GetCurrent().numEliminatedCommands += mSorter->ConsumeNumEliminated();
+      }
+      mStats->Publish();
     }
   }
 
@@ -737,19 +1582,36 @@ private: // internal
 class MContext
 {
 public:// structors
-  MContext(ResourceManager* resMan, uint32_t messageBufferSize)
-  : mResources(resMan)
+  MContext(ResourceManager* resMan, uint32_t messageBufferSize,
+    uint32_t numQueues, bool sortDraws)
+  : mResources(resMan),
+    mSorter(sortDraws ? new DrawSorter() : nullptr)
   {
-    messageBufferSize = XR_ALIGN16(messageBufferSize);
-    for (auto& q: mQueues)
+    XR_ASSERT(GfxM, numQueues > 1);
+    mPages.Init(XR_ALIGN16(messageBufferSize));
+
+    mQueues.reserve(numQueues);
+    mRenderJobs.reserve(numQueues);
+    for (uint32_t i = 0; i < numQueues; ++i)
     {
-      q.Init(messageBufferSize);
+      auto queue = new MessageQueue();
+      queue->Init(mPages);
+      mQueues.emplace_back(queue);
+      mRenderJobs.emplace_back(new RenderJob(mResources, queue, mSorter.get(),
+        &mStats));
     }
-    mActiveQueue = mQueues;
 
-    // Post to the second queue to indicate its immediate availability,
-    // as there's nothing to wait on initially.
-    mQueues[1].Reset();
+    for (auto& l : mCommandLists)
+    {
+      l.stream.Init(mPages);
+    }
+
+    // Post to all but the active queue to indicate their immediate
+    // availability, as there's nothing to wait on initially.
+    for (uint32_t i = 1; i < numQueues; ++i)
+    {
+      mQueues[i]->Reset();
+    }
   }
 
   ~MContext()
@@ -763,9 +1625,58 @@ public: // general
     return *mResources;
   }
 
-  MessageQueue& GetActiveQueue()
+  ///@return The stream that the calling thread records commands to; its
+  /// command list if it has begun one, otherwise the active queue.
+  CommandStream& GetStream()
+  {
+    return tCommandList ? tCommandList->stream : *mQueues[mActiveQueue];
+  }
+
+  CommandListHandle ReserveCommandList()
+  {
+    XR_ASSERTMSG(GfxM, !tCommandList, ("Can't reserve command lists while recording one."));
+    XR_ASSERTMSG(GfxM, mNumCommandLists < kMaxCommandLists,
+      ("Too many command lists reserved; the maximum is %d.", kMaxCommandLists));
+    CommandListHandle h;
+    if (mNumCommandLists < kMaxCommandLists)
+    {
+      h.id = mNumCommandLists;
+      auto& list = mCommandLists[h.id];
+      list.position = mQueues[mActiveQueue]->Seal();
+      list.state.store(CommandList::Reserved, std::memory_order_relaxed);
+      ++mNumCommandLists;
+    }
+    return h;
+  }
+
+  void BeginCommandList(CommandListHandle h)
+  {
+    XR_ASSERTMSG(GfxM, !tCommandList, ("Already recording a command list."));
+    XR_ASSERT(GfxM, h.IsValid() && h.id < kMaxCommandLists);
+    tCommandList = mCommandLists + h.id;
+    const auto state = tCommandList->state.exchange(CommandList::Recording,
+      std::memory_order_relaxed);
+    XR_ASSERTMSG(GfxM, state == CommandList::Reserved,
+      ("Command list %d is not reserved, or has already been recorded into.", h.id));
+    (void)state;
+  }
+
+  void EndCommandList()
+  {
+    XR_ASSERTMSG(GfxM, tCommandList, ("Not recording a command list."));
+    tCommandList->state.store(CommandList::Ended, std::memory_order_relaxed);
+    tCommandList = nullptr;
+    mCommandListsEnded.Post();
+  }
+
+  bool IsSortingDraws() const
   {
-    return *mActiveQueue;
+    return mSorter != nullptr;
+  }
+
+  FrameStats GetFrameStats() const
+  {
+    return mStats.GetLast();
   }
 
   void EnqueueJob(Worker::Job& job)
@@ -773,24 +1684,80 @@ public: // general
     mRenderThread.Enqueue(job);
   }
 
+  ///@brief Hands the active queue over to the render thread, and moves on to
+  /// the next one, waiting for the render thread to finish with it if it's
+  /// still in flight.
   void SubmitCommands()
   {
-    mActiveQueue->WriteCommand(Command::End);
-    auto renderJob = new RenderJob(mResources, mActiveQueue);
-    mRenderThread.Enqueue(*renderJob);
+    XR_ASSERTMSG(GfxM, !tCommandList, ("Can't submit commands while recording a command list."));
+    auto& queue = *mQueues[mActiveQueue];
 
-    auto next = mQueues + ((mActiveQueue - mQueues + 1) & (XR_ARRAY_SIZE(mQueues) - 1));
-    mActiveQueue = next;
-    next->Wait();
+    // Wait for the recording of all reserved command lists to end, then splice
+    // them into the queue. Go from the last, so that lists reserved at the same
+    // point keep their order.
+    WaitForCommandLists();
+    while (mNumCommandLists > 0)
+    {
+      --mNumCommandLists;
+      auto& list = mCommandLists[mNumCommandLists];
+      queue.Splice(list.position, list.stream);
+    }
+
+    queue.WriteCommand(Command::End);
+    mRenderThread.Enqueue(*mRenderJobs[mActiveQueue]);
+
+    mActiveQueue = (mActiveQueue + 1) % mQueues.size();
+    mQueues[mActiveQueue]->Wait();
+  }
+
+private: // internal
+  void WaitForCommandLists()
+  {
+    uint16_t numEnded = 0;
+#if defined XR_DEBUG
+    // A list that was reserved but never begun or ended blocks us forever;
+    // name the lists that we're waiting on if it takes a while.
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (numEnded < mNumCommandLists && std::chrono::steady_clock::now() < deadline)
+    {
+      if (mCommandListsEnded.TryWait())
+      {
+        ++numEnded;
+      }
+      else
+      {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    }
+
+    for (uint16_t i = 0; i < mNumCommandLists && numEnded < mNumCommandLists; ++i)
+    {
+      const auto state = mCommandLists[i].state.load(std::memory_order_relaxed);
+      XR_TRACEIF(GfxM, state != CommandList::Ended,
+        ("WARNING: waiting for command list %d, which has %s; every list that was reserved must be begun and ended before submitting commands.",
+        i, state == CommandList::Reserved ? "not begun" : "not ended"));
+    }
+#endif
+    for (; numEnded < mNumCommandLists; ++numEnded)
+    {
+      mCommandListsEnded.Wait();
+    }
   }
 
 private: // data
   ResourceManager* mResources;
-  MessageQueue mQueues[2];
-  MessageQueue* mActiveQueue = nullptr;
-  Worker mRenderThread;
-
-  static_assert((XR_ARRAY_SIZE(MContext::mQueues) & (XR_ARRAY_SIZE(MContext::mQueues) - 1)) == 0, "Power of two");
+  CommandPagePool mPages; // must outlive the queues.
+  std::vector<std::unique_ptr<MessageQueue>> mQueues;
+  std::vector<std::unique_ptr<RenderJob>> mRenderJobs;
+  size_t mActiveQueue = 0;
+
+  static constexpr uint16_t kMaxCommandLists = 256;
+  CommandList mCommandLists[kMaxCommandLists];
+  uint16_t mNumCommandLists = 0; // main thread only
+  Semaphore mCommandListsEnded;
+  std::unique_ptr<DrawSorter> mSorter; // render thread only
+  FrameStatsCollector mStats;
+  Worker mRenderThread{ Worker::QueueMode::LockFree };
 };
 
 std::unique_ptr<MContext> sContext;
@@ -798,10 +1765,11 @@ std::unique_ptr<MContext> sContext;
 } // nonamespace
 
 //==============================================================================
-void M::Init(Context* context, ResourceManager* resources, uint32_t messageBufferSize)
+void M::Init(Context* context, ResourceManager* resources, uint32_t messageBufferSize,
+  uint32_t numQueues, bool sortDraws)
 {
   XR_ASSERT(GfxM, !sContext);
-  sContext.reset(new MContext(resources, messageBufferSize));
+  sContext.reset(new MContext(resources, messageBufferSize, numQueues, sortDraws));
 
   SyncJob initJob{ [context, resources]() { Core::Init(context, resources); } };
   sContext->EnqueueJob(initJob);
@@ -818,7 +1786,7 @@ VertexFormatHandle M::RegisterVertexFormat(VertexFormat const& format)
 void M::Release(VertexFormatHandle h)
 {
   std::unique_lock<Spinlock> lock(sContext->GetResources().GetLock());
-  sContext->GetActiveQueue().WriteCommand(Command::ReleaseVertexFormat, h);
+  sContext->GetStream().WriteCommand(Command::ReleaseVertexFormat, h);
 }
 
 //==============================================================================
@@ -833,16 +1801,25 @@ VertexBufferHandle M::CreateVertexBuffer(VertexFormatHandle hFormat,
     h.id = static_cast<uint16_t>(vbos.server.Acquire());
   };
 
-  sContext->GetActiveQueue().WriteCommand(Command::CreateVertexBuffer,
+  sContext->GetStream().WriteCommand(Command::CreateVertexBuffer,
     CreateVertexBufferMessage{ hFormat, Buffer{ buffer.size, bufferCopy },
       flags, vbos.data + h.id });
   return h;
 }
 
+//==============================================================================
+void M::UpdateVertexBuffer(VertexBufferHandle h, uint32_t offset,
+  Buffer const& buffer)
+{
+  auto bufferCopy = CopyBuffer(buffer);
+  sContext->GetStream().WriteCommand(Command::UpdateVertexBuffer,
+    UpdateVertexBufferMessage{ h, offset, Buffer{ buffer.size, bufferCopy } });
+}
+
 //==============================================================================
 void M::Release(VertexBufferHandle h)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::ReleaseVertexBuffer, h);
+  sContext->GetStream().WriteCommand(Command::ReleaseVertexBuffer, h);
 }
 
 //==============================================================================
@@ -856,7 +1833,7 @@ IndexBufferHandle M::CreateIndexBuffer(Buffer const& buffer, FlagType flags)
     h.id = static_cast<uint16_t>(ibos.server.Acquire());
   };
 
-  sContext->GetActiveQueue().WriteCommand(Command::CreateIndexBuffer,
+  sContext->GetStream().WriteCommand(Command::CreateIndexBuffer,
     CreateIndexBufferMessage{ Buffer { buffer.size, bufferCopy }, flags,
       ibos.data + h.id });
   return h;
@@ -865,7 +1842,7 @@ IndexBufferHandle M::CreateIndexBuffer(Buffer const& buffer, FlagType flags)
 //==============================================================================
 void M::Release(IndexBufferHandle h)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::ReleaseIndexBuffer, h);
+  sContext->GetStream().WriteCommand(Command::ReleaseIndexBuffer, h);
 }
 
 //==============================================================================
@@ -879,7 +1856,7 @@ InstanceDataBufferHandle M::CreateInstanceDataBuffer(Buffer const& buffer, Insta
     h.id = static_cast<uint16_t>(vbos.server.Acquire());
   }
 
-  sContext->GetActiveQueue().WriteCommand(Command::CreateInstanceDataBuffer,
+  sContext->GetStream().WriteCommand(Command::CreateInstanceDataBuffer,
     CreateInstanceDataBufferMessage{ Buffer { buffer.size, bufferCopy }, stride,
       vbos.data + h.id });
   return h;
@@ -888,7 +1865,7 @@ InstanceDataBufferHandle M::CreateInstanceDataBuffer(Buffer const& buffer, Insta
 //==============================================================================
 void M::Release(InstanceDataBufferHandle h)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::ReleaseInstanceDataBuffer, h);
+  sContext->GetStream().WriteCommand(Command::ReleaseInstanceDataBuffer, h);
 }
 
 //==============================================================================
@@ -940,13 +1917,22 @@ TextureHandle M::CreateTexture(TextureFormat format, Px width,
       TextureInfo::CalculateMipLevels(width, height, flags), flags };
   }
 
-  sContext->GetActiveQueue().WriteCommand(Command::CreateTexture,
+  sContext->GetStream().WriteCommand(Command::CreateTexture,
     CreateTextureMessage { buffersCopy, numBuffers, textureRef });
 
   buffersGuard.buffers = nullptr; // dismiss guard
   return h;
 }
 
+//==============================================================================
+void M::UpdateTexture(TextureHandle h, Px x, Px y, Px width, Px height,
+  Buffer const& buffer)
+{
+  auto bufferCopy = CopyBuffer(buffer);
+  sContext->GetStream().WriteCommand(Command::UpdateTexture,
+    UpdateTextureMessage{ h, x, y, width, height, Buffer { buffer.size, bufferCopy } });
+}
+
 //==============================================================================
 TextureInfo M::GetTextureInfo(TextureHandle h)
 {
@@ -957,7 +1943,7 @@ TextureInfo M::GetTextureInfo(TextureHandle h)
 //==============================================================================
 void M::Release(TextureHandle h)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::ReleaseTexture, h);
+  sContext->GetStream().WriteCommand(Command::ReleaseTexture, h);
 }
 
 //==============================================================================
@@ -971,7 +1957,7 @@ FrameBufferHandle M::CreateFrameBuffer(TextureFormat format, Px width,
     h.id = static_cast<uint16_t>(fbos.server.Acquire());
   }
 
-  sContext->GetActiveQueue().WriteCommand(Command::CreateFrameBufferWithPrivateTexture,
+  sContext->GetStream().WriteCommand(Command::CreateFrameBufferWithPrivateTexture,
     CreateFrameBufferWithPrivateTextureMessage{ format, width, height, flags,
       fbos.data + h.id });
   return h;
@@ -999,7 +1985,7 @@ FrameBufferHandle M::CreateFrameBuffer(uint8_t textureCount,
     h.id = static_cast<uint16_t>(fbos.server.Acquire());
   }
 
-  sContext->GetActiveQueue().WriteCommand(Command::CreateFrameBufferWithTextures,
+  sContext->GetStream().WriteCommand(Command::CreateFrameBufferWithTextures,
     CreateFrameBufferWithTexturesMessage{ textureCount, hTexturesCopy, fbos.data + h.id });
   return h;
 }
@@ -1026,7 +2012,7 @@ FrameBufferHandle M::CreateFrameBuffer(uint8_t attachmentCount,
     h.id =  static_cast<uint16_t>(fbos.server.Acquire());
   }
 
-  sContext->GetActiveQueue().WriteCommand(Command::CreateFrameBufferWithAttachments,
+  sContext->GetStream().WriteCommand(Command::CreateFrameBufferWithAttachments,
     CreateFrameBufferWithAttachmentsMessage{ attachmentCount, attachmentsCopy,
       fbos.data + h.id });
   return h;
@@ -1035,7 +2021,7 @@ FrameBufferHandle M::CreateFrameBuffer(uint8_t attachmentCount,
 //==============================================================================
 void M::Release(FrameBufferHandle h)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::ReleaseFrameBuffer, h);
+  sContext->GetStream().WriteCommand(Command::ReleaseFrameBuffer, h);
 }
 
 //==============================================================================
@@ -1048,7 +2034,7 @@ UniformHandle M::CreateUniform(char const* name, UniformType type, uint8_t array
 //==============================================================================
 void M::Release(UniformHandle h)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::ReleaseUniform, h);
+  sContext->GetStream().WriteCommand(Command::ReleaseUniform, h);
 }
 
 //==============================================================================
@@ -1067,7 +2053,7 @@ ShaderHandle M::CreateShader(ShaderType type, Buffer const& buffer)
     h.id = static_cast<uint16_t>(shaders.server.Acquire());
   }
 
-  sContext->GetActiveQueue().WriteCommand(Command::CreateShader,
+  sContext->GetStream().WriteCommand(Command::CreateShader,
     CreateShaderMessage{ type, Buffer{ buffer.size, bufferCopy }, shaders.data + h.id });
   return h;
 }
@@ -1075,7 +2061,7 @@ ShaderHandle M::CreateShader(ShaderType type, Buffer const& buffer)
 //==============================================================================
 void M::Release(ShaderHandle h)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::ReleaseShader, h);
+  sContext->GetStream().WriteCommand(Command::ReleaseShader, h);
 }
 
 //==============================================================================
@@ -1088,7 +2074,7 @@ ProgramHandle M::CreateProgram(ShaderHandle hVertex, ShaderHandle hFragment)
     h.id = static_cast<uint16_t>(programs.server.Acquire());
   }
 
-  sContext->GetActiveQueue().WriteCommand(Command::CreateProgram,
+  sContext->GetStream().WriteCommand(Command::CreateProgram,
     CreateProgramMessage{ hVertex, hFragment, programs.data + h.id });
   return h;
 }
@@ -1096,20 +2082,20 @@ ProgramHandle M::CreateProgram(ShaderHandle hVertex, ShaderHandle hFragment)
 //==============================================================================
 void M::Release(ProgramHandle h)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::ReleaseProgram, h);
+  sContext->GetStream().WriteCommand(Command::ReleaseProgram, h);
 }
 
 //==============================================================================
 void M::Clear(FlagType flags, Color const& color, float depth, uint8_t stencil)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::Clear,
+  sContext->GetStream().WriteCommand(Command::Clear,
     ClearMessage{ flags, color, depth, stencil });
 }
 
 //==============================================================================
 void M::SetViewport(Rect const& rect)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::SetViewport, rect);
+  sContext->GetStream().WriteCommand(Command::SetViewport, rect);
 }
 
 //==============================================================================
@@ -1123,7 +2109,7 @@ void M::SetScissor(Rect const* rect)
 
   if (!rect || rectCopy)
   {
-    sContext->GetActiveQueue().WriteCommand(Command::SetViewport, rectCopy);
+    sContext->GetStream().WriteCommand(Command::SetViewport, rectCopy);
   }
 }
 
@@ -1137,53 +2123,62 @@ void M::SetUniform(UniformHandle h, uint8_t numElems, void const* data)
   }
   Buffer buffer = { byteSize, CopyBuffer(Buffer{ byteSize,
     reinterpret_cast<uint8_t const*>(data) }) };
-  sContext->GetActiveQueue().WriteCommand(Command::SetUniform,
+  sContext->GetStream().WriteCommand(Command::SetUniform,
     SetUniformMessage{ h, buffer });
 }
 
 //==============================================================================
 void M::SetTexture(TextureHandle h, uint8_t stage)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::SetTexture,
+  sContext->GetStream().WriteCommand(Command::SetTexture,
     SetTextureMessage{ h, stage });
 }
 
 //==============================================================================
 void M::SetState(FlagType flags)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::SetState, flags);
+  sContext->GetStream().WriteCommand(Command::SetState, flags);
 }
 
 //==============================================================================
 void M::SetStencilState(FlagType front, FlagType back)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::SetStencilState,
+  sContext->GetStream().WriteCommand(Command::SetStencilState,
     SetStencilStateMessage{ front, back });
 }
 
 //==============================================================================
 void M::SetInstanceData(InstanceDataBufferHandle h, uint32_t offset, uint32_t count)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::SetInstanceData,
+  sContext->GetStream().WriteCommand(Command::SetInstanceData,
     SetInstanceDataMessage{ h, offset, count });
 }
 
 //==============================================================================
 void M::SetProgram(ProgramHandle h)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::SetProgram, h);
+  sContext->GetStream().WriteCommand(Command::SetProgram, h);
 }
 
 //==============================================================================
 void M::SetFrameBuffer(FrameBufferHandle h)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::SetFrameBuffer, h);
+  sContext->GetStream().WriteCommand(Command::SetFrameBuffer, h);
+}
+
+//==============================================================================
+void M::SetSortDepth(uint16_t depth)
+{
+  if (sContext->IsSortingDraws())
+  {
+    sContext->GetStream().WriteCommand(Command::SetSortDepth, depth);
+  }
 }
 
 //==============================================================================
 void M::Draw(VertexBufferHandle vbh, Primitive pt, uint32_t offset, uint32_t count)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::Draw,
+  sContext->GetStream().WriteCommand(Command::Draw,
     DrawMessage{ vbh, pt, offset, count });
 }
 
@@ -1191,14 +2186,14 @@ void M::Draw(VertexBufferHandle vbh, Primitive pt, uint32_t offset, uint32_t cou
 void M::Draw(VertexBufferHandle vbh, IndexBufferHandle ibh, Primitive pt,
   uint32_t offset, uint32_t count)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::DrawIndexed,
+  sContext->GetStream().WriteCommand(Command::DrawIndexed,
     DrawIndexedMessage{ vbh, ibh, pt, offset, count });
 }
 
 //==============================================================================
 void M::Flush()
 {
-  sContext->GetActiveQueue().WriteCommand(Command::Flush);
+  sContext->GetStream().WriteCommand(Command::Flush);
   Core::OnFlush();
 
   sContext->SubmitCommands();
@@ -1207,7 +2202,7 @@ void M::Flush()
 //==============================================================================
 void M::Present(bool resetState)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::Present, resetState);
+  sContext->GetStream().WriteCommand(Command::Present, resetState);
   Core::OnFlush();
 
   sContext->SubmitCommands();
@@ -1218,12 +2213,36 @@ void M::ReadFrameBuffer(Px x, Px y, Px width, Px height,
   TextureFormat format, uint8_t colorAttachment, void* mem,
   ReadFrameBufferCompleteCallback* onComplete)
 {
-  sContext->GetActiveQueue().WriteCommand(Command::ReadFrameBuffer,
+  sContext->GetStream().WriteCommand(Command::ReadFrameBuffer,
     ReadFrameBufferMessage{ x, y, width, height, format, colorAttachment, mem,
       onComplete });
   sContext->SubmitCommands();
 }
 
+//==============================================================================
+CommandListHandle M::ReserveCommandList()
+{
+  return sContext->ReserveCommandList();
+}
+
+//==============================================================================
+void M::BeginCommandList(CommandListHandle h)
+{
+  sContext->BeginCommandList(h);
+}
+
+//==============================================================================
+void M::EndCommandList()
+{
+  sContext->EndCommandList();
+}
+
+//==============================================================================
+FrameStats M::GetFrameStats()
+{
+  return sContext->GetFrameStats();
+}
+
 //==============================================================================
 Signal<void>& M::FlushSignal()
 {
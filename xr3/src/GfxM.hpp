@@ -24,14 +24,23 @@ class M // Multi-threaded API.
   XR_NONOBJECT_DECL(M)
 
 public: // static
+  ///@param messageBufferSize The size of the pages that commands are recorded
+  /// into. Further pages are chained on as needed.
+  ///@param numQueues The number of command queues to cycle through, i.e. one
+  /// more than the number of submissions that may be in flight before
+  /// recording blocks. Must be at least 2.
+  ///@param sortDraws Whether to sort draws and eliminate redundant state
+  /// commands before replaying them on the render thread.
   static void Init(Context* context, ResourceManager* resources,
-    uint32_t messageBufferSize);
+    uint32_t messageBufferSize, uint32_t numQueues, bool sortDraws);
 
   static VertexFormatHandle RegisterVertexFormat(VertexFormat const& format);
   static void Release(VertexFormatHandle h);
 
   static VertexBufferHandle CreateVertexBuffer(VertexFormatHandle hFormat,
     Buffer const& buffer, FlagType flags);
+  static void UpdateVertexBuffer(VertexBufferHandle h, uint32_t offset,
+    Buffer const& buffer);
   static void Release(VertexBufferHandle h);
 
   static IndexBufferHandle CreateIndexBuffer(Buffer const& buffer, FlagType flags);
@@ -44,6 +53,8 @@ public: // static
   static TextureHandle CreateTexture(TextureFormat format, Px width,
     Px height, Px depth, FlagType flags, Buffer const* buffers,
     uint8_t numBuffers);
+  static void UpdateTexture(TextureHandle h, Px x, Px y, Px width, Px height,
+    Buffer const& buffer);
   static TextureInfo GetTextureInfo(TextureHandle h);
   static void Release(TextureHandle h);
 
@@ -75,6 +86,7 @@ public: // static
   static void SetInstanceData(InstanceDataBufferHandle h, uint32_t offset, uint32_t count);
   static void SetProgram(ProgramHandle h);
   static void SetFrameBuffer(FrameBufferHandle h);
+  static void SetSortDepth(uint16_t depth);
 
   static void Draw(VertexBufferHandle vbh, Primitive pt, uint32_t offset, uint32_t count);
   static void Draw(VertexBufferHandle vbh, IndexBufferHandle ibh, Primitive pt,
@@ -86,6 +98,12 @@ public: // static
     TextureFormat format, uint8_t colorAttachment, void* mem,
     ReadFrameBufferCompleteCallback* onComplete);
 
+  static CommandListHandle ReserveCommandList();
+  static void BeginCommandList(CommandListHandle h);
+  static void EndCommandList();
+
+  static FrameStats GetFrameStats();
+
   static Signal<void>& FlushSignal();
   static Signal<void>& ShutdownSignal();
 
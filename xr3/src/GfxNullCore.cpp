@@ -0,0 +1,520 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "GfxNullCore.hpp"
+#include "xr/events/SignalBroadcaster.hpp"
+#include "xr/threading/Spinlock.hpp"
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+#define LTRACE(x) XR_TRACE(Gfx, x)
+
+namespace xr
+{
+namespace Gfx
+{
+namespace
+{
+
+struct NullCoreContext
+{
+  ResourceManager* mResources;
+  FrameBufferHandle mActiveFrameBuffer;
+
+  SignalBroadcaster<> mOnFlush;
+  SignalBroadcaster<> mOnShutdown;
+
+  std::atomic<bool> mRecording{ false };
+  Spinlock mRecordsLock;
+  std::vector<CommandRecord> mRecords; // guarded by mRecordsLock
+}* sContext = nullptr;
+
+void Record(CommandRecord::Type type, uint16_t id = HandleCoreCore::INVALID_ID,
+  uint32_t p0 = 0, uint32_t p1 = 0, uint32_t p2 = 0, uint32_t p3 = 0)
+{
+  if (sContext->mRecording.load(std::memory_order_relaxed))
+  {
+    std::unique_lock<Spinlock> lock(sContext->mRecordsLock);
+    sContext->mRecords.push_back(CommandRecord{ type, id, { p0, p1, p2, p3 } });
+  }
+}
+
+template <class T, class Array>
+uint16_t GetId(T const& resource, Array const& array)
+{
+  return static_cast<uint16_t>(&resource - array.data);
+}
+
+} // nonamespace
+
+//=============================================================================
+void NullCore::Init(Context* /*context*/, ResourceManager* resources)
+{
+  LTRACE(("Initialising null core..."));
+  sContext = new NullCoreContext;
+  sContext->mResources = resources;
+  XR_ASSERT(Gfx, sContext->mResources);
+
+  // default textures and framebuffer
+  auto& textures = resources->GetTextures();
+  for (auto h : { GetDefaultTexture2D(), GetDefaultTexture3D(), GetDefaultTextureCube() })
+  {
+    textures[h.id].refCount = 0;
+  }
+
+  auto& defaultFbo = resources->GetFbos()[GetDefaultFrameBuffer().id];
+  defaultFbo.numColorAttachments = 2;
+
+  sContext->mActiveFrameBuffer = GetDefaultFrameBuffer();
+}
+
+//=============================================================================
+void NullCore::Release(VertexFormatHandle h)
+{
+  Record(CommandRecord::Type::ReleaseVertexFormat, h.id);
+  sContext->mResources->Release(h);
+}
+
+//=============================================================================
+void NullCore::CreateVertexBuffer(VertexFormatHandle hFormat, Buffer const& buffer,
+  FlagType flags, VertexBufferObject& vbo)
+{
+  XR_ASSERT(Gfx, hFormat.IsValid());
+  auto& vforms = sContext->mResources->GetVertexFormats();
+  ++(vforms[hFormat.id].refCount);
+
+  vbo.hFormat = hFormat;
+  vbo.flags = flags & ~F_BUFFER_INSTANCE_DATA;
+
+  Record(CommandRecord::Type::CreateVertexBuffer,
+    GetId(vbo, sContext->mResources->GetVbos()), hFormat.id, buffer.size, flags);
+}
+
+//=============================================================================
+void NullCore::UpdateVertexBuffer(VertexBufferHandle h, uint32_t offset,
+  Buffer const& buffer)
+{
+  Record(CommandRecord::Type::UpdateVertexBuffer, h.id, offset,
+    static_cast<uint32_t>(buffer.size));
+}
+
+//=============================================================================
+void NullCore::Release(VertexBufferHandle h)
+{
+  Record(CommandRecord::Type::ReleaseVertexBuffer, h.id);
+
+  auto& vbos = sContext->mResources->GetVbos();
+  VertexBufferObject& vbo = vbos[h.id];
+  if (vbo.hFormat.IsValid())  // instance data buffers don't have this.
+  {
+    sContext->mResources->Release(vbo.hFormat);
+  }
+
+  vbo = VertexBufferObject();
+
+  vbos.server.Release(h.id);
+}
+
+//=============================================================================
+void NullCore::CreateIndexBuffer(Buffer const& buffer, FlagType flags, IndexBufferObject& ibo)
+{
+  ibo.indexSize = CheckAllMaskBits(flags, F_BUFFER_INDEX_32BITS) ? sizeof(uint32_t) : sizeof(uint16_t);
+  ibo.flags = flags;
+
+  Record(CommandRecord::Type::CreateIndexBuffer,
+    GetId(ibo, sContext->mResources->GetIbos()), buffer.size, flags);
+}
+
+//=============================================================================
+void NullCore::Release(IndexBufferHandle h)
+{
+  Record(CommandRecord::Type::ReleaseIndexBuffer, h.id);
+
+  auto& ibos = sContext->mResources->GetIbos();
+  ibos[h.id] = IndexBufferObject();
+  ibos.server.Release(h.id);
+}
+
+//=============================================================================
+void NullCore::CreateInstanceDataBuffer(Buffer const& buffer, InstanceDataStrideType stride,
+  VertexBufferObject& idbo)
+{
+  XR_ASSERT(Gfx, buffer.data);
+  XR_ASSERT(Gfx, stride <= kMaxInstanceData * sizeof(float) * 4);
+  XR_ASSERTMSG(Gfx, (stride & 0xf) == 0,
+    ("16x bytes required for stride, got: %d", stride));
+
+  idbo.hFormat = VertexFormatHandle();
+  idbo.flags = VertexBufferObject::EncodeInstanceDataStride(stride);
+
+  Record(CommandRecord::Type::CreateInstanceDataBuffer,
+    GetId(idbo, sContext->mResources->GetVbos()), buffer.size, stride);
+}
+
+//=============================================================================
+void NullCore::Release(InstanceDataBufferHandle h)
+{
+  Record(CommandRecord::Type::ReleaseInstanceDataBuffer, h.id);
+
+  auto& vbos = sContext->mResources->GetVbos();
+  vbos[h.id] = VertexBufferObject();
+  vbos.server.Release(h.id);
+}
+
+//=============================================================================
+void NullCore::CreateTexture(Buffer const* /*buffers*/, uint8_t numBuffers, TextureRef& tr)
+{
+  tr.refCount = 1;
+
+  auto const& info = tr.inst.info;
+  Record(CommandRecord::Type::CreateTexture,
+    GetId(tr, sContext->mResources->GetTextures()), info.width, info.height,
+    numBuffers, info.flags);
+}
+
+//=============================================================================
+void NullCore::UpdateTexture(TextureHandle h, Px x, Px y, Px width, Px height,
+  Buffer const& /*buffer*/)
+{
+  Record(CommandRecord::Type::UpdateTexture, h.id, x, y, width, height);
+}
+
+//=============================================================================
+void NullCore::Release(TextureHandle h)
+{
+  Record(CommandRecord::Type::ReleaseTexture, h.id);
+
+  auto& textures = sContext->mResources->GetTextures();
+  TextureRef& texture = textures[h.id];
+  XR_ASSERT(Gfx, texture.refCount > 0);
+  --texture.refCount;
+  if (texture.refCount == 0)
+  {
+    texture.inst = Texture();
+    textures.server.Release(h.id);
+  }
+}
+
+//=============================================================================
+bool NullCore::CreateFrameBuffer(TextureFormat format, Px width, Px height,
+  FlagType flags, FrameBufferObject& fbo)
+{
+  // Unlike GLCore, which goes through Gfx::CreateTexture(), we create the
+  // texture directly, since we may be on the render thread - which holds the
+  // resource lock already.
+  auto& textures = sContext->mResources->GetTextures();
+  TextureHandle h{ static_cast<uint16_t>(textures.server.Acquire()) };
+
+  auto& tr = textures[h.id];
+  tr.inst.info = TextureInfo{ format, width, height, 0,
+    TextureInfo::CalculateMipLevels(width, height, flags), flags };
+  CreateTexture(nullptr, 0, tr);
+
+  return CreateFrameBuffer(1, &h, true, fbo);
+}
+
+//=============================================================================
+bool NullCore::CreateFrameBuffer(uint8_t textureCount, TextureHandle const* hTextures,
+  bool ownTextures, FrameBufferObject& fbo)
+{
+  XR_ASSERT(Gfx, textureCount < XR_ARRAY_SIZE(FrameBufferObject::hTextures));
+  FrameBufferAttachment attachments[XR_ARRAY_SIZE(FrameBufferObject::hTextures)];
+  for (uint8_t i = 0; i < textureCount; ++i)
+  {
+    attachments[i] = FrameBufferAttachment{ hTextures[i], 0, 0 };
+  }
+  return CreateFrameBuffer(textureCount, attachments, ownTextures, fbo);
+}
+
+//=============================================================================
+bool NullCore::CreateFrameBuffer(uint8_t textureCount, FrameBufferAttachment const* attachments,
+  bool ownTextures, FrameBufferObject& fbo)
+{
+  XR_ASSERT(Gfx, textureCount < XR_ARRAY_SIZE(FrameBufferObject::hTextures));
+
+  fbo.numTextures = textureCount;
+  uint8_t numColorAttachments = 0;
+  auto& textures = sContext->mResources->GetTextures();
+  for (uint8_t i = 0; i < textureCount; ++i)
+  {
+    FrameBufferAttachment const& att = attachments[i];
+    fbo.hTextures[i] = att.hTexture;
+
+    TextureRef& texture = textures[att.hTexture.id];
+    XR_ASSERT(Gfx, texture.inst.info.format != TextureFormat::kCount);
+    numColorAttachments += texture.inst.info.format < TextureFormat::D32;
+
+    if (!ownTextures)
+    {
+      ++texture.refCount;
+    }
+  }
+  fbo.numColorAttachments = numColorAttachments;
+
+  Record(CommandRecord::Type::CreateFrameBuffer,
+    GetId(fbo, sContext->mResources->GetFbos()), textureCount, ownTextures);
+  return true;
+}
+
+//=============================================================================
+void NullCore::Release(FrameBufferHandle h)
+{
+  Record(CommandRecord::Type::ReleaseFrameBuffer, h.id);
+
+  auto& fbos = sContext->mResources->GetFbos();
+  FrameBufferObject& fbo = fbos[h.id];
+  for (uint8_t i = 0; i < fbo.numTextures; ++i)
+  {
+    Release(fbo.hTextures[i]);
+  }
+  fbo = FrameBufferObject();
+
+  fbos.server.Release(h.id);
+
+  if (h == sContext->mActiveFrameBuffer)
+  {
+    sContext->mActiveFrameBuffer.Invalidate();
+  }
+}
+
+//=============================================================================
+bool NullCore::CreateShader(ShaderType type, Buffer const& buffer, ShaderRef& sr)
+{
+  sr.inst.type = type;
+  sr.refCount = 1;
+
+  Record(CommandRecord::Type::CreateShader,
+    GetId(sr, sContext->mResources->GetShaders()), uint32_t(type), buffer.size);
+  return true;
+}
+
+//=============================================================================
+void NullCore::Release(ShaderHandle h)
+{
+  Record(CommandRecord::Type::ReleaseShader, h.id);
+
+  auto& shaders = sContext->mResources->GetShaders();
+  ShaderRef& sr = shaders[h.id];
+  XR_ASSERT(Gfx, sr.refCount > 0);
+  --sr.refCount;
+  if (sr.refCount == 0)
+  {
+    sr.inst = Shader();
+    shaders.server.Release(h.id);
+  }
+}
+
+//=============================================================================
+bool NullCore::CreateProgram(ShaderHandle hVertex, ShaderHandle hFragment, Program& program)
+{
+  auto& shaders = sContext->mResources->GetShaders();
+  ++shaders[hVertex.id].refCount;
+  ++shaders[hFragment.id].refCount;
+
+  program.hVertex = hVertex;
+  program.hFragment = hFragment;
+  program.linked = true;
+
+  Record(CommandRecord::Type::CreateProgram,
+    GetId(program, sContext->mResources->GetPrograms()), hVertex.id, hFragment.id);
+  return true;
+}
+
+//=============================================================================
+void NullCore::Release(ProgramHandle h)
+{
+  Record(CommandRecord::Type::ReleaseProgram, h.id);
+
+  auto& programs = sContext->mResources->GetPrograms();
+  Program& p = programs[h.id];
+  p.linked = false;
+
+  if (p.hVertex.IsValid())
+  {
+    Release(p.hVertex);
+    p.hVertex.Invalidate();
+  }
+
+  if (p.hFragment.IsValid())
+  {
+    Release(p.hFragment);
+    p.hFragment.Invalidate();
+  }
+
+  programs.server.Release(h.id);
+}
+
+//=============================================================================
+void NullCore::Clear(FlagType flags, Color const& /*color*/, float /*depth*/, uint8_t stencil)
+{
+  Record(CommandRecord::Type::Clear, HandleCoreCore::INVALID_ID, flags, stencil);
+}
+
+//=============================================================================
+void NullCore::SetViewport(Rect const& rect)
+{
+  Record(CommandRecord::Type::SetViewport, HandleCoreCore::INVALID_ID,
+    rect.x, rect.y, rect.w, rect.h);
+}
+
+//=============================================================================
+void NullCore::SetScissor(Rect const* rect)
+{
+  if (rect)
+  {
+    Record(CommandRecord::Type::SetScissor, HandleCoreCore::INVALID_ID,
+      rect->x, rect->y, rect->w, rect->h);
+  }
+  else
+  {
+    Record(CommandRecord::Type::SetScissor);
+  }
+}
+
+//=============================================================================
+void NullCore::SetUniform(UniformHandle h, Buffer const& buffer)
+{
+  auto uniformData = sContext->mResources->GetUniformData();
+  std::memcpy(uniformData[h.id], buffer.data, buffer.size);
+
+  Record(CommandRecord::Type::SetUniform, h.id, buffer.size);
+}
+
+//=============================================================================
+void NullCore::SetTexture(TextureHandle h, uint8_t stage)
+{
+  Record(CommandRecord::Type::SetTexture, h.id, stage);
+}
+
+//=============================================================================
+void NullCore::SetState(FlagType flags)
+{
+  Record(CommandRecord::Type::SetState, HandleCoreCore::INVALID_ID, flags);
+}
+
+//=============================================================================
+void NullCore::SetStencilState(FlagType front, FlagType back)
+{
+  Record(CommandRecord::Type::SetStencilState, HandleCoreCore::INVALID_ID, front, back);
+}
+
+//=============================================================================
+void NullCore::SetInstanceData(InstanceDataBufferHandle h, uint32_t offset, uint32_t count)
+{
+  Record(CommandRecord::Type::SetInstanceData, h.id, offset, count);
+}
+
+//=============================================================================
+void NullCore::SetProgram(ProgramHandle h)
+{
+  Record(CommandRecord::Type::SetProgram, h.id);
+}
+
+//=============================================================================
+void NullCore::SetFrameBuffer(FrameBufferHandle h)
+{
+  sContext->mActiveFrameBuffer = h;
+  Record(CommandRecord::Type::SetFrameBuffer, h.id);
+}
+
+//=============================================================================
+void NullCore::Draw(VertexBufferHandle vbh, Primitive pt, uint32_t offset, uint32_t count)
+{
+  Record(CommandRecord::Type::Draw, vbh.id, uint32_t(pt), offset, count);
+}
+
+//=============================================================================
+void NullCore::Draw(VertexBufferHandle vbh, IndexBufferHandle ibh, Primitive pt,
+  uint32_t offset, uint32_t count)
+{
+  Record(CommandRecord::Type::DrawIndexed, vbh.id, ibh.id, uint32_t(pt), offset, count);
+}
+
+//=============================================================================
+void NullCore::Flush()
+{
+  Record(CommandRecord::Type::Flush);
+}
+
+//=============================================================================
+void NullCore::Present(bool resetState)
+{
+  Record(CommandRecord::Type::Present, HandleCoreCore::INVALID_ID, resetState);
+}
+
+//=============================================================================
+void NullCore::ReadFrameBuffer(Px x, Px y, Px width, Px height,
+  TextureFormat /*format*/, uint8_t colorAttachment, void* mem,
+  ReadFrameBufferCompleteCallback* onComplete)
+{
+  XR_ASSERT(Gfx, sContext->mActiveFrameBuffer.IsValid());
+  XR_ASSERT(Gfx, colorAttachment < sContext->mResources->
+    GetFbos()[sContext->mActiveFrameBuffer.id].numColorAttachments);
+  (void)colorAttachment;
+  Record(CommandRecord::Type::ReadFrameBuffer, sContext->mActiveFrameBuffer.id,
+    x, y, width, height);
+
+  if (onComplete)
+  {
+    onComplete->Call(mem);
+  }
+}
+
+//=============================================================================
+Signal<void>& NullCore::FlushSignal()
+{
+  return sContext->mOnFlush;
+}
+
+//=============================================================================
+void NullCore::OnFlush()
+{
+  sContext->mOnFlush.Broadcast();
+}
+
+//=============================================================================
+Signal<void>& NullCore::ShutdownSignal()
+{
+  return sContext->mOnShutdown;
+}
+
+//=============================================================================
+void NullCore::OnShutdown()
+{
+  sContext->mOnShutdown.Broadcast();
+}
+
+//=============================================================================
+void NullCore::Shutdown()
+{
+  LTRACE(("Shutting down null core."));
+  delete sContext;
+  sContext = nullptr;
+}
+
+//=============================================================================
+void NullCore::StartRecording()
+{
+  std::unique_lock<Spinlock> lock(sContext->mRecordsLock);
+  sContext->mRecords.clear();
+  sContext->mRecording.store(true, std::memory_order_relaxed);
+}
+
+//=============================================================================
+std::vector<CommandRecord> NullCore::StopRecording()
+{
+  std::vector<CommandRecord> records;
+  std::unique_lock<Spinlock> lock(sContext->mRecordsLock);
+  sContext->mRecording.store(false, std::memory_order_relaxed);
+  records.swap(sContext->mRecords);
+  return records;
+}
+
+} // Gfx
+}
@@ -20,6 +20,11 @@ namespace
 
 ResourceManager* sResources = nullptr;
 
+// Only the upload of texel and vertex data is tracked; there's no command
+// stream.
+FrameStats sCurrentStats{};
+FrameStats sLastStats{};
+
 } // nonamespace
 
 //=============================================================================
@@ -49,9 +54,18 @@ VertexBufferHandle S::CreateVertexBuffer(VertexFormatHandle hFormat, Buffer cons
   auto& vbos = sResources->GetVbos();
   VertexBufferHandle h{ static_cast<uint16_t>(vbos.server.Acquire()) };
   Core::CreateVertexBuffer(hFormat, buffer, flags, vbos[h.id]);
+  sCurrentStats.numVertexUploadBytes += static_cast<uint32_t>(buffer.size);
   return h;
 }
 
+//=============================================================================
+void S::UpdateVertexBuffer(VertexBufferHandle h, uint32_t offset,
+  Buffer const& buffer)
+{
+  Core::UpdateVertexBuffer(h, offset, buffer);
+  sCurrentStats.numVertexUploadBytes += static_cast<uint32_t>(buffer.size);
+}
+
 //=============================================================================
 void S::Release(VertexBufferHandle h)
 {
@@ -102,9 +116,22 @@ TextureHandle S::CreateTexture(TextureFormat format, Px width,
   ref.inst.info = TextureInfo{ format, width, height, depth,
     TextureInfo::CalculateMipLevels(width, height, flags), flags };
   Core::CreateTexture(buffers, numBuffers, ref);
+
+  for (auto i = buffers, iEnd = i + numBuffers; i != iEnd; ++i)
+  {
+    sCurrentStats.numTextureUploadBytes += static_cast<uint32_t>(i->size);
+  }
   return h;
 }
 
+//=============================================================================
+void S::UpdateTexture(TextureHandle h, Px x, Px y, Px width, Px height,
+  Buffer const& buffer)
+{
+  Core::UpdateTexture(h, x, y, width, height, buffer);
+  sCurrentStats.numTextureUploadBytes += static_cast<uint32_t>(buffer.size);
+}
+
 //=============================================================================
 TextureInfo S::GetTextureInfo(TextureHandle h)
 {
@@ -307,6 +334,9 @@ void S::Present(bool resetState)
 {
   Core::Present(resetState);
   Core::OnFlush();
+
+  sLastStats = sCurrentStats;
+  sCurrentStats = FrameStats{};
 }
 
 //=============================================================================
@@ -318,6 +348,12 @@ void S::ReadFrameBuffer(Px x, Px y, Px width, Px height,
   delete onComplete;
 }
 
+//==============================================================================
+FrameStats S::GetFrameStats()
+{
+  return sLastStats;
+}
+
 //==============================================================================
 Signal<void>& S::FlushSignal()
 {
@@ -335,6 +371,9 @@ void S::Shutdown()
 {
   Core::OnShutdown();
   Core::Shutdown();
+
+  sCurrentStats = FrameStats{};
+  sLastStats = FrameStats{};
 }
 
 } // Gfx
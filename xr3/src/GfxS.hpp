@@ -31,6 +31,8 @@ public: // static
 
   static VertexBufferHandle CreateVertexBuffer(VertexFormatHandle hFormat,
     Buffer const& buffer, FlagType flags);
+  static void UpdateVertexBuffer(VertexBufferHandle h, uint32_t offset,
+    Buffer const& buffer);
   static void Release(VertexBufferHandle h);
 
   static IndexBufferHandle CreateIndexBuffer(Buffer const& buffer, FlagType flags);
@@ -43,6 +45,8 @@ public: // static
   static TextureHandle CreateTexture(TextureFormat format, Px width,
     Px height, Px depth, FlagType flags, Buffer const* buffers,
     uint8_t numBuffers);
+  static void UpdateTexture(TextureHandle h, Px x, Px y, Px width, Px height,
+    Buffer const& buffer);
   static TextureInfo GetTextureInfo(TextureHandle h);
   static void Release(TextureHandle h);
 
@@ -85,6 +89,8 @@ public: // static
     Px height, TextureFormat format, uint8_t colorAttachment, void* mem,
     ReadFrameBufferCompleteCallback* onComplete);
 
+  static FrameStats GetFrameStats();
+
   static Signal<void>& FlushSignal();
   static Signal<void>& ShutdownSignal();
 
@@ -0,0 +1,388 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "SdfBuilder.hpp"
+#include "xr/math/mathutils.hpp"
+#include "xr/debug.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace xr
+{
+namespace
+{
+
+// Marks the absence of a border point; large enough for any distance, with
+// room to grow.
+const int32_t kNoBorder = 1 << 30;
+
+bool IsBorder(uint8_t const* pixel, Px pitch)
+{
+  const auto value = *pixel;
+  return *(pixel - 1) != value || *(pixel + 1) != value ||
+    *(pixel + pitch) != value || *(pixel - pitch) != value;
+}
+
+}
+
+//==============================================================================
+SdfBuilder::SdfBuilder(Px bitmapSize, Px fieldSize, Method method)
+: m_bitmapSize(bitmapSize + 2),  // pad by 1 pixel each side
+  m_bitmapSizeUnpadded(bitmapSize),
+  m_method(method),
+  m_distances(m_bitmapSize * m_bitmapSize, .0f),
+  m_fieldSize(static_cast<float>(fieldSize))
+{
+  if (method == Method::Exact)
+  {
+    m_columnDistances.resize(bitmapSize * bitmapSize);
+    m_parabolaPositions.resize(bitmapSize);
+    m_parabolaHeights.resize(bitmapSize);
+    m_parabolaBounds.resize(bitmapSize);
+  }
+  else
+  {
+    m_points.resize(m_distances.size());
+  }
+}
+
+//==============================================================================
+void SdfBuilder::Generate(uint8_t const* srcPixels, Px srcPitch, Px w, Px h)
+{
+  XR_ASSERT(SdfBuilder, w <= m_bitmapSizeUnpadded);
+  XR_ASSERT(SdfBuilder, h <= m_bitmapSizeUnpadded);
+  if (w == 0 || h == 0)
+  {
+    return;
+  }
+
+  if (m_method == Method::Exact)
+  {
+    GenerateExact(srcPixels, srcPitch, w, h);
+  }
+  else
+  {
+    GeneratePropagation(srcPixels, srcPitch, w, h);
+  }
+
+  // Scale distance field values into the -127, 128 range, clamping them first
+  // to the -fieldSize, fieldSize range. This is to eliminate minification
+  // artifacts.
+  const auto rowDiff = m_bitmapSize - w;
+  const auto srcRowDiff = srcPitch - w;
+  const float scale = m_fieldSize;
+  float* d = m_distances.data() + m_bitmapSize + 1;
+  auto iSrc = srcPixels;
+  for (decltype(h) y = 0; y < h; ++y)
+  {
+    for (decltype(w) x = 0; x < w; ++x)
+    {
+      if (*iSrc == 0)
+      {
+        *d = -*d;
+      }
+
+      const float dist = Clamp(*d, -scale, scale) * (128.0f / scale);
+      *d = Clamp(dist, -127.0f, 128.0f);
+      ++d;
+      ++iSrc;
+    }
+    iSrc += srcRowDiff;
+    d += rowDiff;
+  }
+}
+
+//==============================================================================
+void SdfBuilder::ConvertToBitmap(Px w, Px h, uint8_t* buffer) const
+{
+  XR_ASSERT(SdfBuilder, w <= m_bitmapSizeUnpadded);
+  XR_ASSERT(SdfBuilder, h <= m_bitmapSizeUnpadded);
+  float const* d = m_distances.data() + m_bitmapSize + 1;
+  for (Px y = 0; y < h; ++y)
+  {
+    for (Px x = 0; x < w; ++x)
+    {
+      float value = d[x + m_bitmapSize * y] + 127.0f;
+      buffer[x + w * y] = uint8_t(value);
+    }
+  }
+}
+
+//==============================================================================
+void SdfBuilder::GeneratePropagation(uint8_t const* srcPixels, Px srcPitch, Px w, Px h)
+{
+  const auto rowSizePadded = m_bitmapSize;
+
+  // Clear buffers.
+  std::fill(m_points.begin(), m_points.end(), Point{ Px(-1), Px(-1) });
+  std::fill(m_distances.begin(), m_distances.end(), std::numeric_limits<float>::max());
+
+  const size_t idxBegin = rowSizePadded + 1; // index of first useful pixel.
+  Point* p = m_points.data() + idxBegin;
+  float* d = m_distances.data() + idxBegin;
+
+  // Find border points - points whose value is different from that of its
+  // neighbours. Set their distance to 0.
+  auto iSrc = srcPixels;
+  const auto rowDiff = rowSizePadded - w;
+  const auto srcRowDiff = srcPitch - w;
+  for (decltype(h) y = 0; y < h; ++y)
+  {
+    auto p0 = p;
+    auto p1 = p + w;
+    while (p != p1)
+    {
+      if (IsBorder(iSrc, srcPitch))
+      {
+        *d = .0f;
+        *p = { Px(p - p0), y };
+      }
+      ++d;
+      ++p;
+      ++iSrc;
+    }
+    p += rowDiff;
+    d += rowDiff;
+    iSrc += srcRowDiff;
+  }
+
+  // Calculate distances from closest border point. Once the neighbour of
+  // a border point was found, this closest point will propagate, creating
+  // the distance field. For this to happen, however, we will need two
+  // passes, the first one of which will check left and above.
+  const float d1 = 1.0f;
+  const float d2 = sqrtf(2.0f);
+  p = m_points.data() + idxBegin;
+  d = m_distances.data() + idxBegin;
+  for (decltype(h) y = 0; y < h; ++y)
+  {
+    for (decltype(w) x = 0; x < w; ++x)
+    {
+      ptrdiff_t offset = -(static_cast<int32_t>(rowSizePadded) + 1); // top left
+      if (*(d + offset) + d2 < *d)
+      {
+        auto b = *(p + offset);
+        int dx = x - b.x;
+        int dy = y - b.y;
+        *d = std::sqrt(float(dx * dx + dy * dy));
+        *p = b;
+      }
+
+      offset = -static_cast<int32_t>(rowSizePadded); // above
+      if (*(d + offset) + d1 < *d)
+      {
+        auto b = *(p + offset);
+        int dx = x - b.x;
+        int dy = y - b.y;
+        *d = std::sqrt(float(dx * dx + dy * dy));
+        *p = b;
+      }
+
+      offset = -static_cast<int32_t>(rowSizePadded - 1); // top right
+      if (*(d + offset) + d2 < *d)
+      {
+        auto b = *(p + offset);
+        int dx = x - b.x;
+        int dy = y - b.y;
+        *d = std::sqrt(float(dx * dx + dy * dy));
+        *p = b;
+      }
+
+      offset = -1;  // left
+      if (*(d + offset) + d1 < *d)
+      {
+        auto b = *(p + offset);
+        int dx = x - b.x;
+        int dy = y - b.y;
+        *d = std::sqrt(float(dx * dx + dy * dy));
+        *p = b;
+      }
+
+      ++p;
+      ++d;
+    }
+    p += rowDiff;
+    d += rowDiff;
+  }
+
+  // Second pass, check bottom and right, starting from bottom right corner.
+  const Px wLess1 = w - 1;
+  const Px hLess1 = h - 1;
+  auto idxEnd = idxBegin + wLess1 + hLess1 * rowSizePadded;
+  p = m_points.data() + idxEnd;
+  d = m_distances.data() + idxEnd;
+  for (Px y = hLess1;; --y)
+  {
+    for (Px x = wLess1;; --x)
+    {
+      int offset = 1; // right
+      if (*(d + offset) + d1 < *d)
+      {
+        const auto b = *(p + offset);
+        const int dx = x - b.x;
+        const int dy = y - b.y;
+        *d = std::sqrt(float(dx * dx + dy * dy));
+        *p = b;
+      }
+
+      offset = static_cast<int32_t>(rowSizePadded - 1);  // bottom left
+      if (*(d + offset) + d2 < *d)
+      {
+        const auto b = *(p + offset);
+        const int dx = x - b.x;
+        const int dy = y - b.y;
+        *d = std::sqrt(float(dx * dx + dy * dy));
+        *p = b;
+      }
+
+      offset = static_cast<int32_t>(rowSizePadded);  // below
+      if (*(d + offset) + d1 < *d)
+      {
+        const auto b = *(p + offset);
+        const int dx = x - b.x;
+        const int dy = y - b.y;
+        *d = std::sqrt(float(dx * dx + dy * dy));
+        *p = b;
+      }
+
+      offset = static_cast<int32_t>(rowSizePadded + 1);  // bottom right
+      if (*(d + offset) + d2 < *d)
+      {
+        const auto b = *(p + offset);
+        const int dx = x - b.x;
+        const int dy = y - b.y;
+        *d = std::sqrt(float(dx * dx + dy * dy));
+        *p = b;
+      }
+
+      --p;
+      --d;
+
+      if (x == 0)
+      {
+        break;
+      }
+    }
+
+    p -= rowDiff;
+    d -= rowDiff;
+
+    if (y == 0)
+    {
+      break;
+    }
+  }
+}
+
+//==============================================================================
+void SdfBuilder::GenerateExact(uint8_t const* srcPixels, Px srcPitch, Px w, Px h)
+{
+  // Find border points, and the distance of each pixel from the closest one
+  // in the same column, above, then below. Both passes go along rows, so that
+  // all columns are processed at once.
+  int32_t* columnDistances = m_columnDistances.data();
+  int32_t* row = columnDistances;
+  int32_t const* rowAbove = nullptr;
+  auto iSrc = srcPixels;
+  for (int32_t y = 0; y < h; ++y)
+  {
+    for (int32_t x = 0; x < w; ++x)
+    {
+      row[x] = IsBorder(iSrc + x, srcPitch) ? 0 :
+        (rowAbove ? rowAbove[x] + 1 : kNoBorder);
+    }
+    rowAbove = row;
+    row += w;
+    iSrc += srcPitch;
+  }
+
+  for (int32_t y = h - 2; y >= 0; --y)
+  {
+    row = columnDistances + y * w;
+    int32_t const* rowBelow = row + w;
+    for (int32_t x = 0; x < w; ++x)
+    {
+      row[x] = std::min(row[x], rowBelow[x] + 1);
+    }
+  }
+
+  // For each row, find the lower envelope of the parabolas rooted at each
+  // column, whose height is the squared distance of the closest border point
+  // in the column (see Felzenszwalb & Huttenlocher: Distance Transforms of
+  // Sampled Functions). The envelope then gives the squared distance of the
+  // closest border point to each pixel in the row.
+  // Distances are clamped to the field size, so columns whose border point
+  // is at least as far are left out, and so is the calculation of distances
+  // that are.
+  const int32_t cutoff = static_cast<int32_t>(m_fieldSize);
+  const int64_t cutoffSqr = int64_t(cutoff) * cutoff;
+  int32_t* positions = m_parabolaPositions.data();
+  int64_t* heights = m_parabolaHeights.data();
+  double* bounds = m_parabolaBounds.data();
+  float* d = m_distances.data() + m_bitmapSize + 1;
+  row = columnDistances;
+  for (int32_t y = 0; y < h; ++y)
+  {
+    int32_t k = -1; // the last parabola of the envelope.
+    for (int32_t q = 0; q < w; ++q)
+    {
+      if (row[q] >= cutoff)
+      {
+        continue;
+      }
+
+      const int64_t height = int64_t(row[q]) * row[q];
+      double bound = -std::numeric_limits<double>::infinity();
+      while (k >= 0)
+      {
+        // Where does q's parabola get lower than the last one's?
+        const int64_t p = positions[k];
+        bound = double((height + int64_t(q) * q) - (heights[k] + p * p)) / double(2 * (q - p));
+        if (bound > bounds[k])
+        {
+          break;
+        }
+
+        // The last parabola is nowhere the lowest; drop it.
+        --k;
+        bound = -std::numeric_limits<double>::infinity();
+      }
+
+      ++k;
+      positions[k] = q;
+      heights[k] = height;
+      bounds[k] = bound;
+    }
+
+    if (k < 0)
+    {
+      std::fill(d, d + w, m_fieldSize);
+    }
+    else
+    {
+      int32_t j = 0;
+      for (int32_t x = 0; x < w; ++x)
+      {
+        while (j < k && bounds[j + 1] < x)
+        {
+          ++j;
+        }
+
+        const int64_t dx = x - positions[j];
+        const int64_t dSqr = dx * dx + heights[j];
+        d[x] = dSqr < cutoffSqr ? std::sqrt(float(dSqr)) : m_fieldSize;
+      }
+    }
+
+    row += w;
+    d += m_bitmapSize;
+  }
+}
+
+}
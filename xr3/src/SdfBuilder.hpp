@@ -9,9 +9,8 @@
 // License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
 //
 //==============================================================================
-#include "xr/debug.hpp"
-#include "xr/math/mathutils.hpp"
 #include "xr/Px.hpp"
+#include "xr/types/fundamentals.hpp"
 #include <vector>
 #include <cstdint>
 
@@ -19,240 +18,65 @@ namespace xr
 {
 
 //==============================================================================
-// Generates Signed Distance Field from 8-bit monochrome bitmaps.
+///@brief Generates Signed Distance Field from 8-bit monochrome bitmaps. The
+/// distances are measured from border pixels, whose value differs from that
+/// of any of their 4 neighbours.
+///@note An instance holds the scratch memory for the generation of one field
+/// at a time; use one per thread.
 class SdfBuilder
 {
+  XR_NONCOPY_DECL(SdfBuilder)
+
 public:
+  // types
+  enum class Method
+  {
+    Propagation,  // approximate; propagates the closest border points to the 8 neighbours, in two passes.
+    Exact,  // exact Euclidean distance transform, in separate passes along columns and rows.
+  };
+
   struct Point
   {
     Px x;
     Px y;
   };
 
-  SdfBuilder(Px bitmapSize, Px fieldSize)
-  : m_bitmapSize(bitmapSize + 2),  // pad by 1 pixel each side
-    m_bitmapSizeUnpadded(bitmapSize),
-    m_points(m_bitmapSize * m_bitmapSize),
-    m_distances(m_points.size(), .0f),
-    m_fieldSize(static_cast<float>(fieldSize))
-  {}
-
-  void Generate(uint8_t const* srcPixels, Px srcPitch, Px w, Px h)
-  {
-    const auto rowSizePadded = m_bitmapSize;
-    XR_ASSERT(SdfBuilder, w <= m_bitmapSizeUnpadded);
-    XR_ASSERT(SdfBuilder, h <= m_bitmapSizeUnpadded);
-
-    // Clear buffers.
-    std::fill(m_points.begin(), m_points.end(), Point{ Px(-1), Px(-1) });
-    std::fill(m_distances.begin(), m_distances.end(), std::numeric_limits<float>::max());
-
-    const size_t idxBegin = rowSizePadded + 1; // index of first useful pixel.
-    Point* p = m_points.data() + idxBegin;
-    float* d = m_distances.data() + idxBegin;
-
-    // Find border points - points whose value is different from that of its
-    // neighbours. Set their distance to 0.
-    auto iSrc = srcPixels;
-    const auto rowDiff = rowSizePadded - w;
-    const auto srcRowDiff = srcPitch - w;
-    for (decltype(h) y = 0; y < h; ++y)
-    {
-      auto p0 = p;
-      auto p1 = p + w;
-      while (p != p1)
-      {
-        auto value = *iSrc;
-        if (*(iSrc - 1) != value || *(iSrc + 1) != value ||
-          *(iSrc + srcPitch) != value || *(iSrc - srcPitch) != value)
-        {
-          *d = .0f;
-          *p = { Px(p - p0), y };
-        }
-        ++d;
-        ++p;
-        ++iSrc;
-      }
-      p += rowDiff;
-      d += rowDiff;
-      iSrc += srcRowDiff;
-    }
-
-    // Calculate distances from closest border point. Once the neighbour of
-    // a border point was found, this closest point will propagate, creating
-    // the distance field. For this to happen, however, we will need two
-    // passes, the first one of which will check left and above.
-    const float d1 = 1.0f;
-    const float d2 = sqrtf(2.0f);
-    p = m_points.data() + idxBegin;
-    d = m_distances.data() + idxBegin;
-    for (decltype(h) y = 0; y < h; ++y)
-    {
-      for (decltype(w) x = 0; x < w; ++x)
-      {
-        ptrdiff_t offset = -(static_cast<int32_t>(rowSizePadded) + 1); // top left
-        if (*(d + offset) + d2 < *d)
-        {
-          auto b = *(p + offset);
-          int dx = x - b.x;
-          int dy = y - b.y;
-          *d = std::sqrt(float(dx * dx + dy * dy));
-          *p = b;
-        }
-
-        offset = -static_cast<int32_t>(rowSizePadded); // above
-        if (*(d + offset) + d1 < *d)
-        {
-          auto b = *(p + offset);
-          int dx = x - b.x;
-          int dy = y - b.y;
-          *d = std::sqrt(float(dx * dx + dy * dy));
-          *p = b;
-        }
-
-        offset = -static_cast<int32_t>(rowSizePadded - 1); // top right
-        if (*(d + offset) + d2 < *d)
-        {
-          auto b = *(p + offset);
-          int dx = x - b.x;
-          int dy = y - b.y;
-          *d = std::sqrt(float(dx * dx + dy * dy));
-          *p = b;
-        }
-
-        offset = -1;  // left
-        if (*(d + offset) + d1 < *d)
-        {
-          auto b = *(p + offset);
-          int dx = x - b.x;
-          int dy = y - b.y;
-          *d = std::sqrt(float(dx * dx + dy * dy));
-          *p = b;
-        }
+  // structors
+  ///@brief Creates an SdfBuilder for bitmaps of up to @a bitmapSize square,
+  /// with distances clamped to @a fieldSize pixels.
+  SdfBuilder(Px bitmapSize, Px fieldSize, Method method = Method::Propagation);
 
-        ++p;
-        ++d;
-      }
-      p += rowDiff;
-      d += rowDiff;
-    }
+  // general
+  ///@brief Generates the field for @a w by @a h pixels from @a srcPixels, of
+  /// @a srcPitch bytes per row.
+  ///@note The pixels of a 1 pixel border around the area are read, i.e. it
+  /// must be padded.
+  void Generate(uint8_t const* srcPixels, Px srcPitch, Px w, Px h);
 
-    // Second pass, check bottom and right, starting from bottom right corner.
-    const Px wLess1 = w - 1;
-    const Px hLess1 = h - 1;
-    auto idxEnd = idxBegin + wLess1 + hLess1 * rowSizePadded;
-    p = m_points.data() + idxEnd;
-    d = m_distances.data() + idxEnd;
-    for (Px y = hLess1;; --y)
-    {
-      for (Px x = wLess1;; --x)
-      {
-        int offset = 1; // right
-        if (*(d + offset) + d1 < *d)
-        {
-          const auto b = *(p + offset);
-          const int dx = x - b.x;
-          const int dy = y - b.y;
-          *d = std::sqrt(float(dx * dx + dy * dy));
-          *p = b;
-        }
-
-        offset = static_cast<int32_t>(rowSizePadded - 1);  // bottom left
-        if (*(d + offset) + d2 < *d)
-        {
-          const auto b = *(p + offset);
-          const int dx = x - b.x;
-          const int dy = y - b.y;
-          *d = std::sqrt(float(dx * dx + dy * dy));
-          *p = b;
-        }
-
-        offset = static_cast<int32_t>(rowSizePadded);  // below
-        if (*(d + offset) + d1 < *d)
-        {
-          const auto b = *(p + offset);
-          const int dx = x - b.x;
-          const int dy = y - b.y;
-          *d = std::sqrt(float(dx * dx + dy * dy));
-          *p = b;
-        }
-
-        offset = static_cast<int32_t>(rowSizePadded + 1);  // bottom right
-        if (*(d + offset) + d2 < *d)
-        {
-          const auto b = *(p + offset);
-          const int dx = x - b.x;
-          const int dy = y - b.y;
-          *d = std::sqrt(float(dx * dx + dy * dy));
-          *p = b;
-        }
-
-        --p;
-        --d;
-
-        if (x == 0)
-        {
-          break;
-        }
-      }
-
-      p -= rowDiff;
-      d -= rowDiff;
-
-      if (y == 0)
-      {
-        break;
-      }
-    }
-
-    // Scale distance field values into the -127, 128 range, clamping them first
-    // to the -fieldSize, fieldSize range. This is to eliminate minification
-    // artifacts.
-    const float scale = m_fieldSize;
-    d = m_distances.data() + idxBegin;
-    iSrc = srcPixels;
-    for (decltype(h) y = 0; y < h; ++y)
-    {
-      for (decltype(w) x = 0; x < w; ++x)
-      {
-        if (*iSrc == 0)
-        {
-          *d = -*d;
-        }
-
-        const float dist = Clamp(*d, -scale, scale) * (128.0f / scale);
-        *d = Clamp(dist, -127.0f, 128.0f);
-        ++d;
-        ++iSrc;
-      }
-      iSrc += srcRowDiff;
-      d += rowDiff;
-    }
-  }
-
-  void ConvertToBitmap(Px w, Px h, uint8_t* buffer)
-  {
-    XR_ASSERT(SdfBuilder, w <= m_bitmapSizeUnpadded);
-    XR_ASSERT(SdfBuilder, h <= m_bitmapSizeUnpadded);
-    float* d = m_distances.data() + m_bitmapSize + 1;
-    for (Px y = 0; y < h; ++y)
-    {
-      for (Px x = 0; x < w; ++x)
-      {
-        float value = d[x + m_bitmapSize * y] + 127.0f;
-        buffer[x + w * y] = uint8_t(value);
-      }
-    }
-  }
+  ///@brief Writes the last generated field to @a buffer of @a w by @a h bytes,
+  /// with 127 at the border and larger values inside.
+  void ConvertToBitmap(Px w, Px h, uint8_t* buffer) const;
 
 private:
+  // data
   Px m_bitmapSize;
   Px m_bitmapSizeUnpadded;
+  Method m_method;
   std::vector<Point> m_points;
   std::vector<float> m_distances;
   float m_fieldSize;
+
+  // Exact method only.
+  std::vector<int32_t> m_columnDistances; // to the closest border point in the same column.
+  std::vector<int32_t> m_parabolaPositions;
+  std::vector<int64_t> m_parabolaHeights;
+  std::vector<double> m_parabolaBounds;  // left end of the region where a parabola is the lowest.
+
+  // internal
+  void GeneratePropagation(uint8_t const* srcPixels, Px srcPitch, Px w, Px h);
+  void GenerateExact(uint8_t const* srcPixels, Px srcPitch, Px w, Px h);
 };
 
 }
 
-#endif
+#endif  //XR_SDFBUILDER_HPP
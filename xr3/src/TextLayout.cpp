@@ -0,0 +1,221 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xr/TextLayout.hpp"
+#include "xr/meshutil.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace xr
+{
+
+namespace
+{
+
+// 16-bit indices.
+const uint32_t kMaxGlyphs = (std::numeric_limits<uint16_t>::max() + 1) /
+  Quad::Vertex::kCount;
+
+}
+
+//==============================================================================
+TextLayout::TextLayout()
+: m_firstChange(std::string::npos),
+  m_relayoutAll(true),
+  m_cacheGeneration(0),
+  m_measurement{ Vector2::Zero(), 0, {} },
+  m_stats{ 0, 0.f, 0.f },
+  m_lineGlyphStarts(1, 0)
+{}
+
+//==============================================================================
+void TextLayout::SetBoxText(BoxText const& boxText)
+{
+  XR_ASSERT(TextLayout, boxText.GetFont());
+  m_boxText = boxText;
+  m_relayoutAll = true;
+}
+
+//==============================================================================
+void TextLayout::SetText(char const* text)
+{
+  SetText(text, strlen(text));
+}
+
+//==============================================================================
+void TextLayout::SetText(char const* text, size_t numBytes)
+{
+  auto iMismatch = std::mismatch(m_text.begin(), m_text.end(), text,
+    text + numBytes);
+  const size_t firstChange = iMismatch.first - m_text.begin();
+  if (firstChange < m_text.size() || numBytes != m_text.size())
+  {
+    m_firstChange = std::min(m_firstChange, firstChange);
+    m_text.assign(text, numBytes);
+  }
+}
+
+//==============================================================================
+bool TextLayout::Update(bool updateGlyphCache)
+{
+  auto font = m_boxText.GetFont();
+  XR_ASSERT(TextLayout, font);
+  bool relayoutAll = m_relayoutAll || font->GetCacheGeneration() != m_cacheGeneration;
+  if (!relayoutAll && m_firstChange == std::string::npos)
+  {
+    return false;
+  }
+
+  auto& m = m_measurement;
+  const float lastHeight = m.size.y;
+  m_boxText.Measure(m_text.data(), m_text.size(), m);
+  if (m.numGlyphs > kMaxGlyphs)
+  {
+    // Lay out the longest start of the text that fits the index range.
+    XR_TRACE(TextLayout, ("Too many glyphs (%d) for 16-bit indices; truncating.",
+      m.numGlyphs));
+    size_t fits = 0;
+    size_t exceeds = m_text.size();
+    while (exceeds - fits > 1)
+    {
+      const size_t numBytes = fits + (exceeds - fits) / 2;
+      m_boxText.Measure(m_text.data(), numBytes, m);
+      (m.numGlyphs > kMaxGlyphs ? exceeds : fits) = numBytes;
+    }
+    m_boxText.Measure(m_text.data(), fits, m);
+  }
+
+  // Unless the text moves vertically, lines that are the same as in the last
+  // layout, and precede the first change, don't need to be generated again.
+  relayoutAll = relayoutAll || (m.size.y != lastHeight &&
+    m_boxText.GetVerticalAlignment() != BoxText::Alignment::Negative);
+
+  const auto base = m_text.data();
+  size_t firstLine = 0;
+  if (!relayoutAll)
+  {
+    const size_t numLines = std::min(m.lines.size(), m_lines.size());
+    while (firstLine < numLines)
+    {
+      auto& line = m.lines[firstLine];
+      auto& lastLine = m_lines[firstLine];
+      if (lastLine.end > m_firstChange ||
+        size_t(line.start - base) != lastLine.start ||
+        size_t(line.end - base) != lastLine.end ||
+        line.width != lastLine.width)
+      {
+        break;
+      }
+      ++firstLine;
+    }
+  }
+
+  m_lines.resize(m.lines.size());
+  for (size_t i = firstLine; i < m.lines.size(); ++i)
+  {
+    auto& line = m.lines[i];
+    m_lines[i] = Line{ size_t(line.start - base), size_t(line.end - base),
+      line.width };
+  }
+
+  // Make room for the glyphs, if we have to; the mesh is then re-created.
+  const uint32_t lastNumGlyphs = GetNumGlyphs();
+  const uint32_t capacity = uint32_t(m_vertices.size() / Quad::Vertex::kCount);
+  const bool recreateMesh = m.numGlyphs > capacity;
+  if (recreateMesh)
+  {
+    m_vertices.resize(std::max(m.numGlyphs, std::min(capacity * 2, kMaxGlyphs)) *
+      Quad::Vertex::kCount);
+    firstLine = 0;
+  }
+
+  // Generate the vertices for the lines that need it.
+  auto generate = [this, &m, updateGlyphCache](size_t fromLine) {
+    m_lineGlyphStarts.resize(m.lines.size() + 1);
+    m_lineGlyphCounts.resize(m.lines.size() - fromLine);
+
+    Vector3* positions = nullptr;
+    Vector2* uvs = nullptr;
+    if (!m_vertices.empty())
+    {
+      auto verts = m_vertices.data() + m_lineGlyphStarts[fromLine] *
+        Quad::Vertex::kCount;
+      positions = &verts->pos;
+      uvs = &verts->uv0;
+    }
+
+    m_boxText.Generate(m, fromLine, BoxText::Vertex::kSize, positions, uvs,
+      m_lineGlyphCounts.data(), updateGlyphCache, &m_stats);
+
+    for (size_t i = fromLine; i < m.lines.size(); ++i)
+    {
+      m_lineGlyphStarts[i + 1] = m_lineGlyphStarts[i] + m_lineGlyphCounts[i - fromLine];
+    }
+  };
+
+  uint32_t cacheGeneration = font->GetCacheGeneration();
+  generate(firstLine);
+  if (font->GetCacheGeneration() != cacheGeneration)
+  {
+    // Glyphs of the lines that we've kept, or generated earlier in this pass,
+    // might have been evicted; have one more go, with ours the most recently
+    // used.
+    firstLine = 0;
+    cacheGeneration = font->GetCacheGeneration();
+    generate(firstLine);
+
+    if (font->GetCacheGeneration() != cacheGeneration)
+    {
+      // Our glyphs don't fit in the cache. Don't keep any lines on the next
+      // change of the text.
+      m_lines.clear();
+    }
+  }
+
+  // Upload the vertices of the lines that were generated.
+  const uint32_t numGlyphs = GetNumGlyphs();
+  const uint32_t firstGlyph = m_lineGlyphStarts[firstLine];
+  bool meshChanged = recreateMesh || numGlyphs != lastNumGlyphs;
+  if (recreateMesh)
+  {
+    const uint32_t maxGlyphs = uint32_t(m_vertices.size() / Quad::Vertex::kCount);
+    std::vector<uint16_t> indices(Quad::kIndexCount * maxGlyphs);
+    meshutil::SetIndexPattern(Quad::kIndices, Quad::kIndexCount,
+      Quad::Vertex::kCount, maxGlyphs, indices.data());
+
+    m_mesh = IndexMesh::Create(static_cast<uint32_t>(m_vertices.size()),
+      m_vertices.data(), static_cast<uint32_t>(indices.size()), indices.data());
+  }
+  else if (numGlyphs > firstGlyph)
+  {
+    const uint32_t vertexBytes = Quad::Vertex::kCount * BoxText::Vertex::kSize;
+    Buffer buffer{ (numGlyphs - firstGlyph) * vertexBytes,
+      reinterpret_cast<uint8_t const*>(m_vertices.data() + firstGlyph *
+        Quad::Vertex::kCount) };
+    Gfx::UpdateVertexBuffer(m_mesh.hVertexBuffer, firstGlyph * vertexBytes, buffer);
+    meshChanged = true;
+  }
+
+  m_firstChange = std::string::npos;
+  m_relayoutAll = false;
+  m_cacheGeneration = font->GetCacheGeneration();
+  return meshChanged;
+}
+
+//==============================================================================
+void TextLayout::Render() const
+{
+  const uint32_t numGlyphs = GetNumGlyphs();
+  if (numGlyphs > 0)
+  {
+    m_mesh.Render(Primitive::TriangleList, 0, numGlyphs * Quad::kIndexCount);
+  }
+}
+
+}
@@ -578,6 +578,18 @@ bool Texture::Upload(Gfx::TextureFormat format, Px width, Px height,
   return success;
 }
 
+//==============================================================================
+bool Texture::Update(Px x, Px y, Px width, Px height, Buffer buffer)
+{
+  const bool success = m_handle.IsValid();
+  if (success)
+  {
+    XR_ASSERT(Texture, x + width <= m_width && y + height <= m_height);
+    Gfx::UpdateTexture(m_handle, x, y, width, height, buffer);
+  }
+  return success;
+}
+
 //==============================================================================
 void Texture::Bind(uint8_t stage) const
 {
@@ -8,6 +8,8 @@
 //==============================================================================
 #include "xr/TextureCache.hpp"
 #include "xr/AABB.hpp"
+#include <algorithm>
+#include <cstring>
 
 namespace xr
 {
@@ -47,6 +49,7 @@ TextureCache::TextureCache(Px size, Format format, Px blockWidth,
   {
     r.blocks = b;
     r.firstAvailable = b;
+    r.dirty = Rect();
 
     std::fill(b, b + last, Block{ false, 0 });
     b += last;
@@ -102,7 +105,10 @@ uint8_t* TextureCache::Allocate(Px widthPixels, Px heightPixels,
             break;  // while()
           }
           iBlock = iBlock->Skip();
-          XR_ASSERT(TextureCache, !(iBlock-1)->last);
+          if ((iBlock-1)->last)  // the allocation took the rest of the row.
+          {
+            break;  // while()
+          }
           base = iBlock;
         }
       }
@@ -151,6 +157,13 @@ uint8_t* TextureCache::Allocate(Px widthPixels, Px heightPixels,
     uvs.top = v / float(m_size);
     uvs.bottom = (v + heightPixels) / float(m_size);
 
+    Rect rect(static_cast<int32_t>(u / m_format.stride), static_cast<int32_t>(v),
+      widthPixels, heightPixels);
+    if (!rect.IsZero())
+    {
+      row->dirty = row->dirty.IsZero() ? rect : row->dirty.Union(rect);
+    }
+
     XR_ASSERT(TextureCache, alloc->buffer >= m_buffer.data());
     XR_ASSERT(TextureCache, alloc->buffer <= m_buffer.data() + m_rowStride * m_rows.size());
   }
@@ -161,10 +174,20 @@ uint8_t* TextureCache::Allocate(Px widthPixels, Px heightPixels,
 //==============================================================================
 Gfx::TextureHandle TextureCache::UpdateTexture(uint32_t flags)
 {
+  ClearDirtyRegions();
   Buffer buffer{ m_buffer.size(), m_buffer.data() };
   return Gfx::CreateTexture(m_format.textureFormat, m_size, m_size, 0, flags, &buffer);
 }
 
+//==============================================================================
+void TextureCache::ClearDirtyRegions()
+{
+  for (auto& r : m_rows)
+  {
+    r.dirty = Rect();
+  }
+}
+
 //==============================================================================
 void TextureCache::Deallocate(uint8_t* buffer)
 {
@@ -172,33 +195,35 @@ void TextureCache::Deallocate(uint8_t* buffer)
   auto findPredicate = [buffer](Allocation const& a) {
     return a.buffer == buffer;
   };
-  auto iFind = std::find_if(m_allocsHead, m_allocsEnd, findPredicate);
-  if(iFind != m_allocsEnd)
+  auto const numToEnd = GetNumAllocsToEnd();
+  auto iEnd = m_allocsHead + numToEnd;
+  auto iFind = std::find_if(m_allocsHead, iEnd, findPredicate);
+  if(iFind == iEnd)
   {
-    Deallocate(static_cast<AllocId>(iFind - m_allocs.data()));
+    iEnd = m_allocs.data() + (m_numAllocs - numToEnd);
+    iFind = std::find_if(m_allocs.data(), iEnd, findPredicate);
   }
-  else
+
+  if(iFind != iEnd)
   {
-    iFind = std::find_if(m_allocs.data(), m_allocs.data() + (m_numAllocs - (m_allocsEnd - m_allocsHead)), findPredicate);
-    if(iFind != m_allocsEnd)
-    {
-      Deallocate(static_cast<AllocId>(iFind - m_allocs.data()));
-    }
+    Deallocate(static_cast<AllocId>(iFind - m_allocs.data()));
   }
 }
 
 //==============================================================================
 void TextureCache::Reset()
 {
+  auto const numToEnd = GetNumAllocsToEnd();
   auto i = m_allocsHead;
-  while (i != m_allocsEnd)
+  auto iEnd = i + numToEnd;
+  while (i != iEnd)
   {
     i->Reset();
     ++i;
   }
 
   i = m_allocs.data();
-  auto iEnd = i + (m_numAllocs - (m_allocsEnd - m_allocsHead));
+  iEnd = i + (m_numAllocs - numToEnd);
   while (i != iEnd)
   {
     i->Reset();
@@ -209,6 +234,12 @@ void TextureCache::Reset()
   m_allocsHead = m_allocs.data();
 }
 
+//==============================================================================
+uint32_t TextureCache::GetNumAllocsToEnd() const
+{
+  return std::min(m_numAllocs, static_cast<uint32_t>(m_allocsEnd - m_allocsHead));
+}
+
 //==============================================================================
 TextureCache::Allocation& TextureCache::Next()
 {
@@ -248,4 +279,21 @@ void TextureCache::Deallocate(AllocId id)  // absolute index into the array of a
   --m_numAllocs;
 }
 
+//==============================================================================
+Buffer TextureCache::PackRegion(Rect const& rect)
+{
+  const size_t rowBytes = rect.w * m_format.stride;
+  m_packBuffer.resize(rowBytes * rect.h);
+
+  auto readp = m_buffer.data() + rect.y * m_pitch + rect.x * m_format.stride;
+  auto writep = m_packBuffer.data();
+  for (int32_t i = 0; i < rect.h; ++i)
+  {
+    memcpy(writep, readp, rowBytes);
+    readp += m_pitch;
+    writep += rowBytes;
+  }
+  return Buffer{ m_packBuffer.size(), m_packBuffer.data() };
+}
+
 }
@@ -10,6 +10,7 @@
 #include "xr/FileBuffer.hpp"
 #include "xr/JsonReader.hpp"
 #include "xr/debug.hpp"
+#include <vector>
 
 namespace xr
 {
@@ -45,4 +46,36 @@ JSON::Entity* LoadJSON(const char* filename, int maxDepth, bool quietErrors)
   return pJson;
 }
 
+//==============================================================================
+bool StreamJSON(File::Handle hFile, JSON::StreamParser& parser, size_t chunkSize)
+{
+  XR_ASSERT(StreamJSON, hFile != nullptr);
+  XR_ASSERT(StreamJSON, chunkSize > 0);
+  std::vector<char> buffer(chunkSize);
+  bool result = true;
+  while (result && !parser.IsComplete())
+  {
+    const size_t size = File::Read(hFile, 1, chunkSize, buffer.data());
+    if (size == 0)
+    {
+      break;
+    }
+
+    result = parser.Feed(buffer.data(), size);
+  }
+
+  return parser.Finish();
+}
+
+//==============================================================================
+JsonFileSink::JsonFileSink(FileWriter& file)
+: m_file(file)
+{}
+
+//==============================================================================
+bool JsonFileSink::Write(char const* data, size_t size)
+{
+  return m_file.Write(data, 1, size);
+}
+
 } // xr
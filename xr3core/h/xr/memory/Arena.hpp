@@ -0,0 +1,119 @@
+#ifndef XR_ARENA_HPP
+#define XR_ARENA_HPP
+//==============================================================================
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xr/types/fundamentals.hpp"
+#include "xr/debug.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace xr
+{
+
+//==============================================================================
+///@brief Growing memory arena for objects that share a lifetime. Allocations
+/// are bumped from blocks which are obtained as needed, each one twice the
+/// size of the previous; the memory is only reclaimed as a whole, by Reset()
+/// or destruction, which doesn't depend on the number of allocations made.
+///@note Arena doesn't call destructors; only trivially destructible objects
+/// should be created in it.
+class Arena
+{
+  XR_NONCOPY_DECL(Arena)
+
+public:
+  // static
+  static const size_t kDefaultBlockSize = 16384;
+
+  // structors
+  ///@brief Constructs an Arena, which doesn't allocate until the first
+  /// Allocate() call, when it obtains a block of at least @a blockSize bytes.
+  explicit Arena(size_t blockSize = kDefaultBlockSize);
+  ~Arena();
+
+  // general
+  ///@return A @a size bytes chunk of memory, aligned to @a alignment, which
+  /// must be a power of two.
+  [[nodiscard]] void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  ///@brief Constructs a T in memory allocated from the Arena.
+  template <typename T, typename... Args>
+  [[nodiscard]] T* New(Args&&... args);
+
+  ///@brief Makes all memory available again. The largest block is retained
+  /// and the rest are freed.
+  void  Reset();
+
+  ///@return The size of all allocations made from the Arena, in bytes, including
+  /// padding for alignment.
+  size_t CalculateUsed() const;
+
+  ///@return The number of blocks currently held by the Arena.
+  size_t GetNumBlocks() const;
+
+private:
+  // types
+  struct Block
+  {
+    Block* prev;
+    size_t size;  // of data, which follows the Block.
+  };
+
+  // data
+  size_t m_blockSize;
+  Block* m_block;
+  size_t m_usedPrevBlocks;  // excluding m_block
+  uint8_t* m_next;
+  uint8_t* m_end;
+
+  // internal
+  void* AllocateSlow(size_t size, size_t alignment);
+};
+
+//==============================================================================
+// implementation
+//==============================================================================
+inline
+void* Arena::Allocate(size_t size, size_t alignment)
+{
+  XR_ASSERT(Arena, alignment > 0 && (alignment & (alignment - 1)) == 0);
+  const uintptr_t mask = alignment - 1;
+  uint8_t* p = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(m_next) + mask) & ~mask);
+  if (m_next && p <= m_end && size_t(m_end - p) >= size)
+  {
+    m_next = p + size;
+    return p;
+  }
+  return AllocateSlow(size, alignment);
+}
+
+//==============================================================================
+template <typename T, typename... Args>
+T* Arena::New(Args&&... args)
+{
+  static_assert(std::is_trivially_destructible<T>::value,
+    "Arena doesn't call destructors.");
+  return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+}
+
+//==============================================================================
+inline
+size_t Arena::CalculateUsed() const
+{
+  return m_usedPrevBlocks + (m_block ?
+    size_t(m_next - reinterpret_cast<uint8_t*>(m_block + 1)) : 0);
+}
+
+}
+
+#endif  //XR_ARENA_HPP
@@ -0,0 +1,171 @@
+#ifndef XR_BOUNDEDQUEUE_HPP
+#define XR_BOUNDEDQUEUE_HPP
+//==============================================================================
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xr/debug.hpp"
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+namespace xr
+{
+
+//==============================================================================
+///@brief Lock-free, fixed capacity FIFO queue of trivially copyable elements,
+/// based on Dmitry Vyukov's bounded MPMC queue. Any number of threads may push
+/// and pop concurrently; no allocations are made after construction.
+template <typename T>
+class BoundedQueue
+{
+  static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable.");
+
+public:
+  // types
+  using value_type = T;
+
+  // structors
+  ///@brief Creates a queue that can hold @a capacity elements, rounded up to
+  /// the nearest power of two.
+  explicit BoundedQueue(size_t capacity);
+
+  BoundedQueue(BoundedQueue const&) = delete;
+  BoundedQueue& operator=(BoundedQueue const&) = delete;
+
+  // general
+  ///@return The number of elements the queue can hold.
+  size_t capacity() const;
+
+  ///@brief Attempts to add @a value to the end of the queue.
+  ///@return Whether it has succeeded, i.e. the queue wasn't full.
+  bool try_push(T value);
+
+  ///@brief Attempts to remove the element at the front of the queue, and
+  /// write it to @a outValue.
+  ///@return Whether it has succeeded, i.e. the queue wasn't empty.
+  bool try_pop(T& outValue);
+
+private:
+  // types
+  struct Cell
+  {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  // data
+  static constexpr size_t kCacheLineSize = 64;
+
+  std::unique_ptr<Cell[]> m_cells;
+  size_t m_mask;
+
+  alignas(kCacheLineSize) std::atomic<size_t> m_pushPos;
+  alignas(kCacheLineSize) std::atomic<size_t> m_popPos;
+};
+
+//==============================================================================
+// inline
+//==============================================================================
+template <typename T>
+BoundedQueue<T>::BoundedQueue(size_t capacity)
+: m_pushPos(0),
+  m_popPos(0)
+{
+  XR_ASSERT(BoundedQueue, capacity > 0);
+  size_t size = 1;
+  while (size < capacity)
+  {
+    size <<= 1;
+  }
+
+  m_cells.reset(new Cell[size]);
+  m_mask = size - 1;
+  for (size_t i = 0; i < size; ++i)
+  {
+    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+//==============================================================================
+template <typename T>
+inline
+size_t BoundedQueue<T>::capacity() const
+{
+  return m_mask + 1;
+}
+
+//==============================================================================
+template <typename T>
+bool BoundedQueue<T>::try_push(T value)
+{
+  Cell* cell;
+  size_t pos = m_pushPos.load(std::memory_order_relaxed);
+  while (true)
+  {
+    cell = &m_cells[pos & m_mask];
+    const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+    if (diff == 0)
+    {
+      if (m_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (diff < 0)
+    {
+      return false; // full
+    }
+    else
+    {
+      pos = m_pushPos.load(std::memory_order_relaxed);
+    }
+  }
+
+  cell->value = value;
+  cell->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+//==============================================================================
+template <typename T>
+bool BoundedQueue<T>::try_pop(T& outValue)
+{
+  Cell* cell;
+  size_t pos = m_popPos.load(std::memory_order_relaxed);
+  while (true)
+  {
+    cell = &m_cells[pos & m_mask];
+    const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+    if (diff == 0)
+    {
+      if (m_popPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (diff < 0)
+    {
+      return false; // empty
+    }
+    else
+    {
+      pos = m_popPos.load(std::memory_order_relaxed);
+    }
+  }
+
+  outValue = cell->value;
+  cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+  return true;
+}
+
+} // xr
+
+#endif  //XR_BOUNDEDQUEUE_HPP
@@ -0,0 +1,149 @@
+#ifndef XR_TASKSCHEDULER_HPP
+#define XR_TASKSCHEDULER_HPP
+//==============================================================================
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "Worker.hpp"
+#include "Spinlock.hpp"
+#include "xr/types/fundamentals.hpp"
+#include <condition_variable>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+namespace xr
+{
+
+//==============================================================================
+///@brief Runs tasks on a pool of threads. Each thread has its own queue of
+/// tasks; tasks submitted from a pool thread go to its own queue, and idle
+/// threads steal work from the others. Tasks may depend on other tasks, in
+/// which case they only become runnable once all of those have completed.
+///@note Threads calling Wait() or ParallelFor() help with the execution of
+/// tasks, so it is safe to call them from tasks.
+class TaskScheduler
+{
+  XR_NONCOPY_DECL(TaskScheduler)
+
+public:
+  // types
+  using Function = std::function<void()>;
+  using RangeFunction = std::function<void(size_t begin, size_t end)>;
+
+  static constexpr uint32_t kInvalidIndex = ~0u;
+
+  ///@brief The maximum number of tasks that may be in flight at any time.
+  static constexpr uint32_t kMaxTasks = 1 << 20;
+
+  ///@brief Identifies a task that was submitted to the scheduler. It remains
+  /// safe to use after the task has completed.
+  struct Handle
+  {
+    uint32_t index = kInvalidIndex;
+    uint32_t generation = 0;
+
+    bool IsValid() const
+    {
+      return index != kInvalidIndex;
+    }
+  };
+
+  // structors
+  ///@brief Starts @a numThreads threads; 0 means one per hardware thread.
+  explicit TaskScheduler(uint32_t numThreads = 0);
+
+  ///@brief Completes all outstanding tasks, then stops the threads.
+  ~TaskScheduler();
+
+  // general
+  uint32_t GetNumThreads() const;
+
+  ///@brief Submits @a function to be executed once all of the tasks in
+  /// @a dependencies have completed. Invalid handles are ignored.
+  ///@note If kMaxTasks tasks are already in flight, this will execute tasks
+  /// until one of them has completed.
+  Handle Submit(Function function, Handle const* dependencies = nullptr,
+    size_t numDependencies = 0);
+
+  Handle Submit(Function function, std::initializer_list<Handle> dependencies);
+
+  ///@brief Submits a Worker::Job, which will be Start()ed and Process()ed
+  /// until complete, on one of the threads.
+  ///@note Suspend() / Resume() / Cancel() are not supported.
+  Handle Submit(Worker::Job& job, Handle const* dependencies = nullptr,
+    size_t numDependencies = 0); // no ownership transfer
+
+  ///@return Whether the task identified by @a h has completed.
+  bool IsComplete(Handle h) const;
+
+  ///@brief Executes tasks until the one identified by @a h has completed.
+  void Wait(Handle h);
+
+  ///@brief Executes tasks until there are none left.
+  void WaitAll();
+
+  ///@brief Calls @a fn with subranges of [@a begin, @a end) of at most
+  /// @a grainSize elements, in parallel, and waits for all of them to complete.
+  /// If @a grainSize is 0, it is chosen based on the number of threads.
+  void ParallelFor(size_t begin, size_t end, size_t grainSize, RangeFunction const& fn);
+
+private:
+  // types
+  struct Task;
+  struct Thread;
+
+  static constexpr uint32_t kTaskBlockBits = 10;
+  static constexpr uint32_t kTaskBlockSize = 1 << kTaskBlockBits;
+  static constexpr uint32_t kMaxTaskBlocks = kMaxTasks / kTaskBlockSize;
+
+  // data
+  std::vector<std::unique_ptr<Thread>> m_threads;
+  std::atomic<uint32_t> m_nextThread;
+
+  Spinlock m_poolLock;
+  std::vector<uint32_t> m_freeTasks;  // guarded by m_poolLock
+  std::atomic<Task*> m_taskBlocks[kMaxTaskBlocks];
+  uint32_t m_numTaskBlocks; // guarded by m_poolLock
+
+  std::atomic<int32_t> m_numQueued;
+  std::atomic<int32_t> m_numInFlight;
+
+  std::mutex m_sleepMutex;
+  std::condition_variable m_sleepCV;
+  std::atomic<int32_t> m_numSleeping;
+  bool m_quitting;  // guarded by m_sleepMutex
+
+  // internal
+  Task& GetTask(uint32_t index) const;
+  uint32_t AllocateTask();
+  void FreeTask(uint32_t index);
+
+  Handle SubmitTask(uint32_t index, Handle const* dependencies, size_t numDependencies);
+  void Enqueue(uint32_t index);
+  bool TryDequeue(uint32_t& outIndex);
+  bool RunOne();
+  void Execute(uint32_t index);
+
+  void Loop(uint32_t threadIndex);
+};
+
+//==============================================================================
+// inline
+//==============================================================================
+inline
+TaskScheduler::Handle TaskScheduler::Submit(Function function,
+  std::initializer_list<Handle> dependencies)
+{
+  return Submit(std::move(function), dependencies.begin(), dependencies.size());
+}
+
+} // xr
+
+#endif  //XR_TASKSCHEDULER_HPP
@@ -10,6 +10,7 @@
 //
 //==============================================================================
 #include "Semaphore.hpp"
+#include "BoundedQueue.hpp"
 #include "xr/memory/Queue.hpp"
 #include <thread>
 #include <mutex>
@@ -58,15 +59,31 @@ public:
     virtual void Cancel() {}
   };
 
+  ///@brief Determines how the jobs are passed to the worker thread.
+  enum class QueueMode
+  {
+    ///@brief Mutex guarded, unbounded queue; allocates on Enqueue().
+    Locking,
+    ///@brief Fixed capacity lock-free ring buffer, no allocations after
+    /// construction. Enqueue() will yield until there's space in the queue.
+    LockFree,
+  };
+
+  static constexpr size_t kDefaultCapacity = 1024;
+
   // structors
-  Worker();
+  ///@brief Starts the worker thread. @a capacity is only used with
+  /// QueueMode::LockFree, and is rounded up to the nearest power of two.
+  explicit Worker(QueueMode mode = QueueMode::Locking,
+    size_t capacity = kDefaultCapacity);
 
   // general
   ///@brief Adds a job to the queue, only if the worker thread is still running
   /// (it may have been finalized). If the thread is no longer running, this
   /// will Cancel() @a job.
   ///@note Enqueuing Jobs from the worker thread is allowed, but it carries the
-  /// risk of never finishing.
+  /// risk of never finishing. In QueueMode::LockFree, doing so when the queue
+  /// is full will deadlock.
   void  Enqueue(Job& job);  // no ownership transfer
 
   void  Suspend();
@@ -83,13 +100,22 @@ public:
 private:
   // types
   using JobQueue = Queue<Job*>;
+  using JobRing = BoundedQueue<Job*>;
 
   // data
+  const QueueMode         m_mode;
+
   std::mutex              m_jobsMutex;
   Semaphore::Core         m_workSemaphore;
   JobQueue                m_jobs; // no ownership
 
-  bool                    m_finishing;
+  // QueueMode::LockFree only. m_numPosts is the number of jobs available to
+  // take; when negative, the worker thread is waiting on m_workSemaphore.
+  std::unique_ptr<JobRing> m_ring; // no ownership of jobs
+  std::atomic<int32_t>    m_numPosts;
+  std::atomic<bool>       m_finalized;
+
+  std::atomic<bool>       m_finishing;
   std::thread             m_thread;
 
   std::mutex              m_suspendMutex;
@@ -97,6 +123,12 @@ private:
   bool                    m_isSuspended;
 
   // internal
+  void Post();
+  void Wait();
+  bool TryWait();
+  void CancelRing();
+
+  Job* NextJob();
   void Loop();
 };
 
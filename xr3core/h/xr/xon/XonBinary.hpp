@@ -0,0 +1,376 @@
+#ifndef XR_XONBINARY_HPP
+#define XR_XONBINARY_HPP
+//==============================================================================
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "XonEntity.hpp"
+#include "xr/types/fundamentals.hpp"
+#include <cstdint>
+#include <iosfwd>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+namespace xr
+{
+
+//==============================================================================
+///@brief Compact binary form of a XON document, which can be navigated in place,
+/// without parsing, or any allocations. Objects and values are records in the
+/// buffer, which refer to each other using relative offsets; the keys of an
+/// object are sorted, for binary search. Identical values and keys are only
+/// stored once. The navigation API mirrors that of
+/// XonObject and XonValue, including the exceptions thrown.
+///@note The binary form is little endian with 4 byte alignment. It is not
+/// validated beyond its header, i.e. it should come from Write().
+class XonBinary
+{
+  XR_NONOBJECT_DECL(XonBinary)
+
+public:
+  // types
+  class Object;
+  class Value;
+
+  ///@brief Base class for binary XON entities.
+  class Entity
+  {
+    XR_NONCOPY_DECL(Entity)
+
+  public:
+    // types
+    using Type = XonEntity::Type;
+
+    // general
+    ///@return The type of the entity.
+    Type GetType() const;
+
+    ///@return Whether this is the given @a type.
+    bool Is(Type type) const;
+
+    ///@brief Attempts to cast this to an Object. A XonEntity::Exception of
+    /// type InvalidType is thrown if this is not an object.
+    Object const& ToObject() const;
+
+    ///@brief Attempts to cast this to a Value. A XonEntity::Exception of
+    /// type InvalidType is thrown if this is not a value.
+    Value const& ToValue() const;
+
+  protected:
+    // types
+    enum Kind: uint32_t
+    {
+      kObject,
+      kValue,
+      kNull,
+    };
+
+    static constexpr uint32_t kKindBits = 2;
+    static constexpr uint32_t kKindMask = (1 << kKindBits) - 1;
+
+    // data
+    uint32_t m_kindAndSize;
+
+    // general
+    Kind GetKind() const;
+    uint32_t GetSize() const;
+
+    // friends
+    friend class XonBinary;
+  };
+
+  ///@brief A binary XON object. Elements may be accessed by their index, or if
+  /// they were declared with a key, by the key.
+  class Object final: public Entity
+  {
+  public:
+    // types
+    class Iterator
+    {
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = Entity const*;
+      using difference_type = ptrdiff_t;
+      using pointer = value_type*;
+      using reference = value_type;
+
+      explicit Iterator(int32_t const* offset = nullptr);
+
+      Entity const* operator*() const;
+
+      Iterator& operator++();
+      Iterator operator++(int);
+
+      bool operator==(Iterator const& other) const;
+      bool operator!=(Iterator const& other) const;
+
+    private:
+      int32_t const* m_offset;
+    };
+
+    // general
+    ///@return The number of elements this object contains.
+    size_t GetNumElements() const;
+
+    ///@return The number of keyed elements this object contains.
+    size_t GetNumKeys() const;
+
+    ///@return A pointer to the element mapped to the given @a key; nullptr if
+    /// there is no such element.
+    Entity const* TryGet(std::string_view key) const;
+
+    ///@return A const reference to the element mapped to the given @a key. A
+    /// XonEntity::Exception of type InvalidKey is thrown if there is no such
+    /// element.
+    Entity const& Get(std::string_view key) const;
+
+    ///@brief Passes each of its keys to @a fn, in lexicographic order.
+    template <typename Fn>
+    void GetKeys(Fn fn) const;
+
+    // range based for support
+    Iterator begin() const;
+    Iterator end() const;
+
+    // operators
+    ///@return a const reference to the @a index th element this object has. A
+    /// XonEntity::Exception of type IndexOutOfBounds will be thrown if index is
+    /// outside of the range of valid indices.
+    Entity const& operator[](size_t index) const;
+
+  private:
+    // types
+    struct Key
+    {
+      int32_t offset; // of the Value of the key, from the Key.
+      uint32_t index;
+
+      std::string_view GetString() const;
+    };
+
+    // data
+    uint32_t m_numKeys;
+    // followed by int32_t offsets of elements, relative to the offset itself,
+    // then Key[m_numKeys], sorted by key.
+
+    // internal
+    int32_t const* GetOffsets() const;
+    Key const* GetKeyTable() const;
+
+    static Entity const* Resolve(int32_t const* offset);
+
+    // friends
+    friend class XonBinary;
+  };
+
+  ///@brief A binary XON value, stored as a null-terminated string.
+  class Value final: public Entity
+  {
+  public:
+    // general
+    ///@return The value of this element; nullptr for null values.
+    const char* GetString() const;
+
+    ///@return The length of the value.
+    size_t GetLength() const;
+  };
+
+  // static
+  static constexpr uint32_t kMagic = 0x424e4f58; // "XONB"
+  static constexpr uint32_t kVersion = 1;
+
+  ///@brief Writes the binary form of the document starting at @a root, to
+  /// @a out, replacing its contents.
+  static void Write(XonObject const& root, std::vector<uint8_t>& out);
+
+  ///@brief Writes the binary form of the document starting at @a root, to
+  /// @a stream.
+  ///@return Whether the operation was successful.
+  static bool Write(XonObject const& root, std::ostream& stream);
+
+  ///@return The root object of the binary XON document in @a data, which
+  /// must be 4 byte aligned, and remain valid while the document is used.
+  /// nullptr if @a data doesn't start with a binary XON header, or it's
+  /// shorter than the header says.
+  static Object const* GetRoot(void const* data, size_t size);
+
+private:
+  // types
+  struct Header
+  {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;  // including the header
+    uint32_t reserved;
+  };
+
+  class Builder;
+};
+
+//==============================================================================
+// implementation
+//==============================================================================
+inline
+XonBinary::Entity::Kind XonBinary::Entity::GetKind() const
+{
+  return static_cast<Kind>(m_kindAndSize & kKindMask);
+}
+
+//==============================================================================
+inline
+uint32_t XonBinary::Entity::GetSize() const
+{
+  return m_kindAndSize >> kKindBits;
+}
+
+//==============================================================================
+inline
+XonBinary::Entity::Type XonBinary::Entity::GetType() const
+{
+  return GetKind() == kObject ? Type::Object : Type::Value;
+}
+
+//==============================================================================
+inline
+bool XonBinary::Entity::Is(Type type) const
+{
+  return GetType() == type;
+}
+
+//==============================================================================
+inline
+XonBinary::Object::Iterator::Iterator(int32_t const* offset)
+: m_offset(offset)
+{}
+
+//==============================================================================
+inline
+XonBinary::Entity const* XonBinary::Object::Iterator::operator*() const
+{
+  return Resolve(m_offset);
+}
+
+//==============================================================================
+inline
+XonBinary::Object::Iterator& XonBinary::Object::Iterator::operator++()
+{
+  ++m_offset;
+  return *this;
+}
+
+//==============================================================================
+inline
+XonBinary::Object::Iterator XonBinary::Object::Iterator::operator++(int)
+{
+  Iterator result = *this;
+  ++m_offset;
+  return result;
+}
+
+//==============================================================================
+inline
+bool XonBinary::Object::Iterator::operator==(Iterator const& other) const
+{
+  return m_offset == other.m_offset;
+}
+
+//==============================================================================
+inline
+bool XonBinary::Object::Iterator::operator!=(Iterator const& other) const
+{
+  return m_offset != other.m_offset;
+}
+
+//==============================================================================
+inline
+size_t XonBinary::Object::GetNumElements() const
+{
+  return GetSize();
+}
+
+//==============================================================================
+inline
+size_t XonBinary::Object::GetNumKeys() const
+{
+  return m_numKeys;
+}
+
+//==============================================================================
+template <typename Fn>
+void XonBinary::Object::GetKeys(Fn fn) const
+{
+  auto keys = GetKeyTable();
+  for (auto i = keys, iEnd = keys + m_numKeys; i != iEnd; ++i)
+  {
+    fn(i->GetString());
+  }
+}
+
+//==============================================================================
+inline
+XonBinary::Object::Iterator XonBinary::Object::begin() const
+{
+  return Iterator(GetOffsets());
+}
+
+//==============================================================================
+inline
+XonBinary::Object::Iterator XonBinary::Object::end() const
+{
+  return Iterator(GetOffsets() + GetSize());
+}
+
+//==============================================================================
+inline
+int32_t const* XonBinary::Object::GetOffsets() const
+{
+  return reinterpret_cast<int32_t const*>(this + 1);
+}
+
+//==============================================================================
+inline
+XonBinary::Object::Key const* XonBinary::Object::GetKeyTable() const
+{
+  return reinterpret_cast<Key const*>(GetOffsets() + GetSize());
+}
+
+//==============================================================================
+inline
+XonBinary::Entity const* XonBinary::Object::Resolve(int32_t const* offset)
+{
+  return reinterpret_cast<Entity const*>(reinterpret_cast<uint8_t const*>(offset) +
+    *offset);
+}
+
+//==============================================================================
+inline
+std::string_view XonBinary::Object::Key::GetString() const
+{
+  auto value = reinterpret_cast<Value const*>(reinterpret_cast<uint8_t const*>(this) +
+    offset);
+  return std::string_view(value->GetString(), value->GetLength());
+}
+
+//==============================================================================
+inline
+const char* XonBinary::Value::GetString() const
+{
+  return GetKind() == kNull ? nullptr : reinterpret_cast<char const*>(this + 1);
+}
+
+//==============================================================================
+inline
+size_t XonBinary::Value::GetLength() const
+{
+  return GetSize();
+}
+
+} // xr
+
+#endif //XR_XONBINARY_HPP
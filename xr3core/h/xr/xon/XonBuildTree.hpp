@@ -31,6 +31,17 @@ namespace xr
 [[nodiscard]] XonObject* XonBuildTree(char const* string, size_t length,
   XonParser::State* outState = nullptr);
 
+///@brief Attempts to parse @a string as XON and build a tree of XON entities,
+/// which - along with all of their storage - are allocated from @a arena.
+/// The semantics and parameters are otherwise the same as above.
+///@return A pointer to the root object of the XON document, or nullptr if the
+/// parse has failed.
+///@note Does not transfer ownership; the tree is valid until @a arena is Reset()
+/// or destroyed, and it must not be deleted. Following a failed parse, the
+/// memory used thus far will only be reclaimed with the arena's.
+[[nodiscard]] XonObject* XonBuildTree(char const* string, size_t length,
+  Arena& arena, XonParser::State* outState = nullptr);
+
 } // xr
 
 #endif  //XR_XONBUILDTREE_HPP
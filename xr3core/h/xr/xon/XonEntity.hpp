@@ -10,16 +10,18 @@
 //
 //==============================================================================
 #include "xr/types/fundamentals.hpp"
-#include <map>
+#include <cstdint>
 #include <vector>
 #include <memory>
 #include <string>
 #include <string_view>
 #include <stdexcept>
+#include <type_traits>
 
 namespace xr
 {
 
+class Arena;
 class XonObject;
 class XonValue;
 
@@ -91,15 +93,32 @@ protected:
 //==============================================================================
 ///@brief XON object - a container for other XON entities. Does not have a value
 /// of its own. The elements may be indexed in the order of their declaration.
-/// Additionally, elements declared with a key may be accessed using the key.
+/// Additionally, elements declared with a key may be accessed using the key;
+/// keys are hashed, and beyond a handful of them, indexed in a hash table.
+/// The storage of the object may be allocated from an Arena, see XonObject(Arena&).
 class XonObject final : public XonEntity
 {
 public:
   // types
-  using Xontainer = std::vector<XonEntity*>;
+  ///@brief Names the types of iterators to the elements.
+  struct Xontainer
+  {
+    using iterator = XonEntity**;
+    using const_iterator = XonEntity* const*;
+  };
+
+  using iterator = Xontainer::iterator;
+  using const_iterator = Xontainer::const_iterator;
 
   // structors
   XonObject();
+
+  ///@brief Constructs an object whose storage - for its elements and keys -
+  /// is allocated from @a arena, which must outlive it.
+  ///@note Does not take ownership of its elements, which should also be
+  /// created in @a arena; the whole tree then may be left undestroyed, and its
+  /// memory reclaimed with the arena's.
+  explicit XonObject(Arena& arena);
   ~XonObject();
 
   // general
@@ -108,59 +127,85 @@ public:
   ///@return A pointer to the element mapped to the given @a key; nullptr if
   /// there is no such element.
   ///@note Does not transfer ownership.
-  XonEntity*  TryGet(std::string const& key);
+  XonEntity*  TryGet(std::string_view key);
 
   ///@return A pointer to the element mapped to the given @a key; nullptr if
   /// there is no such element.
-  XonEntity const*  TryGet(std::string const& key) const;
+  XonEntity const*  TryGet(std::string_view key) const;
 
   ///@return A reference to the element mapped to the given @a key. A XonException
   /// of type InvalidKey is thrown if there is no such element.
-  XonEntity&  Get(std::string const& key);
+  XonEntity&  Get(std::string_view key);
 
   ///@return A const reference to the element mapped to the given @a key. A
   /// XonException of type InvalidKey is thrown if there is no such element.
-  XonEntity const&  Get(std::string const& key) const;
+  XonEntity const&  Get(std::string_view key) const;
 
   ///@return The number of elements this object contains.
   size_t GetNumElements() const
   {
-    return m_elements.size();
+    return m_numElements;
+  }
+
+  ///@return The number of distinct keys this object has.
+  size_t GetNumKeys() const
+  {
+    return m_numKeys;
   }
 
-  ///@brief Passes each of its keys to @a fn.
+  ///@brief Passes each of its keys, as a std::string, to @a fn, in
+  /// lexicographic order.
   template <typename Fn,
     std::enable_if_t<std::is_member_function_pointer_v<decltype(&Fn::operator())>>* = nullptr>
   void GetKeys(Fn fn) const
   {
-    for (auto& kv : m_keyedElements)
+    for (auto k : GetSortedKeyIndices())
     {
-      fn(kv.first);
+      fn(std::string(m_keys[k].string, m_keys[k].length));
     }
   }
 
-  ///@brief Assigns each of its keys to output iterator @a i.
+  ///@brief Assigns each of its keys, as a std::string, to output iterator @a i,
+  /// in lexicographic order.
   template <typename OutIt,
     std::enable_if_t<std::is_member_function_pointer_v<decltype(&OutIt::operator*)>>* = nullptr>
   void GetKeys(OutIt i) const
   {
-    for (auto& kv : m_keyedElements)
+    for (auto k : GetSortedKeyIndices())
     {
-      *i = kv.first;
+      *i = std::string(m_keys[k].string, m_keys[k].length);
     }
   }
 
   ///@brief Writes the keys of its elements into @a keys, in lexicographic order.
   void GetKeys(std::vector<std::string>& keys) const;
 
+  ///@brief Passes each of its keys, as a std::string_view, to @a fn, in the
+  /// order of their first declaration. Unlike GetKeys(), this doesn't sort or
+  /// copy the keys.
+  template <typename Fn>
+  void ForEachKeyInOrder(Fn fn) const
+  {
+    for (auto k = m_keys, kEnd = m_keys + m_numKeys; k != kEnd; ++k)
+    {
+      fn(std::string_view{ k->string, k->length });
+    }
+  }
+
+  ///@brief Ensures that there's storage for @a numElements elements, @a numKeys
+  /// of them keyed, without further allocations.
+  void Reserve(size_t numElements, size_t numKeys);
+
   ///@brief Adds the given element @a elem as a child at the next index.
-  ///@note Transfers ownership; @a elem should not be stack-allocated.
+  ///@note Transfers ownership - unless the object was created in an Arena;
+  /// @a elem should not be stack-allocated.
   void AddElement(XonEntity& elem);
 
   ///@brief Adds the given element @a elem as a child at the next index, also
   /// keyed to @a key.
   ///@note Overrides a previous mapping of the same key (if any).
-  ///@note Transfers ownership; @a elem should not be stack-allocated.
+  ///@note Transfers ownership - unless the object was created in an Arena;
+  /// @a elem should not be stack-allocated.
   void AddElement(std::string_view key, XonEntity& elem);
 
   [[deprecated]]
@@ -170,11 +215,11 @@ public:
   bool HasElement(XonEntity const& elem) const;
 
   // range based for support
-  Xontainer::iterator begin() { return m_elements.begin(); }
-  Xontainer::iterator end() { return m_elements.end(); }
+  iterator begin() { return m_elements; }
+  iterator end() { return m_elements + m_numElements; }
 
-  Xontainer::const_iterator begin() const { return m_elements.cbegin(); }
-  Xontainer::const_iterator end() const { return m_elements.cend(); }
+  const_iterator begin() const { return m_elements; }
+  const_iterator end() const { return m_elements + m_numElements; }
 
   // operators
   ///@return a reference to the @a index th element this object has. A XonException
@@ -188,9 +233,40 @@ public:
   XonEntity const&  operator[](size_t index) const;
 
 private:
+  // types
+  struct Key
+  {
+    char const* string;
+    uint32_t length;
+    uint32_t hash;
+    XonEntity* element;
+  };
+
   // data
-  Xontainer m_elements; // ownership
-  std::map<std::string, XonEntity*, std::less<>> m_keyedElements;  // no ownership
+  Arena* m_arena = nullptr;  // if set, storage is allocated from it, and elements aren't owned.
+
+  XonEntity** m_elements = nullptr; // ownership, unless m_arena
+  uint32_t m_numElements = 0;
+  uint32_t m_elementsCapacity = 0;
+
+  Key* m_keys = nullptr;  // in the order of declaration; no ownership of elements
+  uint32_t m_numKeys = 0;
+  uint32_t m_keysCapacity = 0;
+
+  uint32_t* m_index = nullptr;  // open addressing; 1 + index of Key, 0 if vacant.
+  uint32_t m_indexMask = 0; // size of m_index - 1
+
+  // internal
+  void* Allocate(size_t size, size_t alignment);
+  void Deallocate(void* p);
+
+  void ReserveElements(uint32_t capacity);
+  void ReserveKeys(uint32_t capacity);
+  void Index(uint32_t keyIndex);
+
+  Key* FindKey(std::string_view key, uint32_t hash) const;
+
+  std::vector<uint32_t> GetSortedKeyIndices() const;
 };
 
 //==============================================================================
@@ -202,6 +278,10 @@ public:
   XonValue();
   XonValue(char const* value, size_t length);
   XonValue(std::string const& string);
+
+  ///@brief Constructs a value whose string is allocated from @a arena, which
+  /// must outlive it.
+  XonValue(char const* value, size_t length, Arena& arena);
   ~XonValue();
 
   // general
@@ -220,8 +300,9 @@ public:
 
 private:
   // data
-  char* m_value = nullptr;
+  char* m_value = nullptr;  // ownership, unless m_isArenaAllocated
   size_t m_length = 0;
+  bool m_isArenaAllocated = false;
 };
 
 } // xr
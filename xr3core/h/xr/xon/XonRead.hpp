@@ -10,6 +10,7 @@
 //
 //==============================================================================
 #include "XonEntity.hpp"
+#include "XonBinary.hpp"
 #include "xr/io/StructuredReader.hpp"
 #include "xr/strings/stringutils.hpp"
 #include "xr/types/fundamentals.hpp"
@@ -29,6 +30,17 @@ struct XonReaderInTraits
     return in.ToObject().TryGet(key);
   }
 };
+
+struct XonBinaryReaderInTraits
+{
+  using Type = XonBinary::Entity;
+
+  // static
+  static Type const* GetChild(Type const& in, std::string const& key)
+  {
+    return in.ToObject().TryGet(key);
+  }
+};
 }
 
 //==============================================================================
@@ -37,38 +49,49 @@ template <class Out>
 using XonReader = Structured::Reader<detail::XonReaderInTraits, Out>;
 
 //==============================================================================
-///@brief Helper functions to interpret XON into various data types.
-class XonRead
+///@brief Structured reader for processing binary XON.
+template <class Out>
+using XonBinaryReader = Structured::Reader<detail::XonBinaryReaderInTraits, Out>;
+
+//==============================================================================
+///@brief Helper functions to interpret XON into various data types. Entity may
+/// be XonEntity, for XON trees, or XonBinary::Entity, for binary XON.
+template <class Entity>
+class XonReadT
 {
-  XR_NONOBJECT_DECL(XonRead)
+  XR_NONOBJECT_DECL(XonReadT)
 
 public:
   ///@brief Attempts to interpret @a xon as a number of type T.
   /// Throws XonEntity::Exception if @a xon is not a value, or std::illegal_argument
   /// if the xonversion has failed.
   template <typename T>
-  static T Number(XonEntity const& xon);
+  static T Number(Entity const& xon);
 
   ///@brief Attempts to interpret @a xon as a c-string.
   /// Throws XonEntity::Exception if @a xon is not a value.
-  static char const* CString(XonEntity const& xon);
+  static char const* CString(Entity const& xon);
 
   ///@brief Attempts to interpret @a xon as a std::string.
   /// Throws XonEntity::Exception if @a xon is not a value.
-  static std::string String(XonEntity const& xon);
+  static std::string String(Entity const& xon);
 
   ///@brief Attempts to interpret @a xon as an array of objects type T.
   /// Throws XonEntity::Exception if @a xon is not an object, or if the underlying
   /// interpreter had failed.
-  template <typename T, T(*interpreter)(XonEntity const&)>
-  static std::vector<T> Array(XonEntity const& xon);
+  template <typename T, T(*interpreter)(Entity const&)>
+  static std::vector<T> Array(Entity const& xon);
 };
 
+using XonRead = XonReadT<XonEntity>;
+using XonBinaryRead = XonReadT<XonBinary::Entity>;
+
 //==============================================================================
 // implementation
 //==============================================================================
+template <class Entity>
 template <typename T>
-T XonRead::Number(XonEntity const& xon)
+T XonReadT<Entity>::Number(Entity const& xon)
 {
   T result;
   auto value = xon.ToValue().GetString();
@@ -81,13 +104,30 @@ T XonRead::Number(XonEntity const& xon)
 }
 
 //==============================================================================
-template <typename T, T(*interpreter)(XonEntity const&)>
-std::vector<T> XonRead::Array(XonEntity const& xon)
+template <class Entity>
+inline
+char const* XonReadT<Entity>::CString(Entity const & xon)
+{
+  return xon.ToValue().GetString();
+}
+
+//==============================================================================
+template <class Entity>
+inline
+std::string XonReadT<Entity>::String(Entity const & xon)
+{
+  return std::string(CString(xon));
+}
+
+//==============================================================================
+template <class Entity>
+template <typename T, T(*interpreter)(Entity const&)>
+std::vector<T> XonReadT<Entity>::Array(Entity const& xon)
 {
   auto& xonObj = xon.ToObject();
   std::vector<T> result;
   result.reserve(xonObj.GetNumElements());
-  for (auto& x : xonObj)
+  for (auto x : xonObj)
   {
     result.push_back(interpreter(*x));
   }
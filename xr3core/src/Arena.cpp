@@ -0,0 +1,91 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xr/memory/Arena.hpp"
+#include <algorithm>
+
+namespace xr
+{
+
+//==============================================================================
+Arena::Arena(size_t blockSize)
+: m_blockSize(blockSize),
+  m_block(nullptr),
+  m_usedPrevBlocks(0),
+  m_next(nullptr),
+  m_end(nullptr)
+{
+  XR_ASSERT(Arena, blockSize > 0);
+}
+
+//==============================================================================
+Arena::~Arena()
+{
+  while (m_block)
+  {
+    Block* prev = m_block->prev;
+    ::operator delete(m_block);
+    m_block = prev;
+  }
+}
+
+//==============================================================================
+void Arena::Reset()
+{
+  if (m_block)
+  {
+    // The most recent block is the largest one.
+    Block* prev = m_block->prev;
+    while (prev)
+    {
+      Block* next = prev->prev;
+      ::operator delete(prev);
+      prev = next;
+    }
+    m_block->prev = nullptr;
+
+    m_next = reinterpret_cast<uint8_t*>(m_block + 1);
+  }
+  m_usedPrevBlocks = 0;
+}
+
+//==============================================================================
+size_t Arena::GetNumBlocks() const
+{
+  size_t count = 0;
+  for (Block* b = m_block; b; b = b->prev)
+  {
+    ++count;
+  }
+  return count;
+}
+
+//==============================================================================
+void* Arena::AllocateSlow(size_t size, size_t alignment)
+{
+  // Make sure that the request fits even if the data is misaligned.
+  const size_t minSize = size + alignment;
+  size_t blockSize = m_block ? m_block->size * 2 : m_blockSize;
+  blockSize = std::max(blockSize, minSize);
+
+  Block* block = static_cast<Block*>(::operator new(sizeof(Block) + blockSize));
+  block->prev = m_block;
+  block->size = blockSize;
+
+  if (m_block)
+  {
+    m_usedPrevBlocks += m_next - reinterpret_cast<uint8_t*>(m_block + 1);
+  }
+  m_block = block;
+  m_next = reinterpret_cast<uint8_t*>(block + 1);
+  m_end = m_next + blockSize;
+
+  return Allocate(size, alignment);
+}
+
+}
@@ -9,10 +9,217 @@
 #include <cstring>
 #include <string>
 #include "xr/strings/ParserCore.hpp"
+#include "xr/platform.hpp"
 #include "xr/debug.hpp"
 
+// Scanning is vectorised with AVX2 if enabled for the build, SSE2 otherwise,
+// unless XR_PARSERCORE_NO_SIMD is defined.
+#if !defined(XR_PARSERCORE_NO_SIMD) && defined(XR_CPU_INTEL) && (defined(__SSE2__) || defined(_M_X64) ||\
+  (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#if defined(__AVX2__)
+#define XR_PARSERCORE_AVX2
+#include <immintrin.h>
+#else
+#define XR_PARSERCORE_SSE2
+#include <emmintrin.h>
+#endif
+#endif
+
+#if defined(XR_COMPILER_MSVC)
+#include <intrin.h>
+#endif
+
 namespace xr
 {
+namespace
+{
+
+#if defined(XR_PARSERCORE_AVX2) || defined(XR_PARSERCORE_SSE2)
+#define XR_PARSERCORE_SIMD
+
+#if defined(XR_PARSERCORE_AVX2)
+using Chunk = __m256i;
+const int kChunkSize = 32;
+
+Chunk Load(const char* p)
+{
+  return _mm256_loadu_si256(reinterpret_cast<Chunk const*>(p));
+}
+
+Chunk Splat(char c)
+{
+  return _mm256_set1_epi8(c);
+}
+
+uint32_t Equal(Chunk v, Chunk c)
+{
+  return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, c)));
+}
+
+uint32_t Space(Chunk v)
+{
+  // ' ', or '\t' - '\r', i.e. 9 - 13.
+  const Chunk offset = _mm256_sub_epi8(v, Splat('\t'));
+  const Chunk inRange = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, Splat(4)), offset);
+  return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(inRange,
+    _mm256_cmpeq_epi8(v, Splat(' ')))));
+}
+#else
+using Chunk = __m128i;
+const int kChunkSize = 16;
+
+Chunk Load(const char* p)
+{
+  return _mm_loadu_si128(reinterpret_cast<Chunk const*>(p));
+}
+
+Chunk Splat(char c)
+{
+  return _mm_set1_epi8(c);
+}
+
+uint32_t Equal(Chunk v, Chunk c)
+{
+  return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, c)));
+}
+
+uint32_t Space(Chunk v)
+{
+  // ' ', or '\t' - '\r', i.e. 9 - 13.
+  const Chunk offset = _mm_sub_epi8(v, Splat('\t'));
+  const Chunk inRange = _mm_cmpeq_epi8(_mm_min_epu8(offset, Splat(4)), offset);
+  return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(inRange,
+    _mm_cmpeq_epi8(v, Splat(' ')))));
+}
+#endif
+
+const uint32_t kChunkMask = uint32_t(uint64_t(1) << kChunkSize) - 1;
+
+int CountBits(uint32_t bits)
+{
+#if defined(XR_COMPILER_MSVC)
+  bits = bits - ((bits >> 1) & 0x55555555);
+  bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333);
+  return static_cast<int>((((bits + (bits >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24);
+#else
+  return __builtin_popcount(bits);
+#endif
+}
+
+int FindFirstBit(uint32_t bits)
+{
+  XR_ASSERT(ParserCore, bits != 0);
+#if defined(XR_COMPILER_MSVC)
+  unsigned long index;
+  _BitScanForward(&index, bits);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctz(bits);
+#endif
+}
+
+int FindLastBit(uint32_t bits)
+{
+  XR_ASSERT(ParserCore, bits != 0);
+#if defined(XR_COMPILER_MSVC)
+  unsigned long index;
+  _BitScanReverse(&index, bits);
+  return static_cast<int>(index);
+#else
+  return 31 - __builtin_clz(bits);
+#endif
+}
+
+struct MatchChar
+{
+  Chunk c;
+
+  explicit MatchChar(int c_)
+  : c(Splat(static_cast<char>(c_)))
+  {}
+
+  uint32_t operator()(Chunk v) const
+  {
+    return Equal(v, c);
+  }
+};
+
+struct MatchNonSpace
+{
+  uint32_t operator()(Chunk v) const
+  {
+    return ~Space(v) & kChunkMask;
+  }
+};
+
+///@brief Moves @a p forward, a chunk at a time, until @a match finds a
+/// character in the chunk, or there are fewer than a chunk's worth of
+/// characters left before @a end, keeping track of line breaks. CRLF is
+/// counted as a single line break, as by ParserCore::SkipChar().
+///@return Whether a match was found; if so, @a p points to it.
+///@note Must not be used to find CR or LF characters.
+template <class Matcher>
+bool ScanChunks(Matcher const& match, const char*& p, const char* end, int& row,
+  int& column)
+{
+  const Chunk cr = Splat('\r');
+  const Chunk lf = Splat('\n');
+  const char* start = p;
+  const char* lastLineBreak = nullptr;
+  uint32_t carryCR = 0;  // whether the last chunk ended with CR
+  bool found = false;
+  while (end - p >= kChunkSize)
+  {
+    const Chunk v = Load(p);
+    uint32_t crs = Equal(v, cr);
+    uint32_t lfs = Equal(v, lf);
+    const uint32_t matches = match(v);
+    int size = kChunkSize;
+    if (matches != 0)
+    {
+      size = FindFirstBit(matches);
+      const uint32_t before = uint32_t((uint64_t(1) << size) - 1);
+      crs &= before;
+      lfs &= before;
+      found = true;
+    }
+
+    if ((crs | lfs) != 0)
+    {
+      const uint32_t crlfs = crs & (lfs >> 1);
+      row += CountBits(crs) + CountBits(lfs) - CountBits(crlfs) - int(carryCR & lfs);
+      lastLineBreak = p + FindLastBit(crs | lfs);
+    }
+
+    p += size;
+    if (found)
+    {
+      break;
+    }
+    carryCR = crs >> (kChunkSize - 1);
+  }
+
+  if (lastLineBreak)
+  {
+    column = static_cast<int>(p - lastLineBreak);
+  }
+  else
+  {
+    column += static_cast<int>(p - start);
+  }
+
+  // A CR at the very end will be followed by the LF of a CRLF, which the
+  // caller's SkipChar() will count as a line break again.
+  if (!found && carryCR != 0 && p != end && *p == '\n')
+  {
+    --row;
+  }
+  return found;
+}
+
+#endif  // XR_PARSERCORE_AVX2 || XR_PARSERCORE_SSE2
+
+}
 
 //==============================================================================
 ParserCore::ParserCore()
@@ -45,6 +252,13 @@ void  ParserCore::SetBuffer(const char* buffer, size_t size)
 const char* ParserCore::ExpectChar()
 {
   XR_ASSERT(ParserCore, m_p0 != nullptr);
+#if defined(XR_PARSERCORE_SIMD)
+  if (m_p0 != m_p1 && isspace(*m_p0) &&
+    ScanChunks(MatchNonSpace(), m_p0, m_p1, m_row, m_column))
+  {
+    return m_p0;
+  }
+#endif
   while (m_p0 != m_p1 && isspace(*m_p0))
   {
     SkipChar();
@@ -56,6 +270,13 @@ const char* ParserCore::ExpectChar()
 const char* ParserCore::RequireChar(int c)
 {
   XR_ASSERT(ParserCore, m_p0 != nullptr);
+#if defined(XR_PARSERCORE_SIMD)
+  if (c != '\r' && c != '\n' &&
+    ScanChunks(MatchChar(c), m_p0, m_p1, m_row, m_column))
+  {
+    return m_p0;
+  }
+#endif
   while (m_p0 != m_p1 && *m_p0 != c)
   {
     SkipChar();
@@ -0,0 +1,471 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xr/threading/TaskScheduler.hpp"
+#include "xr/debug.hpp"
+#include <algorithm>
+#include <deque>
+#include <thread>
+
+namespace xr
+{
+namespace
+{
+
+const int kSpinCount = 64;
+
+// Identifies the scheduler and queue that the current thread belongs to, if any.
+struct ThreadContext
+{
+  TaskScheduler const* scheduler = nullptr;
+  uint32_t index = 0;
+};
+
+thread_local ThreadContext tContext;
+
+}
+
+//==============================================================================
+struct TaskScheduler::Task
+{
+  // data
+  TaskScheduler::Function function;
+  Worker::Job* job = nullptr;
+
+  std::atomic<uint32_t> generation{ 0 };
+  std::atomic<int32_t> numDependencies{ 0 };
+
+  Spinlock lock;
+  std::vector<uint32_t> dependents;  // guarded by lock
+
+  // general
+  void Run()
+  {
+    if (job)
+    {
+      job->Start();
+      while (!job->Process())
+      {}
+    }
+    else
+    {
+      function();
+    }
+  }
+};
+
+//==============================================================================
+///@brief A pool thread, and its queue of tasks. The owner pushes and pops
+/// at the back; other threads steal from the front.
+struct TaskScheduler::Thread
+{
+  // data
+  Spinlock lock;
+  std::deque<uint32_t> tasks;  // guarded by lock
+  std::thread thread;
+
+  // general
+  void Push(uint32_t index)
+  {
+    std::unique_lock<Spinlock> l(lock);
+    tasks.push_back(index);
+  }
+
+  bool Pop(uint32_t& outIndex)
+  {
+    std::unique_lock<Spinlock> l(lock);
+    bool result = !tasks.empty();
+    if (result)
+    {
+      outIndex = tasks.back();
+      tasks.pop_back();
+    }
+    return result;
+  }
+
+  bool Steal(uint32_t& outIndex)
+  {
+    std::unique_lock<Spinlock> l(lock, std::try_to_lock);
+    bool result = l.owns_lock() && !tasks.empty();
+    if (result)
+    {
+      outIndex = tasks.front();
+      tasks.pop_front();
+    }
+    return result;
+  }
+};
+
+//==============================================================================
+TaskScheduler::TaskScheduler(uint32_t numThreads)
+: m_nextThread(0),
+  m_numTaskBlocks(0),
+  m_numQueued(0),
+  m_numInFlight(0),
+  m_numSleeping(0),
+  m_quitting(false)
+{
+  for (auto& b : m_taskBlocks)
+  {
+    b.store(nullptr, std::memory_order_relaxed);
+  }
+
+  if (numThreads == 0)
+  {
+    numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  m_threads.reserve(numThreads);
+  for (uint32_t i = 0; i < numThreads; ++i)
+  {
+    m_threads.emplace_back(new Thread());
+  }
+
+  // Only start the threads once all of the queues exist.
+  for (uint32_t i = 0; i < numThreads; ++i)
+  {
+    m_threads[i]->thread = std::thread(&TaskScheduler::Loop, this, i);
+  }
+}
+
+//==============================================================================
+TaskScheduler::~TaskScheduler()
+{
+  WaitAll();
+
+  {
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_quitting = true;
+  }
+  m_sleepCV.notify_all();
+
+  for (auto& t : m_threads)
+  {
+    t->thread.join();
+  }
+
+  for (uint32_t i = 0; i < m_numTaskBlocks; ++i)
+  {
+    delete[] m_taskBlocks[i].load(std::memory_order_relaxed);
+  }
+}
+
+//==============================================================================
+uint32_t TaskScheduler::GetNumThreads() const
+{
+  return static_cast<uint32_t>(m_threads.size());
+}
+
+//==============================================================================
+TaskScheduler::Handle TaskScheduler::Submit(Function function,
+  Handle const* dependencies, size_t numDependencies)
+{
+  XR_ASSERT(TaskScheduler, function);
+  const uint32_t index = AllocateTask();
+  GetTask(index).function = std::move(function);
+  return SubmitTask(index, dependencies, numDependencies);
+}
+
+//==============================================================================
+TaskScheduler::Handle TaskScheduler::Submit(Worker::Job& job,
+  Handle const* dependencies, size_t numDependencies)
+{
+  const uint32_t index = AllocateTask();
+  GetTask(index).job = &job;
+  return SubmitTask(index, dependencies, numDependencies);
+}
+
+//==============================================================================
+bool TaskScheduler::IsComplete(Handle h) const
+{
+  return !h.IsValid() ||
+    GetTask(h.index).generation.load(std::memory_order_acquire) != h.generation;
+}
+
+//==============================================================================
+void TaskScheduler::Wait(Handle h)
+{
+  while (!IsComplete(h))
+  {
+    if (!RunOne())
+    {
+      std::this_thread::yield();
+    }
+  }
+}
+
+//==============================================================================
+void TaskScheduler::WaitAll()
+{
+  while (m_numInFlight.load() > 0)
+  {
+    if (!RunOne())
+    {
+      std::this_thread::yield();
+    }
+  }
+}
+
+//==============================================================================
+void TaskScheduler::ParallelFor(size_t begin, size_t end, size_t grainSize,
+  RangeFunction const& fn)
+{
+  if (begin >= end)
+  {
+    return;
+  }
+
+  const size_t count = end - begin;
+  if (grainSize == 0)
+  {
+    // Aim for a few chunks per thread, to give stealing a chance to balance.
+    grainSize = std::max(count / (m_threads.size() * 4), size_t(1));
+  }
+
+  const size_t numChunks = (count + grainSize - 1) / grainSize;
+  std::vector<Handle> handles;
+  handles.reserve(numChunks - 1);
+  for (size_t i = 1; i < numChunks; ++i)
+  {
+    const size_t chunkBegin = begin + i * grainSize;
+    const size_t chunkEnd = std::min(chunkBegin + grainSize, end);
+    handles.push_back(Submit([&fn, chunkBegin, chunkEnd] {
+      fn(chunkBegin, chunkEnd);
+    }));
+  }
+
+  // Do the first chunk on this thread.
+  fn(begin, std::min(begin + grainSize, end));
+
+  for (auto& h : handles)
+  {
+    Wait(h);
+  }
+}
+
+//==============================================================================
+TaskScheduler::Task& TaskScheduler::GetTask(uint32_t index) const
+{
+  Task* block = m_taskBlocks[index >> kTaskBlockBits].load(std::memory_order_acquire);
+  XR_ASSERT(TaskScheduler, block);
+  return block[index & (kTaskBlockSize - 1)];
+}
+
+//==============================================================================
+uint32_t TaskScheduler::AllocateTask()
+{
+  while (true)
+  {
+    {
+      std::unique_lock<Spinlock> lock(m_poolLock);
+      if (m_freeTasks.empty() && m_numTaskBlocks < kMaxTaskBlocks)
+      {
+        // Blocks are never moved or freed until destruction, so GetTask() may
+        // be called without locking.
+        const uint32_t iBlock = m_numTaskBlocks;
+        m_taskBlocks[iBlock].store(new Task[kTaskBlockSize], std::memory_order_release);
+        ++m_numTaskBlocks;
+
+        m_freeTasks.reserve(m_freeTasks.size() + kTaskBlockSize);
+        for (uint32_t i = kTaskBlockSize; i > 0; --i)
+        {
+          m_freeTasks.push_back((iBlock << kTaskBlockBits) + i - 1);
+        }
+      }
+
+      if (!m_freeTasks.empty())
+      {
+        const uint32_t index = m_freeTasks.back();
+        m_freeTasks.pop_back();
+        return index;
+      }
+    }
+
+    // All of the tasks that we may have are in flight; help complete some.
+    if (!RunOne())
+    {
+      std::this_thread::yield();
+    }
+  }
+}
+
+//==============================================================================
+void TaskScheduler::FreeTask(uint32_t index)
+{
+  std::unique_lock<Spinlock> lock(m_poolLock);
+  m_freeTasks.push_back(index);
+}
+
+//==============================================================================
+TaskScheduler::Handle TaskScheduler::SubmitTask(uint32_t index,
+  Handle const* dependencies, size_t numDependencies)
+{
+  Task& task = GetTask(index);
+  Handle h;
+  h.index = index;
+  h.generation = task.generation.load(std::memory_order_relaxed);
+
+  // Hold an extra dependency while registering with the others, so that the
+  // task can't be enqueued before we're done.
+  task.numDependencies.store(1, std::memory_order_relaxed);
+  for (auto i0 = dependencies, i1 = dependencies + numDependencies; i0 != i1; ++i0)
+  {
+    if (!i0->IsValid())
+    {
+      continue;
+    }
+
+    Task& dep = GetTask(i0->index);
+    std::unique_lock<Spinlock> lock(dep.lock);
+    if (dep.generation.load(std::memory_order_relaxed) == i0->generation)
+    {
+      dep.dependents.push_back(index);
+      task.numDependencies.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  m_numInFlight.fetch_add(1);
+  if (task.numDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+  {
+    Enqueue(index);
+  }
+  return h;
+}
+
+//==============================================================================
+void TaskScheduler::Enqueue(uint32_t index)
+{
+  uint32_t iThread;
+  if (tContext.scheduler == this)
+  {
+    iThread = tContext.index;
+  }
+  else
+  {
+    iThread = m_nextThread.fetch_add(1, std::memory_order_relaxed) % m_threads.size();
+  }
+  m_threads[iThread]->Push(index);
+
+  m_numQueued.fetch_add(1);
+  if (m_numSleeping.load() > 0)
+  {
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_sleepCV.notify_one();
+  }
+}
+
+//==============================================================================
+bool TaskScheduler::TryDequeue(uint32_t& outIndex)
+{
+  if (m_numQueued.load(std::memory_order_relaxed) <= 0)
+  {
+    return false;
+  }
+
+  const uint32_t numThreads = GetNumThreads();
+  uint32_t iStart = 0;
+  if (tContext.scheduler == this)
+  {
+    // Our own queue first, newest task first.
+    iStart = tContext.index;
+    if (m_threads[iStart]->Pop(outIndex))
+    {
+      m_numQueued.fetch_sub(1);
+      return true;
+    }
+    ++iStart;
+  }
+
+  for (uint32_t i = 0; i < numThreads; ++i)
+  {
+    if (m_threads[(iStart + i) % numThreads]->Steal(outIndex))
+    {
+      m_numQueued.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+//==============================================================================
+bool TaskScheduler::RunOne()
+{
+  uint32_t index;
+  bool result = TryDequeue(index);
+  if (result)
+  {
+    Execute(index);
+  }
+  return result;
+}
+
+//==============================================================================
+void TaskScheduler::Execute(uint32_t index)
+{
+  Task& task = GetTask(index);
+  task.Run();
+  task.function = nullptr;
+  task.job = nullptr;
+
+  std::vector<uint32_t> dependents;
+  {
+    std::unique_lock<Spinlock> lock(task.lock);
+    task.generation.fetch_add(1, std::memory_order_acq_rel);
+    dependents.swap(task.dependents);
+  }
+
+  for (auto i : dependents)
+  {
+    if (GetTask(i).numDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      Enqueue(i);
+    }
+  }
+
+  FreeTask(index);
+  m_numInFlight.fetch_sub(1);
+}
+
+//==============================================================================
+void TaskScheduler::Loop(uint32_t threadIndex)
+{
+  tContext.scheduler = this;
+  tContext.index = threadIndex;
+
+  int spins = 0;
+  while (true)
+  {
+    if (RunOne())
+    {
+      spins = 0;
+      continue;
+    }
+
+    if (spins < kSpinCount)
+    {
+      ++spins;
+      std::this_thread::yield();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_numSleeping.fetch_add(1);
+    m_sleepCV.wait(lock, [this] {
+      return m_quitting || m_numQueued.load() > 0;
+    });
+    m_numSleeping.fetch_sub(1);
+
+    if (m_quitting)
+    {
+      break;
+    }
+    spins = 0;
+  }
+}
+
+} // xr
@@ -11,10 +11,20 @@
 
 namespace xr
 {
+namespace
+{
+
+const int kSpinCount = 64;
+
+}
 
 //==============================================================================
-Worker::Worker()
-: m_finishing(false),
+Worker::Worker(QueueMode mode, size_t capacity)
+: m_mode(mode),
+  m_ring(mode == QueueMode::LockFree ? new JobRing(capacity) : nullptr),
+  m_numPosts(0),
+  m_finalized(false),
+  m_finishing(false),
   m_thread(std::thread(&Worker::Loop, this)),
   m_isSuspended(false)
 {}
@@ -22,15 +32,39 @@ Worker::Worker()
 //==============================================================================
 void  Worker::Enqueue(Job& j)
 {
-  std::unique_lock<std::mutex> lock(m_jobsMutex);
-  if (m_thread.joinable())
+  if (m_mode == QueueMode::LockFree)
   {
-    m_jobs.push_back(&j);
-    m_workSemaphore.Post();
+    if (m_finalized.load())
+    {
+      j.Cancel();
+      return;
+    }
+
+    while (!m_ring->try_push(&j))
+    {
+      std::this_thread::yield();
+    }
+    Post();
+
+    // If we've raced Finalize(), the worker thread may have quit before
+    // getting to our job.
+    if (m_finalized.load())
+    {
+      CancelRing();
+    }
   }
   else
   {
-    j.Cancel();
+    std::unique_lock<std::mutex> lock(m_jobsMutex);
+    if (m_thread.joinable())
+    {
+      m_jobs.push_back(&j);
+      m_workSemaphore.Post();
+    }
+    else
+    {
+      j.Cancel();
+    }
   }
 }
 
@@ -54,6 +88,12 @@ void Worker::Resume()
 //==============================================================================
 void Worker::CancelPendingJobs()
 {
+  if (m_mode == QueueMode::LockFree)
+  {
+    CancelRing();
+    return;
+  }
+
   JobQueue  q;
   {
     std::unique_lock<std::mutex>  lock(m_jobsMutex);
@@ -78,6 +118,18 @@ void  Worker::Finalize()
 {
   XR_ASSERTMSG(Worker, std::this_thread::get_id() != m_thread.get_id(),
     ("Attempt to join worker thread with itself."));
+  if (m_mode == QueueMode::LockFree)
+  {
+    if (!m_finishing.exchange(true))
+    {
+      Post();
+    }
+    else
+    {
+      XR_TRACE(Worker, ("Worker %p was already finalized.", this));
+    }
+  }
+  else
   {
     std::unique_lock<std::mutex>  lock(m_jobsMutex);
     if (!m_finishing)
@@ -95,30 +147,147 @@ void  Worker::Finalize()
   {
     m_thread.join();
   }
+
+  if (m_mode == QueueMode::LockFree)
+  {
+    // Anything that was enqueued concurrently and missed by the worker thread.
+    m_finalized.store(true);
+    CancelRing();
+  }
 }
 
 //==============================================================================
-void  Worker::Loop()
+void Worker::Post()
 {
+  XR_ASSERT(Worker, m_mode == QueueMode::LockFree);
+  if (m_numPosts.fetch_add(1) < 0)
+  {
+    // The worker thread is waiting; only now do we need the lock.
+    std::unique_lock<std::mutex>  lock(m_jobsMutex);
+    m_workSemaphore.Post();
+  }
+}
+
+//==============================================================================
+void Worker::Wait()
+{
+  XR_ASSERT(Worker, m_mode == QueueMode::LockFree);
+  // Spin briefly before committing to the semaphore, since going to sleep means
+  // that the next Post() will need to take the lock and wake us up.
+  for (int i = 0; i < kSpinCount; ++i)
+  {
+    if (TryWait())
+    {
+      return;
+    }
+    std::this_thread::yield();
+  }
+
+  if (m_numPosts.fetch_sub(1) <= 0)
+  {
+    std::unique_lock<std::mutex>  lock(m_jobsMutex);
+    m_workSemaphore.Wait(lock);
+  }
+}
+
+//==============================================================================
+bool Worker::TryWait()
+{
+  XR_ASSERT(Worker, m_mode == QueueMode::LockFree);
+  // Sequentially consistent, so that Enqueue() and Finalize() may not both
+  // miss a job that was pushed while finalizing.
+  int32_t posts = m_numPosts.load();
+  while (posts > 0)
+  {
+    if (m_numPosts.compare_exchange_weak(posts, posts - 1))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+//==============================================================================
+void Worker::CancelRing()
+{
+  // Every post that we take is backed by a job in the ring, unless it was
+  // Finalize()'s, or the worker thread has taken our job using Finalize()'s
+  // post; in which case we give it back.
   Job* job;
-  while (true)
+  while (TryWait())
   {
-    // Tick the queue.
+    if (m_ring->try_pop(job))
+    {
+      job->Cancel();
+    }
+    else
     {
-      std::unique_lock<std::mutex>  lock(m_jobsMutex);
-      m_workSemaphore.Wait(lock);
+      Post();
+      break;
+    }
+  }
 
-      // If there's no more jobs and the flag is set, we're done.
-      if (m_jobs.empty() && m_finishing)
+  // Once the worker thread has quit, there's no one else to take them.
+  if (m_finalized.load())
+  {
+    while (m_ring->try_pop(job))
+    {
+      job->Cancel();
+    }
+  }
+}
+
+//==============================================================================
+Worker::Job* Worker::NextJob()
+{
+  Job* job = nullptr;
+  if (m_mode == QueueMode::LockFree)
+  {
+    Wait();
+
+    // Every post but Finalize()'s is backed by a job, however with multiple
+    // producers, it may not have been published yet: a producer may have
+    // claimed the slot that we're popping from, while another one has already
+    // filled and posted the next one. Only once finishing may a post with no
+    // job be Finalize()'s; any job that we've missed will be cancelled then.
+    while (!m_ring->try_pop(job))
+    {
+      if (m_finishing.load())
       {
+        job = nullptr;
         break;
       }
+      std::this_thread::yield();
+    }
+  }
+  else
+  {
+    std::unique_lock<std::mutex>  lock(m_jobsMutex);
+    m_workSemaphore.Wait(lock);
 
+    // If there's no more jobs and the flag is set, we're done.
+    if (!(m_jobs.empty() && m_finishing))
+    {
       // Take the next job.
       XR_ASSERT(Worker, !m_jobs.empty());
       job = m_jobs.front();
       m_jobs.pop_front();
     }
+  }
+  return job;
+}
+
+//==============================================================================
+void  Worker::Loop()
+{
+  while (true)
+  {
+    // Tick the queue.
+    Job* job = NextJob();
+    if (!job)
+    {
+      break;
+    }
 
     // Start the job.
     job->Start();
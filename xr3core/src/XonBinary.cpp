@@ -0,0 +1,254 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xr/xon/XonBinary.hpp"
+#include "xr/memory/memory.hpp"
+#include "xr/debug.hpp"
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+namespace xr
+{
+namespace
+{
+
+//==============================================================================
+void ThrowInvalidTypeError(char const* operationName)
+{
+  throw XonEntity::Exception(XonEntity::Exception::Type::InvalidType,
+    std::string("Invalid type: ") + operationName + " not supported.");
+}
+
+//==============================================================================
+void ThrowIndexOutOfBoundsError(size_t index, size_t bounds)
+{
+  throw XonEntity::Exception(XonEntity::Exception::Type::IndexOutOfBounds,
+    "Index (" + std::to_string(index) + ") out of bounds (" + std::to_string(bounds) + ").");
+}
+
+//==============================================================================
+void ThrowInvalidKeyError(std::string_view key)
+{
+  const size_t kMaxSize = 100;
+  const bool overSized = key.size() > kMaxSize;
+  if (overSized)
+  {
+    key = key.substr(key.size() - kMaxSize);
+  }
+  throw XonEntity::Exception(XonEntity::Exception::Type::InvalidKey,
+    "Invalid key '" + std::string(overSized ? "..." : "") + std::string(key) + "'.");
+}
+
+const size_t kAlignment = 4;
+
+}
+
+//==============================================================================
+class XonBinary::Builder
+{
+public:
+  explicit Builder(std::vector<uint8_t>& out)
+  : m_out(out)
+  {}
+
+  uint32_t Allocate(size_t size)
+  {
+    const size_t position = m_out.size();
+    XR_ASSERT(XonBinary, position % kAlignment == 0);
+    m_out.resize(position + Align(size, kAlignment));
+    return static_cast<uint32_t>(position);
+  }
+
+  template <typename T>
+  void Set(uint32_t position, T const& value)
+  {
+    std::memcpy(m_out.data() + position, &value, sizeof(T));
+  }
+
+  uint32_t WriteObject(XonObject const& object)
+  {
+    const size_t numElements = object.GetNumElements();
+    XR_ASSERT(XonBinary, numElements <= (UINT32_MAX >> Entity::kKindBits));
+    std::vector<std::string> keys;
+    object.GetKeys(keys);
+
+    const uint32_t position = Allocate(sizeof(Object) + numElements * sizeof(int32_t) +
+      keys.size() * sizeof(Object::Key));
+    Set(position, uint32_t((numElements << Entity::kKindBits) | Entity::kObject));
+    Set(position + sizeof(uint32_t), uint32_t(keys.size()));
+
+    std::unordered_map<XonEntity const*, uint32_t> indices;
+    uint32_t index = 0;
+    uint32_t offsetPosition = position + sizeof(Object);
+    for (auto e : object)
+    {
+      indices[e] = index++;
+
+      const uint32_t elementPosition = e->Is(XonEntity::Type::Object) ?
+        WriteObject(e->ToObject()) : WriteValue(e->ToValue());
+      Set(offsetPosition, int32_t(elementPosition - offsetPosition));
+      offsetPosition += sizeof(int32_t);
+    }
+
+    // GetKeys() has sorted them.
+    uint32_t keyPosition = offsetPosition;
+    for (auto& k : keys)
+    {
+      const uint32_t stringPosition = WriteString(k.data(), k.size());
+      Set(keyPosition, Object::Key{ int32_t(stringPosition - keyPosition),
+        indices[object.TryGet(k)] });
+      keyPosition += sizeof(Object::Key);
+    }
+    return position;
+  }
+
+  uint32_t WriteValue(XonValue const& value)
+  {
+    const char* string = value.GetString();
+    uint32_t position;
+    if (string)
+    {
+      position = WriteString(string, value.GetLength());
+    }
+    else
+    {
+      if (m_nullPosition == 0)
+      {
+        m_nullPosition = Allocate(sizeof(Value));
+        Set(m_nullPosition, uint32_t(Entity::kNull));
+      }
+      position = m_nullPosition;
+    }
+    return position;
+  }
+
+  uint32_t WriteString(char const* string, size_t length)
+  {
+    XR_ASSERT(XonBinary, length <= (UINT32_MAX >> Entity::kKindBits));
+    auto iInsert = m_strings.insert({ std::string(string, length), 0 });
+    if (iInsert.second)
+    {
+      const uint32_t position = Allocate(sizeof(Value) + length + 1);
+      Set(position, uint32_t((length << Entity::kKindBits) | Entity::kValue));
+      std::memcpy(m_out.data() + position + sizeof(Value), string, length);
+      iInsert.first->second = position;
+    }
+    return iInsert.first->second;
+  }
+
+private:
+  std::vector<uint8_t>& m_out;
+  std::unordered_map<std::string, uint32_t> m_strings;  // to their Values
+  uint32_t m_nullPosition = 0;
+};
+
+//==============================================================================
+void XonBinary::Write(XonObject const& root, std::vector<uint8_t>& out)
+{
+  out.clear();
+  Builder builder(out);
+  const uint32_t headerPosition = builder.Allocate(sizeof(Header));
+  builder.WriteObject(root);
+  builder.Set(headerPosition, Header{ kMagic, kVersion, uint32_t(out.size()), 0 });
+}
+
+//==============================================================================
+bool XonBinary::Write(XonObject const& root, std::ostream& stream)
+{
+  std::vector<uint8_t> buffer;
+  Write(root, buffer);
+  stream.write(reinterpret_cast<char const*>(buffer.data()), buffer.size());
+  return !stream.fail();
+}
+
+//==============================================================================
+XonBinary::Object const* XonBinary::GetRoot(void const* data, size_t size)
+{
+  XR_ASSERT(XonBinary, data != nullptr);
+  XR_ASSERTMSG(XonBinary, reinterpret_cast<uintptr_t>(data) % kAlignment == 0,
+    ("Binary XON must be %zu byte aligned.", kAlignment));
+  Object const* root = nullptr;
+  Header header;
+  if (size >= sizeof(Header) + sizeof(Object))
+  {
+    std::memcpy(&header, data, sizeof(Header));
+    if (header.magic == kMagic && header.version == kVersion && header.size <= size)
+    {
+      auto entity = reinterpret_cast<Entity const*>(static_cast<uint8_t const*>(data) +
+        sizeof(Header));
+      if (entity->GetKind() == Entity::kObject)
+      {
+        root = static_cast<Object const*>(entity);
+      }
+    }
+  }
+  return root;
+}
+
+//==============================================================================
+XonBinary::Object const& XonBinary::Entity::ToObject() const
+{
+  if (GetKind() != kObject)
+  {
+    ThrowInvalidTypeError("ToObject");
+  }
+  return static_cast<Object const&>(*this);
+}
+
+//==============================================================================
+XonBinary::Value const& XonBinary::Entity::ToValue() const
+{
+  if (GetKind() == kObject)
+  {
+    ThrowInvalidTypeError("ToValue");
+  }
+  return static_cast<Value const&>(*this);
+}
+
+//==============================================================================
+XonBinary::Entity const* XonBinary::Object::TryGet(std::string_view key) const
+{
+  auto keys = GetKeyTable();
+  auto keysEnd = keys + m_numKeys;
+  auto iFind = std::lower_bound(keys, keysEnd, key, [](Key const& k, std::string_view value) {
+    return k.GetString() < value;
+  });
+
+  Entity const* result = nullptr;
+  if (iFind != keysEnd && iFind->GetString() == key)
+  {
+    result = Resolve(GetOffsets() + iFind->index);
+  }
+  return result;
+}
+
+//==============================================================================
+XonBinary::Entity const& XonBinary::Object::Get(std::string_view key) const
+{
+  auto result = TryGet(key);
+  if (!result)
+  {
+    ThrowInvalidKeyError(key);
+  }
+  return *result;
+}
+
+//==============================================================================
+XonBinary::Entity const& XonBinary::Object::operator[](size_t index) const
+{
+  if (index >= GetSize())
+  {
+    ThrowIndexOutOfBoundsError(index, GetSize());
+  }
+  return *Resolve(GetOffsets() + index);
+}
+
+} // xr
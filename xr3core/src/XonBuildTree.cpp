@@ -7,10 +7,12 @@
 //
 //==============================================================================
 #include "xr/xon/XonBuildTree.hpp"
-#include "xr/memory/Queue.hpp"
+#include "xr/memory/Arena.hpp"
 #include "xr/strings/stringutils.hpp"
-#include <list>
+#include <algorithm>
 #include <cstring>
+#include <limits>
+#include <vector>
 
 namespace xr
 {
@@ -18,24 +20,18 @@ namespace xr
 //==============================================================================
 struct XonTreeBuildState
 {
-  struct Frame
+  // Elements are collected until the end of their parent object, which then
+  // can allocate exactly as much storage as it needs.
+  struct Element
   {
-    XonObject*            object;
-    XonParser::String     keyCache{};
+    XonParser::String key;
+    XonEntity*        entity;
+  };
 
-    void AddElement(XonEntity& v)
-    {
-      if (keyCache.start)
-      {
-        XR_ASSERT(XonTreeBuildState, keyCache.length < std::numeric_limits<size_t>::max());
-        object->AddElement(std::string_view{ keyCache.start, keyCache.length }, v);
-        keyCache.start = nullptr;  // consume key
-      }
-      else
-      {
-        object->AddElement(v);
-      }
-    }
+  struct Frame
+  {
+    XonObject*  object;
+    size_t      firstElement;  // in elements
   };
 
   static bool EventHandler(XonParser::Event e, XonParser::String const* string,
@@ -44,14 +40,47 @@ struct XonTreeBuildState
     return static_cast<XonTreeBuildState*>(userDataData)->HandleEvent(e, string);
   }
 
-  XonParser                   parser;
-  std::unique_ptr<XonObject>  root;
+  explicit XonTreeBuildState(Arena* a)
+  : arena{ a }
+  {}
+
+  ~XonTreeBuildState()
+  {
+    if (!arena)  // clean up after a failed parse; an Arena is reclaimed as a whole.
+    {
+      for (auto& e : elements)
+      {
+        delete e.entity;
+      }
+      delete root;
+    }
+  }
+
+  XonParser             parser;
+  Arena*                arena;
+  XonObject*            root = nullptr;
 
-  std::list<Frame> stack;
+  std::vector<Frame>    stack;
+  std::vector<Element>  elements;
+  XonParser::String     keyCache{};
+  std::vector<char>     buffer;
 
-  void AddElement(XonParser::String s)
+  template <typename T, typename... Args>
+  T* Create(Args&&... args)
+  {
+    return arena ?
+      new (arena->Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)..., *arena) :
+      new T(std::forward<Args>(args)...);
+  }
+
+  void AddElement(XonEntity& entity)
+  {
+    elements.push_back(Element{ keyCache, &entity });
+    keyCache.start = nullptr;  // consume key
+  }
+
+  void AddValue(XonParser::String s)
   {
-    std::vector<char> buffer;
     if (!s.isQuoted && strncmp(s.start, "null", s.length) == 0)
     {
       s.start = nullptr;
@@ -65,7 +94,35 @@ struct XonTreeBuildState
       s.start = buffer.data();
       s.length = replacedLen;
     }
-    stack.back().AddElement(*new XonValue(s.start, s.length));
+    AddElement(*Create<XonValue>(s.start, s.length));
+  }
+
+  void EndObject()
+  {
+    XR_ASSERT(XonTreeBuildState, !stack.empty());
+    auto& frame = stack.back();
+    const auto iBegin = elements.begin() + frame.firstElement;
+    const auto iEnd = elements.end();
+    const size_t numKeys = std::count_if(iBegin, iEnd, [](Element const& e) {
+      return e.key.start != nullptr;
+    });
+
+    auto object = frame.object;
+    object->Reserve(std::distance(iBegin, iEnd), numKeys);
+    for (auto i = iBegin; i != iEnd; ++i)
+    {
+      if (i->key.start)
+      {
+        XR_ASSERT(XonTreeBuildState, i->key.length < std::numeric_limits<size_t>::max());
+        object->AddElement(std::string_view{ i->key.start, i->key.length }, *i->entity);
+      }
+      else
+      {
+        object->AddElement(*i->entity);
+      }
+    }
+    elements.erase(iBegin, iEnd);
+    stack.pop_back();
   }
 
   bool HandleEvent(XonParser::Event e, XonParser::String const* string)
@@ -74,54 +131,68 @@ struct XonTreeBuildState
     {
     case XonParser::Event::ObjectBegin:
       {
-        auto object = new XonObject;
-        const bool first = root == nullptr;
-        if (first)
+        auto object = Create<XonObject>();
+        if (!root)
         {
-          XR_ASSERT(XonTreeBuildState, !root);
-          root.reset(object);
+          root = object;
         }
         else
         {
-          stack.back().AddElement(*object);
+          AddElement(*object);
         }
-        stack.push_back(Frame{ object });
+        stack.push_back(Frame{ object, elements.size() });
       }
       break;
 
     case XonParser::Event::ObjectEnd:
-      {
-        XR_ASSERT(XonTreeBuildState, !stack.empty());
-        stack.pop_back();
-      }
+      EndObject();
       break;
 
     case XonParser::Event::Key:
       XR_ASSERT(XonTreeBuildState, string);
-      stack.back().keyCache = *string;
+      keyCache = *string;
       break;
 
     case XonParser::Event::Value:
       XR_ASSERT(XonTreeBuildState, string);
-      AddElement(*string);
+      AddValue(*string);
       break;
     }
 
     return true;
   }
+
+  XonObject* Build(char const* string, size_t length, XonParser::State* outState)
+  {
+    bool success = parser.Parse(string, length, EventHandler, this);
+    if (outState)
+    {
+      *outState = parser.GetState();
+    }
+
+    XonObject* result = nullptr;
+    if (success)
+    {
+      XR_ASSERT(XonTreeBuildState, elements.empty());
+      std::swap(result, root);
+    }
+    return result;
+  }
 };
 
 //==============================================================================
 XonObject* XonBuildTree(char const* string, size_t length, XonParser::State* outState)
 {
-  XonTreeBuildState  rs;
-  bool success = rs.parser.Parse(string, length, XonTreeBuildState::EventHandler, &rs);
+  XonTreeBuildState  rs(nullptr);
+  return rs.Build(string, length, outState);
+}
 
-  if (outState)
-  {
-    *outState = rs.parser.GetState();
-  }
-  return success ? rs.root.release() : nullptr;
+//==============================================================================
+XonObject* XonBuildTree(char const* string, size_t length, Arena& arena,
+  XonParser::State* outState)
+{
+  XonTreeBuildState  rs(&arena);
+  return rs.Build(string, length, outState);
 }
 
 } // xr
@@ -7,9 +7,11 @@
 //
 //==============================================================================
 #include "xr/xon/XonEntity.hpp"
+#include "xr/memory/Arena.hpp"
 #include <algorithm>
 #include <string>
 #include <cstring>
+#include <limits>
 
 namespace xr
 {
@@ -32,20 +34,35 @@ void ThrowIndexOutOfBoundsError(size_t index, size_t bounds)
 }
 
 //==============================================================================
-void ThrowInvalidKeyError(const char* name)
+void ThrowInvalidKeyError(std::string_view name)
 {
   char msgBuffer[128];
-  auto len = strlen(name);
   const size_t kMaxSize = 100;
-  bool overSized = len > kMaxSize;
+  bool overSized = name.size() > kMaxSize;
   if (overSized)
   {
-    name += len - kMaxSize;
+    name.remove_prefix(name.size() - kMaxSize);
   }
-  sprintf(msgBuffer, "Invalid key '%s%s'.", overSized ? "..." : "", name);
+  sprintf(msgBuffer, "Invalid key '%s%.*s'.", overSized ? "..." : "",
+    static_cast<int>(name.size()), name.data());
   throw XonEntity::Exception(XonEntity::Exception::Type::InvalidKey, msgBuffer);
 }
 
+// Objects with up to this many keys are searched linearly, without an index.
+const uint32_t kMaxUnindexedKeys = 8;
+
+//==============================================================================
+uint32_t HashKey(std::string_view key)
+{
+  // FNV-1a; keys are short, and the hash must not depend on the global seed.
+  uint32_t hash = 2166136261u;
+  for (auto c : key)
+  {
+    hash = (hash ^ uint8_t(c)) * 16777619u;
+  }
+  return hash;
+}
+
 } //
 
 //==============================================================================
@@ -107,12 +124,28 @@ XonValue const& XonEntity::ToValue() const
 //==============================================================================
 XonObject::XonObject() = default;
 
+//==============================================================================
+XonObject::XonObject(Arena& arena)
+: m_arena{ &arena }
+{}
+
 //==============================================================================
 XonObject::~XonObject()
 {
-  for (auto p : m_elements)
+  if (!m_arena)
   {
-    delete p;
+    for (auto p : *this)
+    {
+      delete p;
+    }
+
+    for (auto i = m_keys, iEnd = m_keys + m_numKeys; i != iEnd; ++i)
+    {
+      Deallocate(const_cast<char*>(i->string));
+    }
+    Deallocate(m_elements);
+    Deallocate(m_keys);
+    Deallocate(m_index);
   }
 }
 
@@ -123,90 +156,124 @@ XonEntity::Type XonObject::GetType() const
 }
 
 //==============================================================================
-XonEntity* XonObject::TryGet(std::string const& name)
+XonEntity* XonObject::TryGet(std::string_view name)
 {
-  XonEntity* result = nullptr;
-  auto iFind = m_keyedElements.find(name);
-  if (iFind != m_keyedElements.end())
-  {
-    result = iFind->second;
-  }
-  return result;
+  auto key = FindKey(name, HashKey(name));
+  return key ? key->element : nullptr;
 }
 
 //==============================================================================
-XonEntity const* XonObject::TryGet(std::string const& name) const
+XonEntity const* XonObject::TryGet(std::string_view name) const
 {
-  XonEntity* result = nullptr;
-  auto iFind = m_keyedElements.find(name);
-  if (iFind != m_keyedElements.end())
-  {
-    result = iFind->second;
-  }
-  return result;
+  auto key = FindKey(name, HashKey(name));
+  return key ? key->element : nullptr;
 }
 
 //==============================================================================
-XonEntity& XonObject::Get(std::string const& name)
+XonEntity& XonObject::Get(std::string_view name)
 {
   auto result = TryGet(name);
   if (!result)
   {
-    ThrowInvalidKeyError(name.c_str());
+    ThrowInvalidKeyError(name);
   }
   return *result;
 }
 
 //==============================================================================
-XonEntity const& XonObject::Get(std::string const& name) const
+XonEntity const& XonObject::Get(std::string_view name) const
 {
   auto result = TryGet(name);
   if (!result)
   {
-    ThrowInvalidKeyError(name.c_str());
+    ThrowInvalidKeyError(name);
   }
   return *result;
 }
 
+//==============================================================================
+void XonObject::Reserve(size_t numElements, size_t numKeys)
+{
+  XR_ASSERT(XonObject, numElements < std::numeric_limits<uint32_t>::max());
+  XR_ASSERT(XonObject, numKeys <= numElements);
+  if (numElements > m_elementsCapacity)
+  {
+    ReserveElements(static_cast<uint32_t>(numElements));
+  }
+
+  if (numKeys > m_keysCapacity)
+  {
+    ReserveKeys(static_cast<uint32_t>(numKeys));
+  }
+}
+
 //==============================================================================
 void XonObject::AddElement(XonEntity& value)
 {
-  m_elements.push_back(&value);
+  if (m_numElements == m_elementsCapacity)
+  {
+    ReserveElements(std::max(m_elementsCapacity * 2, 4u));
+  }
+  m_elements[m_numElements] = &value;
+  ++m_numElements;
 }
 
 //==============================================================================
 void XonObject::AddElement(std::string_view key, XonEntity& value)
 {
   AddElement(value);
-  m_keyedElements[std::string{ key }] = &value;
+  const uint32_t hash = HashKey(key);
+  if (auto k = FindKey(key, hash))
+  {
+    k->element = &value;
+    return;
+  }
+
+  if (m_numKeys == m_keysCapacity)
+  {
+    ReserveKeys(std::max(m_keysCapacity * 2, 4u));
+  }
+
+  XR_ASSERT(XonObject, key.size() < std::numeric_limits<uint32_t>::max());
+  auto string = static_cast<char*>(Allocate(key.size(), 1));
+  std::copy(key.begin(), key.end(), string);
+
+  const uint32_t keyIndex = m_numKeys;
+  m_keys[keyIndex] = Key{ string, static_cast<uint32_t>(key.size()), hash, &value };
+  ++m_numKeys;
+  if (m_index)
+  {
+    Index(keyIndex);
+  }
 }
 
 //==============================================================================
 void XonObject::GetKeys(std::vector<std::string>& keys) const
 {
-  if (keys.capacity() < m_keyedElements.size())
+  keys.clear();
+  if (keys.capacity() < m_numKeys)
   {
-    keys.reserve(m_keyedElements.size());
+    keys.reserve(m_numKeys);
   }
 
-  keys.clear();
-  GetKeys(std::back_inserter(keys));
+  for (auto k : GetSortedKeyIndices())
+  {
+    keys.emplace_back(m_keys[k].string, m_keys[k].length);
+  }
 }
 
 //==============================================================================
 bool XonObject::HasElement(XonEntity const& value) const
 {
-  return std::find_if(m_elements.begin(), m_elements.end(), [p = &value](auto& v) {
-    return p == v;
-  }) != m_elements.end();
+  return std::find(begin(), end(), &value) != end();
 }
 
 //==============================================================================
 XonEntity& XonObject::operator[](size_t index)
 {
-  if (index >= m_elements.size())
+  if (index >= m_numElements)
   {
-    ThrowIndexOutOfBoundsError(index, m_elements.size());
+    ThrowIndexOutOfBoundsError(index, m_numElements);
   }
   return *m_elements[index];
 }
@@ -214,13 +281,132 @@ XonEntity& XonObject::operator[](size_t index)
 //==============================================================================
 XonEntity const& XonObject::operator[](size_t index) const
 {
-  if (index >= m_elements.size())
+  if (index >= m_numElements)
   {
-    ThrowIndexOutOfBoundsError(index, m_elements.size());
+    ThrowIndexOutOfBoundsError(index, m_numElements);
   }
   return *m_elements[index];
 }
 
+//==============================================================================
+void* XonObject::Allocate(size_t size, size_t alignment)
+{
+  return m_arena ? m_arena->Allocate(size, alignment) : ::operator new(size);
+}
+
+//==============================================================================
+void XonObject::Deallocate(void* p)
+{
+  if (!m_arena)
+  {
+    ::operator delete(p);
+  }
+}
+
+//==============================================================================
+void XonObject::ReserveElements(uint32_t capacity)
+{
+  auto elements = static_cast<XonEntity**>(Allocate(capacity * sizeof(XonEntity*),
+    alignof(XonEntity*)));
+  std::copy(m_elements, m_elements + m_numElements, elements);
+  Deallocate(m_elements);
+  m_elements = elements;
+  m_elementsCapacity = capacity;
+}
+
+//==============================================================================
+void XonObject::ReserveKeys(uint32_t capacity)
+{
+  auto keys = static_cast<Key*>(Allocate(capacity * sizeof(Key), alignof(Key)));
+  std::copy(m_keys, m_keys + m_numKeys, keys);
+  Deallocate(m_keys);
+  m_keys = keys;
+  m_keysCapacity = capacity;
+
+  // Index keys beyond the first few, keeping the load factor at most 1/2.
+  if (capacity > kMaxUnindexedKeys)
+  {
+    uint32_t indexSize = 1;
+    while (indexSize < capacity * 2)
+    {
+      indexSize <<= 1;
+    }
+
+    if (indexSize - 1 != m_indexMask)
+    {
+      Deallocate(m_index);
+      m_index = static_cast<uint32_t*>(Allocate(indexSize * sizeof(uint32_t),
+        alignof(uint32_t)));
+      std::fill(m_index, m_index + indexSize, 0);
+      m_indexMask = indexSize - 1;
+      for (uint32_t i = 0; i < m_numKeys; ++i)
+      {
+        Index(i);
+      }
+    }
+  }
+}
+
+//==============================================================================
+void XonObject::Index(uint32_t keyIndex)
+{
+  uint32_t slot = m_keys[keyIndex].hash & m_indexMask;
+  while (m_index[slot] != 0)
+  {
+    slot = (slot + 1) & m_indexMask;
+  }
+  m_index[slot] = keyIndex + 1;
+}
+
+//==============================================================================
+XonObject::Key* XonObject::FindKey(std::string_view key, uint32_t hash) const
+{
+  auto matches = [hash, key](Key const& k) {
+    return k.hash == hash && k.length == key.size() &&
+      std::equal(key.begin(), key.end(), k.string);
+  };
+
+  if (m_index)
+  {
+    uint32_t slot = hash & m_indexMask;
+    while (uint32_t i = m_index[slot])
+    {
+      if (matches(m_keys[i - 1]))
+      {
+        return m_keys + (i - 1);
+      }
+      slot = (slot + 1) & m_indexMask;
+    }
+  }
+  else
+  {
+    for (auto i = m_keys, iEnd = m_keys + m_numKeys; i != iEnd; ++i)
+    {
+      if (matches(*i))
+      {
+        return i;
+      }
+    }
+  }
+  return nullptr;
+}
+
+//==============================================================================
+std::vector<uint32_t> XonObject::GetSortedKeyIndices() const
+{
+  std::vector<uint32_t> indices(m_numKeys);
+  for (uint32_t i = 0; i < m_numKeys; ++i)
+  {
+    indices[i] = i;
+  }
+
+  std::sort(indices.begin(), indices.end(), [this](uint32_t i0, uint32_t i1) {
+    return std::string_view{ m_keys[i0].string, m_keys[i0].length } <
+      std::string_view{ m_keys[i1].string, m_keys[i1].length };
+  });
+  return indices;
+}
+
 //==============================================================================
 XonValue::XonValue() = default;
 
@@ -242,10 +428,27 @@ XonValue::XonValue(std::string const& string):
   XonValue{ string.c_str(), string.size() }
 {}
 
+//==============================================================================
+XonValue::XonValue(const char* value, size_t length, Arena& arena):
+  m_value{ nullptr },
+  m_length{ length },
+  m_isArenaAllocated{ true }
+{
+  if (value)
+  {
+    m_value = static_cast<char*>(arena.Allocate(length + 1, 1));
+    std::copy(value, value + length, m_value);
+    m_value[length] = '\0';
+  }
+}
+
 //==============================================================================
 XonValue::~XonValue()
 {
-  delete[] m_value;
+  if (!m_isArenaAllocated)
+  {
+    delete[] m_value;
+  }
 }
 
 //==============================================================================
@@ -0,0 +1,234 @@
+#ifndef XR_JSONDOCUMENT_HPP
+#define XR_JSONDOCUMENT_HPP
+//==============================================================================
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xr/types/fundamentals.hpp"
+#include "xr/memory/Arena.hpp"
+#include "JsonEntity.hpp"
+#include "JsonParser.hpp"
+#include <cstdint>
+
+namespace xr
+{
+namespace JSON
+{
+
+//==============================================================================
+///@brief Parses JSON into a tree of Nodes which are all allocated from a single
+/// Arena, as opposed to Reader, which allocates every Entity, and copies every
+/// string, individually. String values and keys point into the source, which
+/// must therefore outlive the contents of the Document. The whole of the tree
+/// is freed at once, on the next Parse(), Clear(), or destruction.
+///@note Only the values of numbers, booleans and nulls are normalised the way
+/// that Reader does; strings are as they appear in the source.
+class Document
+{
+  XR_NONCOPY_DECL(Document)
+
+public:
+  // types
+  class Node
+  {
+  public:
+    // general
+    Type        GetType() const;
+
+    ///@return The key of an object member, nullptr for anything else.
+    const char* GetKey() const;
+    size_t      GetKeySize() const;
+
+    ///@return The value of VALUE nodes, nullptr for objects, arrays, and null
+    /// values. Values of numbers and booleans are null terminated, and so
+    /// are strings, if the Document was parsed in situ.
+    const char* GetValue() const;
+    size_t      GetValueSize() const;  // values. objects and arrays return 0
+
+    size_t      GetNumChildren() const;  // objects. arrays and values return 0
+    size_t      GetNumElements() const;  // arrays. objects and values return 0
+
+    ///@return The member of an object with the given @a key, if it's of
+    /// @a acceptType; nullptr otherwise.
+    Node const* GetChild(const char* key, Type acceptType = ANY) const;
+    Node const* GetChild(const char* key, size_t keySize, Type acceptType = ANY) const;
+
+    ///@return The element of an array at the given @a index, if it's of
+    /// @a acceptType; nullptr otherwise.
+    Node const* GetElement(size_t index, Type acceptType = ANY) const;
+
+    ///@return The first member of an object, or element of an array.
+    Node const* GetFirstChild() const;
+    Node const* GetNextSibling() const;
+
+  private:
+    // data
+    Type        m_type;
+    uint32_t    m_size;  // of the value, or the number of children / elements
+    const char* m_key;
+    uint32_t    m_keySize;
+    union
+    {
+      const char* m_value;
+      Node*       m_firstChild;
+    };
+    Node**      m_elements;  // arrays only
+    Node*       m_next;
+
+    friend class Document;
+  };
+
+  // structors
+  explicit Document(int maxDepth = kMaxParseDepthDefault);
+  ~Document();
+
+  // general
+  const ParserCore& GetState() const;
+
+  ///@brief Parses the given JSON-encoded @a string, which is only read.
+  ///@return Whether the parsing was successful. If not, the Document is empty.
+  bool  Parse(const char* string, size_t size);
+
+  ///@brief Parses the given JSON-encoded @a string, null terminating string
+  /// values and keys in place, by overwriting their closing quotes.
+  ///@return Whether the parsing was successful. If not, the Document is empty,
+  /// however @a string may have been modified.
+  bool  ParseInSitu(char* string, size_t size);
+
+  ///@return The root of the tree, or nullptr if empty.
+  Node const* GetRoot() const;
+
+  ///@brief Frees the tree, retaining some of the memory for the next Parse().
+  void  Clear();
+
+  ///@return The number of bytes the tree occupies.
+  size_t CalculateMemoryUsed() const;
+
+private:
+  // types
+  struct Frame
+  {
+    Node* node;
+    Node* lastChild;
+  };
+
+  // data
+  Parser  m_parser;
+  Arena   m_arena;
+  Node*   m_root;
+
+  // current parse
+  const char* m_sourceBegin;
+  const char* m_sourceEnd;
+  char* m_terminator;  // in situ only
+  bool  m_inSitu;
+  Parser::String m_key;
+  std::vector<Frame> m_frames;
+
+  // internal
+  bool  ParseInternal(const char* string, size_t size, bool inSitu);
+  void  OnEntity(Parser::Event e, const Parser::String* string);
+  Node* CreateNode(Type type);
+  void  Terminate(const char* string, size_t length);
+};
+
+//==============================================================================
+// implementation
+//==============================================================================
+inline
+Type Document::Node::GetType() const
+{
+  return m_type;
+}
+
+//==============================================================================
+inline
+const char* Document::Node::GetKey() const
+{
+  return m_key;
+}
+
+//==============================================================================
+inline
+size_t Document::Node::GetKeySize() const
+{
+  return m_keySize;
+}
+
+//==============================================================================
+inline
+const char* Document::Node::GetValue() const
+{
+  return m_type == VALUE ? m_value : nullptr;
+}
+
+//==============================================================================
+inline
+size_t Document::Node::GetValueSize() const
+{
+  return m_type == VALUE ? m_size : 0;
+}
+
+//==============================================================================
+inline
+size_t Document::Node::GetNumChildren() const
+{
+  return m_type == OBJECT ? m_size : 0;
+}
+
+//==============================================================================
+inline
+size_t Document::Node::GetNumElements() const
+{
+  return m_type == ARRAY ? m_size : 0;
+}
+
+//==============================================================================
+inline
+Document::Node const* Document::Node::GetElement(size_t index, Type acceptType) const
+{
+  if (m_type == ARRAY && index < m_size && (acceptType == ANY ||
+    m_elements[index]->m_type == acceptType))
+  {
+    return m_elements[index];
+  }
+  return nullptr;
+}
+
+//==============================================================================
+inline
+Document::Node const* Document::Node::GetFirstChild() const
+{
+  return m_type != VALUE ? m_firstChild : nullptr;
+}
+
+//==============================================================================
+inline
+Document::Node const* Document::Node::GetNextSibling() const
+{
+  return m_next;
+}
+
+//==============================================================================
+inline
+const ParserCore& Document::GetState() const
+{
+  return m_parser.GetState();
+}
+
+//==============================================================================
+inline
+Document::Node const* Document::GetRoot() const
+{
+  return m_root;
+}
+
+} // JSON
+} // xr
+
+#endif // XR_JSONDOCUMENT_HPP
@@ -73,6 +73,7 @@ private:
   bool  ParseArray();
   bool  ParseObject();
   bool  ParseValue();
+  const char* RequireStringEnd();
   void  OnEntity(Event e, const String* data);
 
   void  IncreaseDepth();
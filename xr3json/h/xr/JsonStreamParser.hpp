@@ -0,0 +1,158 @@
+#ifndef XR_JSONSTREAMPARSER_HPP
+#define XR_JSONSTREAMPARSER_HPP
+//==============================================================================
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "JsonParser.hpp"
+#include "xr/types/fundamentals.hpp"
+#include <string>
+#include <vector>
+
+namespace xr
+{
+namespace JSON
+{
+
+//==============================================================================
+///@brief Resumable JSON parser that takes its input in chunks of arbitrary
+/// size, as they become available, i.e. without the need to have the whole of
+/// the document in memory. Raises the same events, with the same values, as
+/// Parser does.
+///@note Strings, numbers and literals that are contained within a single
+/// chunk are passed to the handler directly from it; ones that span chunks are
+/// assembled in a buffer, the size of which is limited by @a maxTokenSize.
+/// Beside this, memory use only depends on the depth of the document.
+class StreamParser
+{
+  XR_NONCOPY_DECL(StreamParser)
+
+public:
+  // static
+  static const size_t kMaxTokenSizeDefault = 1 << 16;
+
+  // structors
+  explicit StreamParser(int maxDepth = kMaxParseDepthDefault,
+    size_t maxTokenSize = kMaxTokenSizeDefault);
+  ~StreamParser();
+
+  // general
+  ///@brief Sets a callback to call when the maximum depth has been exceeded,
+  /// or returned from. See Parser::SetAtMaxDepthCallback().
+  void SetAtMaxDepthCallback(Parser::AtMaxDepthCallback const& onAtMaxDepth);
+
+  ///@brief Starts parsing a new document, sending events to @a handler.
+  void  Start(Parser::EntityCallback const& handler);
+
+  ///@brief Parses the next @a size bytes of the document.
+  ///@return Whether the input was valid so far. Once it was found invalid,
+  /// any further input is ignored.
+  bool  Feed(const char* data, size_t size);
+
+  ///@brief Signifies the end of input.
+  ///@return Whether a complete document has been parsed.
+  bool  Finish();
+
+  ///@return Whether the root object or array has been closed.
+  bool  IsComplete() const;
+
+  ///@return Whether invalid input was encountered.
+  bool  HasError() const;
+
+  ///@return The row where parsing has stopped; 1-based.
+  int   GetRow() const;
+
+  ///@return The column where parsing has stopped; 1-based.
+  int   GetColumn() const;
+
+private:
+  // types
+  enum class State
+  {
+    Root,
+    ObjectKeyOrEnd,
+    ObjectKey,
+    Key,
+    Colon,
+    Value,
+    ArrayValueOrEnd,
+    String,
+    Number,
+    Literal,
+    CommaOrEnd,
+    Done,
+    Error
+  };
+
+  // data
+  const int m_maxDepth;
+  const size_t m_maxTokenSize;
+  std::unique_ptr<Parser::EntityCallback> m_handler;
+  std::unique_ptr<Parser::AtMaxDepthCallback> m_onAtMaxDepth;
+
+  State m_state;
+  std::vector<bool> m_isObject;  // for each level of nesting
+  int m_depth;
+  int m_row;
+  int m_column;
+  bool m_lastWasCR;
+
+  // current token
+  std::string m_token;  // parts of the token from previous chunks
+  bool m_escaped;  // strings
+  bool m_hasDecimal;  // numbers
+  bool m_hasExponential;
+  char m_prevChar;
+
+  // internal
+  const char* ParseChunk(const char* p, const char* end);
+  bool  AppendToken(const char* begin, const char* end);
+  bool  GetToken(const char* begin, const char* end, Parser::String& str);
+  bool  OnString(Parser::Event e, const char* begin, const char* end);
+  bool  OnNumber(const char* begin, const char* end);
+  bool  OnLiteral(const char* begin, const char* end);
+  void  BeginContainer(bool isObject);
+  void  EndContainer();
+  void  OnEntity(Parser::Event e, Parser::String const* string);
+  void  UpdatePosition(const char* begin, const char* end);
+};
+
+//==============================================================================
+// implementation
+//==============================================================================
+inline
+bool StreamParser::IsComplete() const
+{
+  return m_state == State::Done;
+}
+
+//==============================================================================
+inline
+bool StreamParser::HasError() const
+{
+  return m_state == State::Error;
+}
+
+//==============================================================================
+inline
+int StreamParser::GetRow() const
+{
+  return m_row;
+}
+
+//==============================================================================
+inline
+int StreamParser::GetColumn() const
+{
+  return m_column;
+}
+
+} // JSON
+} // xr
+
+#endif // XR_JSONSTREAMPARSER_HPP
@@ -20,8 +20,11 @@ namespace JSON
 {
 
 //==============================================================================
-///@brief Facilitates the writing of a JSON document, to a stream, allowing a
-/// variety of formatting options for indenting, line breaks etc.
+///@brief Facilitates the writing of a JSON document, allowing a variety of
+/// formatting options for indenting, line breaks etc.
+/// The output is formatted into an internal buffer, which is flushed to the
+/// destination - a stream or a Sink - in blocks of around kFlushSize bytes,
+/// or kept in memory if there's no destination.
 class Writer
 {
   XR_NONCOPY_DECL(Writer)
@@ -51,6 +54,18 @@ public:
     kNumEscapedChars
   };
 
+  ///@brief Destination for the output of a Writer.
+  struct Sink
+  {
+    // structors
+    virtual ~Sink() {}
+
+    // virtual
+    ///@brief Writes @a size bytes from @a data.
+    ///@return Whether the operation was successful.
+    virtual bool Write(char const* data, size_t size) = 0;
+  };
+
   struct Object;
 
   ///@brief Manages a JSON Array scope, closing it upon destruction.
@@ -115,10 +130,21 @@ public:
   static const char kEscapeChars[kNumEscapedChars];
   static const char* const kEscapeSequences[kNumEscapedChars];
 
+  ///@brief The number of bytes buffered before flushing to the destination.
+  static const size_t kFlushSize = 1 << 14;
+
   // structors
+  ///@brief Initialises The Writer to keep its output in memory - see
+  /// GetData() - and reserves space for @a maxDepth scopes on the stack.
+  explicit Writer(uint32_t maxDepth = kMaxParseDepthDefault);
+
   ///@brief Initialises The Writer to use the given @a stream and reserves
   /// space for @a maxDepth scopes on the stack.
   explicit Writer(std::ostream& stream, uint32_t maxDepth = kMaxParseDepthDefault);
+
+  ///@brief Initialises The Writer to use the given @a sink and reserves
+  /// space for @a maxDepth scopes on the stack.
+  explicit Writer(Sink& sink, uint32_t maxDepth = kMaxParseDepthDefault);
   ~Writer();
 
   // general
@@ -231,9 +257,33 @@ public:
   Writer& CloseScope();
 
   ///@brief Clears the stack, the completion flag and reassigns the stream,
-  /// allowing The Writer to be reused.
+  /// allowing The Writer to be reused. Any pending output is flushed to the
+  /// previous destination first.
   void Reset(std::ostream& stream);
 
+  ///@brief Clears the stack, the completion flag and reassigns the sink,
+  /// allowing The Writer to be reused. Any pending output is flushed to the
+  /// previous destination first.
+  void Reset(Sink& sink);
+
+  ///@brief Clears the stack, the completion flag, and the output, allowing
+  /// The Writer to be reused, keeping its output in memory. Any pending
+  /// output is flushed to the previous destination first.
+  void Reset();
+
+  ///@brief Writes any pending output to the destination. This happens
+  /// automatically when the document is complete, or The Writer is Reset()
+  /// or destroyed. No-op if the output is kept in memory.
+  ///@return Whether all output so far has been written successfully.
+  bool Flush();
+
+  ///@return The output that hasn't been flushed; with no stream or sink to
+  /// flush to, this is the whole document. Not null terminated.
+  char const* GetData() const;
+
+  ///@return The size of the output that hasn't been flushed, in bytes.
+  size_t GetSize() const;
+
 protected:
   // types
   struct Scope
@@ -255,11 +305,19 @@ protected:
   bool  m_allowSpace : 1;
   bool  m_autoEscapeString : 1;
   bool  m_isComplete : 1;
+  bool  m_hasFailed : 1;
 
   std::ostream* m_stream;
+  Sink* m_sink;
   std::vector<Scope>  m_scopes;
+  std::vector<char> m_buffer;
 
   // internal
+  void  _Write(char c);
+  void  _Write(const char* data, size_t size);
+  void  _WriteInt(int32_t value);
+  void  _WriteDouble(double value);
+  void  _WriteBool(bool value);
   void  _AddLinebreak(bool oneLiner);
   void  _AddIndent();
   void  _AddSpace();
@@ -270,6 +328,36 @@ protected:
   void  _ProcessEscaped(const char* value);
 };
 
+//==============================================================================
+// implementation
+//==============================================================================
+inline
+char const* Writer::GetData() const
+{
+  return m_buffer.data();
+}
+
+//==============================================================================
+inline
+size_t Writer::GetSize() const
+{
+  return m_buffer.size();
+}
+
+//==============================================================================
+inline
+void Writer::_Write(char c)
+{
+  m_buffer.push_back(c);
+}
+
+//==============================================================================
+inline
+void Writer::_Write(const char* data, size_t size)
+{
+  m_buffer.insert(m_buffer.end(), data, data + size);
+}
+
 } // JSON
 } // xr
 
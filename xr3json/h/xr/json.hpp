@@ -27,7 +27,8 @@ enum  Char
   kArrayEnd = ']',
   kNewLine = '\n',
   kDecimal = '.',
-  kExponential = 'e'
+  kExponential = 'e',
+  kEscape = '\\'
 };
 
 //==============================================================================
@@ -0,0 +1,243 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xr/JsonDocument.hpp"
+#include "xr/debug.hpp"
+#include <cstring>
+
+namespace xr
+{
+namespace JSON
+{
+
+//==============================================================================
+Document::Node const* Document::Node::GetChild(const char* key, Type acceptType) const
+{
+  XR_ASSERT(Json::Document, key != nullptr);
+  return GetChild(key, strlen(key), acceptType);
+}
+
+//==============================================================================
+Document::Node const* Document::Node::GetChild(const char* key, size_t keySize,
+  Type acceptType) const
+{
+  if (m_type == OBJECT)
+  {
+    for (Node const* n = m_firstChild; n; n = n->m_next)
+    {
+      if (n->m_keySize == keySize && std::memcmp(n->m_key, key, keySize) == 0)
+      {
+        return (acceptType == ANY || n->m_type == acceptType) ? n : nullptr;
+      }
+    }
+  }
+  return nullptr;
+}
+
+//==============================================================================
+Document::Document(int maxDepth)
+: m_parser(maxDepth),
+  m_arena(),
+  m_root(nullptr),
+  m_sourceBegin(nullptr),
+  m_sourceEnd(nullptr),
+  m_terminator(nullptr),
+  m_inSitu(false),
+  m_key{ nullptr, 0 }
+{
+  m_frames.reserve(maxDepth);
+}
+
+//==============================================================================
+Document::~Document()
+{}
+
+//==============================================================================
+bool Document::Parse(const char* string, size_t size)
+{
+  return ParseInternal(string, size, false);
+}
+
+//==============================================================================
+bool Document::ParseInSitu(char* string, size_t size)
+{
+  return ParseInternal(string, size, true);
+}
+
+//==============================================================================
+void Document::Clear()
+{
+  m_root = nullptr;
+  m_arena.Reset();
+}
+
+//==============================================================================
+size_t Document::CalculateMemoryUsed() const
+{
+  return m_arena.CalculateUsed();
+}
+
+//==============================================================================
+bool Document::ParseInternal(const char* string, size_t size, bool inSitu)
+{
+  XR_ASSERT(Json::Document, string != nullptr);
+  Clear();
+  m_sourceBegin = string;
+  m_sourceEnd = string + size;
+  m_terminator = nullptr;
+  m_inSitu = inSitu;
+  m_key = { nullptr, 0 };
+  m_frames.clear();
+
+  auto handler = MemberCallback<Document, void, Parser::Event, Parser::String const*>
+    (*this, &Document::OnEntity);
+  const bool result = m_parser.Parse(string, size, handler);
+  if (result)
+  {
+    Terminate(nullptr, 0);
+  }
+  else
+  {
+    Clear();
+  }
+  return result;
+}
+
+//==============================================================================
+void Document::OnEntity(Parser::Event e, const Parser::String* string)
+{
+  // The parser is past any strings that we've had, so it is now safe to
+  // terminate them.
+  Terminate(nullptr, 0);
+
+  switch (e)
+  {
+  case  Parser::E_KEY:
+    m_key = *string;
+    Terminate(string->string, string->length);
+    break;
+
+  case  Parser::E_VALUE:
+    {
+      XR_ASSERT(Json::Document, !m_frames.empty());
+      Node* value = CreateNode(VALUE);
+      value->m_size = static_cast<uint32_t>(string->length);
+      if (string->string >= m_sourceBegin && string->string < m_sourceEnd)
+      {
+        value->m_value = string->string;
+        Terminate(string->string, string->length);
+      }
+      else if (string->string)
+      {
+        // Numbers and booleans are normalised by the parser into a temporary.
+        char* copy = static_cast<char*>(m_arena.Allocate(string->length + 1, 1));
+        std::memcpy(copy, string->string, string->length);
+        copy[string->length] = '\0';
+        value->m_value = copy;
+      }
+      else
+      {
+        value->m_value = nullptr;
+      }
+    }
+    break;
+
+  case  Parser::E_OBJECT_BEGIN:
+    m_frames.push_back({ CreateNode(OBJECT), nullptr });
+    break;
+
+  case  Parser::E_ARRAY_BEGIN:
+    m_frames.push_back({ CreateNode(ARRAY), nullptr });
+    break;
+
+  case  Parser::E_OBJECT_END:
+    XR_ASSERT(Json::Document, !m_frames.empty());
+    XR_ASSERT(Json::Document, m_frames.back().node->m_type == OBJECT);
+    m_frames.pop_back();
+    break;
+
+  case  Parser::E_ARRAY_END:
+    {
+      XR_ASSERT(Json::Document, !m_frames.empty());
+      Node* array = m_frames.back().node;
+      XR_ASSERT(Json::Document, array->m_type == ARRAY);
+      m_frames.pop_back();
+
+      // Index the elements for random access.
+      if (array->m_size > 0)
+      {
+        array->m_elements = static_cast<Node**>(m_arena.Allocate(
+          sizeof(Node*) * array->m_size, alignof(Node*)));
+        Node** element = array->m_elements;
+        for (Node* n = array->m_firstChild; n; n = n->m_next)
+        {
+          *element = n;
+          ++element;
+        }
+      }
+    }
+    break;
+  }
+}
+
+//==============================================================================
+Document::Node* Document::CreateNode(Type type)
+{
+  Node* node = m_arena.New<Node>();
+  node->m_type = type;
+  node->m_size = 0;
+  node->m_key = nullptr;
+  node->m_keySize = 0;
+  node->m_firstChild = nullptr;
+  node->m_elements = nullptr;
+  node->m_next = nullptr;
+
+  if (m_frames.empty())
+  {
+    XR_ASSERT(Json::Document, m_root == nullptr);
+    m_root = node;
+  }
+  else
+  {
+    Frame& parent = m_frames.back();
+    if (parent.node->m_type == OBJECT)
+    {
+      XR_ASSERT(Json::Document, m_key.string != nullptr);
+      node->m_key = m_key.string;
+      node->m_keySize = static_cast<uint32_t>(m_key.length);
+    }
+
+    if (parent.lastChild)
+    {
+      parent.lastChild->m_next = node;
+    }
+    else
+    {
+      parent.node->m_firstChild = node;
+    }
+    parent.lastChild = node;
+    ++parent.node->m_size;
+  }
+  return node;
+}
+
+//==============================================================================
+void Document::Terminate(const char* string, size_t length)
+{
+  if (m_inSitu)
+  {
+    if (m_terminator)
+    {
+      *m_terminator = '\0';
+    }
+    m_terminator = string ? const_cast<char*>(string) + length : nullptr;
+  }
+}
+
+} // JSON
+} // xr
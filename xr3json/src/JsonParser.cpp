@@ -134,7 +134,7 @@ bool  Parser::ParseObject()
         break;
       }
 
-      const char* keyEnd(m_state.RequireChar(kQuot)); // get other quot
+      const char* keyEnd(RequireStringEnd()); // get other quot
       result = !m_state.IsOver(keyEnd);
       if (!result)
       {
@@ -206,7 +206,7 @@ bool  Parser::ParseValue()
       result = !m_state.IsOver(charp);
       if (result)
       {
-        const char* pValueEnd(m_state.RequireChar(kQuot)); // look for quot pair
+        const char* pValueEnd(RequireStringEnd()); // look for quot pair
         result = !m_state.IsOver(pValueEnd);
         if (result)
         {
@@ -331,6 +331,32 @@ bool  Parser::ParseValue()
   return result;
 }
 
+//==============================================================================
+const char* Parser::RequireStringEnd()
+{
+  // Find the first quote that isn't escaped, i.e. preceded by an even number
+  // of backslashes.
+  const char* start = m_state.GetChar();
+  const char* charp = m_state.RequireChar(kQuot);
+  while (!m_state.IsOver(charp))
+  {
+    const char* escape = charp;
+    while (escape != start && *(escape - 1) == kEscape)
+    {
+      --escape;
+    }
+
+    if ((charp - escape) % 2 == 0)
+    {
+      break;
+    }
+
+    m_state.SkipChar();
+    charp = m_state.RequireChar(kQuot);
+  }
+  return charp;
+}
+
 //==============================================================================
 void  Parser::OnEntity(Event e, const String* data)
 {
@@ -0,0 +1,557 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xr/JsonStreamParser.hpp"
+#include "xr/debug.hpp"
+#include <algorithm>
+#include <limits>
+#include <ctype.h>
+#include <cstring>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace xr
+{
+namespace JSON
+{
+namespace
+{
+
+const char* SkipSpace(const char* p, const char* end)
+{
+  while (p != end && isspace(static_cast<unsigned char>(*p)))
+  {
+    ++p;
+  }
+  return p;
+}
+
+bool IsValueEnd(char c)
+{
+  return c == kComma || c == kObjectEnd || c == kArrayEnd ||
+    isspace(static_cast<unsigned char>(c));
+}
+
+}
+
+//==============================================================================
+StreamParser::StreamParser(int maxDepth, size_t maxTokenSize)
+: m_maxDepth(maxDepth),
+  m_maxTokenSize(maxTokenSize),
+  m_handler(nullptr),
+  m_onAtMaxDepth(nullptr),
+  m_state(State::Root),
+  m_depth(0),
+  m_row(1),
+  m_column(1),
+  m_lastWasCR(false),
+  m_escaped(false),
+  m_hasDecimal(false),
+  m_hasExponential(false),
+  m_prevChar('\0')
+{
+  XR_ASSERTMSG(Json::StreamParser, maxDepth > 1,
+    ("%d is not a sensible value for maxDepth.", maxDepth));
+  XR_ASSERTMSG(Json::StreamParser, maxTokenSize > 0,
+    ("%zu is not a sensible value for maxTokenSize.", maxTokenSize));
+}
+
+//==============================================================================
+StreamParser::~StreamParser()
+{}
+
+//==============================================================================
+void StreamParser::SetAtMaxDepthCallback(Parser::AtMaxDepthCallback const& onAtMaxDepth)
+{
+  m_onAtMaxDepth.reset(static_cast<Parser::AtMaxDepthCallback*>(onAtMaxDepth.Clone()));
+}
+
+//==============================================================================
+void StreamParser::Start(Parser::EntityCallback const& handler)
+{
+  m_handler.reset(static_cast<Parser::EntityCallback*>(handler.Clone()));
+  m_state = State::Root;
+  m_isObject.clear();
+  m_depth = 0;
+  m_row = 1;
+  m_column = 1;
+  m_lastWasCR = false;
+  m_token.clear();
+}
+
+//==============================================================================
+bool StreamParser::Feed(const char* data, size_t size)
+{
+  XR_ASSERT(Json::StreamParser, data != nullptr || size == 0);
+  if (m_state != State::Error && m_state != State::Done)
+  {
+    const char* end = ParseChunk(data, data + size);
+    UpdatePosition(data, end);
+  }
+  return m_state != State::Error;
+}
+
+//==============================================================================
+bool StreamParser::Finish()
+{
+  if (m_state != State::Done)
+  {
+    m_state = State::Error;
+  }
+  m_token.clear();
+  m_token.shrink_to_fit();
+  return m_state == State::Done;
+}
+
+//==============================================================================
+const char* StreamParser::ParseChunk(const char* p, const char* end)
+{
+  // Tokens that were started in a previous chunk continue from the start of
+  // this one.
+  const char* tokenBegin = p;
+  while (p != end)
+  {
+    switch (m_state)
+    {
+    case State::Root:
+      p = SkipSpace(p, end);
+      if (p != end)
+      {
+        if (*p != kObjectBegin && *p != kArrayBegin)
+        {
+          m_state = State::Error;
+          return p;
+        }
+
+        BeginContainer(*p == kObjectBegin);
+        ++p;
+      }
+      break;
+
+    case State::ObjectKeyOrEnd:
+      p = SkipSpace(p, end);
+      if (p != end)
+      {
+        if (*p == kObjectEnd)
+        {
+          EndContainer();
+          ++p;
+        }
+        else
+        {
+          m_state = State::ObjectKey;
+        }
+      }
+      break;
+
+    case State::ObjectKey:
+      p = SkipSpace(p, end);
+      if (p != end)
+      {
+        if (*p != kQuot)
+        {
+          m_state = State::Error;
+          return p;
+        }
+
+        ++p;
+        tokenBegin = p;
+        m_escaped = false;
+        m_state = State::Key;
+      }
+      break;
+
+    case State::Key:
+    case State::String:
+      // Find the first quote that isn't escaped.
+      while (p != end)
+      {
+        const char c = *p;
+        if (m_escaped)
+        {
+          m_escaped = false;
+        }
+        else if (c == kEscape)
+        {
+          m_escaped = true;
+        }
+        else if (c == kQuot)
+        {
+          break;
+        }
+        ++p;
+      }
+
+      if (p != end)
+      {
+        const bool isKey = m_state == State::Key;
+        if (!OnString(isKey ? Parser::E_KEY : Parser::E_VALUE, tokenBegin, p))
+        {
+          return p;
+        }
+
+        m_state = isKey ? State::Colon : State::CommaOrEnd;
+        ++p;
+      }
+      break;
+
+    case State::Colon:
+      p = SkipSpace(p, end);
+      if (p != end)
+      {
+        if (*p != kColon)
+        {
+          m_state = State::Error;
+          return p;
+        }
+
+        m_state = State::Value;
+        ++p;
+      }
+      break;
+
+    case State::ArrayValueOrEnd:
+      p = SkipSpace(p, end);
+      if (p != end)
+      {
+        if (*p == kArrayEnd)
+        {
+          EndContainer();
+          ++p;
+        }
+        else
+        {
+          m_state = State::Value;
+        }
+      }
+      break;
+
+    case State::Value:
+      p = SkipSpace(p, end);
+      if (p != end)
+      {
+        const char c = *p;
+        if (c == kQuot)
+        {
+          m_escaped = false;
+          m_state = State::String;
+          tokenBegin = p + 1;
+        }
+        else if (isdigit(static_cast<unsigned char>(c)) || c == '-')
+        {
+          m_hasDecimal = false;
+          m_hasExponential = false;
+          m_prevChar = c;
+          m_state = State::Number;
+          tokenBegin = p;
+        }
+        else if (isalpha(static_cast<unsigned char>(c)))
+        {
+          m_state = State::Literal;
+          tokenBegin = p;
+        }
+        else if (c == kObjectBegin || c == kArrayBegin)
+        {
+          BeginContainer(c == kObjectBegin);
+        }
+        else
+        {
+          m_state = State::Error;
+          return p;
+        }
+        ++p;
+      }
+      break;
+
+    case State::Number:
+      while (p != end && !IsValueEnd(*p))
+      {
+        const char c = *p;
+        const bool isExponential = c == kExponential;
+        const bool isDecimal = c == kDecimal;
+        const bool valid = isdigit(static_cast<unsigned char>(c)) ||
+          // first decimal point
+          (isDecimal && !m_hasDecimal) ||
+          // first exponential, not straight after a minus sign
+          (isExponential && !m_hasExponential && m_prevChar != '-') ||
+          // minus sign following the exponential
+          (c == '-' && m_prevChar == kExponential);
+        if (!valid)
+        {
+          m_state = State::Error;
+          return p;
+        }
+
+        m_hasDecimal |= isDecimal;
+        m_hasExponential |= isExponential;
+        m_prevChar = c;
+        ++p;
+      }
+
+      if (p != end)
+      {
+        if (!OnNumber(tokenBegin, p))
+        {
+          return p;
+        }
+        m_state = State::CommaOrEnd; // the delimiter is processed there.
+      }
+      break;
+
+    case State::Literal:
+      while (p != end && !IsValueEnd(*p))
+      {
+        ++p;
+      }
+
+      if (p != end)
+      {
+        if (!OnLiteral(tokenBegin, p))
+        {
+          return p;
+        }
+        m_state = State::CommaOrEnd;
+      }
+      break;
+
+    case State::CommaOrEnd:
+      p = SkipSpace(p, end);
+      if (p != end)
+      {
+        const bool isObject = m_isObject.back();
+        if (*p == kComma)
+        {
+          m_state = isObject ? State::ObjectKey : State::Value;
+        }
+        else if (*p == (isObject ? kObjectEnd : kArrayEnd))
+        {
+          EndContainer();
+        }
+        else
+        {
+          m_state = State::Error;
+          return p;
+        }
+        ++p;
+      }
+      break;
+
+    case State::Done:
+      // Anything past the root is ignored, like Parser does.
+      return p;
+
+    case State::Error:
+      return p;
+    }
+  }
+
+  // Keep the part of the token that we have so far.
+  switch (m_state)
+  {
+  case State::Key:
+  case State::String:
+  case State::Number:
+  case State::Literal:
+    AppendToken(tokenBegin, end);
+    break;
+
+  default:
+    break;
+  }
+  return p;
+}
+
+//==============================================================================
+bool StreamParser::AppendToken(const char* begin, const char* end)
+{
+  const size_t size = end - begin;
+  const bool result = m_token.size() + size <= m_maxTokenSize;
+  if (result)
+  {
+    m_token.append(begin, size);
+  }
+  else
+  {
+    m_state = State::Error;
+  }
+  return result;
+}
+
+//==============================================================================
+bool StreamParser::GetToken(const char* begin, const char* end, Parser::String& str)
+{
+  // Tokens that are wholly within the current chunk are used directly,
+  // and are subject to the same size limit as those that we had to buffer.
+  const size_t size = end - begin;
+  bool result;
+  if (m_token.empty())
+  {
+    result = size <= m_maxTokenSize;
+    if (result)
+    {
+      str = { begin, size };
+    }
+    else
+    {
+      m_state = State::Error;
+    }
+  }
+  else
+  {
+    result = AppendToken(begin, end);
+    if (result)
+    {
+      str = { m_token.c_str(), m_token.size() };
+    }
+  }
+  return result;
+}
+
+//==============================================================================
+bool StreamParser::OnString(Parser::Event e, const char* begin, const char* end)
+{
+  Parser::String str;
+  const bool result = GetToken(begin, end, str);
+  if (result)
+  {
+    OnEntity(e, &str);
+    m_token.clear();
+  }
+  return result;
+}
+
+//==============================================================================
+bool StreamParser::OnNumber(const char* begin, const char* end)
+{
+  // atof() needs a null terminated string, so the number always goes to the
+  // buffer; it's short.
+  const bool result = AppendToken(begin, end);
+  if (result)
+  {
+    const size_t kBufferSize = 64;
+    char  buffer[kBufferSize];
+    size_t len = m_token.size();
+
+    double  value = atof(m_token.c_str());
+    double  absValue = std::abs(value);
+    if (absValue - std::floor(absValue) < std::numeric_limits<double>::epsilon())
+    {
+      len = std::snprintf(buffer, kBufferSize - 1, "%d", int(value));
+    }
+    else
+    {
+      len = std::min(kBufferSize - 1, len);
+      std::strncpy(buffer, m_token.c_str(), len);
+      buffer[len] = '\0';
+    }
+
+    Parser::String  str = { buffer, len };
+    OnEntity(Parser::E_VALUE, &str);
+    m_token.clear();
+  }
+  return result;
+}
+
+//==============================================================================
+bool StreamParser::OnLiteral(const char* begin, const char* end)
+{
+  Parser::String token;
+  bool result = GetToken(begin, end, token);
+  if (result)
+  {
+    if (strncmp(token.string, kFalse, token.length) == 0)
+    {
+      Parser::String  str = { "0", 1 };
+      OnEntity(Parser::E_VALUE, &str);
+    }
+    else if (strncmp(token.string, kTrue, token.length) == 0)
+    {
+      Parser::String  str = { "1", 1 };
+      OnEntity(Parser::E_VALUE, &str);
+    }
+    else if (strncmp(token.string, kNull, token.length) == 0)
+    {
+      Parser::String  str = { nullptr, 0 };
+      OnEntity(Parser::E_VALUE, &str);
+    }
+    else
+    {
+      m_state = State::Error;
+      result = false;
+    }
+    m_token.clear();
+  }
+  return result;
+}
+
+//==============================================================================
+void StreamParser::BeginContainer(bool isObject)
+{
+  OnEntity(isObject ? Parser::E_OBJECT_BEGIN : Parser::E_ARRAY_BEGIN, nullptr);
+  m_isObject.push_back(isObject);
+  ++m_depth;
+  if (m_depth == m_maxDepth + 1 && m_onAtMaxDepth)
+  {
+    m_onAtMaxDepth->Call(true);
+  }
+  m_state = isObject ? State::ObjectKeyOrEnd : State::ArrayValueOrEnd;
+}
+
+//==============================================================================
+void StreamParser::EndContainer()
+{
+  --m_depth;
+  if (m_depth == m_maxDepth && m_onAtMaxDepth)
+  {
+    m_onAtMaxDepth->Call(false);
+  }
+
+  const bool isObject = m_isObject.back();
+  m_isObject.pop_back();
+  OnEntity(isObject ? Parser::E_OBJECT_END : Parser::E_ARRAY_END, nullptr);
+  m_state = m_isObject.empty() ? State::Done : State::CommaOrEnd;
+}
+
+//==============================================================================
+void StreamParser::OnEntity(Parser::Event e, Parser::String const* string)
+{
+  if (m_handler && m_depth <= m_maxDepth)
+  {
+    m_handler->Call(e, string);
+  }
+}
+
+//==============================================================================
+void StreamParser::UpdatePosition(const char* begin, const char* end)
+{
+  // Line breaks are CR, LF, or CRLF, which only counts once.
+  for (; begin != end; ++begin)
+  {
+    const char c = *begin;
+    if (c == '\n' && m_lastWasCR)
+    {
+      m_lastWasCR = false;
+      continue;
+    }
+
+    m_lastWasCR = c == '\r';
+    if (m_lastWasCR || c == '\n')
+    {
+      ++m_row;
+      m_column = 1;
+    }
+    else
+    {
+      ++m_column;
+    }
+  }
+}
+
+} // JSON
+} // xr
@@ -8,8 +8,9 @@
 //==============================================================================
 #include "xr/JsonWriter.hpp"
 #include "xr/debug.hpp"
+#include <charconv>
+#include <cstdio>
 #include <cstring>
-#include <algorithm>
 
 namespace xr
 {
@@ -22,7 +23,7 @@ const char Writer::kEscapeChars[] = { '\b', '\t', '\n', '\f', '\r', '"', '/', '\
 const char* const Writer::kEscapeSequences[] =
 {
   "\\b",
-  "\\t"
+  "\\t",
   "\\n",
   "\\f",
   "\\r",
@@ -31,15 +32,73 @@ const char* const Writer::kEscapeSequences[] =
   "\\\\",
 };
 
+namespace
+{
+
+const char  kScopeOpeners[2] =
+{
+  kObjectBegin,
+  kArrayBegin
+};
+
+const size_t kBufferReserve = Writer::kFlushSize + Writer::kFlushSize / 4;
+
 //==============================================================================
-Writer::Writer(std::ostream& stream, uint32_t maxDepth)
+///@return The index of @a c in Writer::kEscapeChars, or kNumEscapedChars if
+/// it doesn't need escaping.
+int GetEscapedChar(char c)
+{
+  switch (c)
+  {
+  case '\b':
+    return Writer::EC_BACKSPACE;
+  case '\t':
+    return Writer::EC_TAB;
+  case '\n':
+    return Writer::EC_NEWLINE;
+  case '\f':
+    return Writer::EC_FORM_FEED;
+  case '\r':
+    return Writer::EC_CARRIAGE_RETURN;
+  case '"':
+    return Writer::EC_QUOT;
+  case '/':
+    return Writer::EC_SLASH;
+  case '\\':
+    return Writer::EC_BACKSLASH;
+  default:
+    return Writer::kNumEscapedChars;
+  }
+}
+
+}
+
+//==============================================================================
+Writer::Writer(uint32_t maxDepth)
 : m_allowLinebreaks(false),
   m_allowSpace(false),
   m_autoEscapeString(false),
   m_isComplete(false),
-  m_stream(&stream)
+  m_hasFailed(false),
+  m_stream(nullptr),
+  m_sink(nullptr)
 {
   m_scopes.reserve(maxDepth);
+  m_buffer.reserve(kBufferReserve);
+}
+
+//==============================================================================
+Writer::Writer(std::ostream& stream, uint32_t maxDepth)
+: Writer(maxDepth)
+{
+  m_stream = &stream;
+}
+
+//==============================================================================
+Writer::Writer(Sink& sink, uint32_t maxDepth)
+: Writer(maxDepth)
+{
+  m_sink = &sink;
 }
 
 //==============================================================================
@@ -47,6 +106,7 @@ Writer::~Writer()
 {
   XR_ASSERTMSG(Writer, m_scopes.empty(),
     ("Scopes have remained open; the resulting JSON is likely invalid."));
+  Flush();
 }
 
 //==============================================================================
@@ -112,7 +172,7 @@ Writer&  Writer::WriteValue( int32_t value )
 {
   XR_ASSERT(Json::Write, !m_isComplete);
   _WriteComma();
-  *m_stream << value;
+  _WriteInt(value);
 
   return *this;
 }
@@ -122,7 +182,7 @@ Writer&  Writer::WriteValue( double value )
 {
   XR_ASSERT(Json::Write, !m_isComplete);
   _WriteComma();
-  *m_stream << value;
+  _WriteDouble(value);
 
   return *this;
 }
@@ -132,7 +192,7 @@ Writer&  Writer::WriteValue( bool value )
 {
   XR_ASSERT(Json::Write, !m_isComplete);
   _WriteComma();
-  *m_stream << std::boolalpha << value << std::noboolalpha;
+  _WriteBool(value);
 
   return *this;
 }
@@ -166,24 +226,7 @@ Writer&  Writer::WriteValue(const char* key, const char* value)
 {
   XR_ASSERT(Json::Write, !m_isComplete);
   _WriteKey(key);
-
-  if (!value)
-  {
-    *m_stream << kNull;
-  }
-  else
-  {
-    m_stream->put(kQuot);
-    if (m_autoEscapeString)
-    {
-      _ProcessEscaped(value);
-    }
-    else
-    {
-      *m_stream << value;
-    }
-    m_stream->put(kQuot);
-  }
+  _WriteStringValue(value);
 
   return *this;
 }
@@ -193,7 +236,7 @@ Writer&  Writer::WriteValue(const char* key, const int32_t value)
 {
   XR_ASSERT(Json::Write, !m_isComplete);
   _WriteKey(key);
-  *m_stream << value;
+  _WriteInt(value);
 
   return *this;
 }
@@ -203,7 +246,7 @@ Writer&  Writer::WriteValue(const char* key, const double value)
 {
   XR_ASSERT(Json::Write, !m_isComplete);
   _WriteKey(key);
-  *m_stream << value;
+  _WriteDouble(value);
 
   return *this;
 }
@@ -213,7 +256,7 @@ Writer&  Writer::WriteValue(const char* key, bool value)
 {
   XR_ASSERT(Json::Write, !m_isComplete);
   _WriteKey(key);
-  *m_stream << std::boolalpha << value << std::noboolalpha;
+  _WriteBool(value);
 
   return *this;
 }
@@ -255,11 +298,11 @@ Writer&  Writer::CloseScope()
   switch (scope.type)
   {
   case Scope::OBJECT:
-    m_stream->put(kObjectEnd);
+    _Write(kObjectEnd);
     break;
 
   case Scope::ARRAY:
-    m_stream->put(kArrayEnd);
+    _Write(kArrayEnd);
     break;
 
   default:
@@ -269,6 +312,7 @@ Writer&  Writer::CloseScope()
   if (m_scopes.empty())
   {
     m_isComplete = true;  // no further writing should take place.
+    Flush();
   }
 
   return *this;
@@ -277,27 +321,68 @@ Writer&  Writer::CloseScope()
 //==============================================================================
 void Writer::Reset(std::ostream & stream)
 {
+  Reset();
   m_stream = &stream;
+}
+
+//==============================================================================
+void Writer::Reset(Sink& sink)
+{
+  Reset();
+  m_sink = &sink;
+}
+
+//==============================================================================
+void Writer::Reset()
+{
+  Flush();
+  m_stream = nullptr;
+  m_sink = nullptr;
+  m_buffer.clear();
   m_isComplete = false;
+  m_hasFailed = false;
   m_scopes.clear();
 }
 
+//==============================================================================
+bool Writer::Flush()
+{
+  if (!m_buffer.empty() && (m_stream || m_sink))
+  {
+    bool success;
+    if (m_sink)
+    {
+      success = m_sink->Write(m_buffer.data(), m_buffer.size());
+    }
+    else
+    {
+      m_stream->write(m_buffer.data(), m_buffer.size());
+      success = !m_stream->fail();
+    }
+
+    m_hasFailed |= !success;
+    m_buffer.clear();
+  }
+  return !m_hasFailed;
+}
+
 //==============================================================================
 void  Writer::_WriteKey( const char* key )
 {
   XR_ASSERT(Json::Writer, key != nullptr);
   _WriteComma();
 
-  m_stream->put(kQuot);
+  _Write(kQuot);
   if (m_autoEscapeString)
   {
     _ProcessEscaped(key);
   }
   else
   {
-    *m_stream << key;
+    _Write(key, strlen(key));
   }
-  m_stream->put(kQuot).put(kColon);
+  _Write(kQuot);
+  _Write(kColon);
 
   _AddSpace();
 }
@@ -305,6 +390,13 @@ void  Writer::_WriteKey( const char* key )
 //==============================================================================
 void  Writer::_WriteComma()
 {
+  // Every entity starts here; make sure that what we have buffered so far
+  // doesn't grow without limits.
+  if (m_buffer.size() >= kFlushSize)
+  {
+    Flush();
+  }
+
   if (!m_scopes.empty())
   {
     if (m_scopes.back().isEmpty)
@@ -313,24 +405,18 @@ void  Writer::_WriteComma()
     }
     else
     {
-      m_stream->put(kComma);
+      _Write(kComma);
       _AddLinebreak(m_scopes.back().oneLiner);
     }
   }
 }
 
 //==============================================================================
-static const char  kScopeOpeners[2] =
-{
-  kObjectBegin,
-  kArrayBegin
-};
-
 void  Writer::_PushScope(Scope::Type type, bool oneLiner)
 {
   m_scopes.push_back({ type, oneLiner, true });
 
-  m_stream->put(kScopeOpeners[type]);
+  _Write(kScopeOpeners[type]);
   _AddLinebreak(oneLiner);
 }
 
@@ -339,7 +425,7 @@ void Writer::_AddLinebreak(bool oneLiner)
 {
   if (m_allowLinebreaks && !oneLiner)
   {
-    *m_stream << '\n';
+    _Write('\n');
     _AddIndent();
   }
   else
@@ -355,7 +441,7 @@ void Writer::_AddIndent()
   {
     for (auto i = m_scopes.size(); i > 0; --i)
     {
-      *m_stream << m_indent;
+      _Write(m_indent.data(), m_indent.size());
     }
   }
 }
@@ -365,7 +451,7 @@ void Writer::_AddSpace()
 {
   if (m_allowSpace)
   {
-    m_stream->put(' ');
+    _Write(' ');
   }
 }
 
@@ -374,44 +460,72 @@ void Writer::_WriteStringValue( const char* value )
 {
   if (value == nullptr)
   {
-    *m_stream << kNull;
+    _Write(kNull, strlen(kNull));
   }
   else
   {
-    ((m_stream->put(kQuot)) << value).put(kQuot);
+    _Write(kQuot);
+    if (m_autoEscapeString)
+    {
+      _ProcessEscaped(value);
+    }
+    else
+    {
+      _Write(value, strlen(value));
+    }
+    _Write(kQuot);
   }
 }
 
+//==============================================================================
+void Writer::_WriteInt(int32_t value)
+{
+  char buffer[16];
+  auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  _Write(buffer, result.ptr - buffer);
+}
+
+//==============================================================================
+void Writer::_WriteDouble(double value)
+{
+  // Same as the default formatting of std::ostream, i.e. %g.
+  char buffer[32];
+#if defined(__cpp_lib_to_chars)
+  auto result = std::to_chars(buffer, buffer + sizeof(buffer), value,
+    std::chars_format::general, 6);
+  _Write(buffer, result.ptr - buffer);
+#else
+  const int len = std::snprintf(buffer, sizeof(buffer), "%g", value);
+  _Write(buffer, len);
+#endif
+}
+
+//==============================================================================
+void Writer::_WriteBool(bool value)
+{
+  const char* str = value ? kTrue : kFalse;
+  _Write(str, strlen(str));
+}
+
 //==============================================================================
 void Writer::_ProcessEscaped( const char* value )
 {
-  const char* end = strchr(value, '\0');
-  while (value != end)
+  // Write runs of characters that don't need escaping in one go.
+  const char* run = value;
+  while (*value != '\0')
   {
-    const char* nextEscape = strpbrk(value, kEscapeChars);
-    bool  found = nextEscape != nullptr;
-    if (!found)
+    const int escaped = GetEscapedChar(*value);
+    if (escaped != kNumEscapedChars)
     {
-      nextEscape = end;
-    }
+      _Write(run, value - run);
 
-    while (value != nextEscape)
-    {
-      *m_stream << *value;
-      ++value;
-    }
-
-    if (found)
-    {
-      // process escape
-      nextEscape = std::lower_bound(kEscapeChars, kEscapeChars + kNumEscapedChars, value[0]);
-      if (nextEscape != kEscapeChars + kNumEscapedChars)
-      {
-        *m_stream << kEscapeSequences[nextEscape - kEscapeChars];
-        ++value;
-      }
+      const char* sequence = kEscapeSequences[escaped];
+      _Write(sequence, strlen(sequence));
+      run = value + 1;
     }
+    ++value;
   }
+  _Write(run, value - run);
 }
 
 //==============================================================================
@@ -17,6 +17,7 @@ namespace xr
 {
 
 class Entity;
+class ComponentPoolBase;
 
 //==============================================================================
 ///@brief Component class which defines a single unique aspect of an Entity,
@@ -52,6 +53,15 @@ public:
   ///@return The Entity that owns the component.
   Entity* GetOwner() const;
 
+protected:
+  // static
+  ///@return The pool for components of the given type, creating it if
+  /// necessary.
+  static ComponentPoolBase& AcquirePool(size_t typeId, size_t size, size_t alignment);
+
+  static void* Allocate(ComponentPoolBase& pool);
+  static void Deallocate(ComponentPoolBase& pool, void* p);
+
 private:
   // friend
   friend class Entity;
@@ -60,7 +70,10 @@ private:
   Entity* m_owner; // no ownership
 };
 
-///@brief Helper class to automate the definition of GetTypeId().
+///@brief Helper class to automate the definition of GetTypeId(). Instances
+/// of T are allocated from ComponentPool<T>.
+///@note T must be final; anything derived from it would be allocated from
+/// T's pool, and visited as a T by ComponentPool<T>::ForEach().
 template  <typename T>
 class ComponentT: public Component
 {
@@ -68,11 +81,31 @@ public:
   // types
   typedef ComponentT<T> BaseType;
 
+  // static
+  static void* operator new(size_t /*size*/)
+  {
+    static_assert(std::is_final<T>::value, "Pooled components must be final.");
+    return Allocate(GetPool());
+  }
+
+  static void operator delete(void* p)
+  {
+    Deallocate(GetPool(), p);
+  }
+
   // general
   virtual size_t  GetTypeId() const
   {
     return GetTypeIdImpl<T>();
   }
+
+private:
+  // static
+  static ComponentPoolBase& GetPool()
+  {
+    static ComponentPoolBase& pool = AcquirePool(TypeId<T>(), sizeof(T), alignof(T));
+    return pool;
+  }
 };
 
 //==============================================================================
@@ -87,12 +120,12 @@ Entity* Component::GetOwner() const
 }
 
 //==============================================================================
-///@brief Declares @a name as a derivative of xr::Entity::ComponentT<name> thereby
-/// further facilitating the automation of a GetTypeId() implementation required
-/// for Component subtypes.
+///@brief Declares @a name as a final derivative of xr::Entity::ComponentT<name>
+/// thereby further facilitating the automation of a GetTypeId() implementation
+/// required for Component subtypes.
 ///@usage class or struct XR_COMPONENT_DECL(MyComponent) { /* declarations */ };
 ///@note Can be combined with templates and multiple inheritance:
 /// template <typename T> class XR_COMPONENT_DECL(MyComponent), public OtherBase{};
-#define XR_COMPONENT_DECL(name) name: public xr::ComponentT<name>
+#define XR_COMPONENT_DECL(name) name final: public xr::ComponentT<name>
 
 #endif  //XR_COMPONENT_HPP
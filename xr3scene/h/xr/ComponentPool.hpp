@@ -0,0 +1,195 @@
+#ifndef XR_COMPONENTPOOL_HPP
+#define XR_COMPONENTPOOL_HPP
+//==============================================================================
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xr/threading/Spinlock.hpp"
+#include "xr/types/fundamentals.hpp"
+#include "xr/types/typeutils.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace xr
+{
+
+//==============================================================================
+///@brief Type-agnostic part of ComponentPool; manages blocks of slots for
+/// instances of a given size and alignment. Slots have stable addresses, and
+/// the lowest free slot is always reused first, which keeps the instances of a
+/// type packed as tightly as their lifetimes allow. Pools are created on
+/// demand, one per type, and live until the end of the program.
+class ComponentPoolBase
+{
+  XR_NONCOPY_DECL(ComponentPoolBase)
+
+public:
+  // static
+  static constexpr size_t kBlockSize = 256;
+
+  ///@return The pool registered for components with the given @a typeId, if
+  /// any have been created yet; nullptr otherwise.
+  static ComponentPoolBase* Find(size_t typeId);
+
+  ///@return The pool for components with the given @a typeId, creating it
+  /// for the given @a elementSize and @a alignment if necessary.
+  static ComponentPoolBase& Acquire(size_t typeId, size_t elementSize, size_t alignment);
+
+  // structors
+  ~ComponentPoolBase();
+
+  // general
+  ///@return Type id of the components that this pool is for.
+  size_t GetTypeId() const;
+
+  ///@return The number of live components in the pool.
+  size_t GetSize() const;
+
+  ///@brief Allocates storage for a component.
+  void* Allocate();
+
+  ///@brief Returns the storage of a component, which must've come from
+  /// Allocate().
+  void Deallocate(void* p);
+
+private:
+  // types
+  struct Block
+  {
+    uint8_t* data;
+    uint32_t numOccupied;
+    bool occupied[kBlockSize];
+  };
+
+  // friend
+  template <class T> friend class ComponentPool;
+
+  // structors
+  ComponentPoolBase(size_t typeId, size_t elementSize, size_t alignment);
+
+  // data
+  const size_t m_typeId;
+  const size_t m_elementSize;
+  const size_t m_alignment;
+
+  std::vector<Block> m_blocks;  // yes ownership of data
+  std::vector<uint32_t> m_blocksByAddress;
+  size_t m_firstFreeBlock;  // no block before this one has free slots.
+  size_t m_size;
+
+  Spinlock m_lock;
+};
+
+//==============================================================================
+///@brief Typed access to the storage of all Components of type T, which
+/// ComponentT<T> allocates its instances from. Allows systems to process all
+/// components of a type in memory order, without going through their owner
+/// Entities.
+template <class T>
+class ComponentPool
+{
+  XR_NONCOPY_DECL(ComponentPool)
+
+public:
+  // static
+  ///@return The pool for components of type T.
+  static ComponentPool& Get();
+
+  // general
+  ///@return The type-agnostic pool that the Ts are allocated from.
+  ComponentPoolBase& GetBase() const;
+
+  ///@return The number of live Ts.
+  size_t GetSize() const;
+
+  ///@brief Calls @a fn with every live T, in the order of their storage.
+  ///@note Must not be combined with the creation or destruction of Ts.
+  template <class Fn>
+  void ForEach(Fn fn);
+
+private:
+  // structors
+  ComponentPool();
+
+  // data
+  ComponentPoolBase& m_base;
+};
+
+//==============================================================================
+// implementation
+//==============================================================================
+inline
+size_t ComponentPoolBase::GetTypeId() const
+{
+  return m_typeId;
+}
+
+//==============================================================================
+inline
+size_t ComponentPoolBase::GetSize() const
+{
+  return m_size;
+}
+
+//==============================================================================
+template <class T>
+ComponentPool<T>& ComponentPool<T>::Get()
+{
+  static ComponentPool<T> instance;
+  return instance;
+}
+
+//==============================================================================
+template <class T>
+ComponentPool<T>::ComponentPool()
+: m_base(ComponentPoolBase::Acquire(TypeId<T>(), sizeof(T), alignof(T)))
+{}
+
+//==============================================================================
+template <class T>
+inline
+ComponentPoolBase& ComponentPool<T>::GetBase() const
+{
+  return m_base;
+}
+
+//==============================================================================
+template <class T>
+inline
+size_t ComponentPool<T>::GetSize() const
+{
+  return m_base.GetSize();
+}
+
+//==============================================================================
+template <class T>
+template <class Fn>
+void ComponentPool<T>::ForEach(Fn fn)
+{
+  for (auto& b : m_base.m_blocks)
+  {
+    if (b.numOccupied == 0)
+    {
+      continue;
+    }
+
+    T* instances = reinterpret_cast<T*>(b.data);
+    for (size_t i = 0; i < ComponentPoolBase::kBlockSize; ++i)
+    {
+      if (b.occupied[i])
+      {
+        fn(instances[i]);
+      }
+    }
+  }
+}
+
+}
+
+#endif  //XR_COMPONENTPOOL_HPP
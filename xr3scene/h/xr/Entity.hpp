@@ -10,6 +10,7 @@
 //
 //==============================================================================
 #include "Component.hpp"
+#include "TransformStore.hpp"
 #include "xr/Name.hpp"
 #include "xr/math/Matrix.hpp"
 #include "xr/math/Quaternion.hpp"
@@ -18,12 +19,17 @@
 namespace xr
 {
 
+class TaskScheduler;
+
 //==============================================================================
 ///@brief Entity is an object in the world, with a transform and a set of
 /// child Entities and Components, the latter of which are used to extend its
 /// functionality (as opposed to inheritance), and the both of which they have
 /// a @e notion of ownership of.
-/// The children may be traversed in insertion order.
+/// The children may be traversed in insertion order.<br/>
+/// By default, the transforms are stored in the Entities themselves. A hierarchy
+/// may be backed by a TransformStore instead (see SetTransformStore()), which
+/// updates the world transforms of all of its entities in a single batch.
 class Entity
 {
   XR_NONCOPY_DECL(Entity)
@@ -107,12 +113,33 @@ public:
 
   ///@brief Updates the world transform matrix of this Entity from the local transform
   /// and the transform of the parents.
+  ///@note If this Entity is backed by a TransformStore, the whole of the store
+  /// is updated.
   void  UpdateWorldTransform();
 
+  ///@brief Updates the world transform matrix of this Entity as UpdateWorldTransform()
+  /// does; if it is backed by a TransformStore, the update is done in parallel,
+  /// using @a scheduler.
+  void  UpdateWorldTransform(TaskScheduler& scheduler);
+
   ///@param update Whether to process a pending updates first.
   ///@return Current (cached) world transform of this Entity.
   Matrix const&  GetWorldTransform(bool update = true) const;
 
+  ///@brief Moves the transforms of this Entity and all of its descendants to
+  /// @a transforms, or back into the Entities, if nullptr. Entities added as
+  /// children are moved to their parent's store.
+  ///@note Only allowed on an Entity without a parent.
+  ///@note Does not transfer ownership; @a transforms must outlive the Entities.
+  void  SetTransformStore(TransformStore* transforms);
+
+  ///@return The TransformStore that this Entity is backed by, if any.
+  TransformStore* GetTransformStore() const;
+
+  ///@return The id of the transform of this Entity in its TransformStore;
+  /// TransformStore::kInvalidId if it isn't backed by one.
+  TransformStore::Id GetTransformId() const;
+
   ///@return The parent of this Entity, or nullptr if none.
   ///@note Does not transfer ownership.
   Entity* GetParent() const;
@@ -223,6 +250,9 @@ private:
   Entity* m_nextSibling;  // no ownership
   List  m_children; // yes ownership
 
+  TransformStore* m_transforms;  // no ownership
+  TransformStore::Id m_transformId;
+
   Entity* m_nextWorldUpdate;  // no ownership
   Vector3 m_translation;
   Quaternion m_rotation;
@@ -234,6 +264,7 @@ private:
 
   // internal
   bool IsAncestor(Entity* e) const;
+  void MoveTransform(TransformStore* transforms);
   void FlagUpdateNeeded(Entity* worldUpdate);
   void UpdateWorldTransformInternal();
 
@@ -258,21 +289,35 @@ Name Entity::GetName() const
 inline
 Vector3 const& Entity::GetTranslation() const
 {
-  return m_translation;
+  return m_transforms ? m_transforms->GetTranslation(m_transformId) : m_translation;
 }
 
 //==============================================================================
 inline
 Quaternion const& Entity::GetRotation() const
 {
-  return m_rotation;
+  return m_transforms ? m_transforms->GetRotation(m_transformId) : m_rotation;
 }
 
 //==============================================================================
 inline
 Vector3 const& Entity::GetScale() const
 {
-  return m_scale;
+  return m_transforms ? m_transforms->GetScale(m_transformId) : m_scale;
+}
+
+//==============================================================================
+inline
+TransformStore* Entity::GetTransformStore() const
+{
+  return m_transforms;
+}
+
+//==============================================================================
+inline
+TransformStore::Id Entity::GetTransformId() const
+{
+  return m_transformId;
 }
 
 //==============================================================================
@@ -0,0 +1,150 @@
+#ifndef XR_MESHRENDERPASS_HPP
+#define XR_MESHRENDERPASS_HPP
+//==============================================================================
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xr/Material.hpp"
+#include "xr/math/Matrix.hpp"
+#include "xr/math/Vector4.hpp"
+#include "xr/types/fundamentals.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace xr
+{
+
+class Camera;
+class Mesh;
+class MeshRenderer;
+
+//==============================================================================
+///@brief Renders all MeshRenderers that are visible to a Camera. Renderers
+/// are collected from their ComponentPool, culled against the view frustum
+/// using their world space bounds, and sorted by Material, then Mesh, so that
+/// state changes are minimised. Runs of renderers that share both, and whose
+/// Material has an instanced variant (see SetInstancedMaterial()), are drawn
+/// with a single, instanced draw call.
+class MeshRenderPass
+{
+  XR_NONCOPY_DECL(MeshRenderPass)
+
+public:
+  // types
+  struct Stats
+  {
+    uint32_t numRenderers = 0;  // that were considered
+    uint32_t numVisible = 0;  // that survived culling
+    uint32_t numDrawCalls = 0;
+    uint32_t numInstanced = 0;  // renderers drawn via instancing
+  };
+
+  // static
+  ///@brief The smallest number of renderers with the same Mesh and Material,
+  /// that are drawn with instancing.
+  static constexpr uint32_t kMinInstances = 2;
+
+  ///@brief The size of the instance data of a renderer: the first three columns
+  /// of its world transform, translation in w, as iData0 - iData2.
+  static constexpr uint32_t kInstanceDataStride = sizeof(Vector4) * 3;
+
+  // structors
+  MeshRenderPass();
+  ~MeshRenderPass();
+
+  // general
+  ///@brief Sets @a instanced as the Material to draw batches of renderers using
+  /// @a material with. Its shader must calculate the world position of vertices
+  /// from the instance data, i.e. as vec3(dot(iData0, p), dot(iData1, p),
+  /// dot(iData2, p)), where p is the model space position with w = 1.0. Passing
+  /// a null @a instanced removes the mapping. The pass keeps a reference to
+  /// both Materials until then.
+  void SetInstancedMaterial(Material::Ptr const& material,
+    Material::Ptr const& instanced);
+
+  ///@brief Collects the renderers which are visible to @a camera, and sorts
+  /// them into batches. Renderers without an owner, mesh or material are
+  /// skipped; ones without bounds are never culled.
+  void Cull(Camera const& camera);
+
+  ///@brief Draws the renderers collected by the last Cull().
+  ///@note The view and projection transforms must be set, e.g. by Camera::Apply().
+  ///@note The renderers must not be destroyed between Cull() and Render().
+  void Render();
+
+  ///@return The statistics of the last Cull().
+  Stats const& GetStats() const;
+
+  ///@return The number of renderers that were found visible by the last Cull().
+  size_t GetNumVisible() const;
+
+  ///@return The @a i-th visible renderer, in the order of drawing.
+  MeshRenderer* GetVisible(size_t i) const;
+
+private:
+  // types
+  struct Item
+  {
+    MeshRenderer* renderer;
+    Material const* material;
+    Mesh* mesh;
+    Matrix const* world;
+  };
+
+  struct Batch
+  {
+    uint32_t begin; // items
+    uint32_t count;
+    Material const* instanced;  // nullptr for batches that aren't
+    uint32_t instanceOffset;
+  };
+
+  struct InstancedMaterial
+  {
+    Material::Ptr material; // referenced, so its address isn't reused while mapped.
+    Material::Ptr instanced;
+  };
+
+  // data
+  std::vector<InstancedMaterial> m_instancedMaterials;
+
+  std::vector<Item> m_items;
+  std::vector<Batch> m_batches;
+  std::vector<Vector4> m_instanceData;
+  Stats m_stats;
+
+  // internal
+  Material const* FindInstancedMaterial(Material const* material) const;
+};
+
+//==============================================================================
+// implementation
+//==============================================================================
+inline
+MeshRenderPass::Stats const& MeshRenderPass::GetStats() const
+{
+  return m_stats;
+}
+
+//==============================================================================
+inline
+size_t MeshRenderPass::GetNumVisible() const
+{
+  return m_items.size();
+}
+
+//==============================================================================
+inline
+MeshRenderer* MeshRenderPass::GetVisible(size_t i) const
+{
+  return m_items[i].renderer;
+}
+
+}
+
+#endif  //XR_MESHRENDERPASS_HPP
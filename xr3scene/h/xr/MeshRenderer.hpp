@@ -19,7 +19,7 @@ namespace xr
 class Mesh;
 
 //==============================================================================
-class MeshRenderer:  public ComponentT<MeshRenderer>
+class MeshRenderer final:  public ComponentT<MeshRenderer>
 {
 public:
   // data
@@ -35,11 +35,32 @@ public:
   Mesh* GetMesh() const;  // no ownership transfer
   void  SetMesh(Mesh* pMesh);  // no ownership transfer
 
+  ///@brief Sets the bounding sphere of the mesh, in model space, for the
+  /// purposes of culling. A negative @a radius means no bounds, i.e. that the
+  /// renderer is never culled. This is the default.
+  void  SetBounds(Vector3 const& center, float radius);
+
+  ///@return Whether bounds were set for the renderer.
+  bool  HasBounds() const;
+
+  ///@brief Gets the bounding sphere in world space, which is only recalculated
+  /// when the world transform of the owner has changed since the last call.
+  ///@note Requires bounds to have been set.
+  void  GetWorldBounds(Vector3& center, float& radius) const;
+
   void  Render();
 
 protected:
   // data
   Mesh*  m_mesh;  // no ownership
+
+  Vector3 m_boundsCenter;
+  float m_boundsRadius;
+
+  mutable Matrix m_worldBoundsTransform;  // that the world bounds were calculated with
+  mutable Vector3 m_worldBoundsCenter;
+  mutable float m_worldBoundsRadius;
+  mutable bool m_worldBoundsValid;
 };
 
 //==============================================================================
@@ -51,6 +72,13 @@ Mesh*  MeshRenderer::GetMesh() const
   return  m_mesh;
 }
 
+//==============================================================================
+inline
+bool  MeshRenderer::HasBounds() const
+{
+  return m_boundsRadius >= .0f;
+}
+
 }
 
 #endif // XR_MESHRENDERER_HPP
@@ -0,0 +1,197 @@
+#ifndef XR_TRANSFORMSTORE_HPP
+#define XR_TRANSFORMSTORE_HPP
+//==============================================================================
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xr/math/Matrix.hpp"
+#include "xr/math/Quaternion.hpp"
+#include "xr/types/fundamentals.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace xr
+{
+
+class TaskScheduler;
+
+//==============================================================================
+///@brief Stores the local and world transforms of a hierarchy of nodes in flat,
+/// per-component arrays, laid out in depth-first order, i.e. with parents always
+/// preceding their children. This allows Update() to propagate changes and
+/// recalculate the world transforms in a single, linear pass - or to process
+/// independent subtrees, which are contiguous, in parallel.
+///@note Transforms are identified by Ids, which remain stable across changes
+/// to the layout. References to the components of a transform, however, are
+/// only valid until the next Create(), Release(), SetParent() or Update().
+class TransformStore
+{
+  XR_NONCOPY_DECL(TransformStore)
+
+public:
+  // types
+  using Id = uint32_t;
+
+  // static
+  static constexpr Id kInvalidId = Id(-1);
+
+  // structors
+  TransformStore();
+  ~TransformStore();
+
+  // general
+  ///@brief Creates an identity transform, optionally as a child of @a parent.
+  Id Create(Id parent = kInvalidId);
+
+  ///@brief Destroys the transform @a id. Its children become roots.
+  void Release(Id id);
+
+  ///@brief Makes @a id a child of @a parent, or a root if @a parent is kInvalidId.
+  void SetParent(Id id, Id parent);
+
+  ///@return The parent of @a id, or kInvalidId if it is a root.
+  Id GetParent(Id id) const;
+
+  ///@return The number of transforms in the store.
+  size_t GetSize() const;
+
+  Vector3 const& GetTranslation(Id id) const;
+  void SetTranslation(Id id, Vector3 const& t);
+
+  Quaternion const& GetRotation(Id id) const;
+  void SetRotation(Id id, Quaternion const& r);
+
+  Vector3 const& GetScale(Id id) const;
+  void SetScale(Id id, Vector3 const& s);
+
+  ///@return Local transformation calculated from translation, rotation and scale.
+  Matrix GetLocalTransform(Id id) const;
+
+  ///@return The world transform of @a id, as of the last Update().
+  Matrix const& GetWorldTransform(Id id) const;
+
+  ///@return Whether there were any changes since the last Update().
+  bool IsUpdateNeeded() const;
+
+  ///@brief Restores the depth-first layout if the hierarchy has changed, then
+  /// recalculates the world transform of every node that has changed, or has
+  /// an ancestor that did, since the last Update().
+  void Update();
+
+  ///@brief Performs the same update as Update(), splitting the hierarchy into
+  /// independent subtrees which are processed in parallel, using @a scheduler.
+  /// The resulting world transforms are identical to those of Update().
+  void Update(TaskScheduler& scheduler);
+
+private:
+  // types
+  struct Node
+  {
+    uint32_t slot;
+    Id parent;
+    Id firstChild;
+    Id prevSibling;
+    Id nextSibling;
+  };
+
+  struct Range
+  {
+    uint32_t begin;
+    uint32_t end;
+  };
+
+  // data
+  std::vector<Node> m_nodes; // by id
+  std::vector<Id> m_freeIds;
+
+  std::vector<Id> m_ids;  // by slot, from here on
+  std::vector<uint32_t> m_parents;  // slots
+  std::vector<Vector3> m_translations;
+  std::vector<Quaternion> m_rotations;
+  std::vector<Vector3> m_scales;
+  std::vector<uint8_t> m_dirty;
+  std::vector<Matrix> m_worldTransforms;
+  std::vector<uint32_t> m_subtreeSizes;
+
+  // Partitioning for parallel updates: nodes whose subtrees are too large to
+  // be processed by a single task, and ranges of subtrees that are not.
+  std::vector<uint32_t> m_sharedSlots;
+  std::vector<Range> m_ranges;
+  size_t m_grainSize;
+
+  bool m_layoutDirty;
+  bool m_anyDirty;
+
+  // internal
+  void Link(Id id, Id parent);
+  void Unlink(Id id);
+  void SetDirty(uint32_t slot);
+  void RemoveSlot(uint32_t slot);
+  void Relayout();
+  void Partition(size_t grainSize);
+  void UpdateRange(uint32_t begin, uint32_t end);
+  void ClearDirty();
+
+  template <typename T>
+  static void Permute(std::vector<T>& values, std::vector<uint32_t> const& order);
+};
+
+//==============================================================================
+// implementation
+//==============================================================================
+inline
+size_t TransformStore::GetSize() const
+{
+  return m_ids.size();
+}
+
+//==============================================================================
+inline
+Vector3 const& TransformStore::GetTranslation(Id id) const
+{
+  return m_translations[m_nodes[id].slot];
+}
+
+//==============================================================================
+inline
+Quaternion const& TransformStore::GetRotation(Id id) const
+{
+  return m_rotations[m_nodes[id].slot];
+}
+
+//==============================================================================
+inline
+Vector3 const& TransformStore::GetScale(Id id) const
+{
+  return m_scales[m_nodes[id].slot];
+}
+
+//==============================================================================
+inline
+Matrix const& TransformStore::GetWorldTransform(Id id) const
+{
+  return m_worldTransforms[m_nodes[id].slot];
+}
+
+//==============================================================================
+inline
+TransformStore::Id TransformStore::GetParent(Id id) const
+{
+  return m_nodes[id].parent;
+}
+
+//==============================================================================
+inline
+bool TransformStore::IsUpdateNeeded() const
+{
+  return m_anyDirty || m_layoutDirty;
+}
+
+}
+
+#endif  //XR_TRANSFORMSTORE_HPP
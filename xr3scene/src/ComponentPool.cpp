@@ -0,0 +1,169 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xr/ComponentPool.hpp"
+#include "xr/Component.hpp"
+#include "xr/debug.hpp"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <new>
+
+namespace xr
+{
+namespace
+{
+
+struct Registry
+{
+  Spinlock lock;
+  std::vector<std::unique_ptr<ComponentPoolBase>> pools;  // guarded by lock
+
+  // Requires lock to be held.
+  ComponentPoolBase* FindLocked(size_t typeId) const
+  {
+    auto iFind = std::find_if(pools.begin(), pools.end(),
+      [typeId](std::unique_ptr<ComponentPoolBase> const& pool) {
+        return pool->GetTypeId() == typeId;
+      });
+    return iFind != pools.end() ? iFind->get() : nullptr;
+  }
+
+  static Registry& Get()
+  {
+    static Registry instance;
+    return instance;
+  }
+};
+
+}
+
+//==============================================================================
+ComponentPoolBase* ComponentPoolBase::Find(size_t typeId)
+{
+  auto& registry = Registry::Get();
+  std::unique_lock<Spinlock> lock(registry.lock);
+  return registry.FindLocked(typeId);
+}
+
+//==============================================================================
+ComponentPoolBase& ComponentPoolBase::Acquire(size_t typeId, size_t elementSize,
+  size_t alignment)
+{
+  auto& registry = Registry::Get();
+  std::unique_lock<Spinlock> lock(registry.lock);
+  auto pool = registry.FindLocked(typeId);
+  if (!pool)
+  {
+    pool = new ComponentPoolBase(typeId, elementSize, alignment);
+    registry.pools.emplace_back(pool);
+  }
+  XR_ASSERT(ComponentPool, pool->m_elementSize == elementSize &&
+    pool->m_alignment == alignment);
+  return *pool;
+}
+
+//==============================================================================
+ComponentPoolBase::ComponentPoolBase(size_t typeId, size_t elementSize, size_t alignment)
+: m_typeId(typeId),
+  m_elementSize(elementSize),
+  m_alignment(alignment),
+  m_firstFreeBlock(0),
+  m_size(0)
+{}
+
+//==============================================================================
+ComponentPoolBase::~ComponentPoolBase()
+{
+  XR_TRACEIF(ComponentPool, m_size > 0,
+    ("WARNING: %zu components of type %zx were not destroyed.", m_size, m_typeId));
+  for (auto& b : m_blocks)
+  {
+    ::operator delete(b.data, std::align_val_t(m_alignment));
+  }
+}
+
+//==============================================================================
+void* ComponentPoolBase::Allocate()
+{
+  std::unique_lock<Spinlock> lock(m_lock);
+  while (m_firstFreeBlock < m_blocks.size() &&
+    m_blocks[m_firstFreeBlock].numOccupied == kBlockSize)
+  {
+    ++m_firstFreeBlock;
+  }
+
+  if (m_firstFreeBlock == m_blocks.size())
+  {
+    Block block;
+    block.data = static_cast<uint8_t*>(::operator new(m_elementSize * kBlockSize,
+      std::align_val_t(m_alignment)));
+    block.numOccupied = 0;
+    std::fill(block.occupied, block.occupied + kBlockSize, false);
+    m_blocks.push_back(block);
+
+    // Keep an index of the blocks sorted by address, for Deallocate().
+    const uint32_t index = static_cast<uint32_t>(m_blocks.size() - 1);
+    auto iInsert = std::upper_bound(m_blocksByAddress.begin(), m_blocksByAddress.end(),
+      block.data, [this](uint8_t const* address, uint32_t i) {
+        return address < m_blocks[i].data;
+      });
+    m_blocksByAddress.insert(iInsert, index);
+  }
+
+  Block& block = m_blocks[m_firstFreeBlock];
+  auto iSlot = std::find(block.occupied, block.occupied + kBlockSize, false);
+  XR_ASSERT(ComponentPool, iSlot != block.occupied + kBlockSize);
+  *iSlot = true;
+  ++block.numOccupied;
+  ++m_size;
+  return block.data + (iSlot - block.occupied) * m_elementSize;
+}
+
+//==============================================================================
+void ComponentPoolBase::Deallocate(void* p)
+{
+  std::unique_lock<Spinlock> lock(m_lock);
+  auto data = static_cast<uint8_t*>(p);
+  auto iFind = std::upper_bound(m_blocksByAddress.begin(), m_blocksByAddress.end(),
+    data, [this](uint8_t const* address, uint32_t i) {
+      return address < m_blocks[i].data;
+    });
+  XR_ASSERT(ComponentPool, iFind != m_blocksByAddress.begin());
+  const size_t iBlock = *(iFind - 1);
+
+  Block& block = m_blocks[iBlock];
+  const size_t iSlot = (data - block.data) / m_elementSize;
+  XR_ASSERTMSG(ComponentPool, iSlot < kBlockSize && block.occupied[iSlot],
+    ("%p wasn't allocated from this pool.", p));
+  block.occupied[iSlot] = false;
+  --block.numOccupied;
+  --m_size;
+
+  m_firstFreeBlock = std::min(m_firstFreeBlock, iBlock);
+}
+
+//==============================================================================
+ComponentPoolBase& Component::AcquirePool(size_t typeId, size_t size, size_t alignment)
+{
+  return ComponentPoolBase::Acquire(typeId, size, alignment);
+}
+
+//==============================================================================
+void* Component::Allocate(ComponentPoolBase& pool)
+{
+  return pool.Allocate();
+}
+
+//==============================================================================
+void Component::Deallocate(ComponentPoolBase& pool, void* p)
+{
+  pool.Deallocate(p);
+}
+
+}
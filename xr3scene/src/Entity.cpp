@@ -32,6 +32,8 @@ Entity::Entity(Name n, Entity* parent)
 : m_parent(nullptr),  // not yet
   m_firstChild(nullptr),
   m_nextSibling(nullptr),
+  m_transforms(nullptr),
+  m_transformId(TransformStore::kInvalidId),
   m_nextWorldUpdate(parent ? parent->m_nextWorldUpdate : nullptr),
   m_translation(Vector3::Zero()),
   m_rotation(Quaternion::Identity()),
@@ -59,6 +61,11 @@ Entity::~Entity()
     i->m_owner= nullptr;
     delete i;
   }
+
+  if (m_transforms)
+  {
+    m_transforms->Release(m_transformId);
+  }
 }
 
 //==============================================================================
@@ -70,69 +77,101 @@ void  Entity::SetName(Name n)
 //==============================================================================
 void Entity::SetTranslation(Vector3 const& t)
 {
-  m_translation = t;
-  FlagUpdateNeeded(this);
+  if (m_transforms)
+  {
+    m_transforms->SetTranslation(m_transformId, t);
+  }
+  else
+  {
+    m_translation = t;
+    FlagUpdateNeeded(this);
+  }
 }
 
 //==============================================================================
 void Entity::SetXTranslation(float x)
 {
-  m_translation.x = x;
-  FlagUpdateNeeded(this);
+  Vector3 t = GetTranslation();
+  t.x = x;
+  SetTranslation(t);
 }
 
 //==============================================================================
 void Entity::SetYTranslation(float y)
 {
-  m_translation.y = y;
-  FlagUpdateNeeded(this);
+  Vector3 t = GetTranslation();
+  t.y = y;
+  SetTranslation(t);
 }
 
 //==============================================================================
 void Entity::SetZTranslation(float z)
 {
-  m_translation.z = z;
-  FlagUpdateNeeded(this);
+  Vector3 t = GetTranslation();
+  t.z = z;
+  SetTranslation(t);
 }
 
 //==============================================================================
 void Entity::SetRotation(Quaternion const& r)
 {
-  m_rotation = r;
-  FlagUpdateNeeded(this);
+  if (m_transforms)
+  {
+    m_transforms->SetRotation(m_transformId, r);
+  }
+  else
+  {
+    m_rotation = r;
+    FlagUpdateNeeded(this);
+  }
 }
 
 //==============================================================================
 void Entity::SetScale(Vector3 const& s)
 {
-  m_scale = s;
-  FlagUpdateNeeded(this);
+  if (m_transforms)
+  {
+    m_transforms->SetScale(m_transformId, s);
+  }
+  else
+  {
+    m_scale = s;
+    FlagUpdateNeeded(this);
+  }
 }
 
 //==============================================================================
 void Entity::SetXScale(float x)
 {
-  m_scale.x = x;
-  FlagUpdateNeeded(this);
+  Vector3 s = GetScale();
+  s.x = x;
+  SetScale(s);
 }
 
 //==============================================================================
 void Entity::SetYScale(float y)
 {
-  m_scale.y = y;
-  FlagUpdateNeeded(this);
+  Vector3 s = GetScale();
+  s.y = y;
+  SetScale(s);
 }
 
 //==============================================================================
 void Entity::SetZScale(float z)
 {
-  m_scale.z = z;
-  FlagUpdateNeeded(this);
+  Vector3 s = GetScale();
+  s.z = z;
+  SetScale(s);
 }
 
 //==============================================================================
 Matrix Entity::GetLocalTransform() const
 {
+  if (m_transforms)
+  {
+    return m_transforms->GetLocalTransform(m_transformId);
+  }
+
   Matrix xform(m_rotation, m_translation);
   xform.ScaleX(m_scale.x);
   xform.ScaleY(m_scale.y);
@@ -143,7 +182,11 @@ Matrix Entity::GetLocalTransform() const
 //==============================================================================
 void Entity::UpdateWorldTransform()
 {
-  if (m_nextWorldUpdate)
+  if (m_transforms)
+  {
+    m_transforms->Update();
+  }
+  else if (m_nextWorldUpdate)
   {
     auto nextWorldUpdate = m_nextWorldUpdate;
     if (!nextWorldUpdate->GetParent())  // process root separately.
@@ -158,6 +201,19 @@ void Entity::UpdateWorldTransform()
   }
 }
 
+//==============================================================================
+void Entity::UpdateWorldTransform(TaskScheduler& scheduler)
+{
+  if (m_transforms)
+  {
+    m_transforms->Update(scheduler);
+  }
+  else
+  {
+    UpdateWorldTransform();
+  }
+}
+
 //==============================================================================
 Matrix const&  Entity::GetWorldTransform(bool update) const
 {
@@ -165,7 +221,23 @@ Matrix const&  Entity::GetWorldTransform(bool update) const
   {
     const_cast<Entity*>(this)->UpdateWorldTransform();
   }
-  return m_worldTransform;
+  return m_transforms ? m_transforms->GetWorldTransform(m_transformId) :
+    m_worldTransform;
+}
+
+//==============================================================================
+void Entity::SetTransformStore(TransformStore* transforms)
+{
+  XR_ASSERTMSG(Entity, !m_parent, ("'%s' must not have a parent.",
+    m_name.GetDebugValue()));
+  if (transforms != m_transforms)
+  {
+    MoveTransform(transforms);
+    if (!transforms)
+    {
+      FlagUpdateNeeded(this);
+    }
+  }
 }
 
 //==============================================================================
@@ -223,7 +295,19 @@ void  Entity::AddChild(Entity& e)
   e.m_parent = this;
   m_children.insert(iInsert, &e);
 
-  e.FlagUpdateNeeded(m_nextWorldUpdate ? m_nextWorldUpdate : &e);
+  if (e.m_transforms != m_transforms)
+  {
+    e.MoveTransform(m_transforms);
+  }
+
+  if (m_transforms)
+  {
+    m_transforms->SetParent(e.m_transformId, m_transformId);
+  }
+  else
+  {
+    e.FlagUpdateNeeded(m_nextWorldUpdate ? m_nextWorldUpdate : &e);
+  }
 }
 
 //==============================================================================
@@ -268,7 +352,19 @@ void Entity::AddChild(Entity& e, size_t index)
   e.m_parent = this;
   m_children.insert(iInsert, &e);
 
-  e.FlagUpdateNeeded(m_nextWorldUpdate ? m_nextWorldUpdate : &e);
+  if (e.m_transforms != m_transforms)
+  {
+    e.MoveTransform(m_transforms);
+  }
+
+  if (m_transforms)
+  {
+    m_transforms->SetParent(e.m_transformId, m_transformId);
+  }
+  else
+  {
+    e.FlagUpdateNeeded(m_nextWorldUpdate ? m_nextWorldUpdate : &e);
+  }
 }
 
 //==============================================================================
@@ -297,7 +393,14 @@ bool  Entity::RemoveChild(Entity& e)
 
     e.m_nextSibling = nullptr;
     e.m_parent = nullptr;
-    e.FlagUpdateNeeded(&e);
+    if (m_transforms)
+    {
+      m_transforms->SetParent(e.m_transformId, TransformStore::kInvalidId);
+    }
+    else
+    {
+      e.FlagUpdateNeeded(&e);
+    }
   }
   return result;
 }
@@ -383,9 +486,9 @@ Entity* Entity::Clone(Entity* parent) const
   Entity* clone = new Entity(GetName(), nullptr);
 
   // copy local transformation
-  clone->m_translation = m_translation;
-  clone->m_rotation = m_rotation;
-  clone->m_scale = m_scale;
+  clone->m_translation = GetTranslation();
+  clone->m_rotation = GetRotation();
+  clone->m_scale = GetScale();
   // NOTE: transform is updated outside, recursively.
 
   // clone components
@@ -426,6 +529,42 @@ bool Entity::IsAncestor(Entity* e) const
   return false;
 }
 
+//==============================================================================
+void Entity::MoveTransform(TransformStore* transforms)
+{
+  const Vector3 translation = GetTranslation();
+  const Quaternion rotation = GetRotation();
+  const Vector3 scale = GetScale();
+  if (m_transforms)
+  {
+    m_transforms->Release(m_transformId);
+    m_transformId = TransformStore::kInvalidId;
+  }
+
+  m_transforms = transforms;
+  if (transforms)
+  {
+    const bool isParentBacked = m_parent && m_parent->m_transforms == transforms;
+    m_transformId = transforms->Create(isParentBacked ? m_parent->m_transformId :
+      TransformStore::kInvalidId);
+    transforms->SetTranslation(m_transformId, translation);
+    transforms->SetRotation(m_transformId, rotation);
+    transforms->SetScale(m_transformId, scale);
+  }
+  else
+  {
+    m_translation = translation;
+    m_rotation = rotation;
+    m_scale = scale;
+    m_nextWorldUpdate = nullptr;  // to be flagged by the caller.
+  }
+
+  for (auto i : m_children)
+  {
+    i->MoveTransform(transforms);
+  }
+}
+
 //==============================================================================
 void Entity::FlagUpdateNeeded(Entity* worldUpdate)
 {
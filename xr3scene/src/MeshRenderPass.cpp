@@ -0,0 +1,250 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xr/MeshRenderPass.hpp"
+#include "xr/MeshRenderer.hpp"
+#include "xr/ComponentPool.hpp"
+#include "xr/Camera.hpp"
+#include "xr/Mesh.hpp"
+#include "xr/Transforms.hpp"
+#include "xr/math/Matrix4.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace xr
+{
+namespace
+{
+
+const int kNumFrustumPlanes = 6;
+
+// Extracts the planes of the frustum from the view projection matrix, with the
+// normals pointing inwards, normalised.
+void CalculateFrustumPlanes(Camera const& camera, Vector4 (&planes)[kNumFrustumPlanes])
+{
+  Matrix view = camera.GetViewerTransform();
+  view.Invert();
+  view.t = view.Rotate(-view.t);
+
+  Matrix4 viewMatrix;
+  viewMatrix.Import(view);
+
+  Matrix4 viewProjection;
+  viewMatrix.Transform(camera.GetProjectionMatrix(), viewProjection);
+
+  // Row vectors are transformed, so clip space coordinates are the dot products
+  // of the position with the columns of the matrix.
+  float const* m = viewProjection.data;
+  const Vector4 column[] = {
+    Vector4(m[0], m[4], m[8], m[12]),
+    Vector4(m[1], m[5], m[9], m[13]),
+    Vector4(m[2], m[6], m[10], m[14]),
+    Vector4(m[3], m[7], m[11], m[15]),
+  };
+
+  for (int i = 0; i < 3; ++i)
+  {
+    planes[i * 2] = column[3] + column[i];
+    planes[i * 2 + 1] = column[3] - column[i];
+  }
+
+  for (auto& p : planes)
+  {
+    const float magnitude = Vector3(p.x, p.y, p.z).Magnitude();
+    p *= 1.f / magnitude;
+  }
+}
+
+bool IsSphereVisible(Vector4 const (&planes)[kNumFrustumPlanes],
+  Vector3 const& center, float radius)
+{
+  for (auto& p : planes)
+  {
+    if (p.x * center.x + p.y * center.y + p.z * center.z + p.w < -radius)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+}
+
+//==============================================================================
+MeshRenderPass::MeshRenderPass()
+{}
+
+//==============================================================================
+MeshRenderPass::~MeshRenderPass()
+{}
+
+//==============================================================================
+void MeshRenderPass::SetInstancedMaterial(Material::Ptr const& material,
+  Material::Ptr const& instanced)
+{
+  XR_ASSERT(MeshRenderPass, material);
+  auto iFind = std::find_if(m_instancedMaterials.begin(), m_instancedMaterials.end(),
+    [&material](InstancedMaterial const& im) {
+      return im.material == material;
+    });
+  if (instanced)
+  {
+    if (iFind != m_instancedMaterials.end())
+    {
+      iFind->instanced = instanced;
+    }
+    else
+    {
+      m_instancedMaterials.push_back({ material, instanced });
+    }
+  }
+  else if (iFind != m_instancedMaterials.end())
+  {
+    m_instancedMaterials.erase(iFind);
+  }
+}
+
+//==============================================================================
+void MeshRenderPass::Cull(Camera const& camera)
+{
+  m_items.clear();
+  m_batches.clear();
+  m_instanceData.clear();
+  m_stats = Stats();
+
+  Vector4 planes[kNumFrustumPlanes];
+  CalculateFrustumPlanes(camera, planes);
+
+  ComponentPool<MeshRenderer>::Get().ForEach([this, &planes](MeshRenderer& r) {
+    Entity* owner = r.GetOwner();
+    Mesh* mesh = r.GetMesh();
+    if (!(owner && mesh && r.material))
+    {
+      return;
+    }
+
+    ++m_stats.numRenderers;
+    if (r.HasBounds())
+    {
+      Vector3 center;
+      float radius;
+      r.GetWorldBounds(center, radius);
+      if (!IsSphereVisible(planes, center, radius))
+      {
+        return;
+      }
+    }
+
+    m_items.push_back({ &r, r.material.Get(), mesh, &owner->GetWorldTransform() });
+  });
+  m_stats.numVisible = static_cast<uint32_t>(m_items.size());
+
+  // Stable, so that draw order is deterministic, i.e. that of the pool.
+  std::stable_sort(m_items.begin(), m_items.end(), [](Item const& a, Item const& b) {
+    std::less<void const*> less;
+    return a.material != b.material ? less(a.material, b.material) :
+      less(a.mesh, b.mesh);
+  });
+
+  // Group runs of the same material and mesh.
+  const uint32_t numItems = static_cast<uint32_t>(m_items.size());
+  uint32_t i = 0;
+  while (i < numItems)
+  {
+    Item const& first = m_items[i];
+    uint32_t end = i + 1;
+    while (end < numItems && m_items[end].material == first.material &&
+      m_items[end].mesh == first.mesh)
+    {
+      ++end;
+    }
+
+    const uint32_t count = end - i;
+    Material const* instanced = count >= kMinInstances ?
+      FindInstancedMaterial(first.material) : nullptr;
+    if (instanced)
+    {
+      m_batches.push_back({ i, count, instanced,
+        static_cast<uint32_t>(m_instanceData.size() / 3) });
+      for (uint32_t j = i; j < end; ++j)
+      {
+        Matrix const& m = *m_items[j].world;
+        m_instanceData.push_back(Vector4(m.xx(), m.yx(), m.zx(), m.t.x));
+        m_instanceData.push_back(Vector4(m.xy(), m.yy(), m.zy(), m.t.y));
+        m_instanceData.push_back(Vector4(m.xz(), m.yz(), m.zz(), m.t.z));
+      }
+
+      ++m_stats.numDrawCalls;
+      m_stats.numInstanced += count;
+    }
+    else
+    {
+      m_batches.push_back({ i, count, nullptr, 0 });
+      m_stats.numDrawCalls += count;
+    }
+    i = end;
+  }
+}
+
+//==============================================================================
+void MeshRenderPass::Render()
+{
+  Gfx::InstanceDataBufferHandle hInstanceData;
+  if (!m_instanceData.empty())
+  {
+    hInstanceData = Gfx::CreateInstanceDataBuffer(Buffer::FromArray(
+      m_instanceData.size(), m_instanceData.data()), kInstanceDataStride);
+  }
+
+  Material const* lastMaterial = nullptr;
+  auto applyMaterial = [&lastMaterial](Material const* material) {
+    if (material != lastMaterial)
+    {
+      material->Apply();
+      lastMaterial = material;
+    }
+  };
+
+  for (auto& b : m_batches)
+  {
+    Item const* item = m_items.data() + b.begin;
+    if (b.instanced)
+    {
+      applyMaterial(b.instanced);
+      Gfx::SetInstanceData(hInstanceData, b.instanceOffset, b.count);
+      item->mesh->Render(Primitive::TriangleList);
+    }
+    else
+    {
+      applyMaterial(item->material);
+      for (auto end = item + b.count; item != end; ++item)
+      {
+        XR_TRANSFORMS_SCOPED_MODEL(*item->world);
+        item->mesh->Render(Primitive::TriangleList);
+      }
+    }
+  }
+
+  if (hInstanceData.IsValid())
+  {
+    Gfx::Release(hInstanceData);
+  }
+}
+
+//==============================================================================
+Material const* MeshRenderPass::FindInstancedMaterial(Material const* material) const
+{
+  auto iFind = std::find_if(m_instancedMaterials.begin(), m_instancedMaterials.end(),
+    [material](InstancedMaterial const& im) {
+      return im.material.Get() == material;
+    });
+  return iFind != m_instancedMaterials.end() ? iFind->instanced.Get() : nullptr;
+}
+
+}
@@ -9,6 +9,8 @@
 #include "xr/MeshRenderer.hpp"
 #include "xr/Mesh.hpp"
 #include "xr/Transforms.hpp"
+#include <algorithm>
+#include <cstring>
 
 namespace xr
 {
@@ -16,7 +18,11 @@ namespace xr
 //==============================================================================
 MeshRenderer::MeshRenderer()
 : BaseType(),
-  m_mesh(nullptr)
+  m_mesh(nullptr),
+  m_boundsCenter(Vector3::Zero()),
+  m_boundsRadius(-1.f),
+  m_worldBoundsRadius(-1.f),
+  m_worldBoundsValid(false)
 {}
 
 //==============================================================================
@@ -27,7 +33,9 @@ MeshRenderer::~MeshRenderer()
 MeshRenderer*  MeshRenderer::Clone() const
 {
   MeshRenderer*  pClone(new MeshRenderer());
+  pClone->material = material;
   pClone->SetMesh(m_mesh);
+  pClone->SetBounds(m_boundsCenter, m_boundsRadius);
   return  pClone;
 }
 
@@ -37,14 +45,40 @@ void  MeshRenderer::SetMesh(Mesh* mesh)
   m_mesh = mesh;
 }
 
+//==============================================================================
+void  MeshRenderer::SetBounds(Vector3 const& center, float radius)
+{
+  m_boundsCenter = center;
+  m_boundsRadius = radius;
+  m_worldBoundsValid = false;
+}
+
+//==============================================================================
+void  MeshRenderer::GetWorldBounds(Vector3& center, float& radius) const
+{
+  XR_ASSERT(MeshRenderer, GetOwner() != nullptr);
+  XR_ASSERT(MeshRenderer, HasBounds());
+  Matrix const& world = GetOwner()->GetWorldTransform();
+  if (!m_worldBoundsValid ||
+    std::memcmp(&world, &m_worldBoundsTransform, sizeof(Matrix)) != 0)
+  {
+    m_worldBoundsTransform = world;
+    m_worldBoundsCenter = world.Transform(m_boundsCenter);
+    m_worldBoundsRadius = m_boundsRadius * std::max(world.GetXScaling(),
+      std::max(world.GetYScaling(), world.GetZScaling()));
+    m_worldBoundsValid = true;
+  }
+
+  center = m_worldBoundsCenter;
+  radius = m_worldBoundsRadius;
+}
+
 //==============================================================================
 void  MeshRenderer::Render()
 {
   XR_ASSERT(MeshRenderer, GetOwner() != nullptr);
   XR_ASSERT(MeshRenderer, m_mesh != nullptr);
-  // TODO: probably introduce interim RendererComponent with model[view] matrix
-  // stack update, rather than regenerating the world transform from scratch.
-  XR_TRANSFORMS_SCOPED_MODEL(GetOwner()->GetLocalTransform());
+  XR_TRANSFORMS_SCOPED_MODEL(GetOwner()->GetWorldTransform());
   material->Apply();
   m_mesh->Render(Primitive::TriangleList);
 }
@@ -0,0 +1,437 @@
+//
+// XRhodes
+//
+// copyright (c) Gyorgy Straub. All rights reserved.
+//
+// License: https://github.com/zyndor/xrhodes#License-bsd-2-clause
+//
+//==============================================================================
+#include "xr/TransformStore.hpp"
+#include "xr/threading/TaskScheduler.hpp"
+#include "xr/debug.hpp"
+#include <algorithm>
+
+namespace xr
+{
+namespace
+{
+
+// The smallest number of transforms worth processing in a task.
+const size_t kMinGrainSize = 512;
+
+Matrix CalculateLocalTransform(Vector3 const& t, Quaternion const& r, Vector3 const& s)
+{
+  Matrix xform(r, t);
+  xform.ScaleX(s.x);
+  xform.ScaleY(s.y);
+  xform.ScaleZ(s.z);
+  return xform;
+}
+
+}
+
+//==============================================================================
+template <typename T>
+void TransformStore::Permute(std::vector<T>& values, std::vector<uint32_t> const& order)
+{
+  std::vector<T> permuted;
+  permuted.reserve(values.size());
+  for (auto i : order)
+  {
+    permuted.push_back(values[i]);
+  }
+  values.swap(permuted);
+}
+
+//==============================================================================
+TransformStore::TransformStore()
+: m_grainSize(0),
+  m_layoutDirty(false),
+  m_anyDirty(false)
+{}
+
+//==============================================================================
+TransformStore::~TransformStore()
+{
+  XR_TRACEIF(TransformStore, !m_ids.empty(),
+    ("WARNING: %zu transforms were not released.", m_ids.size()));
+}
+
+//==============================================================================
+TransformStore::Id TransformStore::Create(Id parent)
+{
+  Id id;
+  if (m_freeIds.empty())
+  {
+    id = static_cast<Id>(m_nodes.size());
+    m_nodes.push_back(Node());
+  }
+  else
+  {
+    id = m_freeIds.back();
+    m_freeIds.pop_back();
+  }
+
+  const uint32_t slot = static_cast<uint32_t>(m_ids.size());
+  m_nodes[id] = Node{ slot, kInvalidId, kInvalidId, kInvalidId, kInvalidId };
+
+  m_ids.push_back(id);
+  m_parents.push_back(kInvalidId);
+  m_translations.push_back(Vector3::Zero());
+  m_rotations.push_back(Quaternion::Identity());
+  m_scales.push_back(Vector3::One());
+  m_dirty.push_back(false);
+  m_worldTransforms.push_back(Matrix::Identity());
+  m_layoutDirty = true;  // not in the subtree sizes or the partitioning yet.
+
+  if (parent != kInvalidId)
+  {
+    Link(id, parent);
+  }
+  return id;
+}
+
+//==============================================================================
+void TransformStore::Release(Id id)
+{
+  XR_ASSERT(TransformStore, id < m_nodes.size());
+  Node& node = m_nodes[id];
+  XR_ASSERTMSG(TransformStore, node.slot != kInvalidId, ("%u is not a live transform.", id));
+  while (node.firstChild != kInvalidId)
+  {
+    SetParent(node.firstChild, kInvalidId);
+  }
+  Unlink(id);
+
+  RemoveSlot(node.slot);
+  node.slot = kInvalidId;
+  m_freeIds.push_back(id);
+}
+
+//==============================================================================
+void TransformStore::SetParent(Id id, Id parent)
+{
+  XR_ASSERT(TransformStore, id < m_nodes.size());
+  if (m_nodes[id].parent != parent)
+  {
+    Unlink(id);
+    if (parent != kInvalidId)
+    {
+      Link(id, parent);
+    }
+    else
+    {
+      SetDirty(m_nodes[id].slot);
+    }
+  }
+}
+
+//==============================================================================
+void TransformStore::SetTranslation(Id id, Vector3 const& t)
+{
+  const uint32_t slot = m_nodes[id].slot;
+  m_translations[slot] = t;
+  SetDirty(slot);
+}
+
+//==============================================================================
+void TransformStore::SetRotation(Id id, Quaternion const& r)
+{
+  const uint32_t slot = m_nodes[id].slot;
+  m_rotations[slot] = r;
+  SetDirty(slot);
+}
+
+//==============================================================================
+void TransformStore::SetScale(Id id, Vector3 const& s)
+{
+  const uint32_t slot = m_nodes[id].slot;
+  m_scales[slot] = s;
+  SetDirty(slot);
+}
+
+//==============================================================================
+Matrix TransformStore::GetLocalTransform(Id id) const
+{
+  const uint32_t slot = m_nodes[id].slot;
+  return CalculateLocalTransform(m_translations[slot], m_rotations[slot], m_scales[slot]);
+}
+
+//==============================================================================
+void TransformStore::Update()
+{
+  if (m_layoutDirty)
+  {
+    Relayout();
+  }
+
+  if (!m_anyDirty)
+  {
+    return;
+  }
+
+  UpdateRange(0, static_cast<uint32_t>(m_ids.size()));
+  ClearDirty();
+}
+
+//==============================================================================
+void TransformStore::Update(TaskScheduler& scheduler)
+{
+  if (m_layoutDirty)
+  {
+    Relayout();
+  }
+
+  if (!m_anyDirty)
+  {
+    return;
+  }
+
+  const size_t grainSize = std::max(m_ids.size() / (scheduler.GetNumThreads() * 4),
+    kMinGrainSize);
+  if (grainSize != m_grainSize)
+  {
+    Partition(grainSize);
+  }
+
+  // The shared nodes are ancestors to the ranges, and need to be done first.
+  for (auto i : m_sharedSlots)
+  {
+    UpdateRange(i, i + 1);
+  }
+
+  scheduler.ParallelFor(0, m_ranges.size(), 1, [this](size_t begin, size_t end) {
+    for (; begin != end; ++begin)
+    {
+      UpdateRange(m_ranges[begin].begin, m_ranges[begin].end);
+    }
+  });
+  ClearDirty();
+}
+
+//==============================================================================
+void TransformStore::Link(Id id, Id parent)
+{
+  XR_ASSERT(TransformStore, parent < m_nodes.size());
+#if defined XR_DEBUG
+  for (Id i = parent; i != kInvalidId; i = m_nodes[i].parent)
+  {
+    XR_ASSERTMSG(TransformStore, i != id, ("%u is an ancestor of %u.", id, parent));
+  }
+#endif  //XR_DEBUG
+
+  Node& node = m_nodes[id];
+  Node& parentNode = m_nodes[parent];
+  node.parent = parent;
+  node.nextSibling = parentNode.firstChild;
+  if (parentNode.firstChild != kInvalidId)
+  {
+    m_nodes[parentNode.firstChild].prevSibling = id;
+  }
+  parentNode.firstChild = id;
+
+  // The child may well precede its new parent now.
+  m_parents[node.slot] = m_nodes[parent].slot;
+  m_layoutDirty = true;
+  SetDirty(node.slot);
+}
+
+//==============================================================================
+void TransformStore::Unlink(Id id)
+{
+  Node& node = m_nodes[id];
+  if (node.parent != kInvalidId)
+  {
+    if (node.prevSibling != kInvalidId)
+    {
+      m_nodes[node.prevSibling].nextSibling = node.nextSibling;
+    }
+    else
+    {
+      m_nodes[node.parent].firstChild = node.nextSibling;
+    }
+
+    if (node.nextSibling != kInvalidId)
+    {
+      m_nodes[node.nextSibling].prevSibling = node.prevSibling;
+    }
+
+    node.parent = kInvalidId;
+    node.prevSibling = kInvalidId;
+    node.nextSibling = kInvalidId;
+    m_parents[node.slot] = kInvalidId;
+    m_layoutDirty = true;  // subtree sizes have changed.
+  }
+}
+
+//==============================================================================
+void TransformStore::SetDirty(uint32_t slot)
+{
+  m_dirty[slot] = true;
+  m_anyDirty = true;
+}
+
+//==============================================================================
+void TransformStore::RemoveSlot(uint32_t slot)
+{
+  // Move the last transform into the vacated slot; Relayout() will restore
+  // the order, and the partitioning, before the next Update().
+  const uint32_t last = static_cast<uint32_t>(m_ids.size() - 1);
+  if (slot != last)
+  {
+    const Id moved = m_ids[last];
+    m_nodes[moved].slot = slot;
+    m_ids[slot] = moved;
+    m_parents[slot] = m_parents[last];
+    m_translations[slot] = m_translations[last];
+    m_rotations[slot] = m_rotations[last];
+    m_scales[slot] = m_scales[last];
+    m_dirty[slot] = m_dirty[last];
+    m_worldTransforms[slot] = m_worldTransforms[last];
+  }
+  m_layoutDirty = true;
+
+  m_ids.pop_back();
+  m_parents.pop_back();
+  m_translations.pop_back();
+  m_rotations.pop_back();
+  m_scales.pop_back();
+  m_dirty.pop_back();
+  m_worldTransforms.pop_back();
+}
+
+//==============================================================================
+void TransformStore::Relayout()
+{
+  // Get the slots in depth-first order, starting from the roots in their
+  // current order.
+  const size_t size = m_ids.size();
+  std::vector<uint32_t> order;
+  order.reserve(size);
+
+  std::vector<Id> stack;
+  for (size_t i = 0; i < size; ++i)
+  {
+    const Id root = m_ids[i];
+    if (m_nodes[root].parent != kInvalidId)
+    {
+      continue;
+    }
+
+    stack.push_back(root);
+    while (!stack.empty())
+    {
+      const Id id = stack.back();
+      stack.pop_back();
+
+      Node const& node = m_nodes[id];
+      order.push_back(node.slot);
+      for (Id child = node.firstChild; child != kInvalidId;
+        child = m_nodes[child].nextSibling)
+      {
+        stack.push_back(child);
+      }
+    }
+  }
+  XR_ASSERT(TransformStore, order.size() == size);
+
+  Permute(m_ids, order);
+  Permute(m_translations, order);
+  Permute(m_rotations, order);
+  Permute(m_scales, order);
+  Permute(m_dirty, order);
+  Permute(m_worldTransforms, order);
+
+  for (uint32_t i = 0; i < size; ++i)
+  {
+    m_nodes[m_ids[i]].slot = i;
+  }
+
+  for (uint32_t i = 0; i < size; ++i)
+  {
+    const Id parent = m_nodes[m_ids[i]].parent;
+    m_parents[i] = parent != kInvalidId ? m_nodes[parent].slot : kInvalidId;
+  }
+
+  // Children follow their parents, so a reverse pass accumulates subtree sizes.
+  m_subtreeSizes.assign(size, 1);
+  for (uint32_t i = static_cast<uint32_t>(size); i > 0; --i)
+  {
+    const uint32_t parent = m_parents[i - 1];
+    if (parent != kInvalidId)
+    {
+      m_subtreeSizes[parent] += m_subtreeSizes[i - 1];
+    }
+  }
+
+  m_grainSize = 0;  // needs partitioning.
+  m_layoutDirty = false;
+}
+
+//==============================================================================
+void TransformStore::Partition(size_t grainSize)
+{
+  m_sharedSlots.clear();
+  m_ranges.clear();
+
+  // Subtrees that are small enough become (part of) a range, and are skipped.
+  // Otherwise we descend; the next slot is the node's first child.
+  const uint32_t size = static_cast<uint32_t>(m_ids.size());
+  uint32_t i = 0;
+  while (i < size)
+  {
+    const uint32_t subtreeSize = m_subtreeSizes[i];
+    if (subtreeSize <= grainSize)
+    {
+      const uint32_t end = i + subtreeSize;
+      if (!m_ranges.empty() && m_ranges.back().end == i &&
+        end - m_ranges.back().begin <= grainSize)
+      {
+        m_ranges.back().end = end;
+      }
+      else
+      {
+        m_ranges.push_back(Range{ i, end });
+      }
+      i = end;
+    }
+    else
+    {
+      m_sharedSlots.push_back(i);
+      ++i;
+    }
+  }
+
+  m_grainSize = grainSize;
+}
+
+//==============================================================================
+void TransformStore::UpdateRange(uint32_t begin, uint32_t end)
+{
+  // Parents precede their children, so by the time we get to a node, its
+  // parent's dirtiness and world transform are final.
+  for (uint32_t i = begin; i < end; ++i)
+  {
+    const uint32_t parent = m_parents[i];
+    if (parent != kInvalidId)
+    {
+      m_dirty[i] |= m_dirty[parent];
+    }
+
+    if (m_dirty[i])
+    {
+      Matrix local = CalculateLocalTransform(m_translations[i], m_rotations[i], m_scales[i]);
+      m_worldTransforms[i] = parent != kInvalidId ?
+        local * m_worldTransforms[parent] : local;
+    }
+  }
+}
+
+//==============================================================================
+void TransformStore::ClearDirty()
+{
+  std::fill(m_dirty.begin(), m_dirty.end(), uint8_t(false));
+  m_anyDirty = false;
+}
+
+}